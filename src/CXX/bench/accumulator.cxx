@@ -0,0 +1,223 @@
+/**
+ *  \file
+ *  \brief  Accumulator benchmark (voting rate)
+ *
+ *  Pseudo-random 2D samples are voted with circle and disc kernels
+ *  to sparse, dense and shared concurrent backends (single-threaded
+ *  and in parallel); voting time per sample and vote rate are reported.
+ *
+ *  \date   2016/01/16
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "bench.hxx"
+
+#include <libaccl/accumulator.hxx>
+#include <libaccl/backend/dense.hxx>
+#include <libaccl/backend/sparse_concurrent.hxx>
+#include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/pattern/kernel.hxx>
+#include <libaccl/hash/mix.hxx>
+
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+
+
+typedef libaccl::pattern::kernel<int, unsigned, 2> kernel_t;  /**< Kernel */
+
+/** Sparse accumulator */
+typedef libaccl::accumulator<int, unsigned, 2> sparse_t;
+
+/** Dense accumulator */
+typedef libaccl::accumulator<int, unsigned, 2,
+    libaccl::backend::dense<int, unsigned, 2> > dense_t;
+
+/** Shared concurrent accumulator */
+typedef libaccl::accumulator<int, unsigned, 2,
+    libaccl::backend::sparse_concurrent<int, unsigned, 2> > shared_t;
+
+/** Samples box half-width */
+static const int BOX = 512;
+
+
+/**
+ *  \brief  Run benchmark
+ *
+ *  Votes for all samples with a fresh accumulator;
+ *  best of \c rounds runs is reported.
+ *
+ *  \tparam Make     Accumulator factory type
+ *  \param  out      Report
+ *  \param  backend  Backend name
+ *  \param  shape    Kernel shape name
+ *  \param  radius   Kernel radius
+ *  \param  kernel   Kernel
+ *  \param  samples  Samples (row-major)
+ *  \param  threads  Thread count
+ *  \param  rounds   Number of runs
+ *  \param  make     Accumulator factory (returns \c std::unique_ptr,
+ *                   since accumulators are constructed in place;
+ *                   concurrent backends are not movable)
+ */
+template <class Make>
+static void run(
+    bench::report          & out,
+    const char             * backend,
+    const char             * shape,
+    int                      radius,
+    const kernel_t         & kernel,
+    const std::vector<int> & samples,
+    unsigned                 threads,
+    unsigned                 rounds,
+    Make                     make)
+{
+    const size_t n = samples.size() / 2;
+
+    double vote_ns = 0;
+    size_t cells = 0;
+
+    for (unsigned r = 0; r < rounds; ++r) {
+        const auto acc = make();
+
+        bench::stopwatch sw;
+        acc->vote(samples.data(), n, threads);
+        bench::best(vote_ns, sw.ns_per_op(n), r);
+
+        cells = acc->size();
+    }
+
+    // Millions of (cell) votes per second
+    const double mvotes = vote_ns ? kernel.size() * 1e3 / vote_ns : 0;
+
+    out(backend, shape, radius, kernel.size(), threads, n, cells,
+        vote_ns, mvotes);
+}
+
+
+/**
+ *  \brief  Benchmark
+ *
+ *  Usage: \c accumulator [--csv|--json] [samples] [rounds] [threads]
+ */
+static int main_impl(int argc, char * const argv[]) {
+    const bench::args args(argc, argv);
+
+    const size_t   n       = args.integer(0, 100000);  // number of samples
+    const unsigned rounds  = args.integer(1, 3);       // number of runs
+    const unsigned threads = libaccl::parallel::thread_cnt(
+        args.integer(2, 0));                           // threads (0 = all)
+
+    // Pseudo-random samples
+    std::vector<int> samples;
+    samples.reserve(2 * n);
+    bench::random rand;
+    for (size_t i = 0; i < 2 * n; ++i)
+        samples.push_back(rand.uniform(-BOX, BOX));
+
+    bench::report out(args.format(), "accumulator",
+        {"backend", "kernel", "radius", "kernel_size", "threads",
+         "samples", "cells", "vote_ns", "mvotes_s"});
+
+    const int radii[] = { 4, 16 };
+    for (size_t i = 0; i < sizeof(radii) / sizeof(radii[0]); ++i) {
+        const int radius = radii[i];
+        const int edge   = BOX + radius;
+
+        // Cells to be voted for (at most); table capacity must suffice
+        const size_t size = libaccl::hash::pow2(
+            (size_t)(4 * edge * edge / 0.85) + 1);
+
+        const dense_t::point_t lo = {{-edge, -edge}}, hi = {{edge, edge}};
+
+        for (int filled = 0; filled < 2; ++filled) {
+            const char * shape = filled ? "disc" : "circle";
+
+            const libaccl::pattern::hypersphere<int, 2> sphere(filled
+                ? std::vector<int>{radius, 0} : std::vector<int>{radius});
+            const kernel_t kernel(sphere);
+
+            for (unsigned t = 1; ; t = std::min(2 * t, threads)) {
+                run(out, "sparse", shape, radius, kernel, samples, t, rounds,
+                [&kernel, size]() {
+                    return std::unique_ptr<sparse_t>(
+                        new sparse_t(kernel, size));
+                });
+
+                run(out, "dense", shape, radius, kernel, samples, t, rounds,
+                [&kernel, &lo, &hi]() {
+                    return std::unique_ptr<dense_t>(
+                        new dense_t(kernel, lo, hi));
+                });
+
+                run(out, "shared", shape, radius, kernel, samples, t, rounds,
+                [&kernel, size]() {
+                    return std::unique_ptr<shared_t>(
+                        new shared_t(kernel, size));
+                });
+
+                if (t == threads) break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/** Benchmark exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,286 @@
+#ifndef bench__bench_hxx
+#define bench__bench_hxx
+
+/**
+ *  \file
+ *  \brief  Benchmark support (timing, reproducible inputs, machine-readable reports)
+ *
+ *  Benchmarks report records (rows of named columns) to standard output,
+ *  either as CSV (header line, then one line per record) or as JSON lines
+ *  (one object per record), so that results may be stored and compared
+ *  between releases.
+ *  Inputs are generated by a fixed-seed generator; the reported times
+ *  are the best of a number of runs.
+ *
+ *  \date   2016/01/16
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace bench {
+
+/** Report format */
+enum format_t {
+    CSV,   /**< Comma-separated values (with header line) */
+    JSON,  /**< JSON lines (one object per record)        */
+};  // end of enum format_t
+
+/**
+ *  \brief  Command line arguments
+ *
+ *  Options \c --csv (default) and \c --json select report format
+ *  and may be given anywhere; other arguments are positional.
+ */
+class args {
+    private:
+
+    format_t                  m_format;  /**< Report format        */
+    std::vector<const char *> m_pos;     /**< Positional arguments */
+
+    public:
+
+    /** Constructor */
+    args(int argc, char * const argv[]): m_format(CSV) {
+        for (int i = 1; i < argc; ++i) {
+            if      (0 == std::strcmp(argv[i], "--csv"))  m_format = CSV;
+            else if (0 == std::strcmp(argv[i], "--json")) m_format = JSON;
+            else if (0 == std::strncmp(argv[i], "--", 2))
+                throw std::runtime_error(
+                    std::string("bench::args: unknown option ") + argv[i]);
+            else
+                m_pos.push_back(argv[i]);
+        }
+    }
+
+    /** Report format */
+    format_t format() const { return m_format; }
+
+    /** Positional argument \c i as integer (or default) */
+    long integer(size_t i, long def) const {
+        return i < m_pos.size() ? std::atol(m_pos[i]) : def;
+    }
+
+    /** Positional argument \c i as real number (or default) */
+    double real(size_t i, double def) const {
+        return i < m_pos.size() ? std::atof(m_pos[i]) : def;
+    }
+
+};  // end of class args
+
+/**
+ *  \brief  Report
+ *
+ *  Records have the same columns; the first one is the benchmark name.
+ */
+class report {
+    private:
+
+    const format_t                 m_format;   /**< Format               */
+    const std::string              m_name;     /**< Benchmark name       */
+    const std::vector<std::string> m_columns;  /**< Column names         */
+    std::ostream                 & m_out;      /**< Output stream        */
+    bool                           m_header;   /**< Header line written  */
+
+    /** Format value */
+    template <typename T>
+    static std::string field(const T & value) {
+        std::ostringstream s;
+        s.precision(6);
+        s << value;
+        return s.str();
+    }
+
+    /** Format string value (quoted in JSON) */
+    std::string field(const std::string & value) const {
+        return JSON == m_format ? '"' + value + '"' : value;
+    }
+
+    /** Format string value (quoted in JSON) */
+    std::string field(const char * value) const {
+        return field(std::string(value));
+    }
+
+    /** Collect fields (recursion fixed point) */
+    void collect(std::vector<std::string> & ) const {}
+
+    /** Collect fields */
+    template <typename T, typename... Values>
+    void collect(
+        std::vector<std::string> & fields,
+        const T                  & value,
+        const Values &...          values) const
+    {
+        fields.push_back(field(value));
+        collect(fields, values...);
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  fmt      Format
+     *  \param  name     Benchmark name
+     *  \param  columns  Column names (besides the benchmark name)
+     *  \param  out      Output stream
+     */
+    report(
+        format_t                         fmt,
+        const std::string              & name,
+        const std::vector<std::string> & columns,
+        std::ostream                   & out = std::cout)
+    :
+        m_format  ( fmt     ),
+        m_name    ( name    ),
+        m_columns ( columns ),
+        m_out     ( out     ),
+        m_header  ( false   )
+    {}
+
+    /**
+     *  \brief  Write record
+     *
+     *  \param  values  Column values (in the order of columns)
+     */
+    template <typename... Values>
+    void operator () (const Values &... values) {
+        std::vector<std::string> fields;
+        collect(fields, values...);
+
+        if (fields.size() != m_columns.size())
+            throw std::logic_error(
+                "bench::report: column count mismatch");
+
+        if (CSV == m_format) {
+            if (!m_header) {
+                m_out << "bench";
+                for (size_t i = 0; i < m_columns.size(); ++i)
+                    m_out << ',' << m_columns[i];
+                m_out << std::endl;
+
+                m_header = true;
+            }
+
+            m_out << m_name;
+            for (size_t i = 0; i < fields.size(); ++i)
+                m_out << ',' << fields[i];
+            m_out << std::endl;
+        }
+        else {
+            m_out << "{\"bench\":\"" << m_name << '"';
+            for (size_t i = 0; i < fields.size(); ++i)
+                m_out << ",\"" << m_columns[i] << "\":" << fields[i];
+            m_out << '}' << std::endl;
+        }
+    }
+
+};  // end of class report
+
+/** Stopwatch */
+class stopwatch {
+    private:
+
+    typedef std::chrono::steady_clock clock_t;  /**< Clock */
+
+    clock_t::time_point m_start;  /**< Start time */
+
+    public:
+
+    /** Constructor (starts the stopwatch) */
+    stopwatch(): m_start(clock_t::now()) {}
+
+    /** Restart */
+    void restart() { m_start = clock_t::now(); }
+
+    /** Nanoseconds elapsed */
+    double ns() const {
+        const std::chrono::duration<double, std::nano> t =
+            clock_t::now() - m_start;
+
+        return t.count();
+    }
+
+    /** Nanoseconds per operation */
+    double ns_per_op(size_t ops) const { return ops ? ns() / ops : 0; }
+
+};  // end of class stopwatch
+
+/** Keep minimum (best run time; the 1st run sets it) */
+inline void best(double & min, double t, unsigned run) {
+    if (0 == run || t < min) min = t;
+}
+
+/**
+ *  \brief  Pseudo-random generator
+ *
+ *  64-bit LCG with fixed default seed; produces the same sequence
+ *  on all platforms (unlike \c std::rand or distributions).
+ */
+class random {
+    private:
+
+    uint64_t m_state;  /**< State */
+
+    public:
+
+    /** Constructor */
+    random(uint64_t seed = 12345): m_state(seed) {}
+
+    /** Next 32 random bits */
+    uint32_t next() {
+        m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (uint32_t)(m_state >> 32);
+    }
+
+    /** Integer from range [lo, hi) */
+    int uniform(int lo, int hi) {
+        return lo + (int)(next() % (uint32_t)(hi - lo));
+    }
+
+};  // end of class random
+
+}  // end of namespace bench
+
+#endif  // end of #ifndef bench__bench_hxx
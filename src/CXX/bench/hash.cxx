@@ -0,0 +1,279 @@
+/**
+ *  \file
+ *  \brief  Hash table benchmark (modular vs. power-of-2 masking)
+ *
+ *  \date   2016/01/09
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "bench.hxx"
+
+#include <libaccl/hash/linear.hxx>
+#include <libaccl/hash/chain.hxx>
+#include <libaccl/hash/mix.hxx>
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+
+
+typedef std::array<int, 2> point_t;  /**< Key (2D accumulator cell) */
+
+/** Table item (cell) */
+struct cell {
+    point_t  point;  /**< Coordinates */
+    unsigned count;  /**< Votes       */
+
+    typedef std::true_type key_constructed;  /**< See hash::linear */
+
+    cell(): count(0) {}
+    cell(const point_t & p): point(p), count(0) {}
+
+};  // end of struct cell
+
+/** Cell key accessor */
+class key_fn {
+    public:
+
+    inline const point_t & operator () (const cell & c) const {
+        return c.point;
+    }
+
+};  // end of class key_fn
+
+/** Modular hash function (FNV-1a, reduced by modulo) */
+class modular_hash {
+    private:
+
+    size_t m_seed;  /**< Seed */
+
+    public:
+
+    modular_hash(size_t seed = 0): m_seed(seed) {}
+
+    size_t operator () (const point_t & point, size_t size) const {
+        unsigned long long h = 0xcbf29ce484222325ULL ^ m_seed;
+        for (size_t d = 0; d < point.size(); ++d) {
+            h ^= (unsigned long long)point[d];
+            h *= 0x100000001b3ULL;
+        }
+
+        h ^= h >> 29;
+        return h % size;
+    }
+
+};  // end of class modular_hash
+
+/** Modular hash functions */
+typedef libaccl::hash::chain<modular_hash, modular_hash> modular_chain_t;
+
+/** Masking hash functions */
+typedef libaccl::hash::chain<
+        libaccl::hash::point_hash<point_t>,
+        libaccl::hash::point_hash<point_t> >
+    mask_chain_t;
+
+/** Modular hashing table (odd size) */
+typedef libaccl::hash::linear<cell, modular_chain_t, point_t, key_fn>
+    modular_tab_t;
+
+/** Masking table (power-of-2 size) */
+typedef libaccl::hash::linear<cell, mask_chain_t, point_t, key_fn>
+    mask_tab_t;
+
+
+/**
+ *  \brief  Run benchmark
+ *
+ *  Votes for (pseudo-random) points, then looks up present
+ *  and absent ones; best of \c rounds runs is reported.
+ *
+ *  \param  out     Report
+ *  \param  name    Scheme name
+ *  \param  empty   Empty hash table
+ *  \param  points  Points
+ *  \param  rounds  Number of runs
+ */
+template <class Table>
+static void run(
+    bench::report & out, const char * name, const Table & empty,
+    const std::vector<point_t> & points, unsigned rounds)
+{
+    double vote_ns = 0, hit_ns = 0, miss_ns = 0;
+    size_t items = 0;
+
+    for (unsigned r = 0; r < rounds; ++r) {
+        Table tab(empty);
+
+        bench::stopwatch sw;
+        for (size_t i = 0; i < points.size(); ++i) ++tab[points[i]].count;
+        bench::best(vote_ns, sw.ns_per_op(points.size()), r);
+
+        size_t hits = 0;
+        sw.restart();
+        for (size_t i = 0; i < points.size(); ++i)
+            hits += tab.exists(points[i]);
+        bench::best(hit_ns, sw.ns_per_op(points.size()), r);
+
+        size_t misses = 0;
+        sw.restart();
+        for (size_t i = 0; i < points.size(); ++i) {
+            const point_t miss = {{points[i][0], points[i][1] + (1 << 20)}};
+            misses += !tab.exists(miss);
+        }
+        bench::best(miss_ns, sw.ns_per_op(points.size()), r);
+
+        if (hits != points.size() || misses != points.size())
+            throw std::logic_error("lookup failure");
+
+        items = tab.item_cnt();
+    }
+
+    out(name, empty.size(), items, vote_ns, hit_ns, miss_ns);
+}
+
+
+/**
+ *  \brief  Run batch operations benchmark
+ *
+ *  Same as \ref run, using batch (prefetching) operations
+ *  (miss time is not measured, reported as 0).
+ *
+ *  \param  out     Report
+ *  \param  name    Scheme name
+ *  \param  empty   Empty hash table
+ *  \param  points  Points
+ *  \param  rounds  Number of runs
+ */
+template <class Table>
+static void run_batch(
+    bench::report & out, const char * name, const Table & empty,
+    const std::vector<point_t> & points, unsigned rounds)
+{
+    double vote_ns = 0, hit_ns = 0;
+    size_t items = 0;
+
+    const std::vector<unsigned> votes(points.size(), 1);
+    std::vector<ssize_t> index(points.size());
+
+    for (unsigned r = 0; r < rounds; ++r) {
+        Table tab(empty);
+
+        bench::stopwatch sw;
+        tab.add_batch(points.begin(), points.end(), votes.begin(),
+            &cell::count);
+        bench::best(vote_ns, sw.ns_per_op(points.size()), r);
+
+        sw.restart();
+        tab.find_batch(points.begin(), points.end(), index.begin());
+        bench::best(hit_ns, sw.ns_per_op(points.size()), r);
+
+        if (index.end() != std::find(index.begin(), index.end(), -1))
+            throw std::logic_error("lookup failure");
+
+        items = tab.item_cnt();
+    }
+
+    out(name, empty.size(), items, vote_ns, hit_ns, 0);
+}
+
+
+/**
+ *  \brief  Benchmark
+ *
+ *  Usage: \c hash [--csv|--json] [votes] [rounds]
+ */
+static int main_impl(int argc, char * const argv[]) {
+    const bench::args args(argc, argv);
+
+    const size_t   n      = args.integer(0, 1000000);  // number of votes
+    const unsigned rounds = args.integer(1, 5);        // number of runs
+
+    // Pseudo-random points (clustered in a box, like accumulator cells)
+    std::vector<point_t> points;
+    points.reserve(n);
+    bench::random rand;
+    for (size_t i = 0; i < n; ++i) {
+        const point_t p = {{rand.uniform(-512, 512), rand.uniform(-512, 512)}};
+        points.push_back(p);
+    }
+
+    bench::report out(args.format(), "hash",
+        {"scheme", "size", "items", "vote_ns", "hit_ns", "miss_ns"});
+
+    const size_t size = 2 * n;
+
+    // Modular scheme (odd size)
+    const modular_tab_t mod_tab(size | 1,
+        {modular_chain_t(1, 2)}, 0.85 * size);
+    run(out, "modular", mod_tab, points, rounds);
+
+    // Power-of-2 masking
+    const mask_tab_t mask_tab(libaccl::hash::pow2(size),
+        {mask_chain_t(1, 2)}, 0.85 * size);
+    run(out, "mask", mask_tab, points, rounds);
+
+    // Power-of-2 masking, batch operations
+    run_batch(out, "mask batch", mask_tab, points, rounds);
+
+    return 0;
+}
+
+/** Benchmark exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,239 @@
+/**
+ *  \file
+ *  \brief  Hash table benchmark (load factor and hash function count)
+ *
+ *  For each number of hash functions and load factor, the table is filled
+ *  with unique keys; insertion, search (hit) and miss times are reported
+ *  together with the items' probe lengths (histogram) and the longest
+ *  cluster (see \ref libaccl::hash::linear::snapshot).
+ *
+ *  \date   2016/01/16
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "bench.hxx"
+
+#include <libaccl/hash/linear.hxx>
+#include <libaccl/hash/chain.hxx>
+#include <libaccl/hash/mix.hxx>
+
+#include <array>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+
+typedef std::array<int, 2> point_t;  /**< Key (2D accumulator cell) */
+
+typedef libaccl::hash::point_hash<point_t> hash_fn_t;  /**< Hash function */
+
+/** Hash function seeds */
+static const uint64_t seeds[] = { 1, 2, 3 };
+
+/** Chain of 1 hash function */
+typedef libaccl::hash::chain<hash_fn_t> chain1_t;
+
+/** Chain of 2 hash functions */
+typedef libaccl::hash::chain<hash_fn_t, hash_fn_t> chain2_t;
+
+/** Chain of 3 hash functions */
+typedef libaccl::hash::chain<hash_fn_t, hash_fn_t, hash_fn_t> chain3_t;
+
+/** Hash chains (of \c seeds) */
+static chain1_t make_chain(chain1_t *) {
+    return chain1_t(seeds[0]);
+}
+
+/** Hash chains (of \c seeds) */
+static chain2_t make_chain(chain2_t *) {
+    return chain2_t(seeds[0], seeds[1]);
+}
+
+/** Hash chains (of \c seeds) */
+static chain3_t make_chain(chain3_t *) {
+    return chain3_t(seeds[0], seeds[1], seeds[2]);
+}
+
+
+/**
+ *  \brief  Run benchmark
+ *
+ *  Inserts keys to an empty table (up to the load factor), then looks up
+ *  the present and absent ones; best of \c rounds runs is reported.
+ *
+ *  \tparam Chain   Hash functions chain
+ *  \param  out     Report
+ *  \param  size    Table size
+ *  \param  load    Load factor
+ *  \param  keys    Unique keys (at least \c load * \c size)
+ *  \param  misses  Absent keys
+ *  \param  rounds  Number of runs
+ */
+template <class Chain>
+static void run(
+    bench::report              & out,
+    size_t                       size,
+    double                       load,
+    const std::vector<point_t> & keys,
+    const std::vector<point_t> & misses,
+    unsigned                     rounds)
+{
+    typedef libaccl::hash::linear<point_t, Chain> table_t;
+
+    const size_t hashes = Chain::size;
+    const size_t n = load * size;
+    if (n > keys.size())
+        throw std::logic_error("not enough keys");
+
+    double insert_ns = 0, hit_ns = 0, miss_ns = 0;
+    libaccl::hash::stats::snapshot snap;
+
+    for (unsigned r = 0; r < rounds; ++r) {
+        table_t tab(size, {make_chain((Chain *)NULL)}, n);
+
+        bench::stopwatch sw;
+        for (size_t i = 0; i < n; ++i)
+            if (0 > tab.insert(keys[i]))
+                throw std::logic_error("insertion failure");
+        bench::best(insert_ns, sw.ns_per_op(n), r);
+
+        size_t hits = 0;
+        sw.restart();
+        for (size_t i = 0; i < n; ++i) hits += tab.exists(keys[i]);
+        bench::best(hit_ns, sw.ns_per_op(n), r);
+
+        size_t absent = 0;
+        sw.restart();
+        for (size_t i = 0; i < misses.size(); ++i)
+            absent += !tab.exists(misses[i]);
+        bench::best(miss_ns, sw.ns_per_op(misses.size()), r);
+
+        if (hits != n || absent != misses.size())
+            throw std::logic_error("lookup failure");
+
+        snap = tab.snapshot();  // the same in each run
+    }
+
+    // Probe length histogram ("length:count" pairs)
+    std::ostringstream hist;
+    for (size_t len = 1; len < snap.probe_hist.size(); ++len)
+        if (snap.probe_hist[len])
+            hist << (hist.tellp() ? " " : "")
+                 << len << ':' << snap.probe_hist[len];
+
+    out(hashes, load, size, n, insert_ns, hit_ns, miss_ns,
+        snap.mean_probe(), snap.max_probe, snap.longest_run, hist.str());
+}
+
+
+/**
+ *  \brief  Benchmark
+ *
+ *  Usage: \c hash_load [--csv|--json] [log2(size)] [rounds]
+ */
+static int main_impl(int argc, char * const argv[]) {
+    const bench::args args(argc, argv);
+
+    const size_t   size   = (size_t)1 << args.integer(0, 20);  // table size
+    const unsigned rounds = args.integer(1, 5);                // runs
+
+    // Unique pseudo-random keys (and absent ones)
+    std::vector<point_t> keys;
+    keys.reserve(size);
+    bench::random rand;
+    while (keys.size() < size) {
+        for (size_t i = keys.size(); i < size; ++i) {
+            const point_t p = {{
+                rand.uniform(-(1 << 20), 1 << 20),
+                rand.uniform(-(1 << 20), 1 << 20)}};
+            keys.push_back(p);
+        }
+
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+
+    // Insertion order shouldn't be sorted
+    for (size_t i = keys.size() - 1; i > 0; --i)
+        std::swap(keys[i], keys[rand.uniform(0, i + 1)]);
+
+    std::vector<point_t> misses;
+    misses.reserve(size / 4);
+    for (size_t i = 0; i < size / 4; ++i) {
+        const point_t p = {{keys[i][0], keys[i][1] + (1 << 22)}};
+        misses.push_back(p);
+    }
+
+    bench::report out(args.format(), "hash_load",
+        {"hashes", "load", "size", "items", "insert_ns", "hit_ns", "miss_ns",
+         "probe_mean", "probe_max", "longest_run", "probe_hist"});
+
+    const double loads[] = { 0.5, 0.6, 0.7, 0.8, 0.85, 0.9, 0.95 };
+    for (size_t i = 0; i < sizeof(loads) / sizeof(loads[0]); ++i) {
+        run<chain1_t>(out, size, loads[i], keys, misses, rounds);
+        run<chain2_t>(out, size, loads[i], keys, misses, rounds);
+        run<chain3_t>(out, size, loads[i], keys, misses, rounds);
+    }
+
+    return 0;
+}
+/** Benchmark exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
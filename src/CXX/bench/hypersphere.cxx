@@ -0,0 +1,162 @@
+/**
+ *  \file
+ *  \brief  Hypersphere pattern benchmark (construction vs dimension and radius)
+ *
+ *  Reports construction time, number of points and memory taken
+ *  by the pattern for runtime and compile-time dimension, sequential
+ *  and parallel construction.
+ *
+ *  \date   2016/01/16
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "bench.hxx"
+
+#include <libaccl/pattern/hypersphere.hxx>
+
+#include <vector>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+
+
+/**
+ *  \brief  Run benchmark
+ *
+ *  Best of \c rounds constructions is reported.
+ *
+ *  \tparam Make    Pattern factory type
+ *  \param  out     Report
+ *  \param  name    Variant name
+ *  \param  dim     Space dimension
+ *  \param  radius  Hypersphere radius
+ *  \param  rounds  Number of runs
+ *  \param  make    Pattern factory
+ */
+template <class Make>
+static void run(
+    bench::report & out, const char * name, size_t dim, int radius,
+    unsigned rounds, Make make)
+{
+    double build_us = 0;
+    size_t points = 0, memory = 0;
+
+    for (unsigned r = 0; r < rounds; ++r) {
+        bench::stopwatch sw;
+        const auto sphere = make();
+        bench::best(build_us, sw.ns() / 1000, r);
+
+        points = sphere.size();
+        memory = sphere.memory();
+    }
+
+    out(name, dim, radius, points, memory, build_us,
+        points ? build_us * 1000 / points : 0);
+}
+
+
+/**
+ *  \brief  Benchmark
+ *
+ *  Usage: \c hypersphere [--csv|--json] [max. radius] [rounds] [threads]
+ *
+ *  Radii are powers of 2 up to the max. radius (halved for each dimension
+ *  above 3 so that the run time stays reasonable).
+ */
+static int main_impl(int argc, char * const argv[]) {
+    const bench::args args(argc, argv);
+
+    const int      max_r   = args.integer(0, 64);  // max. radius
+    const unsigned rounds  = args.integer(1, 3);   // number of runs
+    const unsigned threads = args.integer(2, 0);   // threads (0 = all)
+
+    bench::report out(args.format(), "hypersphere",
+        {"variant", "dimension", "radius", "points", "memory",
+         "build_us", "ns_per_point"});
+
+    for (size_t dim = 2; dim <= 5; ++dim) {
+        const int limit = dim > 3 ? max_r >> (dim - 3) : max_r;
+
+        for (int radius = 4; radius <= limit; radius <<= 1) {
+            const std::vector<int> layers = {radius};
+
+            run(out, "runtime", dim, radius, rounds, [dim, &layers]() {
+                return libaccl::pattern::hypersphere<int>(dim, layers);
+            });
+
+            run(out, "parallel", dim, radius, rounds,
+            [dim, &layers, threads]() {
+                return libaccl::pattern::hypersphere<int>(
+                    dim, layers, threads);
+            });
+
+            // Compile-time dimension
+            if (2 == dim)
+                run(out, "static", dim, radius, rounds, [&layers]() {
+                    return libaccl::pattern::hypersphere<int, 2>(layers);
+                });
+
+            else if (3 == dim)
+                run(out, "static", dim, radius, rounds, [&layers]() {
+                    return libaccl::pattern::hypersphere<int, 3>(layers);
+                });
+        }
+    }
+
+    return 0;
+}
+/** Benchmark exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,564 @@
+#ifndef libaccl__accumulator_hxx
+#define libaccl__accumulator_hxx
+
+/**
+ *  \file
+ *  \brief  Accumulator
+ *
+ *  Samples in N-dimensional discrete Euclidean space are convolved
+ *  with a pattern (kernel); each sample votes for cells at the kernel
+ *  point offsets (with the kernel point weight).
+ *  Clusters are then found as peaks in the accumulator.
+ *
+ *  \date   2016/01/04
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/pattern/points.hxx"
+#include "libaccl/pattern/kernel.hxx"
+#include "libaccl/backend/sparse.hxx"
+#include "libaccl/parallel.hxx"
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdlib>
+
+
+namespace libaccl {
+
+namespace impl {
+
+/**
+ *  \brief  Neighbourhood offsets
+ *
+ *  The (3^N - 1) offsets of direct neighbours of a cell (row-major),
+ *  lexicographically ordered (so the 1st half of them precedes the cell).
+ *  The offsets are computed once per dimension and cached.
+ *
+ *  \param  dimension  Space dimension
+ *
+ *  \return Neighbourhood offsets
+ */
+template <typename Base_t>
+const std::vector<Base_t> & neighbourhood(size_t dimension) {
+    static std::mutex mutex;
+    static std::map<size_t, std::vector<Base_t> > cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<Base_t> & offsets = cache[dimension];
+    if (!offsets.empty() || !dimension) return offsets;
+
+    std::vector<Base_t> offset(dimension, -1);
+    for (;;) {
+        if (std::count(offset.begin(), offset.end(), 0)
+            != (ptrdiff_t)dimension)
+        {
+            offsets.insert(offsets.end(), offset.begin(), offset.end());
+        }
+
+        size_t d = dimension;
+        for (; d > 0 && 1 == offset[d - 1]; --d) offset[d - 1] = -1;
+        if (0 == d) break;
+        ++offset[d - 1];
+    }
+
+    return offsets;
+}
+
+}  // end of namespace impl
+
+/**
+ *  \brief  Accumulator
+ *
+ *  The accumulator stores votes for cells in N-dimensional discrete space.
+ *  Votes are produced by convolution of samples with a kernel (see
+ *  \ref pattern::kernel).
+ *  The cells storage is implemented by the \c Backend; it must provide
+ *  the following:
+ *  * \c kernel_t type and constructor taking space dimension as 1st argument
+ *  * \c bind(const kernel_t & kernel) for kernel-specific precomputations
+ *  * \c vote(const Base_t * sample, const kernel_t & kernel)
+ *  * \c count(const point_t & cell) returning cell vote count
+ *  * \c for_each(fn) calling \c fn(point, count) for every cell with votes
+ *  * \c size() returning number of cells with votes
+ *  * \c concurrent static flag; \c true means that \c vote may be called
+ *    by more threads concurrently
+ *  * \c shard() returning empty backend of the same configuration
+ *    and \c merge(const Backend & other) adding votes of another backend
+ *    (only required for non-concurrent backends)
+ *  * \c prune(Count_t threshold) dropping cells with fewer votes
+ *    (optional, only required by \ref prune)
+ *  * \c add(const point_t & cell, Count_t votes) adding votes to a cell
+ *    (optional, only required by \ref vote_if)
+ *  * \c retract(const Base_t * sample, const kernel_t & kernel) removing
+ *    votes of a sample (optional, only required by \ref retract)
+ *  * \c sorted_maxima static flag; if \c false, \c slots() returning
+ *    number of storage slots and \c maxima(threshold, neighbours, begin,
+ *    end, fn) calling \c fn for local maxima in a slot range
+ *    (see \ref backend::dense::maxima); if \c true,
+ *    \c candidates(threshold, threads) returning cells with at least
+ *    \c threshold votes sorted by coordinates and \c maxima(candidates,
+ *    begin, end, fn) calling \c fn for local maxima in a candidates range
+ *    (see \ref backend::sparse::maxima; only required by \ref peaks)
+ *
+ *  \tparam  Base_t   Base numeric type (integral)
+ *  \tparam  Count_t  Vote count type
+ *  \tparam  N        Space dimension (0 means runtime)
+ *  \tparam  Backend  Cells storage (\ref backend::sparse by default,
+ *                   \ref backend::dense for bounded low-dimensional spaces,
+ *                   \ref backend::sparse_concurrent for shared parallel
+ *                   voting, \ref backend::partitioned for voting
+ *                   across processes, \ref backend::cuda for voting
+ *                   on GPU)
+ */
+template <
+    typename Base_t,
+    typename Count_t = unsigned,
+    size_t   N       = 0,
+    class    Backend = backend::sparse<Base_t, Count_t, N> >
+class accumulator {
+    public:
+
+    typedef Backend                      backend_t;  /**< Backend */
+    typedef typename Backend::kernel_t   kernel_t;   /**< Kernel  */
+    typedef typename kernel_t::point_t   point_t;    /**< Point   */
+
+    /** Accumulator peak */
+    struct peak {
+        point_t point;  /**< Cell coordinates */
+        Count_t count;  /**< Vote count       */
+
+        /** Constructor */
+        peak(const point_t & p, Count_t c): point(p), count(c) {}
+
+        /** Peaks are ordered by count (descending), then by coordinates */
+        bool operator < (const peak & rarg) const {
+            if (count != rarg.count) return count > rarg.count;
+            return point < rarg.point;
+        }
+
+    };  // end of struct peak
+
+    typedef std::vector<peak> peaks_t;  /**< Peak list */
+
+    private:
+
+    const kernel_t m_kernel;   /**< Voting kernel */
+    backend_t      m_backend;  /**< Cells storage */
+
+    /** Parallel voting (shared concurrent backend) */
+    void vote(
+        const Base_t * samples, size_t count, unsigned threads,
+        std::true_type)
+    {
+        parallel::run(threads,
+        [this, samples, count, threads](unsigned i) {
+            const auto range = parallel::chunk(count, threads, i);
+
+            for (size_t j = range.first; j < range.second; ++j)
+                m_backend.vote(samples + j * dimension(), m_kernel);
+        });
+    }
+
+    /** Parallel voting (backend shards + tree reduction) */
+    void vote(
+        const Base_t * samples, size_t count, unsigned threads,
+        std::false_type)
+    {
+        std::vector<backend_t> shards;
+        shards.reserve(threads - 1);
+        for (unsigned i = 1; i < threads; ++i)
+            shards.push_back(m_backend.shard());
+
+        auto shard = [this, &shards](size_t i) -> backend_t & {
+            return i ? shards[i - 1] : m_backend;
+        };
+
+        // Voting
+        parallel::run(threads,
+        [this, samples, count, threads, &shard](unsigned i) {
+            const auto range = parallel::chunk(count, threads, i);
+            backend_t & backend = shard(i);
+
+            for (size_t j = range.first; j < range.second; ++j)
+                backend.vote(samples + j * dimension(), m_kernel);
+        });
+
+        // Tree reduction
+        for (size_t step = 1; step < threads; step <<= 1) {
+            const size_t pairs = (threads - step + 2 * step - 1) / (2 * step);
+
+            parallel::run(pairs, [step, &shard](unsigned i) {
+                const size_t dst = 2 * step * i;
+                shard(dst).merge(shard(dst + step));
+            });
+        }
+    }
+
+    /** Peaks collector (keeps top peaks in heap, the worst one on top) */
+    struct top_peaks {
+        peaks_t & peaks;  /**< Peaks                              */
+        size_t    top;    /**< Max. number of peaks (0 means all) */
+
+        /** Add peak */
+        void operator () (const point_t & point, Count_t count) const {
+            peaks.emplace_back(point, count);
+
+            if (top) {
+                std::push_heap(peaks.begin(), peaks.end());
+                if (peaks.size() > top) {
+                    std::pop_heap(peaks.begin(), peaks.end());
+                    peaks.pop_back();
+                }
+            }
+        }
+
+    };  // end of struct top_peaks
+
+    /**
+     *  \brief  Peaks of ranges, one range per thread
+     *
+     *  \param  size     Ranges total size
+     *  \param  top      Max. number of peaks (0 means all)
+     *  \param  threads  Thread count
+     *  \param  maxima   Function calling \ref top_peaks (3rd argument)
+     *                   for local maxima in range [1st, 2nd argument)
+     *
+     *  \return Peaks, ordered by vote count (descending)
+     */
+    template <class Maxima>
+    static peaks_t peaks(
+        size_t size, size_t top, unsigned threads, Maxima maxima)
+    {
+        threads = parallel::thread_cnt(threads);
+        if (threads > size) threads = size ? size : 1;
+
+        std::vector<peaks_t> parts(threads);
+        parallel::run(threads,
+        [top, threads, size, &maxima, &parts](unsigned i) {
+            const auto range = parallel::chunk(size, threads, i);
+            maxima(range.first, range.second, top_peaks{parts[i], top});
+        });
+
+        peaks_t peaks(std::move(parts[0]));
+        for (size_t i = 1; i < parts.size(); ++i)
+            peaks.insert(peaks.end(),
+                std::make_move_iterator(parts[i].begin()),
+                std::make_move_iterator(parts[i].end()));
+
+        if (top && top < peaks.size()) {
+            std::nth_element(peaks.begin(), peaks.begin() + top, peaks.end());
+            peaks.erase(peaks.begin() + top, peaks.end());
+        }
+
+        std::sort(peaks.begin(), peaks.end());
+
+        return peaks;
+    }
+
+    /** Find peaks (in backend slot ranges, by neighbour lookups) */
+    peaks_t peaks(
+        Count_t threshold, size_t top, unsigned threads,
+        std::false_type) const
+    {
+        const std::vector<Base_t> & neighbours =
+            impl::neighbourhood<Base_t>(dimension());
+
+        return peaks(m_backend.slots(), top, threads,
+        [this, threshold, &neighbours](size_t begin, size_t end,
+            const top_peaks & fn)
+        {
+            m_backend.maxima(threshold, neighbours, begin, end, fn);
+        });
+    }
+
+    /** Find peaks (in ranges of sorted candidate cells) */
+    peaks_t peaks(
+        Count_t threshold, size_t top, unsigned threads,
+        std::true_type) const
+    {
+        const auto cells = m_backend.candidates(threshold, threads);
+
+        return peaks(cells.size(), top, threads,
+        [this, &cells](size_t begin, size_t end,
+            const top_peaks & fn)
+        {
+            m_backend.maxima(cells, begin, end, fn);
+        });
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \tparam Backend_args  Backend constructor argument types
+     *  \param  kernel        Voting kernel
+     *  \param  backend_args  Backend constructor arguments (after dimension)
+     */
+    template <typename... Backend_args>
+    accumulator(
+        const kernel_t &  kernel,
+        Backend_args...   backend_args)
+    :
+        m_kernel  ( kernel                                ),
+        m_backend ( kernel.dimension(), backend_args...   )
+    {
+        m_backend.bind(m_kernel);
+    }
+
+    /**
+     *  \brief  Copy constructor
+     *
+     *  The backend is bound to the copy of the kernel (the bound kernel
+     *  of the original goes away with it).
+     *
+     *  \param  orig  Original accumulator
+     */
+    accumulator(const accumulator & orig):
+        m_kernel  ( orig.m_kernel  ),
+        m_backend ( orig.m_backend )
+    {
+        m_backend.bind(m_kernel);
+    }
+
+    /**
+     *  \brief  Move constructor
+     *
+     *  See the copy constructor.
+     *
+     *  \param  orig  Original accumulator
+     */
+    accumulator(accumulator && orig):
+        m_kernel  ( orig.m_kernel             ),
+        m_backend ( std::move(orig.m_backend) )
+    {
+        m_backend.bind(m_kernel);
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return m_kernel.dimension(); }
+
+    /** Voting kernel */
+    const kernel_t & kernel() const { return m_kernel; }
+
+    /** Backend */
+    const backend_t & backend() const { return m_backend; }
+
+    /** Backend (e.g. for exchange of \ref backend::partitioned batches) */
+    backend_t & backend() { return m_backend; }
+
+    /** Number of cells with votes */
+    size_t size() const { return m_backend.size(); }
+
+    /**
+     *  \brief  Vote for sample
+     *
+     *  \param  sample  Sample coordinates
+     */
+    void vote(const point_t & sample) {
+        if (sample.size() != dimension())
+            throw std::logic_error(
+                "libaccl::accumulator::vote: "
+                "sample dimension mismatch");
+
+        m_backend.vote(sample.data(), m_kernel);
+    }
+
+    /**
+     *  \brief  Vote for batch of samples
+     *
+     *  \param  samples  Sample coordinates (row-major, \ref dimension stride)
+     *  \param  count    Number of samples
+     */
+    void vote(const Base_t * samples, size_t count) {
+        for (size_t i = 0; i < count; ++i, samples += dimension())
+            m_backend.vote(samples, m_kernel);
+    }
+
+    /**
+     *  \brief  Vote for batch of samples in parallel
+     *
+     *  Samples are split to contiguous chunks, one per thread.
+     *
+     *  Concurrent backends (see \ref backend::sparse_concurrent) are shared
+     *  by all the threads.
+     *
+     *  Otherwise, each thread votes to its private backend shard (the 1st one
+     *  votes directly to the accumulator), so no locking takes place.
+     *  The shards are then merged by parallel tree reduction
+     *  (log2(threads) rounds of pairwise merges).
+     *  Note that each shard takes as much memory as the accumulator
+     *  backend (use the same table size for sparse backends).
+     *
+     *  \param  samples  Sample coordinates (row-major, \ref dimension stride)
+     *  \param  count    Number of samples
+     *  \param  threads  Thread count (0 means hardware concurrency)
+     */
+    void vote(const Base_t * samples, size_t count, unsigned threads) {
+        threads = parallel::thread_cnt(threads);
+        if (threads > count) threads = count ? count : 1;
+
+        if (1 == threads) {
+            vote(samples, count);
+            return;
+        }
+
+        vote(samples, count, threads,
+            std::integral_constant<bool, backend_t::concurrent>());
+    }
+
+    /**
+     *  \brief  Vote for sample, filtered
+     *
+     *  Only kernel image cells accepted by \c filter get the votes
+     *  (so that votes may be limited to a region of interest).
+     *
+     *  \param  sample  Sample coordinates
+     *  \param  filter  Filter, called with cell coordinates
+     *
+     *  \return Number of cells which got votes
+     */
+    template <class Filter>
+    size_t vote_if(const Base_t * sample, Filter filter) {
+        const size_t dim = dimension();
+        point_t cell = pattern::impl::point_type<Base_t, N>::zero(dim);
+
+        size_t voted = 0;
+        for (size_t i = 0; i < m_kernel.size(); ++i) {
+            const Base_t * offset = m_kernel.offset(i);
+            for (size_t d = 0; d < dim; ++d)
+                cell[d] = sample[d] + offset[d];
+
+            if (filter(static_cast<const point_t &>(cell))) {
+                m_backend.add(cell, m_kernel.weight(i));
+                ++voted;
+            }
+        }
+
+        return voted;
+    }
+
+    /**
+     *  \brief  Retract votes of sample (voted before)
+     *
+     *  \param  sample  Sample coordinates
+     */
+    void retract(const point_t & sample) {
+        if (sample.size() != dimension())
+            throw std::logic_error(
+                "libaccl::accumulator::retract: "
+                "sample dimension mismatch");
+
+        m_backend.retract(sample.data(), m_kernel);
+    }
+
+    /**
+     *  \brief  Vote for range of samples
+     *
+     *  \param  begin  Samples begin iterator
+     *  \param  end    Samples end iterator
+     */
+    template <class Iter>
+    void vote(Iter begin, Iter end) {
+        for (; begin != end; ++begin) vote(*begin);
+    }
+
+    /**
+     *  \brief  Cell vote count
+     *
+     *  \param  point  Cell coordinates
+     *
+     *  \return Number of votes for the cell
+     */
+    Count_t count(const point_t & point) const {
+        return m_backend.count(point);
+    }
+
+    /**
+     *  \brief  Call function for every cell with votes
+     *
+     *  \param  fn  Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(Fn fn) const { m_backend.for_each(fn); }
+
+    /**
+     *  \brief  Drop cells with too few votes (e.g. between voting passes)
+     *
+     *  \param  threshold  Minimal vote count of a cell to keep
+     */
+    void prune(Count_t threshold) { m_backend.prune(threshold); }
+
+    /**
+     *  \brief  Find peaks
+     *
+     *  A peak is a cell with at least \c threshold votes and no fewer votes
+     *  than any of its (3^N - 1) direct neighbours.
+     *  Of neighbour cells with equal count, the lexicographically lowest one
+     *  is the peak.
+     *
+     *  Cells under the threshold are skipped before the neighbourhood
+     *  is checked (non-maximum suppression).
+     *  The backend storage is split to slot ranges (dense array chunks),
+     *  or, for sparse backends, the cells over the threshold are sorted
+     *  and split to ranges; neighbourhoods are then checked by a sweep
+     *  of the sorted cells rather than by table lookups.
+     *  Each thread checks one range and keeps (up to) \c top best peaks
+     *  of it, the partial results are then merged.
+     *
+     *  \param  threshold  Minimal vote count
+     *  \param  top        Max. number of peaks (0 means all)
+     *  \param  threads    Thread count (0 means hardware concurrency)
+     *
+     *  \return Peaks, ordered by vote count (descending)
+     */
+    peaks_t peaks(Count_t threshold, size_t top = 0, unsigned threads = 1)
+        const
+    {
+        return peaks(threshold, top, threads,
+            std::integral_constant<bool, backend_t::sorted_maxima>());
+    }
+
+};  // end of template class accumulator
+
+}  // end of namespace libaccl
+
+#endif  // end of #ifndef libaccl__accumulator_hxx
@@ -0,0 +1,246 @@
+#ifndef libaccl__arena_hxx
+#define libaccl__arena_hxx
+
+/**
+ *  \file
+ *  \brief  Monotonic arena and allocator
+ *
+ *  Containers built in bulk and released as a whole (e.g. patterns
+ *  built for many radii) may draw their memory from an arena instead
+ *  of the heap.
+ *
+ *  \date   2016/01/11
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <utility>
+#include <new>
+#include <limits>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+namespace arena {
+
+/**
+ *  \brief  Monotonic arena
+ *
+ *  Memory is handed out from large blocks by bumping a pointer;
+ *  it is never freed individually, but all at once by \ref release
+ *  (or \ref rewind, or destruction).
+ *  Block sizes grow geometrically, so that even an arena started small
+ *  ends up with a few blocks.
+ *  The arena is NOT thread-safe.
+ */
+class monotonic {
+    private:
+
+    typedef std::pair<char *, size_t> block_t;  /**< Block (address, size) */
+
+    std::vector<block_t> m_blocks;  /**< Blocks                */
+    size_t               m_next;    /**< Next block size       */
+    char *               m_ptr;     /**< Free space            */
+    size_t               m_left;    /**< Free space size       */
+    size_t               m_used;    /**< Bytes handed out      */
+
+    /** Allocate new block (at least \c size bytes) */
+    void new_block(size_t size) {
+        if (size < m_next) size = m_next;
+
+        m_blocks.reserve(m_blocks.size() + 1);  // don't leak the block
+        m_ptr  = (char *)::operator new(size);
+        m_left = size;
+        m_blocks.push_back(block_t(m_ptr, size));
+
+        m_next = 2 * size;
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  block_size  Initial block size (allocated on 1st demand)
+     */
+    monotonic(size_t block_size = 65536):
+        m_next ( block_size ? block_size : 1 ),
+        m_ptr  ( NULL                        ),
+        m_left ( 0                           ),
+        m_used ( 0                           )
+    {}
+
+    monotonic(const monotonic & ) = delete;
+    monotonic & operator = (const monotonic & ) = delete;
+
+    /** Destructor (releases all memory) */
+    ~monotonic() { release(); }
+
+    /**
+     *  \brief  Allocate memory
+     *
+     *  \param  size   Size
+     *  \param  align  Alignment (power of 2)
+     *
+     *  \return Memory
+     */
+    void * allocate(size_t size, size_t align) {
+        size_t pad = -(uintptr_t)m_ptr & (align - 1);
+
+        if (!m_ptr || pad + size > m_left) {
+            new_block(size + align);
+            pad = -(uintptr_t)m_ptr & (align - 1);
+        }
+
+        void * mem = m_ptr + pad;
+        m_ptr  += pad + size;
+        m_left -= pad + size;
+        m_used += size;
+
+        return mem;
+    }
+
+    /**
+     *  \brief  Release memory (but a single block)
+     *
+     *  All memory handed out is released; one block is kept for reuse.
+     *  Multiple blocks are replaced by a single one at least as large
+     *  as all of them, so that repeated builds of similar size
+     *  don't allocate any more.
+     */
+    void rewind() {
+        if (m_blocks.empty()) return;
+
+        if (m_blocks.size() > 1) {
+            const size_t size = this->size();
+            release();
+            new_block(size);
+            return;
+        }
+
+        m_ptr  = m_blocks.back().first;
+        m_left = m_blocks.back().second;
+        m_used = 0;
+    }
+
+    /** Release all memory */
+    void release() {
+        for (size_t i = 0; i < m_blocks.size(); ++i)
+            ::operator delete(m_blocks[i].first);
+
+        m_blocks.clear();
+        m_ptr  = NULL;
+        m_left = 0;
+        m_used = 0;
+    }
+
+    /** Number of blocks */
+    size_t blocks() const { return m_blocks.size(); }
+
+    /** Bytes allocated (in blocks) */
+    size_t size() const {
+        size_t size = 0;
+        for (size_t i = 0; i < m_blocks.size(); ++i)
+            size += m_blocks[i].second;
+
+        return size;
+    }
+
+    /** Bytes handed out */
+    size_t used() const { return m_used; }
+
+};  // end of class monotonic
+
+
+/**
+ *  \brief  Arena allocator
+ *
+ *  Standard allocator drawing memory from \ref monotonic arena.
+ *  Deallocation is no-op; the memory is released with the arena
+ *  (which must outlive the containers using it).
+ *
+ *  \tparam  T  Value type
+ */
+template <typename T>
+class allocator {
+    template <typename U> friend class allocator;
+
+    private:
+
+    monotonic * m_arena;  /**< Arena */
+
+    public:
+
+    typedef T value_type;  /**< Value type */
+
+    /** Constructor */
+    allocator(monotonic & arena): m_arena(&arena) {}
+
+    /** Rebinding constructor */
+    template <typename U>
+    allocator(const allocator<U> & orig): m_arena(orig.m_arena) {}
+
+    /** Arena */
+    monotonic & arena() const { return *m_arena; }
+
+    /** Allocate \c n values */
+    T * allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_alloc();
+
+        return (T *)m_arena->allocate(n * sizeof(T), alignof(T));
+    }
+
+    /** Deallocate (no-op) */
+    void deallocate(T * , size_t ) {}
+
+    /** Comparison (allocators of the same arena are equal) */
+    template <typename U>
+    bool operator == (const allocator<U> & rarg) const {
+        return m_arena == rarg.m_arena;
+    }
+
+    /** Comparison */
+    template <typename U>
+    bool operator != (const allocator<U> & rarg) const {
+        return !(*this == rarg);
+    }
+
+};  // end of template class allocator
+
+}}  // end of namespace libaccl::arena
+
+#endif  // end of #ifndef libaccl__arena_hxx
@@ -0,0 +1,465 @@
+/**
+ *  \file
+ *  \brief  Dense accumulator backend (CUDA device code)
+ *
+ *  \date   2016/01/19
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/backend/cuda.hxx"
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+
+#include <cuda_runtime.h>
+
+
+namespace libaccl {
+namespace backend {
+namespace impl {
+namespace cuda {
+
+namespace {
+
+/** Threads per block */
+const unsigned BLOCK_THREADS = 256;
+
+/** Max. number of blocks (grid-stride loops do the rest) */
+const unsigned GRID_BLOCKS = 4096;
+
+/** Check CUDA call result */
+void check(cudaError_t status, const char * fn) {
+    if (cudaSuccess == status) return;
+
+    throw std::runtime_error(
+        std::string("libaccl::backend::cuda::") + fn + ": " +
+        cudaGetErrorString(status));
+}
+
+/** Number of blocks for given amount of work */
+unsigned blocks(uint64_t work) {
+    const uint64_t b = (work + BLOCK_THREADS - 1) / BLOCK_THREADS;
+    return b < GRID_BLOCKS ? (b ? (unsigned)b : 1) : GRID_BLOCKS;
+}
+
+/** Box (passed to device code by value) */
+struct box {
+    int32_t  lo[MAX_DIMENSION];      /**< Lower corner   */
+    int32_t  hi[MAX_DIMENSION];      /**< Upper corner   */
+    uint64_t stride[MAX_DIMENSION];  /**< Array strides  */
+    unsigned dimension;              /**< Dimension      */
+    uint64_t size;                   /**< Number of cells */
+};  // end of struct box
+
+/**
+ *  \brief  Voting
+ *
+ *  A thread per (sample, kernel point) pair; threads of a warp mostly
+ *  vote for the same sample (consecutive kernel points), so kernel
+ *  reads are coalesced and samples are broadcast.
+ */
+__global__ void vote_kernel(
+    box              b,
+    uint32_t *       cells,
+    const int32_t *  offsets,
+    const uint32_t * weights,
+    uint64_t         kernel_size,
+    const int32_t *  samples,
+    uint64_t         sample_cnt)
+{
+    const uint64_t work = sample_cnt * kernel_size;
+    for (uint64_t i = blockIdx.x * (uint64_t)blockDim.x + threadIdx.x;
+        i < work; i += (uint64_t)gridDim.x * blockDim.x)
+    {
+        const uint64_t s = i / kernel_size;
+        const uint64_t k = i % kernel_size;
+
+        uint64_t ix = 0;
+        bool inside = true;
+        for (unsigned d = 0; d < b.dimension; ++d) {
+            const int32_t x =
+                samples[s * b.dimension + d] + offsets[k * b.dimension + d];
+
+            inside = inside && b.lo[d] <= x && x <= b.hi[d];
+            ix += (uint64_t)(x - b.lo[d]) * b.stride[d];
+        }
+
+        if (inside) atomicAdd(cells + ix, weights[k]);
+    }
+}
+
+/** Single cell addition */
+__global__ void add_kernel(uint32_t * cells, uint64_t index, uint32_t votes) {
+    cells[index] += votes;
+}
+
+/** Cells addition */
+__global__ void merge_kernel(
+    uint32_t * cells, const uint32_t * other, uint64_t size)
+{
+    for (uint64_t i = blockIdx.x * (uint64_t)blockDim.x + threadIdx.x;
+        i < size; i += (uint64_t)gridDim.x * blockDim.x)
+    {
+        cells[i] += other[i];
+    }
+}
+
+/** Pruning */
+__global__ void prune_kernel(uint32_t * cells, uint64_t size, uint32_t threshold) {
+    for (uint64_t i = blockIdx.x * (uint64_t)blockDim.x + threadIdx.x;
+        i < size; i += (uint64_t)gridDim.x * blockDim.x)
+    {
+        if (cells[i] < threshold) cells[i] = 0;
+    }
+}
+
+/**
+ *  \brief  Peak extraction
+ *
+ *  A thread per cell; neighbours are enumerated as base-3 numbers
+ *  (digit - 1 is the offset, the 1st dimension is the most significant),
+ *  i.e. in lexicographic order, so those under the cell itself
+ *  are the lower ones (see \ref dense::maxima).
+ *  Peaks are appended to the output by atomic counter; those over
+ *  the capacity are only counted.
+ */
+__global__ void peaks_kernel(
+    box              b,
+    const uint32_t * cells,
+    uint32_t         threshold,
+    uint64_t *       peak_ix,
+    uint32_t *       peak_cnt,
+    unsigned long long * found,
+    uint64_t         capacity)
+{
+    unsigned neighbourhood = 1;
+    for (unsigned d = 0; d < b.dimension; ++d) neighbourhood *= 3;
+    const unsigned self = neighbourhood / 2;
+
+    for (uint64_t i = blockIdx.x * (uint64_t)blockDim.x + threadIdx.x;
+        i < b.size; i += (uint64_t)gridDim.x * blockDim.x)
+    {
+        const uint32_t count = cells[i];
+        if (0 == count || count < threshold) continue;
+
+        int32_t x[MAX_DIMENSION];
+        uint64_t rest = i;
+        for (unsigned d = 0; d < b.dimension; ++d) {
+            x[d] = b.lo[d] + (int32_t)(rest / b.stride[d]);
+            rest %= b.stride[d];
+        }
+
+        bool peak = true;
+        for (unsigned k = 0; k < neighbourhood && peak; ++k) {
+            if (self == k) continue;
+
+            int64_t n_ix = 0;
+            bool inside = true;
+            for (unsigned d = 0, digits = k, pow = neighbourhood / 3;
+                d < b.dimension; ++d, pow /= 3)
+            {
+                const int32_t n = x[d] + (int32_t)(digits / pow) - 1;
+                digits %= pow;
+
+                inside = inside && b.lo[d] <= n && n <= b.hi[d];
+                n_ix += (int64_t)(n - b.lo[d]) * (int64_t)b.stride[d];
+            }
+
+            const uint32_t n_count = inside ? cells[n_ix] : 0;
+            peak = n_count < count || (n_count == count && self < k);
+        }
+
+        if (!peak) continue;
+
+        const unsigned long long slot = atomicAdd(found, 1ULL);
+        if (slot < capacity) {
+            peak_ix[slot]  = i;
+            peak_cnt[slot] = count;
+        }
+    }
+}
+
+}  // end of anonymous namespace
+
+
+/** Device grid */
+struct grid {
+    box          b;                /**< Box                        */
+    uint32_t *   cells;            /**< Cells                      */
+    int32_t *    offsets;          /**< Kernel offsets             */
+    uint32_t *   weights;          /**< Kernel weights             */
+    uint64_t     kernel_size;      /**< Kernel size                */
+    size_t       batch;            /**< Samples batch size         */
+    int32_t *    staging[2];       /**< Pinned samples buffers     */
+    int32_t *    samples[2];       /**< Device samples buffers     */
+    cudaEvent_t  done[2];          /**< Buffers are free           */
+    unsigned     next;             /**< Next buffer                */
+    cudaStream_t stream;           /**< Stream                     */
+};  // end of struct grid
+
+
+size_t device_cnt() {
+    int cnt = 0;
+    if (cudaSuccess != cudaGetDeviceCount(&cnt)) {
+        cudaGetLastError();  // reset the error
+        return 0;
+    }
+
+    return (size_t)cnt;
+}
+
+
+grid * create(
+    size_t          dimension,
+    const int32_t * lo,
+    const int32_t * hi,
+    size_t          batch)
+{
+    grid * g = new grid;
+    ::memset(g, 0, sizeof(*g));
+
+    g->b.dimension = dimension;
+    g->b.size      = 1;
+    for (size_t d = dimension; d-- > 0; ) {
+        g->b.lo[d]     = lo[d];
+        g->b.hi[d]     = hi[d];
+        g->b.stride[d] = g->b.size;
+        g->b.size     *= (uint64_t)(hi[d] - lo[d]) + 1;
+    }
+
+    g->batch = batch;
+
+    try {
+        const size_t samples_size = batch * dimension * sizeof(int32_t);
+
+        check(cudaStreamCreate(&g->stream), "create");
+        check(cudaMalloc((void **)&g->cells, g->b.size * sizeof(uint32_t)),
+            "create");
+        check(cudaMemset(g->cells, 0, g->b.size * sizeof(uint32_t)),
+            "create");
+
+        for (unsigned i = 0; i < 2; ++i) {
+            check(cudaMallocHost((void **)&g->staging[i], samples_size),
+                "create");
+            check(cudaMalloc((void **)&g->samples[i], samples_size),
+                "create");
+            check(cudaEventCreateWithFlags(&g->done[i],
+                cudaEventDisableTiming), "create");
+        }
+    }
+    catch (...) {
+        destroy(g);
+        throw;
+    }
+
+    return g;
+}
+
+
+void destroy(grid * g) {
+    if (NULL != g->stream) cudaStreamSynchronize(g->stream);
+
+    for (unsigned i = 0; i < 2; ++i) {
+        if (NULL != g->done[i])    cudaEventDestroy(g->done[i]);
+        if (NULL != g->samples[i]) cudaFree(g->samples[i]);
+        if (NULL != g->staging[i]) cudaFreeHost(g->staging[i]);
+    }
+
+    if (NULL != g->weights) cudaFree(g->weights);
+    if (NULL != g->offsets) cudaFree(g->offsets);
+    if (NULL != g->cells)   cudaFree(g->cells);
+    if (NULL != g->stream)  cudaStreamDestroy(g->stream);
+
+    delete g;
+}
+
+
+void bind(
+    grid *           g,
+    const int32_t *  offsets,
+    const uint32_t * weights,
+    size_t           size)
+{
+    check(cudaStreamSynchronize(g->stream), "bind");
+
+    if (NULL != g->weights) cudaFree(g->weights);
+    if (NULL != g->offsets) cudaFree(g->offsets);
+    g->weights = NULL;
+    g->offsets = NULL;
+    g->kernel_size = 0;
+
+    if (!size) return;
+
+    const size_t offsets_size = size * g->b.dimension * sizeof(int32_t);
+
+    check(cudaMalloc((void **)&g->offsets, offsets_size), "bind");
+    check(cudaMalloc((void **)&g->weights, size * sizeof(uint32_t)), "bind");
+    check(cudaMemcpy(g->offsets, offsets, offsets_size,
+        cudaMemcpyHostToDevice), "bind");
+    check(cudaMemcpy(g->weights, weights, size * sizeof(uint32_t),
+        cudaMemcpyHostToDevice), "bind");
+
+    g->kernel_size = size;
+}
+
+
+void vote(grid * g, const int32_t * samples, size_t count) {
+    if (!count || !g->kernel_size) return;
+
+    if (count > g->batch)
+        throw std::logic_error(
+            "libaccl::backend::cuda::vote: "
+            "batch overflow");
+
+    const unsigned i = g->next;
+    g->next = 1 - i;
+
+    // Wait till the buffer is free (its previous voting is done)
+    check(cudaEventSynchronize(g->done[i]), "vote");
+
+    const size_t size = count * g->b.dimension * sizeof(int32_t);
+    ::memcpy(g->staging[i], samples, size);
+
+    check(cudaMemcpyAsync(g->samples[i], g->staging[i], size,
+        cudaMemcpyHostToDevice, g->stream), "vote");
+
+    vote_kernel<<<blocks(count * g->kernel_size), BLOCK_THREADS, 0,
+        g->stream>>>(g->b, g->cells, g->offsets, g->weights, g->kernel_size,
+        g->samples[i], count);
+
+    check(cudaGetLastError(), "vote");
+    check(cudaEventRecord(g->done[i], g->stream), "vote");
+}
+
+
+void add(grid * g, uint64_t index, uint32_t votes) {
+    add_kernel<<<1, 1, 0, g->stream>>>(g->cells, index, votes);
+    check(cudaGetLastError(), "add");
+}
+
+
+void merge(grid * g, grid * other) {
+    check(cudaStreamSynchronize(other->stream), "merge");
+
+    merge_kernel<<<blocks(g->b.size), BLOCK_THREADS, 0, g->stream>>>(
+        g->cells, other->cells, g->b.size);
+
+    check(cudaGetLastError(), "merge");
+}
+
+
+void prune(grid * g, uint32_t threshold) {
+    prune_kernel<<<blocks(g->b.size), BLOCK_THREADS, 0, g->stream>>>(
+        g->cells, g->b.size, threshold);
+
+    check(cudaGetLastError(), "prune");
+}
+
+
+void download(grid * g, uint32_t * cells) {
+    check(cudaMemcpyAsync(cells, g->cells, g->b.size * sizeof(uint32_t),
+        cudaMemcpyDeviceToHost, g->stream), "download");
+
+    check(cudaStreamSynchronize(g->stream), "download");
+}
+
+
+void peaks(grid * g, uint32_t threshold, std::vector<peak_t> & peaks) {
+    uint64_t capacity = 1024;
+
+    for (;;) {  // until the output is large enough
+        uint64_t *           peak_ix  = NULL;
+        uint32_t *           peak_cnt = NULL;
+        unsigned long long * found    = NULL;
+
+        unsigned long long cnt = 0;
+        std::vector<uint64_t> ix;
+        std::vector<uint32_t> counts;
+
+        try {
+            check(cudaMalloc((void **)&peak_ix, capacity * sizeof(uint64_t)),
+                "peaks");
+            check(cudaMalloc((void **)&peak_cnt, capacity * sizeof(uint32_t)),
+                "peaks");
+            check(cudaMalloc((void **)&found, sizeof(*found)), "peaks");
+            check(cudaMemsetAsync(found, 0, sizeof(*found), g->stream),
+                "peaks");
+
+            peaks_kernel<<<blocks(g->b.size), BLOCK_THREADS, 0, g->stream>>>(
+                g->b, g->cells, threshold, peak_ix, peak_cnt, found, capacity);
+
+            check(cudaGetLastError(), "peaks");
+            check(cudaMemcpyAsync(&cnt, found, sizeof(cnt),
+                cudaMemcpyDeviceToHost, g->stream), "peaks");
+            check(cudaStreamSynchronize(g->stream), "peaks");
+
+            if (cnt <= capacity) {
+                ix.resize(cnt);
+                counts.resize(cnt);
+                check(cudaMemcpy(ix.data(), peak_ix, cnt * sizeof(uint64_t),
+                    cudaMemcpyDeviceToHost), "peaks");
+                check(cudaMemcpy(counts.data(), peak_cnt,
+                    cnt * sizeof(uint32_t), cudaMemcpyDeviceToHost), "peaks");
+            }
+        }
+        catch (...) {
+            cudaFree(found);
+            cudaFree(peak_cnt);
+            cudaFree(peak_ix);
+            throw;
+        }
+
+        cudaFree(found);
+        cudaFree(peak_cnt);
+        cudaFree(peak_ix);
+
+        if (cnt > capacity) {
+            capacity = cnt;
+            continue;
+        }
+
+        peaks.clear();
+        peaks.reserve(cnt);
+        for (size_t i = 0; i < cnt; ++i)
+            peaks.push_back(peak_t(ix[i], counts[i]));
+
+        return;
+    }
+}
+
+}}}}  // end of namespace libaccl::backend::impl::cuda
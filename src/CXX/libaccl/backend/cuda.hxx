@@ -0,0 +1,558 @@
+#ifndef libaccl__backend__cuda_hxx
+#define libaccl__backend__cuda_hxx
+
+/**
+ *  \file
+ *  \brief  Dense accumulator backend (CUDA)
+ *
+ *  Cells are stored in device memory; votes and peak extraction run
+ *  on the GPU.
+ *  The device code is built to libaccl_cuda library if configured
+ *  with --enable-cuda (link it and CUDA runtime).
+ *
+ *  \date   2016/01/19
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/pattern/points.hxx"
+#include "libaccl/pattern/kernel.hxx"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+namespace backend {
+
+namespace impl {
+
+/**
+ *  \brief  CUDA device layer
+ *
+ *  Non-template interface of the device code (see cuda.cu);
+ *  coordinates are 32-bit signed, vote counts are 32-bit unsigned.
+ *  The functions throw \c std::runtime_error on CUDA errors.
+ */
+namespace cuda {
+
+/** Max. space dimension */
+static const size_t MAX_DIMENSION = 4;
+
+/** Device grid (opaque) */
+struct grid;
+
+/** Number of CUDA devices (0 if there's none or no driver) */
+size_t device_cnt();
+
+/** Peak (cell linear index and vote count) */
+typedef std::pair<uint64_t, uint32_t> peak_t;
+
+/**
+ *  \brief  Create device grid
+ *
+ *  Cells cover the box [lo, hi] (inclusive); two pinned host buffers
+ *  of \c batch samples are allocated for streaming.
+ *
+ *  \param  dimension  Space dimension
+ *  \param  lo         Box lower corner
+ *  \param  hi         Box upper corner
+ *  \param  batch      Samples batch size
+ *
+ *  \return Device grid
+ */
+grid * create(
+    size_t          dimension,
+    const int32_t * lo,
+    const int32_t * hi,
+    size_t          batch);
+
+/** Destroy device grid */
+void destroy(grid * g);
+
+/**
+ *  \brief  Upload kernel
+ *
+ *  \param  g        Device grid
+ *  \param  offsets  Kernel point offsets (row-major)
+ *  \param  weights  Kernel point weights
+ *  \param  size     Kernel size
+ */
+void bind(
+    grid *           g,
+    const int32_t *  offsets,
+    const uint32_t * weights,
+    size_t           size);
+
+/**
+ *  \brief  Vote for batch of samples (asynchronous)
+ *
+ *  The samples are copied to a pinned buffer and the upload and voting
+ *  are enqueued; the call only waits for the previous use of the buffer
+ *  (so upload of a batch overlaps voting of the previous one).
+ *
+ *  \param  g        Device grid
+ *  \param  samples  Sample coordinates (row-major)
+ *  \param  count    Number of samples (at most the batch size)
+ */
+void vote(grid * g, const int32_t * samples, size_t count);
+
+/**
+ *  \brief  Add votes to cell
+ *
+ *  \param  g      Device grid
+ *  \param  index  Cell linear index
+ *  \param  votes  Votes
+ */
+void add(grid * g, uint64_t index, uint32_t votes);
+
+/**
+ *  \brief  Add cells of another grid (of the same box)
+ *
+ *  \param  g      Device grid
+ *  \param  other  Another grid
+ */
+void merge(grid * g, grid * other);
+
+/**
+ *  \brief  Clear cells with too few votes
+ *
+ *  \param  g          Device grid
+ *  \param  threshold  Minimal vote count of a cell to keep
+ */
+void prune(grid * g, uint32_t threshold);
+
+/**
+ *  \brief  Download cells (waits for pending votes)
+ *
+ *  \param  g      Device grid
+ *  \param  cells  Cells (the box size)
+ */
+void download(grid * g, uint32_t * cells);
+
+/**
+ *  \brief  Find peaks (waits for pending votes)
+ *
+ *  See \ref dense::maxima; the whole neighbourhood is checked.
+ *
+ *  \param  g          Device grid
+ *  \param  threshold  Minimal vote count
+ *  \param  peaks      Peaks (unordered)
+ */
+void peaks(grid * g, uint32_t threshold, std::vector<peak_t> & peaks);
+
+}  // end of namespace cuda
+
+}  // end of namespace impl
+
+
+/**
+ *  \brief  Dense accumulator backend (CUDA)
+ *
+ *  Cells of the box [lo, hi] (inclusive) are stored in device memory;
+ *  votes outside the box are dropped (just like by \ref dense).
+ *
+ *  Kernel offsets and weights are uploaded once (by \ref bind).
+ *  Samples are collected to batches which are streamed to the device;
+ *  each device thread then adds weight of a kernel point to the cell
+ *  of a sample by atomic addition.
+ *  Peaks are found on the device as well, so only the peaks
+ *  are downloaded (see \ref maxima).
+ *  Cells are only downloaded when they are accessed on host
+ *  (see \ref count, \ref for_each).
+ *
+ *  The backend is meant for 2D/3D boxes and large kernels; coordinates
+ *  must be 32-bit signed and vote counts 32-bit unsigned.
+ *
+ *  \tparam  Base_t   Base numeric type (\c int32_t)
+ *  \tparam  Count_t  Vote count type (\c uint32_t)
+ *  \tparam  N        Space dimension (0 means runtime)
+ */
+template <typename Base_t, typename Count_t, size_t N = 0>
+class cuda {
+    static_assert(std::is_same<Base_t, int32_t>::value,
+        "libaccl::backend::cuda: base type must be int32_t");
+
+    static_assert(std::is_same<Count_t, uint32_t>::value,
+        "libaccl::backend::cuda: count type must be uint32_t");
+
+    public:
+
+    /** Cell coordinates */
+    typedef typename pattern::impl::point_type<Base_t, N>::type point_t;
+
+    typedef pattern::kernel<Base_t, Count_t, N> kernel_t;  /**< Kernel */
+
+    /** Backend is not thread-safe (parallel voting uses shards) */
+    static const bool concurrent = false;
+
+    /** Peaks are found in slot ranges (see \ref maxima) */
+    static const bool sorted_maxima = false;
+
+    private:
+
+    const size_t                  m_dimension;  /**< Space dimension     */
+    const point_t                 m_lo;         /**< Box lower corner    */
+    const point_t                 m_hi;         /**< Box upper corner    */
+    const size_t                  m_batch;      /**< Batch size          */
+    std::vector<size_t>           m_stride;     /**< Array strides       */
+    impl::cuda::grid *            m_grid;       /**< Device grid         */
+    const kernel_t *              m_kernel;     /**< Bound kernel        */
+    mutable std::vector<Base_t>   m_samples;    /**< Samples batch       */
+    mutable std::vector<Count_t>  m_cells;      /**< Cells (host copy)   */
+    mutable bool                  m_synced;     /**< Host copy is valid  */
+
+    /** Cell is in the box */
+    bool inside(const point_t & point) const {
+        for (size_t d = 0; d < dimension(); ++d)
+            if (point[d] < m_lo[d] || m_hi[d] < point[d]) return false;
+
+        return true;
+    }
+
+    /** Cell linear index (cell must be in the box) */
+    size_t index(const point_t & point) const {
+        size_t ix = 0;
+        for (size_t d = 0; d < dimension(); ++d)
+            ix += (size_t)(point[d] - m_lo[d]) * m_stride[d];
+
+        return ix;
+    }
+
+    /** Cell coordinates */
+    point_t point(size_t ix) const {
+        point_t p = m_lo;
+        for (size_t d = 0; d < dimension(); ++d) {
+            p[d] += (Base_t)(ix / m_stride[d]);
+            ix %= m_stride[d];
+        }
+
+        return p;
+    }
+
+    /** Ship collected samples */
+    void flush() const {
+        if (m_samples.empty()) return;
+
+        impl::cuda::vote(m_grid, m_samples.data(),
+            m_samples.size() / dimension());
+
+        m_samples.clear();
+        m_synced = false;
+    }
+
+    /** Download cells (if not done since the last change) */
+    void sync() const {
+        flush();
+        if (m_synced) return;
+
+        impl::cuda::download(m_grid, m_cells.data());
+        m_synced = true;
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  dimension  Space dimension (at most 4)
+     *  \param  lo         Box lower corner
+     *  \param  hi         Box upper corner (inclusive)
+     *  \param  batch      Samples batch size
+     */
+    cuda(
+        size_t          dimension,
+        const point_t & lo,
+        const point_t & hi,
+        size_t          batch = 65536)
+    :
+        m_dimension ( dimension ),
+        m_lo        ( lo        ),
+        m_hi        ( hi        ),
+        m_batch     ( batch ? batch : 1 ),
+        m_stride    ( dimension ),
+        m_grid      ( NULL      ),
+        m_kernel    ( NULL      ),
+        m_synced    ( true      )
+    {
+        if (lo.size() != dimension || hi.size() != dimension)
+            throw std::logic_error(
+                "libaccl::backend::cuda: "
+                "box dimension mismatch");
+
+        if (!dimension || dimension > impl::cuda::MAX_DIMENSION)
+            throw std::logic_error(
+                "libaccl::backend::cuda: "
+                "unsupported dimension");
+
+        size_t size = 1;
+        for (size_t d = dimension; d-- > 0; ) {
+            if (hi[d] < lo[d])
+                throw std::logic_error(
+                    "libaccl::backend::cuda: "
+                    "invalid box");
+
+            m_stride[d] = size;
+            size *= (size_t)(hi[d] - lo[d]) + 1;
+        }
+
+        m_samples.reserve(m_batch * dimension);
+        m_cells.resize(size);  // zero, as the device cells
+        m_grid = impl::cuda::create(dimension, lo.data(), hi.data(), m_batch);
+    }
+
+    /** Move constructor */
+    cuda(cuda && orig):
+        m_dimension ( orig.m_dimension          ),
+        m_lo        ( orig.m_lo                 ),
+        m_hi        ( orig.m_hi                 ),
+        m_batch     ( orig.m_batch              ),
+        m_stride    ( std::move(orig.m_stride)  ),
+        m_grid      ( orig.m_grid               ),
+        m_kernel    ( orig.m_kernel             ),
+        m_samples   ( std::move(orig.m_samples) ),
+        m_cells     ( std::move(orig.m_cells)   ),
+        m_synced    ( orig.m_synced             )
+    {
+        orig.m_grid = NULL;
+    }
+
+    cuda(const cuda & ) = delete;
+    cuda & operator = (const cuda & ) = delete;
+
+    /** Destructor */
+    ~cuda() { if (NULL != m_grid) impl::cuda::destroy(m_grid); }
+
+    /** Space dimension */
+    size_t dimension() const { return N ? N : m_dimension; }
+
+    /** Box lower corner */
+    const point_t & lo() const { return m_lo; }
+
+    /** Box upper corner */
+    const point_t & hi() const { return m_hi; }
+
+    /** Cells array (downloaded from device) */
+    const std::vector<Count_t> & cells() const {
+        sync();
+        return m_cells;
+    }
+
+    /**
+     *  \brief  Bind kernel
+     *
+     *  Uploads the kernel offsets and weights to the device.
+     *
+     *  \param  kernel  Voting kernel
+     */
+    void bind(const kernel_t & kernel) {
+        flush();
+
+        impl::cuda::bind(m_grid, kernel.offsets(), kernel.weights(),
+            kernel.size());
+
+        m_kernel = &kernel;
+    }
+
+    /** Empty backend of the same configuration (for parallel voting) */
+    cuda shard() const {
+        cuda s(dimension(), m_lo, m_hi, m_batch);
+        if (NULL != m_kernel) s.bind(*m_kernel);
+
+        return s;
+    }
+
+    /**
+     *  \brief  Merge votes of another backend (on device)
+     *
+     *  \param  other  Backend of the same configuration
+     */
+    void merge(const cuda & other) {
+        if (other.m_cells.size() != m_cells.size())
+            throw std::logic_error(
+                "libaccl::backend::cuda::merge: "
+                "box mismatch");
+
+        flush();
+        other.flush();
+
+        impl::cuda::merge(m_grid, other.m_grid);
+        m_synced = false;
+    }
+
+    /**
+     *  \brief  Clear cells with too few votes (on device)
+     *
+     *  \param  threshold  Minimal vote count of a cell to keep
+     */
+    void prune(Count_t threshold) {
+        flush();
+
+        impl::cuda::prune(m_grid, threshold);
+        m_synced = false;
+    }
+
+    /**
+     *  \brief  Add votes to cell
+     *
+     *  Note that each call is a device round trip; use \ref vote
+     *  for bulk voting.
+     *
+     *  \param  point  Cell coordinates (votes outside the box are dropped)
+     *  \param  votes  Votes
+     */
+    void add(const point_t & point, Count_t votes) {
+        if (!inside(point)) return;
+
+        flush();
+
+        impl::cuda::add(m_grid, index(point), votes);
+        m_synced = false;
+    }
+
+    /**
+     *  \brief  Vote
+     *
+     *  The sample is added to the current batch; full batch is shipped
+     *  to the device.
+     *
+     *  \param  sample  Sample coordinates
+     *  \param  kernel  Voting kernel (uploaded unless bound)
+     */
+    void vote(const Base_t * sample, const kernel_t & kernel) {
+        if (&kernel != m_kernel) bind(kernel);
+
+        m_samples.insert(m_samples.end(), sample, sample + dimension());
+        if (m_samples.size() >= m_batch * dimension()) flush();
+    }
+
+    /**
+     *  \brief  Cell vote count
+     *
+     *  \param  point  Cell coordinates
+     *
+     *  \return Number of votes for the cell (0 out of the box)
+     */
+    Count_t count(const point_t & point) const {
+        if (!inside(point)) return Count_t();
+
+        sync();
+        return m_cells[index(point)];
+    }
+
+    /** Number of cells with votes (by scan) */
+    size_t size() const {
+        sync();
+        return m_cells.size() - std::count(
+            m_cells.begin(), m_cells.end(), Count_t());
+    }
+
+    /**
+     *  \brief  Call function for every cell with votes
+     *
+     *  \param  fn  Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(Fn fn) const {
+        sync();
+
+        point_t point = m_lo;
+        for (size_t i = 0; i < m_cells.size(); ++i) {
+            if (Count_t() != m_cells[i]) fn(point, m_cells[i]);
+
+            // Next cell coordinates
+            for (size_t d = dimension(); d-- > 0; ) {
+                if (point[d] < m_hi[d]) { ++point[d]; break; }
+                point[d] = m_lo[d];
+            }
+        }
+    }
+
+    /**
+     *  \brief  Slot count
+     *
+     *  Peaks are extracted by the device at once, so there's just one
+     *  slot (see \ref maxima).
+     */
+    size_t slots() const { return 1; }
+
+    /**
+     *  \brief  Local maxima (on device)
+     *
+     *  See \ref dense::maxima; the device checks the whole neighbourhood
+     *  of each cell (in the same order), so only the peaks are
+     *  downloaded.
+     *
+     *  \param  threshold   Minimal vote count
+     *  \param  neighbours  Neighbourhood offsets (the whole one)
+     *  \param  begin       Range begin (slot index)
+     *  \param  end         Range end (slot index)
+     *  \param  fn          Function, called with peak coordinates and vote count
+     */
+    template <class Fn>
+    void maxima(
+        Count_t                     threshold,
+        const std::vector<Base_t> & neighbours,
+        size_t                      begin,
+        size_t                      end,
+        Fn                          fn) const
+    {
+        if (begin > 0 || end <= begin) return;
+
+        size_t cnt = 1;
+        for (size_t d = 0; d < dimension(); ++d) cnt *= 3;
+        if (neighbours.size() != (cnt - 1) * dimension())
+            throw std::logic_error(
+                "libaccl::backend::cuda::maxima: "
+                "partial neighbourhood is not supported");
+
+        flush();
+
+        std::vector<impl::cuda::peak_t> peaks;
+        impl::cuda::peaks(m_grid, threshold, peaks);
+
+        for (size_t i = 0; i < peaks.size(); ++i)
+            fn(point(peaks[i].first), peaks[i].second);
+    }
+
+};  // end of template class cuda
+
+}}  // end of namespace libaccl::backend
+
+#endif  // end of #ifndef libaccl__backend__cuda_hxx
@@ -0,0 +1,589 @@
+#ifndef libaccl__backend__dense_hxx
+#define libaccl__backend__dense_hxx
+
+/**
+ *  \file
+ *  \brief  Dense accumulator backend
+ *
+ *  Accumulator cells are kept in a flat N-dimensional array covering
+ *  a bounded range of the space.
+ *  Suitable for low-dimensional data with bounded ranges (image-like).
+ *
+ *  \date   2016/01/05
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/pattern/points.hxx"
+#include "libaccl/pattern/kernel.hxx"
+#include "libaccl/saturating.hxx"
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace libaccl {
+namespace backend {
+
+namespace impl {
+
+/**
+ *  \brief  Add row of votes
+ *
+ *  The loop is trivially vectorisable; AVX2 specialisation
+ *  for 32-bit counters exists (if available), as well as SSE2/AVX2
+ *  specialisations for 8 and 16-bit \ref saturating counters.
+ *
+ *  \param  dst  Cells
+ *  \param  src  Votes
+ *  \param  len  Row length
+ */
+template <typename Count_t>
+inline void add_row(Count_t * dst, const Count_t * src, size_t len) {
+    for (size_t i = 0; i < len; ++i) dst[i] += src[i];
+}
+
+#ifdef __AVX2__
+/** Add row of votes (32-bit integer counters, AVX2) */
+inline void add_row_epi32(uint32_t * dst, const uint32_t * src, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_add_epi32(d, s));
+    }
+
+    for (; i < len; ++i) dst[i] += src[i];
+}
+
+template <>
+inline void add_row<uint32_t>(uint32_t * dst, const uint32_t * src, size_t len) {
+    add_row_epi32(dst, src, len);
+}
+
+template <>
+inline void add_row<int32_t>(int32_t * dst, const int32_t * src, size_t len) {
+    add_row_epi32((uint32_t *)dst, (const uint32_t *)src, len);
+}
+#endif  // end of #ifdef __AVX2__
+
+#ifdef __SSE2__
+/** Add row of votes (saturating 8-bit counters, SSE2 or AVX2) */
+inline void add_row_epu8(uint8_t * dst, const uint8_t * src, size_t len) {
+    size_t i = 0;
+#ifdef __AVX2__
+    for (; i + 32 <= len; i += 32) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_adds_epu8(d, s));
+    }
+#endif
+    for (; i + 16 <= len; i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_adds_epu8(d, s));
+    }
+
+    for (; i < len; ++i) {
+        const unsigned sum = dst[i] + src[i];
+        dst[i] = sum > UINT8_MAX ? UINT8_MAX : sum;
+    }
+}
+
+/** Add row of votes (saturating 16-bit counters, SSE2 or AVX2) */
+inline void add_row_epu16(uint16_t * dst, const uint16_t * src, size_t len) {
+    size_t i = 0;
+#ifdef __AVX2__
+    for (; i + 16 <= len; i += 16) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_adds_epu16(d, s));
+    }
+#endif
+    for (; i + 8 <= len; i += 8) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_adds_epu16(d, s));
+    }
+
+    for (; i < len; ++i) {
+        const unsigned sum = dst[i] + src[i];
+        dst[i] = sum > UINT16_MAX ? UINT16_MAX : sum;
+    }
+}
+
+template <>
+inline void add_row<saturating<uint8_t> >(
+    saturating<uint8_t> * dst, const saturating<uint8_t> * src, size_t len)
+{
+    add_row_epu8((uint8_t *)dst, (const uint8_t *)src, len);
+}
+
+template <>
+inline void add_row<saturating<uint16_t> >(
+    saturating<uint16_t> * dst, const saturating<uint16_t> * src, size_t len)
+{
+    add_row_epu16((uint16_t *)dst, (const uint16_t *)src, len);
+}
+#endif  // end of #ifdef __SSE2__
+
+}  // end of namespace impl
+
+
+/**
+ *  \brief  Dense accumulator backend
+ *
+ *  Cells are stored in a flat row-major N-dimensional array covering
+ *  the box [lo, hi] (inclusive).
+ *  Votes outside the box are dropped.
+ *
+ *  Upon binding a kernel, its point offsets are converted to linear
+ *  array offsets and grouped to rows (runs of consecutive offsets
+ *  along the last dimension).
+ *  Vote for a sample is then \c base_index \c + \c row_offset
+ *  followed by a vectorised addition of the row weights.
+ *  Samples whose kernel image crosses the box boundary take a slower,
+ *  bounds-checked path.
+ *
+ *  \tparam  Base_t   Base numeric type (integral)
+ *  \tparam  Count_t  Vote count type
+ *  \tparam  N        Space dimension (0 means runtime)
+ */
+template <typename Base_t, typename Count_t, size_t N = 0>
+class dense {
+    public:
+
+    /** Cell coordinates */
+    typedef typename pattern::impl::point_type<Base_t, N>::type point_t;
+
+    typedef pattern::kernel<Base_t, Count_t, N> kernel_t;  /**< Kernel */
+
+    /** Backend is not thread-safe (parallel voting uses shards) */
+    static const bool concurrent = false;
+
+    /** Peaks are found in slot ranges (see \ref maxima) */
+    static const bool sorted_maxima = false;
+
+    private:
+
+    /** Row of kernel points (consecutive cells along the last dimension) */
+    struct row {
+        ptrdiff_t offset;  /**< Linear offset of the 1st cell */
+        size_t    weight;  /**< Index of the 1st weight       */
+        size_t    len;     /**< Row length                    */
+    };  // end of struct row
+
+    const size_t           m_dimension;  /**< Space dimension           */
+    const point_t          m_lo;         /**< Box lower corner          */
+    const point_t          m_hi;         /**< Box upper corner          */
+    std::vector<size_t>    m_stride;     /**< Array strides             */
+    std::vector<Count_t>   m_cells;      /**< Cells                     */
+    const kernel_t *       m_kernel;     /**< Bound kernel              */
+    std::vector<row>       m_rows;       /**< Kernel rows               */
+    std::vector<Count_t>   m_weights;    /**< Kernel weights (by rows)  */
+
+    /** Cell is in the box */
+    template <class Point_t>
+    bool inside(const Point_t & point) const {
+        for (size_t d = 0; d < dimension(); ++d)
+            if (point[d] < m_lo[d] || m_hi[d] < point[d]) return false;
+
+        return true;
+    }
+
+    /** Cell linear index (cell must be in the box) */
+    template <class Point_t>
+    size_t index(const Point_t & point) const {
+        size_t ix = 0;
+        for (size_t d = 0; d < dimension(); ++d)
+            ix += (size_t)(point[d] - m_lo[d]) * m_stride[d];
+
+        return ix;
+    }
+
+    /** Bounds-checked vote */
+    void vote_checked(const Base_t * sample, const kernel_t & kernel) {
+        point_t cell = pattern::impl::point_type<Base_t, N>::zero(dimension());
+
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            const Base_t * offset = kernel.offset(i);
+            for (size_t d = 0; d < dimension(); ++d)
+                cell[d] = sample[d] + offset[d];
+
+            if (inside(cell)) m_cells[index(cell)] += kernel.weight(i);
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  dimension  Space dimension
+     *  \param  lo         Box lower corner
+     *  \param  hi         Box upper corner (inclusive)
+     */
+    dense(size_t dimension, const point_t & lo, const point_t & hi):
+        m_dimension ( dimension ),
+        m_lo        ( lo        ),
+        m_hi        ( hi        ),
+        m_stride    ( dimension ),
+        m_kernel    ( NULL      )
+    {
+        if (lo.size() != dimension || hi.size() != dimension)
+            throw std::logic_error(
+                "libaccl::backend::dense: "
+                "box dimension mismatch");
+
+        size_t size = 1;
+        for (size_t d = dimension; d-- > 0; ) {
+            if (hi[d] < lo[d])
+                throw std::logic_error(
+                    "libaccl::backend::dense: "
+                    "invalid box");
+
+            m_stride[d] = size;
+            size *= (size_t)(hi[d] - lo[d]) + 1;
+        }
+
+        m_cells.resize(size);
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return N ? N : m_dimension; }
+
+    /** Box lower corner */
+    const point_t & lo() const { return m_lo; }
+
+    /** Box upper corner */
+    const point_t & hi() const { return m_hi; }
+
+    /** Cells array */
+    const std::vector<Count_t> & cells() const { return m_cells; }
+
+    /**
+     *  \brief  Bind kernel
+     *
+     *  Precomputes linear offsets of the kernel points (grouped to rows).
+     *
+     *  \param  kernel  Voting kernel
+     */
+    void bind(const kernel_t & kernel) {
+        m_kernel = &kernel;
+        m_rows.clear();
+        m_weights.clear();
+        m_weights.reserve(kernel.size());
+
+        // Linear offsets, sorted
+        std::vector<ptrdiff_t> offsets(kernel.size());
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            ptrdiff_t offset = 0;
+            for (size_t d = 0; d < dimension(); ++d)
+                offset += (ptrdiff_t)kernel.offset(i)[d]
+                        * (ptrdiff_t)m_stride[d];
+
+            offsets[i] = offset;
+        }
+
+        std::vector<size_t> perm(kernel.size());
+        std::iota(perm.begin(), perm.end(), 0);
+        std::sort(perm.begin(), perm.end(),
+        [&offsets](size_t larg, size_t rarg) {
+            return offsets[larg] < offsets[rarg];
+        });
+
+        // Rows
+        for (size_t i = 0; i < perm.size(); ++i) {
+            const ptrdiff_t offset = offsets[perm[i]];
+
+            if (m_rows.empty() ||
+                m_rows.back().offset + (ptrdiff_t)m_rows.back().len != offset)
+            {
+                row r; r.offset = offset; r.weight = m_weights.size(); r.len = 0;
+                m_rows.push_back(r);
+            }
+
+            ++m_rows.back().len;
+            m_weights.push_back(kernel.weight(perm[i]));
+        }
+    }
+
+    /**
+     *  \brief  Kernel is bound (and so voting uses the fast path)
+     *
+     *  \param  kernel  Voting kernel
+     */
+    bool bound(const kernel_t & kernel) const { return &kernel == m_kernel; }
+
+    /** Empty backend of the same configuration (for parallel voting) */
+    dense shard() const {
+        dense s(dimension(), m_lo, m_hi);
+        s.m_kernel  = m_kernel;
+        s.m_rows    = m_rows;
+        s.m_weights = m_weights;
+
+        return s;
+    }
+
+    /**
+     *  \brief  Merge votes of another backend
+     *
+     *  \param  other  Backend of the same configuration
+     */
+    void merge(const dense & other) {
+        if (other.m_cells.size() != m_cells.size())
+            throw std::logic_error(
+                "libaccl::backend::dense::merge: "
+                "box mismatch");
+
+        impl::add_row(m_cells.data(), other.m_cells.data(), m_cells.size());
+    }
+
+    /**
+     *  \brief  Clear cells with too few votes
+     *
+     *  \param  threshold  Minimal vote count of a cell to keep
+     */
+    void prune(Count_t threshold) {
+        for (size_t i = 0; i < m_cells.size(); ++i)
+            if (m_cells[i] < threshold) m_cells[i] = Count_t();
+    }
+
+    /**
+     *  \brief  Add votes to cell
+     *
+     *  \param  point  Cell coordinates (votes outside the box are dropped)
+     *  \param  votes  Votes
+     */
+    void add(const point_t & point, Count_t votes) {
+        if (inside(point)) m_cells[index(point)] += votes;
+    }
+
+    /**
+     *  \brief  Retract vote (inverse of \ref vote)
+     *
+     *  \param  sample  Sample coordinates (voted before)
+     *  \param  kernel  Voting kernel
+     */
+    void retract(const Base_t * sample, const kernel_t & kernel) {
+        point_t cell = pattern::impl::point_type<Base_t, N>::zero(dimension());
+
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            const Base_t * offset = kernel.offset(i);
+            for (size_t d = 0; d < dimension(); ++d)
+                cell[d] = sample[d] + offset[d];
+
+            if (inside(cell)) m_cells[index(cell)] -= kernel.weight(i);
+        }
+    }
+
+    /**
+     *  \brief  Vote
+     *
+     *  \param  sample  Sample coordinates
+     *  \param  kernel  Voting kernel (bound one uses the fast path)
+     */
+    void vote(const Base_t * sample, const kernel_t & kernel) {
+        // Fast path: kernel image is inside the box
+        if (bound(kernel)) {
+            bool fast = true;
+            for (size_t d = 0; d < dimension() && fast; ++d)
+                fast = m_lo[d] <= sample[d] + kernel.lo()[d]
+                    && sample[d] + kernel.hi()[d] <= m_hi[d];
+
+            if (fast) {
+                // Note that the sample itself may be out of the box
+                ptrdiff_t base = 0;
+                for (size_t d = 0; d < dimension(); ++d)
+                    base += (ptrdiff_t)(sample[d] - m_lo[d])
+                          * (ptrdiff_t)m_stride[d];
+
+                const Count_t * weights = m_weights.data();
+                for (size_t i = 0; i < m_rows.size(); ++i) {
+                    const row & r = m_rows[i];
+                    impl::add_row(
+                        m_cells.data() + (base + r.offset),
+                        weights + r.weight, r.len);
+                }
+
+                return;
+            }
+        }
+
+        vote_checked(sample, kernel);
+    }
+
+    /**
+     *  \brief  Cell vote count
+     *
+     *  \param  point  Cell coordinates
+     *
+     *  \return Number of votes for the cell (0 out of the box)
+     */
+    Count_t count(const point_t & point) const {
+        return inside(point) ? m_cells[index(point)] : Count_t();
+    }
+
+    /** Number of cells with votes (by scan) */
+    size_t size() const {
+        return m_cells.size() - std::count(
+            m_cells.begin(), m_cells.end(), Count_t());
+    }
+
+    /**
+     *  \brief  Call function for every cell with votes
+     *
+     *  \param  fn  Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(Fn fn) const {
+        point_t point = m_lo;
+
+        for (size_t i = 0; i < m_cells.size(); ++i) {
+            if (Count_t() != m_cells[i]) fn(point, m_cells[i]);
+
+            // Next cell coordinates
+            for (size_t d = dimension(); d-- > 0; ) {
+                if (point[d] < m_hi[d]) { ++point[d]; break; }
+                point[d] = m_lo[d];
+            }
+        }
+    }
+
+    /** Slot count (for range partitioning; cells linear indices) */
+    size_t slots() const { return m_cells.size(); }
+
+    /**
+     *  \brief  Local maxima in slot range
+     *
+     *  Calls \c fn for every cell with at least \c threshold votes
+     *  which has no neighbour with more votes (nor a lower one with equal
+     *  votes).
+     *  The neighbourhood offsets are (3^N - 1) points (row-major) ordered
+     *  lexicographically, so the 1st half of them is lower than the cell.
+     *  Linear offsets of the neighbours are precomputed, so that cells
+     *  not touching the box boundary are checked without bounds checks.
+     *
+     *  \param  threshold   Minimal vote count
+     *  \param  neighbours  Neighbourhood offsets
+     *  \param  begin       Range begin (cell linear index)
+     *  \param  end         Range end (cell linear index)
+     *  \param  fn          Function, called with peak coordinates and vote count
+     */
+    template <class Fn>
+    void maxima(
+        Count_t                     threshold,
+        const std::vector<Base_t> & neighbours,
+        size_t                      begin,
+        size_t                      end,
+        Fn                          fn) const
+    {
+        const size_t dim  = dimension();
+        const size_t cnt  = neighbours.size() / dim;
+        const size_t half = cnt / 2;  // lower neighbours
+
+        if (end > m_cells.size()) end = m_cells.size();
+        if (begin >= end) return;
+
+        // Neighbours linear offsets
+        std::vector<ptrdiff_t> offsets(cnt);
+        for (size_t k = 0; k < cnt; ++k) {
+            ptrdiff_t offset = 0;
+            for (size_t d = 0; d < dim; ++d)
+                offset += (ptrdiff_t)neighbours[k * dim + d]
+                        * (ptrdiff_t)m_stride[d];
+
+            offsets[k] = offset;
+        }
+
+        // 1st cell coordinates
+        point_t point = m_lo;
+        for (size_t d = 0, ix = begin; d < dim; ++d) {
+            point[d] += (Base_t)(ix / m_stride[d]);
+            ix %= m_stride[d];
+        }
+
+        point_t n = point;
+        const Count_t * cells = m_cells.data();
+        for (size_t i = begin; i < end; ++i) {
+            const Count_t count = cells[i];
+
+            if (Count_t() != count && !(count < threshold)) {
+                bool inner = true;
+                for (size_t d = 0; d < dim && inner; ++d)
+                    inner = m_lo[d] < point[d] && point[d] < m_hi[d];
+
+                bool peak = true;
+                for (size_t k = 0; k < cnt && peak; ++k) {
+                    Count_t n_count;
+                    if (inner)
+                        n_count = cells[i + offsets[k]];
+
+                    else {
+                        for (size_t d = 0; d < dim; ++d)
+                            n[d] = point[d] + neighbours[k * dim + d];
+
+                        n_count = this->count(n);
+                    }
+
+                    peak = n_count < count || (n_count == count && half <= k);
+                }
+
+                if (peak) fn(point, count);
+            }
+
+            // Next cell coordinates
+            for (size_t d = dim; d-- > 0; ) {
+                if (point[d] < m_hi[d]) { ++point[d]; break; }
+                point[d] = m_lo[d];
+            }
+        }
+    }
+
+};  // end of template class dense
+
+}}  // end of namespace libaccl::backend
+
+#endif  // end of #ifndef libaccl__backend__dense_hxx
@@ -0,0 +1,789 @@
+#ifndef libaccl__backend__partitioned_hxx
+#define libaccl__backend__partitioned_hxx
+
+/**
+ *  \file
+ *  \brief  Partitioned accumulator backend
+ *
+ *  The cell space is split by hash to partitions (one per worker
+ *  process); votes for cells of other partitions are shipped to their
+ *  owners in compact batches.
+ *
+ *  \date   2016/01/18
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/accumulator.hxx"
+#include "libaccl/backend/sparse.hxx"
+#include "libaccl/hash/mix.hxx"
+#include "libaccl/pattern/points.hxx"
+#include "libaccl/pattern/kernel.hxx"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+
+
+namespace libaccl {
+namespace backend {
+
+namespace impl {
+
+/**
+ *  \brief  Partition batch header
+ *
+ *  The batch layout is
+ *  - header,
+ *  - cell records (\c payload_size bytes).
+ *
+ *  Records are sorted by cell coordinates; each record holds coordinate
+ *  differences to the previous record (zigzag varints, the 1st record
+ *  is relative to origin) and vote count (varint).
+ *  Header numbers are stored in the native byte order (checked by
+ *  the byte order mark).
+ */
+struct batch_header {
+    char     magic[8];      /**< Batch magic                   */
+    uint32_t byte_order;    /**< Byte order mark               */
+    uint32_t version;       /**< Format version                */
+    uint32_t kind;          /**< Batch kind (see \ref BATCH_VOTES) */
+    uint32_t source;        /**< Source partition              */
+    uint32_t destination;   /**< Destination partition         */
+    uint32_t dimension;     /**< Space dimension               */
+    uint64_t cell_cnt;      /**< Number of cell records        */
+    uint64_t payload_size;  /**< Cell records size             */
+};  // end of struct batch_header
+
+/** Partition batch magic */
+static const char BATCH_MAGIC[8] = { 'L', 'A', 'C', 'C', 'L', 'P', 'B', 'T' };
+
+/** Partition batch byte order mark */
+static const uint32_t BATCH_BYTE_ORDER = 0x01020304;
+
+/** Partition batch format version */
+static const uint32_t BATCH_VERSION = 1;
+
+/** Batch of votes (count deltas for cells of the destination) */
+static const uint32_t BATCH_VOTES = 0;
+
+/** Batch of halo cells (vote counts of cells next to the destination) */
+static const uint32_t BATCH_HALO = 1;
+
+/** Append varint */
+inline void put_varint(std::string & buf, uint64_t x) {
+    for (; x >= 0x80; x >>= 7) buf.push_back((char)((x & 0x7f) | 0x80));
+    buf.push_back((char)x);
+}
+
+/**
+ *  \brief  Read varint
+ *
+ *  \param  pos  Position (moved past the varint)
+ *  \param  end  Buffer end
+ *  \param  x    Value
+ *
+ *  \return \c false if the varint is truncated or too long
+ */
+inline bool get_varint(const char * & pos, const char * end, uint64_t & x) {
+    x = 0;
+    for (unsigned shift = 0; pos < end && shift < 64; shift += 7) {
+        const uint8_t byte = (uint8_t)*pos++;
+        x |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+
+    return false;
+}
+
+/** Zigzag encoding (small magnitudes have short varints) */
+inline uint64_t zigzag(int64_t x) {
+    return ((uint64_t)x << 1) ^ (uint64_t)(x >> 63);
+}
+
+/** Zigzag decoding */
+inline int64_t unzigzag(uint64_t x) {
+    return (int64_t)(x >> 1) ^ -(int64_t)(x & 1);
+}
+
+/** Floor division by power of 2 (also for negative numbers) */
+template <typename Base_t>
+inline Base_t floor_shift(Base_t x, unsigned bits) {
+    return x < 0 ? ~(~x >> bits) : x >> bits;
+}
+
+}  // end of namespace impl
+
+/**
+ *  \brief  Partitioned accumulator backend
+ *
+ *  The cell space is split to blocks of 2^block cells per side;
+ *  blocks are assigned to partitions by hash of their coordinates,
+ *  so that the load is balanced and borders between partitions
+ *  are block borders.
+ *  Each worker process holds one partition and votes for its local
+ *  samples; votes for its own cells are resolved in a \ref sparse
+ *  backend, votes for other cells are aggregated per owner partition
+ *  and shipped by \ref send (one batch per partition) to be merged
+ *  by the owner's \ref receive.
+ *  Batch transport is left to the caller (pipes, sockets, files...);
+ *  see \ref impl::batch_header for the format.
+ *
+ *  Peaks are found by each partition for its own cells.
+ *  Cells at partition borders need counts of neighbours owned by
+ *  other partitions; these are exchanged as halo by \ref halo,
+ *  \ref send_halo and \ref receive.
+ *  So, the round of a worker process is
+ *  -# \c vote for local samples,
+ *  -# \ref send vote batches to and \ref receive them from all partitions,
+ *  -# \ref halo, \ref send_halo to and \ref receive halo from all
+ *     partitions,
+ *  -# \c peaks (with at least the \ref halo threshold).
+ *
+ *  Partition cells may be saved (see \ref save) for checkpointing;
+ *  saved partitions may be merged offline (see \ref load and
+ *  \ref sparse::load).
+ *
+ *  \tparam  Base_t   Base numeric type (integral)
+ *  \tparam  Count_t  Vote count type
+ *  \tparam  N        Space dimension (0 means runtime)
+ */
+template <typename Base_t, typename Count_t, size_t N = 0>
+class partitioned {
+    public:
+
+    typedef sparse<Base_t, Count_t, N> local_t;  /**< Partition cells */
+
+    typedef typename local_t::point_t  point_t;   /**< Cell coordinates */
+    typedef typename local_t::kernel_t kernel_t;  /**< Kernel           */
+    typedef typename local_t::mapped_t mapped_t;  /**< Saved cells      */
+
+    /** Backend is not thread-safe (parallel voting uses shards) */
+    static const bool concurrent = false;
+
+    /** Peaks are found by neighbour lookups (partition and halo cells) */
+    static const bool sorted_maxima = false;
+
+    private:
+
+    /** Block of cell (coordinates view) */
+    class block_view {
+        private:
+
+        const point_t & m_point;  /**< Cell coordinates */
+        const unsigned  m_bits;   /**< Block bits       */
+
+        public:
+
+        /** Constructor */
+        block_view(const point_t & point, unsigned bits):
+            m_point(point), m_bits(bits)
+        {}
+
+        /** Dimension */
+        size_t size() const { return m_point.size(); }
+
+        /** Block coordinate */
+        Base_t operator [] (size_t d) const {
+            return impl::floor_shift(m_point[d], m_bits);
+        }
+
+    };  // end of class block_view
+
+    /** Batch cell record */
+    typedef std::pair<point_t, Count_t> record_t;
+
+    const size_t                      m_part;      /**< Partition           */
+    const size_t                      m_parts;     /**< Partition count     */
+    const unsigned                    m_block;     /**< Block bits          */
+    const hash::point_hash<block_view> m_owner_fn; /**< Block owner hash    */
+    local_t                           m_local;     /**< Partition cells     */
+    local_t                           m_halo;      /**< Halo cells          */
+    std::vector<local_t>              m_outbox;    /**< Votes per partition */
+    std::vector<std::vector<record_t> > m_halo_out; /**< Halo per partition */
+    point_t                           m_cell;      /**< Cell scratch        */
+
+    /** Outbox (and halo) table size */
+    static size_t outbox_size(size_t size, size_t parts) {
+        return std::max<size_t>(64, size / parts);
+    }
+
+    /** Check partition index */
+    void check(size_t part, const char * fn) const {
+        if (part < m_parts && part != m_part) return;
+
+        throw std::logic_error(
+            std::string("libaccl::backend::partitioned::") + fn +
+            ": invalid partition");
+    }
+
+    /**
+     *  \brief  Write batch
+     *
+     *  \param  out      Output stream (binary)
+     *  \param  kind     Batch kind
+     *  \param  part     Destination partition
+     *  \param  records  Cell records (sorted here)
+     */
+    void write(
+        std::ostream &          out,
+        uint32_t                kind,
+        size_t                  part,
+        std::vector<record_t> & records) const
+    {
+        std::sort(records.begin(), records.end(),
+        [](const record_t & larg, const record_t & rarg) {
+            return larg.first < rarg.first;
+        });
+
+        const size_t dim = dimension();
+
+        std::string payload;
+        std::vector<int64_t> prev(dim, 0);
+        for (size_t i = 0; i < records.size(); ++i) {
+            const point_t & point = records[i].first;
+            for (size_t d = 0; d < dim; ++d) {
+                impl::put_varint(payload,
+                    impl::zigzag((int64_t)point[d] - prev[d]));
+                prev[d] = point[d];
+            }
+
+            impl::put_varint(payload, (uint64_t)records[i].second);
+        }
+
+        impl::batch_header hdr;
+        ::memset(&hdr, 0, sizeof(hdr));
+        ::memcpy(hdr.magic, impl::BATCH_MAGIC, sizeof(hdr.magic));
+        hdr.byte_order   = impl::BATCH_BYTE_ORDER;
+        hdr.version      = impl::BATCH_VERSION;
+        hdr.kind         = kind;
+        hdr.source       = m_part;
+        hdr.destination  = part;
+        hdr.dimension    = dim;
+        hdr.cell_cnt     = records.size();
+        hdr.payload_size = payload.size();
+
+        out.write((const char *)&hdr, sizeof(hdr));
+        out.write(payload.data(), payload.size());
+
+        if (!out)
+            throw std::runtime_error(
+                "libaccl::backend::partitioned::send: "
+                "write failed");
+    }
+
+    /**
+     *  \brief  Check batch header
+     *
+     *  \param  hdr  Header
+     *
+     *  \return Error message or \c NULL if the header is valid
+     */
+    const char * check(const impl::batch_header & hdr) const {
+        if (0 != ::memcmp(hdr.magic, impl::BATCH_MAGIC, sizeof(hdr.magic)))
+            return "not a partition batch";
+
+        if (impl::BATCH_BYTE_ORDER != hdr.byte_order)
+            return "byte order mismatch";
+
+        if (impl::BATCH_VERSION != hdr.version)
+            return "unsupported format version";
+
+        if (impl::BATCH_VOTES != hdr.kind && impl::BATCH_HALO != hdr.kind)
+            return "unknown batch kind";
+
+        if (dimension() != hdr.dimension)
+            return "dimension mismatch";
+
+        if (m_part != hdr.destination || !(hdr.source < m_parts)
+        ||  m_part == hdr.source)
+            return "partition mismatch";
+
+        // Each record takes (dimension + 1) varints of 1 to 10 bytes
+        const uint64_t fields = dimension() + 1;
+        if (hdr.cell_cnt > hdr.payload_size / fields
+        ||  hdr.payload_size / fields / 10 > hdr.cell_cnt)
+            return "corrupt header";
+
+        return NULL;
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  All the partitions must use the same partition count and block bits.
+     *  See \ref hash::linear for notes on table size, capacity and growth
+     *  (outbox and halo tables always grow).
+     *
+     *  \param  dimension  Space dimension
+     *  \param  part       Partition (index)
+     *  \param  parts      Partition count
+     *  \param  size       Partition table size
+     *  \param  capacity   Partition table capacity (default by \ref hash::linear)
+     *  \param  growth     Partition table growth factor (0 means fixed size)
+     *  \param  block      Block bits (blocks have 2^block cells per side)
+     */
+    partitioned(
+        size_t   dimension,
+        size_t   part,
+        size_t   parts,
+        size_t   size,
+        size_t   capacity = 0,
+        double   growth   = 0,
+        unsigned block    = 4)
+    :
+        m_part     ( part  ),
+        m_parts    ( parts ),
+        m_block    ( block ),
+        m_owner_fn ( 0x85ebca6b ),
+        m_local    ( dimension, size, capacity, growth ),
+        m_halo     ( dimension, outbox_size(size, parts ? parts : 1), 0, 2.0 ),
+        m_halo_out ( parts ),
+        m_cell     ( pattern::impl::point_type<Base_t, N>::zero(dimension) )
+    {
+        if (!(part < parts) || block >= 8 * sizeof(Base_t))
+            throw std::logic_error(
+                "libaccl::backend::partitioned: "
+                "invalid partitioning");
+
+        m_outbox.reserve(parts);
+        for (size_t i = 0; i < parts; ++i)
+            m_outbox.emplace_back(dimension,
+                i == part ? 1 : outbox_size(size, parts), 0, 2.0);
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return m_local.dimension(); }
+
+    /** Partition (index) */
+    size_t part() const { return m_part; }
+
+    /** Partition count */
+    size_t parts() const { return m_parts; }
+
+    /** Block bits */
+    unsigned block() const { return m_block; }
+
+    /** Number of partition cells that received a vote */
+    size_t size() const { return m_local.size(); }
+
+    /** Partition cells */
+    const local_t & local() const { return m_local; }
+
+    /**
+     *  \brief  Cell owner
+     *
+     *  \param  point  Cell coordinates
+     *
+     *  \return Partition owning the cell
+     */
+    size_t owner(const point_t & point) const {
+        if (1 == m_parts) return 0;
+
+        return m_owner_fn.hash(block_view(point, m_block)) % m_parts;
+    }
+
+    /**
+     *  \brief  Number of cells with votes waiting for shipping
+     *
+     *  \param  part  Destination partition
+     */
+    size_t pending(size_t part) const {
+        check(part, "pending");
+        return m_outbox[part].size();
+    }
+
+    /** Bind kernel (nothing to precompute) */
+    void bind(const kernel_t & ) {}
+
+    /** Empty backend of the same configuration (for parallel voting) */
+    partitioned shard() const {
+        return partitioned(dimension(), m_part, m_parts,
+            m_local.table().size(), m_local.table().capacity(),
+            m_local.table().growth(), m_block);
+    }
+
+    /**
+     *  \brief  Merge votes of another backend
+     *
+     *  Partition cells and votes waiting for shipping are merged.
+     *
+     *  \param  other  Backend of the same configuration (and partition)
+     */
+    void merge(const partitioned & other) {
+        if (other.m_part != m_part || other.m_parts != m_parts
+        ||  other.m_block != m_block)
+            throw std::logic_error(
+                "libaccl::backend::partitioned::merge: "
+                "partitioning mismatch");
+
+        m_local.merge(other.m_local);
+        for (size_t i = 0; i < m_parts; ++i)
+            if (i != m_part) m_outbox[i].merge(other.m_outbox[i]);
+    }
+
+    /**
+     *  \brief  Add votes of saved backend (offline merge)
+     *
+     *  Cells of other partitions are routed to their outboxes
+     *  (so partitions may also be repartitioned offline).
+     *
+     *  \param  mapped  Saved cell table (see \ref save and \ref map)
+     */
+    void load(const mapped_t & mapped) {
+        for (size_t i = 0; i < mapped.size(); ++i)
+            if (mapped.used(i)) add(mapped.at(i).point, mapped.at(i).count);
+    }
+
+    /**
+     *  \brief  Save partition cells (see \ref sparse::save)
+     *
+     *  Votes waiting for shipping and halo are not saved.
+     *
+     *  \param  out  Output stream (binary)
+     */
+    void save(std::ostream & out) const { m_local.save(out); }
+
+    /**
+     *  \brief  Save partition cells
+     *
+     *  \param  file  File path
+     */
+    void save(const std::string & file) const { m_local.save(file); }
+
+    /**
+     *  \brief  Map saved cells
+     *
+     *  \param  file  File path
+     *
+     *  \return Mapped cell table
+     */
+    static mapped_t map(const std::string & file) {
+        return local_t::map(file);
+    }
+
+    /**
+     *  \brief  Erase partition cells with too few votes
+     *
+     *  \param  threshold  Minimal vote count of a cell to keep
+     */
+    void prune(Count_t threshold) { m_local.prune(threshold); }
+
+    /**
+     *  \brief  Add votes to cell
+     *
+     *  Votes for cells of other partitions wait for shipping.
+     *
+     *  \param  point  Cell coordinates
+     *  \param  votes  Votes
+     */
+    void add(const point_t & point, Count_t votes) {
+        const size_t part = owner(point);
+        (part == m_part ? m_local : m_outbox[part]).add(point, votes);
+    }
+
+    /**
+     *  \brief  Vote
+     *
+     *  \param  sample  Sample coordinates
+     *  \param  kernel  Voting kernel
+     */
+    void vote(const Base_t * sample, const kernel_t & kernel) {
+        const size_t dim = dimension();
+
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            const Base_t * offset = kernel.offset(i);
+            for (size_t d = 0; d < dim; ++d)
+                m_cell[d] = sample[d] + offset[d];
+
+            add(m_cell, kernel.weight(i));
+        }
+    }
+
+    /**
+     *  \brief  Ship votes for cells of another partition
+     *
+     *  The votes are written as one batch and forgotten.
+     *
+     *  \param  part  Destination partition
+     *  \param  out   Output stream (binary)
+     *
+     *  \return Number of cells shipped
+     */
+    size_t send(size_t part, std::ostream & out) {
+        check(part, "send");
+
+        std::vector<record_t> records;
+        records.reserve(m_outbox[part].size());
+        m_outbox[part].for_each([&records](const point_t & p, Count_t c) {
+            records.emplace_back(p, c);
+        });
+
+        write(out, impl::BATCH_VOTES, part, records);
+        m_outbox[part].clear();
+
+        return records.size();
+    }
+
+    /**
+     *  \brief  Collect halo
+     *
+     *  Partition cells with at least \c threshold votes next to cells
+     *  of other partitions are prepared for shipping (see \ref send_halo).
+     *  Halo received before is dropped.
+     *  Note that peaks found with (at least) the same threshold are
+     *  exact, since neighbours with fewer votes can't suppress them.
+     *
+     *  \param  threshold  Minimal vote count
+     */
+    void halo(Count_t threshold) {
+        m_halo.clear();
+        for (size_t i = 0; i < m_parts; ++i) m_halo_out[i].clear();
+
+        if (1 == m_parts) return;
+
+        const size_t dim  = dimension();
+        const Base_t last = ((Base_t)1 << m_block) - 1;
+        const std::vector<Base_t> & neighbours =
+            libaccl::impl::neighbourhood<Base_t>(dim);
+
+        std::vector<size_t> shipped(m_parts, 0);  // last cell shipped + 1
+        size_t serial = 0;
+
+        point_t n = pattern::impl::point_type<Base_t, N>::zero(dim);
+        m_local.for_each(
+        [&](const point_t & point, Count_t count) {
+            if (count < threshold) return;
+
+            // Cells inside block only have neighbours in the same block
+            size_t d = 0;
+            for (; d < dim; ++d) {
+                const Base_t low = point[d] & last;
+                if (0 == low || last == low) break;
+            }
+            if (d == dim) return;
+
+            ++serial;
+            for (size_t i = 0; i < neighbours.size(); i += dim) {
+                for (d = 0; d < dim; ++d)
+                    n[d] = point[d] + neighbours[i + d];
+
+                const size_t part = owner(n);
+                if (part == m_part || serial == shipped[part]) continue;
+
+                m_halo_out[part].emplace_back(point, count);
+                shipped[part] = serial;
+            }
+        });
+    }
+
+    /**
+     *  \brief  Ship halo to another partition (see \ref halo)
+     *
+     *  \param  part  Destination partition
+     *  \param  out   Output stream (binary)
+     *
+     *  \return Number of cells shipped
+     */
+    size_t send_halo(size_t part, std::ostream & out) {
+        check(part, "send_halo");
+
+        std::vector<record_t> records;
+        records.swap(m_halo_out[part]);
+        write(out, impl::BATCH_HALO, part, records);
+
+        return records.size();
+    }
+
+    /**
+     *  \brief  Receive batch (see \ref send and \ref send_halo)
+     *
+     *  Votes are added to partition cells; halo cells are kept
+     *  for peak search.
+     *  Throws an exception on malformed batch or batch for another
+     *  partition.
+     *
+     *  \param  in  Input stream (binary)
+     *
+     *  \return Number of cells received
+     */
+    size_t receive(std::istream & in) {
+        impl::batch_header hdr;
+        in.read((char *)&hdr, sizeof(hdr));
+        if (!in)
+            throw std::runtime_error(
+                "libaccl::backend::partitioned::receive: "
+                "truncated batch");
+
+        const char * error = check(hdr);
+        if (NULL != error)
+            throw std::runtime_error(
+                std::string("libaccl::backend::partitioned::receive: ") +
+                error);
+
+        // Payload is read by chunks, so that memory is only taken
+        // by data actually received
+        std::vector<char> payload;
+        for (uint64_t left = hdr.payload_size; left; ) {
+            const size_t chunk = std::min<uint64_t>(left, 1 << 16);
+            payload.resize(payload.size() + chunk);
+            in.read(payload.data() + payload.size() - chunk, chunk);
+            if (!in)
+                throw std::runtime_error(
+                    "libaccl::backend::partitioned::receive: "
+                    "truncated batch");
+
+            left -= chunk;
+        }
+
+        const size_t dim = dimension();
+        const bool   halo = impl::BATCH_HALO == hdr.kind;
+
+        const char * pos = payload.data();
+        const char * end = pos + payload.size();
+
+        // Records are validated before any of them is applied
+        std::vector<record_t> records;
+        records.reserve(hdr.cell_cnt);  // bounded by payload size
+
+        std::vector<int64_t> prev(dim, 0);
+        for (uint64_t i = 0; i < hdr.cell_cnt; ++i) {
+            bool valid = true;
+            uint64_t x = 0;
+            for (size_t d = 0; d < dim && valid; ++d) {
+                valid = impl::get_varint(pos, end, x);
+                prev[d] += impl::unzigzag(x);
+                m_cell[d] = (Base_t)prev[d];
+            }
+
+            if (!(valid && impl::get_varint(pos, end, x)))
+                throw std::runtime_error(
+                    "libaccl::backend::partitioned::receive: "
+                    "corrupt batch");
+
+            // Votes must be ours, halo must not be
+            if (halo == (owner(m_cell) == m_part))
+                throw std::runtime_error(
+                    "libaccl::backend::partitioned::receive: "
+                    "cell of wrong partition");
+
+            records.emplace_back(m_cell, static_cast<Count_t>(x));
+        }
+
+        if (pos != end)
+            throw std::runtime_error(
+                "libaccl::backend::partitioned::receive: "
+                "corrupt batch");
+
+        local_t & cells = halo ? m_halo : m_local;
+        for (size_t i = 0; i < records.size(); ++i)
+            cells.add(records[i].first, records[i].second);
+
+        return hdr.cell_cnt;
+    }
+
+    /**
+     *  \brief  Cell vote count
+     *
+     *  Cells of other partitions are only known from halo.
+     *
+     *  \param  point  Cell coordinates
+     *
+     *  \return Number of votes for the cell (0 if it got none)
+     */
+    Count_t count(const point_t & point) const {
+        const Count_t count = m_local.count(point);
+        return Count_t() != count ? count : m_halo.count(point);
+    }
+
+    /**
+     *  \brief  Call function for every partition cell with votes
+     *
+     *  \param  fn  Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(Fn fn) const { m_local.for_each(fn); }
+
+    /** Slot count (see \ref sparse::slots) */
+    size_t slots() const { return m_local.slots(); }
+
+    /**
+     *  \brief  Call function for every partition cell with votes
+     *          in slot range
+     *
+     *  \param  begin  Range begin (slot index)
+     *  \param  end    Range end (slot index)
+     *  \param  fn     Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(size_t begin, size_t end, Fn fn) const {
+        m_local.for_each(begin, end, fn);
+    }
+
+    /**
+     *  \brief  Local maxima of partition cells in slot range
+     *
+     *  See \ref dense::maxima; neighbours of other partitions are
+     *  looked up in halo (see \ref halo).
+     *
+     *  \param  threshold   Minimal vote count
+     *  \param  neighbours  Neighbourhood offsets
+     *  \param  begin       Range begin (slot index)
+     *  \param  end         Range end (slot index)
+     *  \param  fn          Function, called with peak coordinates and vote count
+     */
+    template <class Fn>
+    void maxima(
+        Count_t                     threshold,
+        const std::vector<Base_t> & neighbours,
+        size_t                      begin,
+        size_t                      end,
+        Fn                          fn) const
+    {
+        impl::maxima(*this, threshold, neighbours, begin, end, fn);
+    }
+
+};  // end of template class partitioned
+
+}}  // end of namespace libaccl::backend
+
+#endif  // end of #ifndef libaccl__backend__partitioned_hxx
@@ -0,0 +1,628 @@
+#ifndef libaccl__backend__sparse_hxx
+#define libaccl__backend__sparse_hxx
+
+/**
+ *  \file
+ *  \brief  Sparse accumulator backend
+ *
+ *  Accumulator cells are kept in a linear hashtable; only cells
+ *  that received a vote take space.
+ *
+ *  \date   2016/01/04
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/hash/linear.hxx"
+#include "libaccl/hash/linear_mapped.hxx"
+#include "libaccl/hash/mix.hxx"
+#include "libaccl/pattern/points.hxx"
+#include "libaccl/pattern/kernel.hxx"
+#include "libaccl/parallel.hxx"
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <cstdlib>
+
+
+namespace libaccl {
+namespace backend {
+
+namespace impl {
+
+/**
+ *  \brief  Local maxima in slot range (by neighbour lookups)
+ *
+ *  See \ref dense::maxima; neighbour cells are looked up by
+ *  \c backend.count (but only for cells with at least \c threshold votes).
+ *
+ *  \param  backend     Backend
+ *  \param  threshold   Minimal vote count
+ *  \param  neighbours  Neighbourhood offsets
+ *  \param  begin       Slot range begin
+ *  \param  end         Slot range end
+ *  \param  fn          Function, called with cell coordinates and vote count
+ */
+template <class Backend, typename Base_t, typename Count_t, class Fn>
+void maxima(
+    const Backend &             backend,
+    Count_t                     threshold,
+    const std::vector<Base_t> & neighbours,
+    size_t                      begin,
+    size_t                      end,
+    Fn                          fn)
+{
+    typedef typename Backend::point_t point_t;
+
+    const size_t dim  = backend.dimension();
+    const size_t half = neighbours.size() / dim / 2;  // lower neighbours
+
+    backend.for_each(begin, end,
+    [&backend, threshold, &neighbours, dim, half, &fn](
+        const point_t & point, Count_t count)
+    {
+        if (count < threshold) return;
+
+        point_t n = point;
+        for (size_t i = 0, k = 0; i < neighbours.size(); i += dim, ++k) {
+            for (size_t d = 0; d < dim; ++d)
+                n[d] = point[d] + neighbours[i + d];
+
+            const Count_t n_count = backend.count(n);
+            if (n_count > count || (n_count == count && k < half))
+                return;  // not a peak
+        }
+
+        fn(point, count);
+    });
+}
+
+/**
+ *  \brief  Cells with at least \c threshold votes (sorted)
+ *
+ *  The cells are collected from slot ranges in parallel and sorted
+ *  by coordinates (lexicographically), see \ref sorted_maxima.
+ *
+ *  \param  backend    Backend
+ *  \param  threshold  Minimal vote count
+ *  \param  threads    Thread count
+ *
+ *  \return Cells (coordinates and vote count), sorted by coordinates
+ */
+template <class Backend, typename Count_t>
+std::vector<std::pair<typename Backend::point_t, Count_t> > candidates(
+    const Backend & backend,
+    Count_t         threshold,
+    unsigned        threads)
+{
+    typedef typename Backend::point_t            point_t;
+    typedef std::pair<point_t, Count_t>          cell_t;
+    typedef std::vector<cell_t>                  cells_t;
+
+    const size_t slots = backend.slots();
+    threads = parallel::thread_cnt(threads);
+    if (threads > slots) threads = slots ? slots : 1;
+
+    std::vector<cells_t> parts(threads);
+    parallel::run(threads,
+    [&backend, threshold, threads, slots, &parts](unsigned i) {
+        const auto range = parallel::chunk(slots, threads, i);
+        cells_t & cells = parts[i];
+
+        backend.for_each(range.first, range.second,
+        [threshold, &cells](const point_t & point, Count_t count) {
+            if (!(count < threshold)) cells.emplace_back(point, count);
+        });
+    });
+
+    cells_t cells(std::move(parts[0]));
+    for (size_t i = 1; i < parts.size(); ++i)
+        cells.insert(cells.end(),
+            std::make_move_iterator(parts[i].begin()),
+            std::make_move_iterator(parts[i].end()));
+
+    std::sort(cells.begin(), cells.end(),
+    [](const cell_t & larg, const cell_t & rarg) {
+        return larg.first < rarg.first;
+    });
+
+    return cells;
+}
+
+/**
+ *  \brief  Local maxima in range of sorted cells (by neighbourhood sweep)
+ *
+ *  See \ref dense::maxima; \c cells are those with at least the threshold
+ *  votes, sorted by coordinates (see \ref candidates).
+ *  Cells under the threshold can't suppress any candidate, so the sorted
+ *  cells are all that needs to be checked.
+ *
+ *  Neighbours of a cell that share the same coordinates prefix
+ *  (all but the last coordinate) form a run of at most 3 sorted cells.
+ *  There are 3^(N-1) such prefixes; the run start keys are the cell
+ *  coordinates shifted by a constant offset, so as the cells are visited
+ *  in order, each run start only moves forward.
+ *  It's tracked by a cursor, set by a binary search for the range
+ *  1st cell and then skipping ahead.
+ *  No hash lookups are done.
+ *
+ *  \param  cells  Sorted cells (coordinates and vote count)
+ *  \param  dim    Space dimension
+ *  \param  begin  Range begin (cell index)
+ *  \param  end    Range end (cell index)
+ *  \param  fn     Function, called with peak coordinates and vote count
+ */
+template <typename Point_t, typename Count_t, class Fn>
+void sorted_maxima(
+    const std::vector<std::pair<Point_t, Count_t> > & cells,
+    size_t                                           dim,
+    size_t                                           begin,
+    size_t                                           end,
+    Fn                                               fn)
+{
+    typedef std::pair<Point_t, Count_t> cell_t;
+
+    if (end > cells.size()) end = cells.size();
+    if (!(begin < end)) return;
+
+    // Prefix offsets (3^(N-1) rows of N-1 offsets from {-1, 0, 1})
+    const size_t last = dim - 1;
+    size_t prefixes = 1;
+    for (size_t d = 0; d < last; ++d) prefixes *= 3;
+
+    std::vector<int> offsets(prefixes * last);
+    for (size_t p = 0; p < prefixes; ++p)
+        for (size_t d = 0, k = p; d < last; ++d, k /= 3)
+            offsets[p * last + d] = (int)(k % 3) - 1;
+
+    auto less = [](const cell_t & larg, const Point_t & rarg) {
+        return larg.first < rarg;
+    };
+
+    // Neighbours run start key (with prefix offsets)
+    Point_t key = cells[begin].first;
+    auto set_key = [&key, &offsets, last](const Point_t & point, size_t p) {
+        for (size_t d = 0; d < last; ++d)
+            key[d] = point[d] + offsets[p * last + d];
+        key[last] = point[last] - 1;
+    };
+
+    // Seek the run starts of the range 1st cell
+    std::vector<size_t> cursor(prefixes);
+    for (size_t p = 0; p < prefixes; ++p) {
+        set_key(cells[begin].first, p);
+        cursor[p] = std::lower_bound(cells.begin(), cells.end(), key, less)
+                  - cells.begin();
+    }
+
+    for (size_t i = begin; i < end; ++i) {
+        const Point_t & point = cells[i].first;
+        const Count_t   count = cells[i].second;
+
+        bool peak = true;
+        for (size_t p = 0; peak && p < prefixes; ++p) {
+            set_key(point, p);
+
+            // Skip to the 1st cell not less than the key
+            size_t & c = cursor[p];
+            while (c < cells.size() && cells[c].first < key) ++c;
+
+            // Neighbours with the prefix
+            for (size_t j = c; j < cells.size(); ++j) {
+                const Point_t & n = cells[j].first;
+                if (!std::equal(key.begin(), key.begin() + last, n.begin())
+                ||  point[last] + 1 < n[last]) break;
+
+                if (j == i) continue;
+
+                const Count_t n_count = cells[j].second;
+                if (n_count > count || (n_count == count && j < i)) {
+                    peak = false;  // not a peak
+                    break;
+                }
+            }
+        }
+
+        if (peak) fn(point, count);
+    }
+}
+
+}  // end of namespace impl
+
+/**
+ *  \brief  Sparse accumulator backend
+ *
+ *  Accumulator cells (cell coordinates and vote count) are stored inline
+ *  in \ref hash::linear table slots.
+ *  Votes are resolved in place; the only allocation happens when a new
+ *  cell is created for runtime dimension (coordinates vector copy).
+ *
+ *  \tparam  Base_t   Base numeric type (integral)
+ *  \tparam  Count_t  Vote count type
+ *  \tparam  N        Space dimension (0 means runtime)
+ */
+template <typename Base_t, typename Count_t, size_t N = 0>
+class sparse {
+    public:
+
+    /** Cell coordinates */
+    typedef typename pattern::impl::point_type<Base_t, N>::type point_t;
+
+    typedef pattern::kernel<Base_t, Count_t, N> kernel_t;  /**< Kernel */
+
+    /** Backend is not thread-safe (parallel voting uses shards) */
+    static const bool concurrent = false;
+
+    /** Peaks are found in sorted candidates (see \ref candidates) */
+    static const bool sorted_maxima = true;
+
+    /** Accumulator cell */
+    struct cell {
+        point_t point;  /**< Cell coordinates */
+        Count_t count;  /**< Vote count       */
+
+        /** New cells are constructed from coordinates (by the table) */
+        typedef std::true_type key_constructed;
+
+        /** Default constructor */
+        cell(): count(0) {}
+
+        /** Constructor (empty cell) */
+        cell(const point_t & p): point(p), count(0) {}
+
+    };  // end of struct cell
+
+    /** Cell key accessor */
+    class key_fn {
+        public:
+
+        inline const point_t & operator () (const cell & c) const {
+            return c.point;
+        }
+
+    };  // end of class key_fn
+
+    /** Cell hash function (masking for power-of-2 table size) */
+    typedef hash::point_hash<point_t> hash_fn;
+
+    typedef hash::linear<cell, hash_fn, point_t, key_fn> table_t;  /**< Table */
+
+    /** Saved cell table (see \ref save, fixed dimension only) */
+    typedef hash::linear_mapped<cell, hash_fn, point_t, key_fn> mapped_t;
+
+    private:
+
+    /** Cell table hash functions (the same for saved tables) */
+    static hash_fn table_hash(size_t i) {
+        return hash_fn(i ? 0x7f4a7c15 : 0x9e3779b9);
+    }
+
+    const size_t         m_dimension;  /**< Space dimension          */
+    table_t              m_tab;        /**< Cells                    */
+    std::vector<point_t> m_cells;      /**< Cell coordinates scratch */
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  See \ref hash::linear for notes on table size, capacity and growth.
+     *
+     *  \param  dimension  Space dimension
+     *  \param  size       Table size
+     *  \param  capacity   Table capacity (default by \ref hash::linear)
+     *  \param  growth     Table growth factor (0 means fixed size)
+     */
+    sparse(
+        size_t dimension,
+        size_t size,
+        size_t capacity = 0,
+        double growth   = 0)
+    :
+        m_dimension ( dimension ),
+        m_tab       ( size, {table_hash(0), table_hash(1)}, capacity )
+    {
+        m_tab.set_growth(growth);
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return N ? N : m_dimension; }
+
+    /** Number of cells that received a vote */
+    size_t size() const { return m_tab.item_cnt(); }
+
+    /** Cell table */
+    const table_t & table() const { return m_tab; }
+
+    /** Bind kernel (nothing to precompute) */
+    void bind(const kernel_t & ) {}
+
+    /** Empty backend of the same configuration (for parallel voting) */
+    sparse shard() const {
+        return sparse(dimension(), m_tab.size(), m_tab.capacity(),
+            m_tab.growth());
+    }
+
+    /**
+     *  \brief  Merge votes of another backend
+     *
+     *  \param  other  Backend of the same configuration
+     */
+    void merge(const sparse & other) {
+        for (auto c = other.m_tab.begin(); c != other.m_tab.end(); ++c)
+            add(c->point, c->count);
+    }
+
+    /**
+     *  \brief  Add votes of saved backend (offline merge)
+     *
+     *  \param  mapped  Saved cell table (see \ref save and \ref map)
+     */
+    void load(const mapped_t & mapped) {
+        for (size_t i = 0; i < mapped.size(); ++i)
+            if (mapped.used(i)) add(mapped.at(i).point, mapped.at(i).count);
+    }
+
+    /**
+     *  \brief  Save cells (see \ref hash::linear_mapped::save)
+     *
+     *  Only available for fixed dimension (cells must be trivially
+     *  copyable).
+     *
+     *  \param  out  Output stream (binary)
+     */
+    void save(std::ostream & out) const { mapped_t::save(m_tab, out); }
+
+    /**
+     *  \brief  Save cells
+     *
+     *  \param  file  File path
+     */
+    void save(const std::string & file) const { mapped_t::save(m_tab, file); }
+
+    /**
+     *  \brief  Map saved cells
+     *
+     *  The saved table is looked up in place (read-only);
+     *  use \ref load to merge it.
+     *
+     *  \param  file  File path
+     *
+     *  \return Mapped cell table
+     */
+    static mapped_t map(const std::string & file) {
+        return mapped_t(file, {table_hash(0), table_hash(1)});
+    }
+
+    /**
+     *  \brief  Erase cells with too few votes
+     *
+     *  The table is compacted afterwards (see \ref hash::linear::compact).
+     *
+     *  \param  threshold  Minimal vote count of a cell to keep
+     */
+    void prune(Count_t threshold) {
+        for (auto c = m_tab.begin(); c != m_tab.end(); ++c)
+            if (c->count < threshold) m_tab.erase(c.index());
+
+        m_tab.compact();
+    }
+
+    /** Erase all cells (the table is compacted, see \ref prune) */
+    void clear() {
+        for (auto c = m_tab.begin(); c != m_tab.end(); ++c)
+            m_tab.erase(c.index());
+
+        m_tab.compact();
+    }
+
+    /**
+     *  \brief  Add votes to cell
+     *
+     *  Throws an exception on table overfill.
+     *
+     *  \param  point  Cell coordinates
+     *  \param  votes  Votes
+     */
+    void add(const point_t & point, Count_t votes) {
+        m_tab[point].count += votes;
+    }
+
+    /**
+     *  \brief  Subtract votes from cell
+     *
+     *  Cells left without votes are erased; the table is compacted
+     *  once tombstones take the free slots reserve (growing tables
+     *  do that by themselves, see \ref hash::linear::set_growth).
+     *  The compaction is incremental; each subtraction advances it
+     *  by a bounded step (see \ref hash::linear::rehash_step).
+     *
+     *  \param  point  Cell coordinates
+     *  \param  votes  Votes (at most the cell vote count)
+     */
+    void subtract(const point_t & point, Count_t votes) {
+        m_tab.rehash_step();  // pending compaction (or growth)
+
+        const ssize_t index = m_tab.find(point);
+        if (0 > index || m_tab.at(index).count < votes)
+            throw std::logic_error(
+                "libaccl::backend::sparse::subtract: "
+                "cell has fewer votes");
+
+        cell & c = m_tab.at(index);
+        c.count -= votes;
+        if (Count_t() != c.count) return;
+
+        m_tab.erase(index);
+
+        if (0 == m_tab.growth() && !m_tab.rehashing() &&
+            m_tab.avail_cnt() > m_tab.size() - m_tab.capacity())
+        {
+            m_tab.compact(true);
+        }
+    }
+
+    /**
+     *  \brief  Retract vote (inverse of \ref vote)
+     *
+     *  \param  sample  Sample coordinates (voted before)
+     *  \param  kernel  Voting kernel
+     */
+    void retract(const Base_t * sample, const kernel_t & kernel) {
+        point_t c = pattern::impl::point_type<Base_t, N>::zero(dimension());
+
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            const Base_t * offset = kernel.offset(i);
+            for (size_t d = 0; d < dimension(); ++d)
+                c[d] = sample[d] + offset[d];
+
+            subtract(c, kernel.weight(i));
+        }
+    }
+
+    /**
+     *  \brief  Vote
+     *
+     *  Cells of the whole kernel are computed first and then added
+     *  by a batch (see \ref hash::linear::add_batch), so that the table
+     *  slots are prefetched.
+     *
+     *  \param  sample  Sample coordinates
+     *  \param  kernel  Voting kernel
+     */
+    void vote(const Base_t * sample, const kernel_t & kernel) {
+        if (m_cells.size() < kernel.size())
+            m_cells.resize(kernel.size(),
+                pattern::impl::point_type<Base_t, N>::zero(dimension()));
+
+        const Base_t * offset = kernel.offsets();
+
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            point_t & c = m_cells[i];
+            for (size_t d = 0; d < dimension(); ++d)
+                c[d] = sample[d] + *offset++;
+        }
+
+        m_tab.add_batch(m_cells.begin(), m_cells.begin() + kernel.size(),
+            kernel.weights(), &cell::count);
+    }
+
+    /**
+     *  \brief  Cell vote count
+     *
+     *  \param  point  Cell coordinates
+     *
+     *  \return Number of votes for the cell (0 if it got none)
+     */
+    Count_t count(const point_t & point) const {
+        ssize_t index = m_tab.find(point);
+        return 0 > index ? Count_t() : m_tab.at(index).count;
+    }
+
+    /**
+     *  \brief  Call function for every cell with votes
+     *
+     *  \param  fn  Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(Fn fn) const {
+        for (auto c = m_tab.begin(); c != m_tab.end(); ++c)
+            fn(c->point, c->count);
+    }
+
+    /** Slot count (for range partitioning, see \ref hash::linear::slots) */
+    size_t slots() const { return m_tab.slots(); }
+
+    /**
+     *  \brief  Call function for every cell with votes in slot range
+     *
+     *  \param  begin  Range begin (slot index)
+     *  \param  end    Range end (slot index)
+     *  \param  fn     Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(size_t begin, size_t end, Fn fn) const {
+        if (end > slots()) end = slots();
+
+        for (auto c = m_tab.begin(begin); c.index() < end; ++c)
+            fn(c->point, c->count);
+    }
+
+    /** Sorted cells with votes over threshold (see \ref candidates) */
+    typedef std::vector<std::pair<point_t, Count_t> > candidates_t;
+
+    /**
+     *  \brief  Cells with at least \c threshold votes (for \ref maxima)
+     *
+     *  \param  threshold  Minimal vote count
+     *  \param  threads    Thread count (0 means hardware concurrency)
+     *
+     *  \return Cells, sorted by coordinates
+     */
+    candidates_t candidates(Count_t threshold, unsigned threads = 1) const {
+        return impl::candidates(*this, threshold, threads);
+    }
+
+    /**
+     *  \brief  Local maxima in range of candidate cells
+     *
+     *  See \ref dense::maxima; neighbourhoods are checked by sweeping
+     *  the sorted candidates (see \ref impl::sorted_maxima).
+     *
+     *  \param  cells  Candidate cells (see \ref candidates)
+     *  \param  begin  Range begin (candidate index)
+     *  \param  end    Range end (candidate index)
+     *  \param  fn     Function, called with peak coordinates and vote count
+     */
+    template <class Fn>
+    void maxima(
+        const candidates_t & cells,
+        size_t               begin,
+        size_t               end,
+        Fn                   fn) const
+    {
+        impl::sorted_maxima(cells, dimension(), begin, end, fn);
+    }
+
+};  // end of template class sparse
+
+}}  // end of namespace libaccl::backend
+
+#endif  // end of #ifndef libaccl__backend__sparse_hxx
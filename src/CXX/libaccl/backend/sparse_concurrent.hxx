@@ -0,0 +1,240 @@
+#ifndef libaccl__backend__sparse_concurrent_hxx
+#define libaccl__backend__sparse_concurrent_hxx
+
+/**
+ *  \file
+ *  \brief  Sparse accumulator backend (concurrent)
+ *
+ *  \date   2016/01/07
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/hash/linear_concurrent.hxx"
+#include "libaccl/backend/sparse.hxx"
+#include "libaccl/pattern/points.hxx"
+#include "libaccl/pattern/kernel.hxx"
+
+#include <stdexcept>
+#include <cstdlib>
+
+
+namespace libaccl {
+namespace backend {
+
+/**
+ *  \brief  Sparse accumulator backend (concurrent)
+ *
+ *  Like \ref sparse, but the cells are stored in
+ *  \ref hash::linear_concurrent table, so that many threads may vote
+ *  into one backend at the same time (votes are atomic fetch-and-adds).
+ *  That is preferable to sharding where shards would take too much memory.
+ *
+ *  \tparam  Base_t   Base numeric type (integral)
+ *  \tparam  Count_t  Vote count type (integral)
+ *  \tparam  N        Space dimension (0 means runtime)
+ */
+template <typename Base_t, typename Count_t, size_t N = 0>
+class sparse_concurrent {
+    public:
+
+    /** Cell coordinates */
+    typedef typename pattern::impl::point_type<Base_t, N>::type point_t;
+
+    typedef pattern::kernel<Base_t, Count_t, N> kernel_t;  /**< Kernel */
+
+    /** Backend is thread-safe (parallel voting shares it) */
+    static const bool concurrent = true;
+
+    /** Peaks are found in sorted candidates (see \ref candidates) */
+    static const bool sorted_maxima = true;
+
+    typedef typename sparse<Base_t, Count_t, N>::cell    cell;     /**< Cell   */
+    typedef typename sparse<Base_t, Count_t, N>::key_fn  key_fn;   /**< Key    */
+    typedef typename sparse<Base_t, Count_t, N>::hash_fn hash_fn;  /**< Hash   */
+
+    /** Table */
+    typedef hash::linear_concurrent<cell, hash_fn, point_t, key_fn> table_t;
+
+    private:
+
+    const size_t m_dimension;  /**< Space dimension */
+    table_t      m_tab;        /**< Cells           */
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  See \ref hash::linear for notes on table size and capacity.
+     *
+     *  \param  dimension  Space dimension
+     *  \param  size       Table size
+     *  \param  capacity   Table capacity (default by \ref hash::linear)
+     */
+    sparse_concurrent(size_t dimension, size_t size, size_t capacity = 0):
+        m_dimension ( dimension ),
+        m_tab       ( size, {hash_fn(0x9e3779b9), hash_fn(0x7f4a7c15)},
+                      capacity )
+    {
+        if (N && N != dimension)
+            throw std::logic_error(
+                "libaccl::backend::sparse_concurrent: "
+                "dimension mismatch");
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return N ? N : m_dimension; }
+
+    /** Number of cells that received a vote */
+    size_t size() const { return m_tab.item_cnt(); }
+
+    /** Cell table */
+    const table_t & table() const { return m_tab; }
+
+    /** Bind kernel (nothing to precompute) */
+    void bind(const kernel_t & ) {}
+
+    /**
+     *  \brief  Add votes to cell (thread-safe)
+     *
+     *  Throws an exception on table overfill.
+     *
+     *  \param  point  Cell coordinates
+     *  \param  votes  Votes
+     */
+    void add(const point_t & point, Count_t votes) {
+        m_tab.fetch_add(point, &cell::count, votes);
+    }
+
+    /**
+     *  \brief  Vote (thread-safe)
+     *
+     *  \param  sample  Sample coordinates
+     *  \param  kernel  Voting kernel
+     */
+    void vote(const Base_t * sample, const kernel_t & kernel) {
+        point_t point = pattern::impl::point_type<Base_t, N>::zero(dimension());
+
+        const Base_t  * offset = kernel.offsets();
+        const Count_t * weight = kernel.weights();
+
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            for (size_t d = 0; d < dimension(); ++d)
+                point[d] = sample[d] + *offset++;
+
+            add(point, weight[i]);
+        }
+    }
+
+    /**
+     *  \brief  Cell vote count
+     *
+     *  \param  point  Cell coordinates
+     *
+     *  \return Number of votes for the cell (0 if it got none)
+     */
+    Count_t count(const point_t & point) const {
+        ssize_t index = m_tab.find(point);
+        return 0 > index ? Count_t() : table_t::load(m_tab.at(index).count);
+    }
+
+    /**
+     *  \brief  Call function for every cell with votes
+     *
+     *  \param  fn  Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(Fn fn) const { for_each(0, slots(), fn); }
+
+    /** Slot count (for range partitioning) */
+    size_t slots() const { return m_tab.size(); }
+
+    /**
+     *  \brief  Call function for every cell with votes in slot range
+     *
+     *  \param  begin  Range begin (slot index)
+     *  \param  end    Range end (slot index)
+     *  \param  fn     Function, called with cell coordinates and vote count
+     */
+    template <class Fn>
+    void for_each(size_t begin, size_t end, Fn fn) const {
+        m_tab.for_each(begin, end, [&fn](size_t , const cell & c) {
+            fn(c.point, table_t::load(c.count));
+        });
+    }
+
+    /** Sorted cells with votes over threshold (see \ref candidates) */
+    typedef std::vector<std::pair<point_t, Count_t> > candidates_t;
+
+    /**
+     *  \brief  Cells with at least \c threshold votes (for \ref maxima)
+     *
+     *  Must not run concurrently with voting.
+     *
+     *  \param  threshold  Minimal vote count
+     *  \param  threads    Thread count (0 means hardware concurrency)
+     *
+     *  \return Cells, sorted by coordinates
+     */
+    candidates_t candidates(Count_t threshold, unsigned threads = 1) const {
+        return impl::candidates(*this, threshold, threads);
+    }
+
+    /**
+     *  \brief  Local maxima in range of candidate cells
+     *
+     *  See \ref dense::maxima; neighbourhoods are checked by sweeping
+     *  the sorted candidates (see \ref impl::sorted_maxima).
+     *
+     *  \param  cells  Candidate cells (see \ref candidates)
+     *  \param  begin  Range begin (candidate index)
+     *  \param  end    Range end (candidate index)
+     *  \param  fn     Function, called with peak coordinates and vote count
+     */
+    template <class Fn>
+    void maxima(
+        const candidates_t & cells,
+        size_t               begin,
+        size_t               end,
+        Fn                   fn) const
+    {
+        impl::sorted_maxima(cells, dimension(), begin, end, fn);
+    }
+
+};  // end of template class sparse_concurrent
+
+}}  // end of namespace libaccl::backend
+
+#endif  // end of #ifndef libaccl__backend__sparse_concurrent_hxx
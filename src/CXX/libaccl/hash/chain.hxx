@@ -0,0 +1,282 @@
+#ifndef libaccl__hash__chain_hxx
+#define libaccl__hash__chain_hxx
+
+/**
+ *  \file
+ *  \brief  Hash functions chain
+ *
+ *  \date   2016/01/08
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <tuple>
+#include <initializer_list>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+namespace hash {
+
+/**
+ *  \brief  Hash function wrapper
+ *
+ *  Turns a function into a functor type so that calls may be inlined
+ *  (unlike calls via function pointer).
+ *  Example: \c function<decltype(&my_hash),&my_hash>
+ *
+ *  \tparam  Fn_t  Function type
+ *  \tparam  Fn    Function
+ */
+template <typename Fn_t, Fn_t Fn>
+class function {
+    public:
+
+    template <typename Key_t>
+    inline size_t operator () (const Key_t & key, size_t size) const {
+        return Fn(key, size);
+    }
+
+};  // end of template class function
+
+/**
+ *  \brief  Static chain of hash functions
+ *
+ *  Hash tables (like \ref linear) accept the chain as their \c Hash_fn
+ *  parameter; the hash functions are then given by template parameters
+ *  (instead of a vector of functors), so the multiple hashing loop
+ *  is unrolled at compile time and the calls may be inlined.
+ *  Pass empty hash functions list to the table constructor
+ *  (the functors are default-constructed) or a chain instance.
+ *
+ *  \tparam  Hash_fns  Hash functors
+ */
+template <class... Hash_fns>
+class chain {
+    static_assert(sizeof...(Hash_fns) > 0, "at least one hash function required");
+
+    public:
+
+    typedef std::tuple<Hash_fns...> functors_t;  /**< Hash functors */
+
+    private:
+
+    functors_t m_fn;  /**< Hash functors */
+
+    public:
+
+    /** Default constructor */
+    chain() {}
+
+    /** Constructor */
+    chain(const Hash_fns &... fn): m_fn(fn...) {}
+
+    /** Number of hash functions */
+    static const size_t size = sizeof...(Hash_fns);
+
+    /** Hash functors */
+    const functors_t & functors() const { return m_fn; }
+
+};  // end of template class chain
+
+namespace impl {
+
+/** Full (unreduced) hash, provided by the hash functor */
+template <class Hash_fn, typename Key_t>
+inline auto full_hash(const Hash_fn & fn, const Key_t & key, int)
+    -> decltype((uint64_t)fn.hash(key))
+{
+    return fn.hash(key);
+}
+
+/** Full (unreduced) hash, maximal table size otherwise */
+template <class Hash_fn, typename Key_t>
+inline uint64_t full_hash(const Hash_fn & fn, const Key_t & key, long) {
+    return fn(key, ~(size_t)0);
+}
+
+/**
+ *  \brief  Hash functions of a table
+ *
+ *  Generic version: runtime vector of \c Hash_fn functors.
+ *
+ *  \tparam  Hash_fn  Hash functor
+ */
+template <class Hash_fn>
+class hash_fns {
+    private:
+
+    std::vector<Hash_fn> m_fn;  /**< Hash functors */
+
+    public:
+
+    /** Constructor */
+    hash_fns(const std::initializer_list<Hash_fn> & fn): m_fn(fn) {}
+
+    /** Number of hash functions */
+    size_t size() const { return m_fn.size(); }
+
+    /** Primary hash (full, not reduced to table size) */
+    template <typename Key_t>
+    uint64_t first(const Key_t & key) const {
+        return full_hash(m_fn.front(), key, 0);
+    }
+
+    /** Primary hash index */
+    template <typename Key_t>
+    size_t first(const Key_t & key, size_t size) const {
+        return m_fn.front()(key, size);
+    }
+
+    /** Last hash */
+    template <typename Key_t>
+    size_t last(const Key_t & key, size_t size) const {
+        return m_fn.back()(key, size);
+    }
+
+    /**
+     *  \brief  Probe hash indices
+     *
+     *  Calls \c fn(index) for hash indices in order until it returns \c true.
+     *
+     *  \param  key    Key
+     *  \param  size   Table size
+     *  \param  index  Last hash index (output)
+     *  \param  fn     Index check
+     *
+     *  \return \c true iff \c fn returned \c true
+     */
+    template <typename Key_t, class Fn>
+    bool probe(const Key_t & key, size_t size, size_t & index, Fn fn) const {
+        for (size_t i = 0; i < m_fn.size(); ++i) {
+            index = m_fn[i](key, size);
+
+            if (fn(index)) return true;
+        }
+
+        return false;
+    }
+
+};  // end of template class hash_fns
+
+/**
+ *  \brief  Hash functions of a table
+ *
+ *  Static chain version: the probing is unrolled at compile time.
+ *
+ *  \tparam  Hash_fns  Hash functors
+ */
+template <class... Hash_fns>
+class hash_fns<chain<Hash_fns...> > {
+    private:
+
+    typedef chain<Hash_fns...>            chain_t;  /**< Chain     */
+    typedef typename chain_t::functors_t  fns_t;    /**< Functors  */
+
+    static const size_t N = sizeof...(Hash_fns);   /**< Functions */
+
+    fns_t m_fn;  /**< Hash functors */
+
+    /** Probe hash index (recursion) */
+    template <typename Key_t, class Fn, size_t I>
+    bool probe(
+        const Key_t & key, size_t size, size_t & index, Fn & fn,
+        std::integral_constant<size_t, I>)
+    const {
+        index = std::get<I>(m_fn)(key, size);
+
+        return fn(index) || probe(key, size, index, fn,
+            std::integral_constant<size_t, I + 1>());
+    }
+
+    /** Probe hash index (recursion end) */
+    template <typename Key_t, class Fn>
+    bool probe(
+        const Key_t & , size_t , size_t & , Fn & ,
+        std::integral_constant<size_t, N>)
+    const {
+        return false;
+    }
+
+    public:
+
+    /** Constructor (empty list means default functors) */
+    hash_fns(const std::initializer_list<chain_t> & fn):
+        m_fn(fn.size() ? fn.begin()->functors() : fns_t())
+    {
+        if (fn.size() > 1)
+            throw std::logic_error(
+                "libaccl::hash::chain: "
+                "at most one chain expected");
+    }
+
+    /** Number of hash functions */
+    size_t size() const { return N; }
+
+    /** Primary hash (full, not reduced to table size) */
+    template <typename Key_t>
+    uint64_t first(const Key_t & key) const {
+        return full_hash(std::get<0>(m_fn), key, 0);
+    }
+
+    /** Primary hash index */
+    template <typename Key_t>
+    size_t first(const Key_t & key, size_t size) const {
+        return std::get<0>(m_fn)(key, size);
+    }
+
+    /** Last hash */
+    template <typename Key_t>
+    size_t last(const Key_t & key, size_t size) const {
+        return std::get<N - 1>(m_fn)(key, size);
+    }
+
+    /** Probe hash indices (see the generic version) */
+    template <typename Key_t, class Fn>
+    bool probe(const Key_t & key, size_t size, size_t & index, Fn fn) const {
+        return probe(key, size, index, fn,
+            std::integral_constant<size_t, 0>());
+    }
+
+};  // end of template class hash_fns specialisation
+
+}  // end of namespace impl
+
+}}  // end of namespace libaccl::hash
+
+#endif  // end of #ifndef libaccl__hash__chain_hxx
@@ -41,11 +41,27 @@
  *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "libaccl/hash/chain.hxx"
+#include "libaccl/hash/mix.hxx"
+#include "libaccl/hash/stats.hxx"
+
 #include <vector>
 #include <list>
+#include <memory>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <iterator>
 #include <initializer_list>
+#include <type_traits>
 #include <stdexcept>
 #include <cstdlib>
+#include <cstdint>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 namespace libaccl {
@@ -64,9 +80,278 @@ class identity_key {
 
 };  // end of template class identity_key
 
+/** \c void (for detection of member types) */
+template <typename T>
+struct void_type { typedef void type; };
+
+/** Control byte of empty slot (used slots hold 7-bit key fingerprint) */
+static const uint8_t CTRL_EMPTY = 0x80;
+
+/** Control byte of available slot */
+static const uint8_t CTRL_AVAIL = 0xfe;
+
+/** Control bytes group size */
+static const size_t CTRL_GROUP = 16;
+
+/** Batch prefetch distance (number of keys prefetched ahead) */
+static const size_t BATCH = 16;
+
+/** Control byte of slot in use */
+inline bool ctrl_used(uint8_t ctrl) { return !(ctrl & 0x80); }
+
+/**
+ *  \brief  Match group of control bytes
+ *
+ *  \param  ctrl   Control bytes (\ref CTRL_GROUP)
+ *  \param  fp     Key fingerprint
+ *  \param  avail  Match available slots, too
+ *
+ *  \return Bit mask of empty slots and slots with matching fingerprint
+ *          (and available slots if required)
+ */
+inline unsigned ctrl_match(const uint8_t * ctrl, uint8_t fp, bool avail) {
+#ifdef __SSE2__
+    const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+
+    __m128i match = _mm_or_si128(
+        _mm_cmpeq_epi8(group, _mm_set1_epi8((char)fp)),
+        _mm_cmpeq_epi8(group, _mm_set1_epi8((char)CTRL_EMPTY)));
+
+    if (avail)
+        match = _mm_or_si128(match,
+            _mm_cmpeq_epi8(group, _mm_set1_epi8((char)CTRL_AVAIL)));
+
+    return (unsigned)_mm_movemask_epi8(match);
+#else
+    unsigned match = 0;
+    for (size_t i = 0; i < CTRL_GROUP; ++i)
+        if (fp == ctrl[i] || CTRL_EMPTY == ctrl[i]
+        ||  (avail && CTRL_AVAIL == ctrl[i])) match |= 1U << i;
+
+    return match;
+#endif
+}
+
+/**
+ *  \brief  Key fingerprint
+ *
+ *  7 bits of the (full) primary hash,
+ *  stored in control bytes of used slots.
+ *
+ *  \param  hash_fn  Hash functors
+ *  \param  key      Item key
+ *
+ *  \return Fingerprint
+ */
+template <class Hash_fns, typename Key_t>
+uint8_t fingerprint(const Hash_fns & hash_fn, const Key_t & key) {
+    const unsigned long long h = hash_fn.first(key);
+    return (uint8_t)((h * 0x9e3779b97f4a7c15ULL) >> 57);
+}
+
+/**
+ *  \brief  Check item indices
+ *
+ *  The function implements \ref get_index indices resolution.
+ *  Table \c Tab provides \c ctrl (control bytes), \c item(index),
+ *  \c size() and \c max_probe.
+ *  Probe position is the number of slots checked so far (including
+ *  the current one); search may stop when it exceeds the longest
+ *  probe of an item in the table.
+ *  Search probe position is where the search ended (the longest probe
+ *  if it stopped there).
+ *
+ *  \param  key_fn      Key accessor
+ *  \param  tab         Table
+ *  \param  key         Item key
+ *  \param  fp          Key fingerprint
+ *  \param  index       Current index
+ *  \param  pos         Current probe position
+ *  \param  insert      Insert index
+ *  \param  insert_pos  Insert probe position
+ *  \param  find        Search index
+ *  \param  find_pos    Search probe position
+ *
+ *  \return \c true iff required indices are set (\ref get_index may return)
+ */
+template <class Tab, typename Key_t, class Key_fn>
+bool check_index(
+    const Key_fn & key_fn,
+    const Tab    & tab,
+    const Key_t  & key,
+    uint8_t        fp,
+    size_t         index,
+    size_t         pos,
+    ssize_t *    & insert,
+    size_t       * insert_pos,
+    ssize_t *    & find,
+    size_t       * find_pos)
+{
+    // No item is further
+    if (!insert && pos > tab.max_probe) {
+        if (find)     *find     = -1;
+        if (find_pos) *find_pos = tab.max_probe;
+
+        return 1;  // not found
+    }
+
+    switch (tab.ctrl[index]) {
+        case impl::CTRL_EMPTY:
+            if (insert) {
+                *insert = index;  // insert to empty slot
+                if (insert_pos) *insert_pos = pos;
+            }
+
+            if (find)     *find     = -1;  // had been here if present
+            if (find_pos) *find_pos = pos;
+
+            return 1;  // that's it
+
+        case impl::CTRL_AVAIL:
+            if (insert) {
+                *insert = index;  // insert to available slot
+                if (insert_pos) *insert_pos = pos;
+            }
+
+            if (!find) return 1;  // no reason to continue
+
+            // Continue looking for the item
+            insert = NULL;
+            break;
+
+        default:  // used
+            if (fp == tab.ctrl[index] && key_fn(*tab.item(index)) == key) {
+                if (insert)   *insert   = -1;     // already exists
+                if (find)     *find     = index;  // gotcha!
+                if (find_pos) *find_pos = pos;
+
+                return 1;  // all done
+            }
+    }
+
+    return 0;  // continue
+}
+
+/**
+ *  \brief  Find item index in table
+ *
+ *  The collision string is scanned by groups of control bytes;
+ *  only slots that may stop the scan (empty, available if insert
+ *  index is required, used with matching fingerprint) are checked.
+ *  Search (without insertion) ends at the table longest probe.
+ *
+ *  \param  hash_fn     Hash functors
+ *  \param  key_fn      Key accessor
+ *  \param  tab         Table
+ *  \param  key         Item key
+ *  \param  fp          Key fingerprint
+ *  \param  insert      Insert index (optional)
+ *  \param  insert_pos  Insert probe position (optional)
+ *  \param  find        Search index (optional)
+ *  \param  find_pos    Search probe position (optional)
+ */
+template <class Hash_fns, class Tab, typename Key_t, class Key_fn>
+void get_index(
+    const Hash_fns & hash_fn,
+    const Key_fn   & key_fn,
+    const Tab      & tab,
+    const Key_t    & key,
+    uint8_t          fp,
+    ssize_t        * insert,
+    size_t         * insert_pos,
+    ssize_t        * find,
+    size_t         * find_pos = NULL)
+{
+    size_t index = 0;
+    size_t pos   = 0;
+
+    // (Multiple) hashing
+    if (hash_fn.probe(key, tab.size(), index,
+        [&key_fn, &tab, &key, fp, &pos, &insert, insert_pos, &find, find_pos]
+        (size_t ix) {
+            return check_index(key_fn, tab, key, fp, ix, ++pos,
+                insert, insert_pos, find, find_pos);
+        })) return;
+
+    // Collision string (from the last hash index till the end
+    // of the table, then from the table beginning)
+    const size_t begin_ix  = index;
+    const size_t begin_pos = pos + 1 - begin_ix;  // position of index 0
+    const size_t wrap_pos  = begin_pos + tab.size();
+    for (bool wrapped = false; ; ) {
+        const size_t end_ix = wrapped ? begin_ix : tab.size();
+        pos = (wrapped ? wrap_pos : begin_pos) + index;
+
+        if (!insert && pos > tab.max_probe) {  // no item is further
+            if (find_pos) *find_pos = tab.max_probe;
+            break;
+        }
+
+        if (index + impl::CTRL_GROUP <= end_ix) {
+            unsigned mask = impl::ctrl_match(
+                &tab.ctrl[index], fp, NULL != insert);
+
+            for (; mask; mask &= mask - 1) {
+                const size_t off = __builtin_ctz(mask);
+
+                if (check_index(key_fn, tab, key, fp, index + off, pos + off,
+                    insert, insert_pos, find, find_pos)) return;
+            }
+
+            index += impl::CTRL_GROUP;
+        }
+        else if (index < end_ix) {
+            if (check_index(key_fn, tab, key, fp, index, pos,
+                insert, insert_pos, find, find_pos)) return;
+
+            ++index;
+        }
+        else if (!wrapped) {
+            index   = 0;
+            wrapped = true;
+        }
+        else {  // whole table run through
+            if (find_pos) *find_pos = pos - 1;
+            break;
+        }
+    }
+
+    if (insert) *insert = -1;
+    if (find)   *find   = -1;
+}
+
 }  // end of namespace impl
 
 
+/**
+ *  \brief  New items are constructed from key
+ *
+ *  Items created by \ref linear::operator[] (and alike) for missing keys
+ *  are value-initialised by default.
+ *  Items constructible from the key may opt in to be constructed from it
+ *  by \c key_constructed member type (\c std::true_type), or by
+ *  specialisation of this trait.
+ *  Self-keyed items (the key type is the item type) are always
+ *  constructed from the key.
+ *
+ *  \tparam  Item_t  Item type
+ *  \tparam  Key_t   Key type
+ */
+template <typename Item_t, typename Key_t, typename = void>
+struct key_constructed: std::is_same<Item_t, Key_t> {};
+
+/** Item type opts in by \c key_constructed member type */
+template <typename Item_t, typename Key_t>
+struct key_constructed<Item_t, Key_t,
+    typename impl::void_type<typename Item_t::key_constructed>::type>:
+    Item_t::key_constructed {};
+
+
+// Read-only memory-mapped table (see libaccl/hash/linear_mapped.hxx)
+template <typename Item_t, class Hash_fn, typename Key_t, class Key_fn>
+class linear_mapped;
+
+
 /**
  *  \brief  Hashtable with linear collision resolution
  *
@@ -78,6 +363,38 @@ class identity_key {
  *  If all hash functions fail to find an unused slot then the next one in row
  *  that is unused is taken for the collision resolution.
  *  Note that it is recommended to use at least two hash functions.
+ *  The hash functions are either passed to the constructor as a list
+ *  of \c Hash_fn functors or given statically by \c Hash_fn being
+ *  \ref chain (which allows for inlining).
+ *
+ *  Slot states are kept in a separate array of control bytes (apart from
+ *  the items); used slots hold a 7-bit key fingerprint there, so most
+ *  of the probed slots are rejected without touching the items.
+ *  The collision string is scanned by groups of 16 control bytes
+ *  (using SSE2 if available).
+ *  The table records the longest probe (number of slots checked)
+ *  of its items; unsuccessful search stops there instead of running
+ *  to the first empty slot, so misses stay cheap even at high load.
+ *
+ *  The table may grow automatically (see \ref set_growth).
+ *  When the item count reaches the table capacity, a larger table is
+ *  allocated and the items are moved incrementally, a few slots per
+ *  modification, so that no single operation rehashes the whole table.
+ *  During the migration, items are looked up in both tables.
+ *
+ *  Erased items leave available slots (tombstones) so that probe paths
+ *  of other items stay intact; tombstones are reused by insertions and
+ *  removed by \ref compact (the same incremental rehash, to a table
+ *  of the same size).
+ *
+ *  Tables of trivially copyable items may be saved to a flat file
+ *  and memory-mapped read-only (see \ref linear_mapped).
+ *
+ *  Table layout (probe lengths, slot states, clusters) may be inspected
+ *  by \ref snapshot at any time.
+ *  Operations are counted if the \c Stats policy is set to
+ *  \ref stats::counters (see \ref stats); the default \ref stats::none
+ *  policy costs nothing.
  *
  *  Items need keys which may or may not be part of them (even themselves).
  *  The \c Key_fn is used to access an item key.
@@ -85,97 +402,189 @@ class identity_key {
  *  it may be reconstructed on demand (although that may not be much efficient).
  *  Keys must be comparable using \c == operator.
  *
- *  Note that the \c Item_t item type must have default constructor and is NOT
- *  destroyed on removal from table.
- *  It should be considered more a handle, unless it is a primitive type.
- *  Use pointers or iterators to aggregate objects.
+ *  Items are constructed in place in uninitialized slot storage (copied,
+ *  moved or emplaced), moved when the table is rehashed and destroyed
+ *  on removal from table.
+ *  New items created by \ref operator[] are value-initialised, unless
+ *  the item type opts in to be constructed from the key
+ *  (see \ref key_constructed); default constructor is not required
+ *  otherwise.
  *
  *  \tparam  Item_t   Item type (must be comparable with \c ==)
  *  \tparam  Hash_fn  Hash functor, accepts \c Key_t and \c size_t (table size)
+ *                    (or \ref chain of such functors)
  *  \tparam  Key_t    Key type (the item type by default)
  *  \tparam  Key_fn   Key accessor (item identity by default)
+ *  \tparam  Stats    Statistics policy (none by default)
  */
 template <
     typename Item_t,
     class    Hash_fn,
     typename Key_t   = Item_t,
-    class    Key_fn  = impl::identity_key<Item_t> >
+    class    Key_fn  = impl::identity_key<Item_t>,
+    class    Stats   = stats::none>
 class linear {
+    friend class linear_mapped<Item_t, Hash_fn, Key_t, Key_fn>;
+
     private:
 
-    /** Table slot */
-    struct slot {
-        /** Table slot type */
-        enum type_t {
-            EMPTY = 0,  /**< Empty slot (unused yet)          */
-            AVAIL,      /**< Available slot (previously used) */
-            USED        /**< Slot in use                      */
-        };  // end of enum type_t
+    /** Table (control bytes and items in separate arrays) */
+    struct table {
+        /** Item storage (uninitialized) */
+        typedef typename std::aligned_storage<
+            sizeof(Item_t), alignof(Item_t)>::type storage_t;
 
-        type_t type;  /**< Slot type        */
-        Item_t item;  /**< Item in the slot */
+        std::vector<uint8_t>         ctrl;       /**< Slot control bytes     */
+        std::unique_ptr<storage_t[]> data;       /**< Slot items storage     */
+        size_t                       max_probe;  /**< Longest item probe     */
 
         /** Constructor */
-        slot(): type(EMPTY) {}
+        table(size_t size = 0):
+            ctrl      ( size, impl::CTRL_EMPTY               ),
+            data      ( size ? new storage_t[size] : NULL    ),
+            max_probe ( 0                                    )
+        {}
+
+        /** Copy constructor (copies items in use) */
+        table(const table & orig):
+            ctrl      ( orig.size(), impl::CTRL_EMPTY        ),
+            data      ( orig.size() ? new storage_t[orig.size()] : NULL ),
+            max_probe ( orig.max_probe                       )
+        {
+            try {
+                for (size_t i = 0; i < size(); ++i) {
+                    if (impl::ctrl_used(orig.ctrl[i]))
+                        new (item(i)) Item_t(*orig.item(i));
 
-        /** Item assignment */
-        Item_t & operator = (const Item_t & it) {
-            type = USED;
-            return item = it;
+                    ctrl[i] = orig.ctrl[i];
+                }
+            }
+            catch (...) {
+                clear();
+                throw;
+            }
         }
 
-    };  // end of struct slot
+        /** Move constructor */
+        table(table && orig):
+            ctrl      ( std::move(orig.ctrl) ),
+            data      ( std::move(orig.data) ),
+            max_probe ( orig.max_probe       )
+        {
+            orig.ctrl.clear();
+        }
 
-    std::vector<Hash_fn> m_hash_fn;   /**< Hash functors      */
-    std::vector<slot>    m_tab;       /**< Hash table         */
-    size_t               m_item_cnt;  /**< Current item count */
-    const size_t         m_capacity;  /**< Table capacity     */
-    const Key_fn         m_key_fn;    /**< Key accessor       */
+        /** Assignment */
+        table & operator = (table orig) { swap(orig); return *this; }
 
-    /**
-     *  \brief  Check item indices
-     *
-     *  The function implements \ref get_index indices resolution.
-     *
-     *  \param  key     Item key
-     *  \param  index   Current index
-     *  \param  insert  Insert index
-     *  \param  find    Search index
-     *
-     *  \return \c true iff required indices are set (\ref get_index may return)
-     */
-    bool check_index(
-        const Key_t & key,
-        size_t        index,
-        ssize_t *   & insert,
-        ssize_t *   & find)
-    const {
-        switch (m_tab[index].type) {
-            case slot::EMPTY:
-                if (insert) *insert = index;  // insert to empty slot
-                if (find)   *find   = -1;     // had been here if present
+        /** Destructor */
+        ~table() { clear(); }
 
-                return 1;  // that's it
+        /** Table size */
+        size_t size() const { return ctrl.size(); }
 
-            case slot::AVAIL:
-                if (insert) *insert = index;  // insert to available slot
+        /** Table is empty (no slots) */
+        bool empty() const { return ctrl.empty(); }
 
-                if (!find) return 1;  // no reason to continue
+        /** Item storage */
+        Item_t * item(size_t index) {
+            return reinterpret_cast<Item_t *>(data.get() + index);
+        }
 
-                // Continue looking for the item
-                insert = NULL;
-                break;
+        /** Item storage */
+        const Item_t * item(size_t index) const {
+            return reinterpret_cast<const Item_t *>(data.get() + index);
+        }
 
-            case slot::USED:
-                if (m_key_fn(m_tab[index].item) == key) {
-                    if (insert) *insert = -1;     // already exists
-                    if (find)   *find   = index;  // gotcha!
+        /** Destroy item (the slot becomes available) */
+        void destroy(size_t index) {
+            item(index)->~Item_t();
+            ctrl[index] = impl::CTRL_AVAIL;
+        }
 
-                    return 1;  // all done
-                }
+        /** Destroy all items */
+        void clear() {
+            for (size_t i = 0; i < size(); ++i)
+                if (impl::ctrl_used(ctrl[i])) destroy(i);
         }
 
-        return 0;  // continue
+        /** Swap tables */
+        void swap(table & other) {
+            ctrl.swap(other.ctrl);
+            data.swap(other.data);
+            std::swap(max_probe, other.max_probe);
+        }
+
+    };  // end of struct table
+
+    impl::hash_fns<Hash_fn> m_hash_fn;   /**< Hash functors                */
+    table                m_tab;          /**< Hash table                   */
+    table                m_old;          /**< Previous table (rehashing)   */
+    size_t               m_rehash_ix;    /**< Previous table rehash index  */
+    size_t               m_rehash_step;  /**< Slots rehashed per operation */
+    size_t               m_item_cnt;     /**< Current item count           */
+    size_t               m_avail_cnt;    /**< Available slots (tombstones) */
+    size_t               m_capacity;     /**< Table capacity               */
+    double               m_load;         /**< Load factor (capacity/size)  */
+    double               m_growth;       /**< Growth factor (0 = fixed)    */
+    size_t               m_step;         /**< Min. rehash step             */
+    const Key_fn         m_key_fn;       /**< Key accessor                 */
+    mutable Stats        m_stats;        /**< Statistics                   */
+
+    /** Number of slots (both tables) */
+    size_t slot_cnt() const { return m_tab.size() + m_old.size(); }
+
+    /** Slot table (indices past table size address the previous table) */
+    const table & table_at(size_t & index) const {
+        if (index < m_tab.size()) return m_tab;
+
+        index -= m_tab.size();
+        return m_old;
+    }
+
+    /** Slot table (indices past table size address the previous table) */
+    table & table_at(size_t & index) {
+        if (index < m_tab.size()) return m_tab;
+
+        index -= m_tab.size();
+        return m_old;
+    }
+
+    /** Slot is in use */
+    bool used(size_t index) const {
+        const table & tab = table_at(index);
+        return impl::ctrl_used(tab.ctrl[index]);
+    }
+
+    /** Slot item */
+    const Item_t & item_at(size_t index) const {
+        const table & tab = table_at(index);
+        return *tab.item(index);
+    }
+
+    /** Slot item */
+    Item_t & item_at(size_t index) {
+        table & tab = table_at(index);
+        return *tab.item(index);
+    }
+
+    /** Key fingerprint (see \ref impl::fingerprint) */
+    uint8_t fingerprint(const Key_t & key) const {
+        return impl::fingerprint(m_hash_fn, key);
+    }
+
+    /** Find item index in table (see \ref impl::get_index) */
+    void get_index(
+        const table & tab,
+        const Key_t & key,
+        uint8_t       fp,
+        ssize_t     * insert,
+        size_t      * insert_pos,
+        ssize_t     * find,
+        size_t      * find_pos = NULL)
+    const {
+        impl::get_index(m_hash_fn, m_key_fn, tab, key, fp,
+            insert, insert_pos, find, find_pos);
     }
 
     /**
@@ -183,79 +592,384 @@ class linear {
      *
      *  The function unifies computation of insert and search index.
      *  It is capable of efficiently finding either or both.
+     *  While rehashing, the item is also looked for in the previous table
+     *  (new items are always inserted to the current one).
      *
-     *  \param  key     Item key
-     *  \param  insert  Insert index (optional)
-     *  \param  find    Search index (optional)
+     *  \param  key         Item key
+     *  \param  fp          Key fingerprint
+     *  \param  insert      Insert index (optional)
+     *  \param  find        Search index (optional)
+     *  \param  insert_pos  Insert probe position (optional)
+     *  \param  find_pos    Search probe position (optional, sum of both
+     *                      tables while rehashing)
      */
     void get_index(
         const Key_t & key,
-        ssize_t     * insert = NULL,
-        ssize_t     * find   = NULL)
+        uint8_t       fp,
+        ssize_t     * insert     = NULL,
+        ssize_t     * find       = NULL,
+        size_t      * insert_pos = NULL,
+        size_t      * find_pos   = NULL)
     const {
         if (!(m_item_cnt < m_capacity)) {
-            if (insert) *insert = -1;  // overfill
+            if (insert) {
+                *insert = -1;  // overfill
+                m_stats.overfill();
+            }
 
             if (!find) return;  // nothing left to do
 
             insert = NULL;  // look for item
         }
 
-        size_t index = 0;
+        if (m_old.empty()) {
+            get_index(m_tab, key, fp, insert, insert_pos, find, find_pos);
+            return;
+        }
+
+        // Rehashing, the item may still be in the previous table
+        ssize_t find_ix;
+        get_index(m_tab, key, fp, insert, insert_pos, &find_ix, find_pos);
 
-        // (Multiple) hashing
-        for (size_t i = 0; i < m_hash_fn.size(); ++i) {
-            index = m_hash_fn[i](key, m_tab.size());
+        if (0 > find_ix) {
+            size_t old_pos = 0;
+            get_index(m_old, key, fp, NULL, NULL, &find_ix, &old_pos);
+            if (find_pos) *find_pos += old_pos;
 
-            if (check_index(key, index, insert, find)) return;
+            if (0 <= find_ix) {
+                find_ix += m_tab.size();
+                if (insert) *insert = -1;  // already exists
+            }
         }
 
-        // Collision string
-        const size_t begin_ix = index;
-        while (!check_index(key, index, insert, find)) {
-            if (!(++index < m_tab.size())) index = 0;
+        if (find) *find = find_ix;
+    }
+
+    /**
+     *  \brief  Construct item in the current table
+     *
+     *  \tparam Args   Item constructor argument types
+     *  \param  index  Slot index (in the current table)
+     *  \param  pos    Slot probe position
+     *  \param  fp     Item key fingerprint
+     *  \param  args   Item constructor arguments
+     *
+     *  \return Stored item
+     */
+    template <typename... Args>
+    Item_t & store(size_t index, size_t pos, uint8_t fp, Args &&... args) {
+        Item_t * item = new (m_tab.item(index))
+            Item_t(std::forward<Args>(args)...);
+
+        if (impl::CTRL_AVAIL == m_tab.ctrl[index]) --m_avail_cnt;
+        if (pos > m_tab.max_probe) m_tab.max_probe = pos;
+
+        m_tab.ctrl[index] = fp;
+        return *item;
+    }
+
+    /**
+     *  \brief  Start rehashing to a new table
+     *
+     *  \param  size  New table size
+     */
+    void rehash_to(size_t size) {
+        // Keep capacity unless the size changes (no rounding drift)
+        if (size != m_tab.size())
+            m_capacity = (size_t)std::lround(m_load * size);
+
+        m_old.swap(m_tab);
+        table(size).swap(m_tab);
+        m_avail_cnt = 0;
+        m_rehash_ix = 0;
+
+        // Make sure the rehash is done before the new table fills up
+        const size_t free = m_capacity > m_item_cnt
+            ? m_capacity - m_item_cnt : 1;
+        m_rehash_step = std::max(m_step, (m_old.size() + free - 1) / free);
+    }
+
+    /**
+     *  \brief  Rehash slots of the previous table
+     *
+     *  Starts rehashing if the table should grow (or be compacted).
+     *
+     *  \param  step  Max. number of slots to rehash (0 means default)
+     */
+    void migrate(size_t step = 0) {
+        if (m_old.empty()) {
+            if (0 == m_growth) return;
+
+            if (!(m_item_cnt < m_capacity)) {
+                const size_t size = m_tab.size() * m_growth;
 
-            // Whole table run through
-            if (begin_ix == index) {
-                if (insert) *insert = -1;
-                if (find)   *find   = -1;
-                break;
+                // Keep power-of-2 size (for masking), odd otherwise
+                // (which is better for modular hashing)
+                rehash_to(is_pow2(m_tab.size()) ? pow2(size) : size | 1);
             }
+
+            // Tombstones took the free slots reserve
+            else if (m_avail_cnt > m_tab.size() - m_capacity)
+                rehash_to(m_tab.size());
+
+            else return;
         }
+
+        if (0 == step) step = m_rehash_step;
+
+        const size_t end = std::min(m_old.size(), m_rehash_ix + step);
+        for (; m_rehash_ix < end; ++m_rehash_ix) {
+            if (!impl::ctrl_used(m_old.ctrl[m_rehash_ix])) continue;
+
+            // The item is never in the current table, yet
+            Item_t &      item = *m_old.item(m_rehash_ix);
+            const uint8_t fp   = m_old.ctrl[m_rehash_ix];
+            ssize_t index;
+            size_t  pos;
+            get_index(m_tab, m_key_fn(item), fp, &index, &pos, NULL);
+
+            store(index, pos, fp, std::move(item));
+            m_stats.rehash();
+
+            // Keep the probe paths of the rest
+            m_old.destroy(m_rehash_ix);
+        }
+
+        if (m_old.size() == m_rehash_ix) table().swap(m_old);
     }
 
     /**
-     *  \brief  Find index for new item
+     *  \brief  Find index of an existing item
      *
      *  \param  key  Item key
      *
-     *  \return Table index or -1 in case the table is overfilled
+     *  \return Table index or -1 if no such item exists
      */
-    inline ssize_t insert_index(const Key_t & key) const {
-        ssize_t index; get_index(key, &index);
+    inline ssize_t find_index(const Key_t & key) const {
+        ssize_t index = 0;
+        size_t  pos   = 0;
+        get_index(key, fingerprint(key), NULL, &index, NULL, &pos);
+        found(index, pos);
         return index;
     }
 
     /**
-     *  \brief  Find index of an existing item
+     *  \brief  Item probe length
+     *
+     *  Number of slots checked when the item is looked up: position
+     *  of its slot among the hash indices, or in the collision string
+     *  (which starts at the last hash index, see \ref impl::get_index).
+     *
+     *  \param  index  Item index
+     *
+     *  \return Probe length
+     */
+    size_t probe_len(size_t index) const {
+        const table & tab = table_at(index);
+        const Key_t & key = m_key_fn(*tab.item(index));
+
+        size_t pos = 0, last = 0;
+        if (m_hash_fn.probe(key, tab.size(), last,
+            [&pos, index](size_t ix) { ++pos; return ix == index; }))
+            return pos;
+
+        return pos + 1 + (index + tab.size() - last) % tab.size();
+    }
+
+    /**
+     *  \brief  Count lookup (statistics)
+     *
+     *  \param  index  Item index (-1 for a miss)
+     *  \param  pos    Search probe position (of a miss)
+     */
+    void found(ssize_t index, size_t pos = 0) const {
+        if (!Stats::enabled) return;
+
+        if (0 > index) m_stats.miss(pos);
+        else m_stats.hit(probe_len(index));
+    }
+
+    /**
+     *  \brief  Survey table slots (see \ref snapshot)
+     *
+     *  \param  tab     Table
+     *  \param  offset  Table slots index offset
+     *  \param  snap    Snapshot
+     */
+    void survey(const table & tab, size_t offset, stats::snapshot & snap)
+    const {
+        size_t lead = 0, run = 0;  // leading and current non-empty run
+        for (size_t i = 0; i < tab.size(); ++i) {
+            switch (tab.ctrl[i]) {
+                case impl::CTRL_EMPTY:
+                    ++snap.empty;
+                    if (run == i) lead = run;  // run from the beginning
+                    run = 0;
+                    continue;
+
+                case impl::CTRL_AVAIL:
+                    ++snap.avail;
+                    break;
+
+                default:  // used
+                    ++snap.used;
+                    snap.item(probe_len(offset + i));
+            }
+
+            snap.longest_run = std::max(snap.longest_run, ++run);
+        }
+
+        // Runs wrap around the table end
+        snap.longest_run = std::max(snap.longest_run,
+            run == tab.size() ? run : std::min(lead + run, tab.size()));
+
+        snap.max_probe = std::max(snap.max_probe, tab.max_probe);
+    }
+
+    /** Prefetch primary slot of key */
+    void prefetch(const Key_t & key) const {
+        if (m_tab.empty()) return;
+
+        const size_t index = m_hash_fn.first(key, m_tab.size());
+        __builtin_prefetch(m_tab.ctrl.data()  + index);
+        __builtin_prefetch(m_tab.item(index));
+    }
+
+    /** New item for \ref operator[] (constructed from key) */
+    Item_t & new_item(
+        size_t index, size_t pos, uint8_t fp, const Key_t & key,
+        std::true_type)
+    {
+        return store(index, pos, fp, key);
+    }
+
+    /** New item for \ref operator[] (value-initialised) */
+    Item_t & new_item(
+        size_t index, size_t pos, uint8_t fp, const Key_t & ,
+        std::false_type)
+    {
+        return store(index, pos, fp);
+    }
+
+    /**
+     *  \brief  Insert index of a new item
+     *
+     *  The item is also looked for, since it may be stored after
+     *  an available slot on its probe path (the insert index would be
+     *  resolved there).
      *
      *  \param  key  Item key
+     *  \param  fp   Key fingerprint
+     *  \param  pos  Insert probe position
      *
-     *  \return Table index or -1 if no such item exists
+     *  \return Insert index or -1 in case of table overfill or duplicity
      */
-    inline ssize_t find_index(const Key_t & key) const {
-        ssize_t index = 0; get_index(key, NULL, &index);
+    ssize_t insert_index(const Key_t & key, uint8_t fp, size_t & pos) const {
+        ssize_t ins_ix, find_ix;
+        get_index(key, fp, &ins_ix, &find_ix, &pos);
+
+        return 0 > find_ix ? ins_ix : -1;
+    }
+
+    /**
+     *  \brief  Insert item
+     *
+     *  \param  item  Item (copied or moved)
+     *
+     *  \return Item index or -1 in case of table overfill or duplicity
+     */
+    template <class Item_ref>
+    ssize_t insert_item(Item_ref && item) {
+        migrate();
+
+        const Key_t & key = m_key_fn(item);
+        const uint8_t fp  = fingerprint(key);
+
+        size_t  pos;
+        ssize_t index = insert_index(key, fp, pos);
+
+        if (0 <= index) {
+            store(index, pos, fp, std::forward<Item_ref>(item));
+            m_stats.insert(pos);
+            ++m_item_cnt;
+        }
+
         return index;
     }
 
     public:
 
+    /** Const iterator (iterates over items in use) */
+    class const_iterator {
+        friend class linear;
+
+        public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Item_t                    value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const Item_t *            pointer;
+        typedef const Item_t &            reference;
+
+        private:
+
+        const linear * m_tab;  /**< Table      */
+        size_t         m_ix;   /**< Slot index */
+
+        /** Skip unused slots */
+        void skip() {
+            while (m_ix < m_tab->slot_cnt() && !m_tab->used(m_ix)) ++m_ix;
+        }
+
+        /** Constructor */
+        const_iterator(const linear * tab, size_t ix):
+            m_tab(tab), m_ix(ix)
+        {
+            skip();
+        }
+
+        public:
+
+        /** Item index */
+        size_t index() const { return m_ix; }
+
+        /** Dereference */
+        const Item_t & operator * () const {
+            return m_tab->item_at(m_ix);
+        }
+
+        /** Member access */
+        const Item_t * operator -> () const { return &**this; }
+
+        /** Pre-increment */
+        const_iterator & operator ++ () { ++m_ix; skip(); return *this; }
+
+        /** Post-increment */
+        const_iterator operator ++ (int) {
+            const_iterator copy(*this); ++*this; return copy;
+        }
+
+        /** Comparison */
+        bool operator == (const const_iterator & rarg) const {
+            return m_ix == rarg.m_ix && m_tab == rarg.m_tab;
+        }
+
+        /** Comparison */
+        bool operator != (const const_iterator & rarg) const {
+            return !(*this == rarg);
+        }
+
+    };  // end of class const_iterator
+
     /**
      *  \brief  Constructor
      *
      *  Note that the \c size parameter should be selected with care.
      *  Depending on the hash functions, the table may benefit from prime-number
      *  size (using modular hashing) etc.
+     *  Power-of-2 size (see \ref pow2) avoids division altogether if the hash
+     *  functions reduce hashes by mask (see \ref reduce, \ref int_hash
+     *  and \ref point_hash); growth then keeps the size power of 2.
      *
      *  Also, practical tests suggest that the table should not be filled
      *  more than to about 80% of its capacity, since the number of collisions
@@ -263,7 +977,7 @@ class linear {
      *
      *  \tparam Key_fn_args  Key functor constructor argument types
      *  \param  size         Table maximal size
-     *  \param  hash_fn      Hash functions
+     *  \param  hash_fn      Hash functions (empty list for default \ref chain)
      *  \param  capacity     Table capacity (85 % of \c size by default)
      *  \param  key_fn_args  Key functor constructor arguments
      */
@@ -274,17 +988,123 @@ class linear {
         size_t                                 capacity = 0,
         Key_fn_args...                         key_fn_args)
     :
-        m_hash_fn  ( hash_fn                  ),
-        m_tab      ( size                     ),
-        m_item_cnt ( 0                        ),
-        m_capacity ( capacity ? : 0.85 * size ),
-        m_key_fn   ( key_fn_args...           )
+        m_hash_fn     ( hash_fn                  ),
+        m_tab         ( size                     ),
+        m_rehash_ix   ( 0                        ),
+        m_rehash_step ( 0                        ),
+        m_item_cnt    ( 0                        ),
+        m_avail_cnt   ( 0                        ),
+        m_capacity    ( capacity ? : 0.85 * size ),
+        m_load        ( 0                        ),
+        m_growth      ( 0                        ),
+        m_step        ( 0                        ),
+        m_key_fn      ( key_fn_args...           )
     {
+        m_stats.hashes(m_hash_fn.size());
+
         // Check capacity sanity
         if (m_capacity > m_tab.size())
             throw std::logic_error(
                 "libaccl::hash::linear: "
                 "invalid capacity");
+
+        m_load = size ? (double)m_capacity / size : 0;
+    }
+
+    /**
+     *  \brief  Set growth policy
+     *
+     *  When the item count reaches the capacity, the table grows by
+     *  \c factor (keeping the load factor given by the capacity).
+     *  Also, the table is compacted (see \ref compact) when tombstones
+     *  take more slots than the capacity leaves free.
+     *  The items are then moved to the new table incrementally; each
+     *  modification (\ref insert, \ref operator[]) moves at least \c step
+     *  slots (more if necessary to finish before the new table fills up).
+     *
+     *  Note that item indices and references are only valid until the next
+     *  modification while growth is enabled.
+     *
+     *  \param  factor  Growth factor (> 1, 0 disables growth)
+     *  \param  step    Minimal number of slots rehashed per modification
+     */
+    void set_growth(double factor, size_t step = 4) {
+        if (0 != factor && !(factor > 1))
+            throw std::logic_error(
+                "libaccl::hash::linear::set_growth: "
+                "invalid growth factor");
+
+        m_growth = factor;
+        m_step   = step ? step : 1;
+    }
+
+    /** Growth factor getter (0 means fixed size) */
+    double growth() const { return m_growth; }
+
+    /** Rehashing (to a larger table) is in progress */
+    bool rehashing() const { return !m_old.empty(); }
+
+    /** Finish pending rehashing at once */
+    void rehash() { if (!m_old.empty()) migrate(m_old.size()); }
+
+    /**
+     *  \brief  Advance pending rehashing (e.g. incremental \ref compact)
+     *
+     *  \param  step  Max. number of slots to rehash (0 means as much
+     *                as a modification does, see \ref set_growth)
+     */
+    void rehash_step(size_t step = 0) { if (!m_old.empty()) migrate(step); }
+
+    /** Longest probe (number of slots checked) of an item in the table */
+    size_t max_probe() const { return m_tab.max_probe; }
+
+    /** Number of available slots (tombstones) in the table */
+    size_t avail_cnt() const { return m_avail_cnt; }
+
+    /** Statistics (see \ref stats::counters) */
+    const Stats & stats() const { return m_stats; }
+
+    /** Statistics (see \ref stats::counters) */
+    Stats & stats() { return m_stats; }
+
+    /**
+     *  \brief  Table snapshot
+     *
+     *  Slots are surveyed for probe lengths of items (and the hash
+     *  functions that resolved them), slot states and the longest
+     *  run of non-empty slots (cluster), which is what search has to scan
+     *  in the worst case.
+     *  Takes time linear in the table size (available with any \c Stats).
+     *
+     *  \return Snapshot
+     */
+    stats::snapshot snapshot() const {
+        stats::snapshot snap(m_hash_fn.size());
+        survey(m_tab, 0, snap);
+        survey(m_old, m_tab.size(), snap);
+
+        return snap;
+    }
+
+    /**
+     *  \brief  Compact table (remove tombstones)
+     *
+     *  Items are rehashed to a new table of the same size.
+     *  Incremental compaction proceeds with the following modifications
+     *  just like growth does (see \ref set_growth); items are looked up
+     *  in both tables meanwhile.
+     *  Note that the table takes twice the memory during compaction.
+     *
+     *  \param  incremental  Rehash incrementally (at once by default)
+     */
+    void compact(bool incremental = false) {
+        rehash();  // finish pending rehash
+
+        if (m_avail_cnt) {
+            rehash_to(m_tab.size());
+
+            if (!incremental) rehash();
+        }
     }
 
     /** Table size getter */
@@ -296,21 +1116,136 @@ class linear {
     /** Item count getter */
     size_t item_cnt() const { return m_item_cnt; }
 
+    /** Begin const iterator */
+    const_iterator begin() const { return const_iterator(this, 0); }
+
+    /** End const iterator */
+    const_iterator end() const { return const_iterator(this, slot_cnt()); }
+
     /**
-     *  \brief  Insert item
+     *  \brief  Slot count
+     *
+     *  Slots of both tables while rehashing; slot ranges may be used to split
+     *  the items (e.g. for parallel processing, see \ref begin(size_t)).
+     */
+    size_t slots() const { return slot_cnt(); }
+
+    /**
+     *  \brief  Const iterator of the 1st item at or after slot
+     *
+     *  \param  index  Slot index (see \ref slots)
+     */
+    const_iterator begin(size_t index) const {
+        return const_iterator(this, std::min(index, slot_cnt()));
+    }
+
+    /**
+     *  \brief  Item getter
+     *
+     *  \param  index  Item index (as returned by \ref find or \ref insert)
+     *
+     *  \return Item
+     */
+    const Item_t & at(size_t index) const { return item_at(index); }
+
+    /**
+     *  \brief  Item getter
+     *
+     *  \param  index  Item index (as returned by \ref find or \ref insert)
+     *
+     *  \return Item
+     */
+    Item_t & at(size_t index) { return item_at(index); }
+
+    /**
+     *  \brief  Insert item (copy)
+     *
+     *  \param  item  Item
+     *
+     *  \return Item index or -1 in case of table overfill or duplicity
+     */
+    ssize_t insert(const Item_t & item) { return insert_item(item); }
+
+    /**
+     *  \brief  Insert item (move)
+     *
+     *  The item is only moved from if inserted.
      *
      *  \param  item  Item
      *
      *  \return Item index or -1 in case of table overfill or duplicity
      */
-    ssize_t insert(const Item_t & item) {
-        ssize_t index = insert_index(m_key_fn(item));
+    ssize_t insert(Item_t && item) { return insert_item(std::move(item)); }
+
+    /**
+     *  \brief  Construct item in place
+     *
+     *  The item is constructed directly in its slot, provided that no item
+     *  with the key exists (nothing is constructed otherwise).
+     *  The constructed item must have the \c key.
+     *
+     *  \tparam Args  Item constructor argument types
+     *  \param  key   Item key
+     *  \param  args  Item constructor arguments
+     *
+     *  \return Item index or -1 in case of table overfill or duplicity
+     */
+    template <typename... Args>
+    ssize_t emplace(const Key_t & key, Args &&... args) {
+        migrate();
+
+        const uint8_t fp = fingerprint(key);
 
-        if (0 <= index) m_tab[index] = item;
+        size_t  pos;
+        ssize_t index = insert_index(key, fp, pos);
+
+        if (0 <= index) {
+            store(index, pos, fp, std::forward<Args>(args)...);
+            m_stats.insert(pos);
+            ++m_item_cnt;
+        }
 
         return index;
     }
 
+    /**
+     *  \brief  Erase item
+     *
+     *  The item is destroyed; its slot becomes available.
+     *  Items are not moved, so erasure during iteration is safe
+     *  (items after the erased one are still iterated).
+     *
+     *  \param  index  Item index (as returned by \ref find or \ref insert)
+     */
+    void erase(size_t index) {
+        if (!(index < slot_cnt() && used(index)))
+            throw std::logic_error(
+                "libaccl::hash::linear::erase: "
+                "slot not in use");
+
+        if (index < m_tab.size()) ++m_avail_cnt;
+
+        table & tab = table_at(index);
+        tab.destroy(index);
+        m_stats.erase();
+        --m_item_cnt;
+    }
+
+    /**
+     *  \brief  Erase item
+     *
+     *  \param  key  Item key
+     *
+     *  \return \c true iff the item existed
+     */
+    bool erase(const Key_t & key) {
+        ssize_t index = find_index(key);
+        if (0 > index) return false;
+
+        erase((size_t)index);
+        return true;
+    }
+
     /**
      *  \brief  Find item
      *
@@ -341,17 +1276,114 @@ class linear {
      *  \return Item
      */
     Item_t & operator [] (const Key_t & key) {
+        migrate();
+
+        const uint8_t fp = fingerprint(key);
+
         // Note that insert index is resolved at least as fast as search index
-        ssize_t ins_ix, find_ix; get_index(key, &ins_ix, &find_ix);
+        ssize_t ins_ix, find_ix;
+        size_t  pos;
+        get_index(key, fp, &ins_ix, &find_ix, &pos);
 
-        if (0 <= find_ix) return m_tab[find_ix].item;  // found
+        if (0 <= find_ix) {  // found
+            found(find_ix);
+            return item_at(find_ix);
+        }
 
         if (0 > ins_ix)
             throw std::runtime_error(
                 "libaccl::hash::linear::[]: "
                 "table overfill");
 
-        return m_tab[ins_ix] = Item_t();  // insert new item
+        Item_t & item = new_item(ins_ix, pos, fp, key,  // insert new item
+            key_constructed<Item_t, Key_t>());
+
+        m_stats.insert(pos);
+
+        ++m_item_cnt;
+
+        return item;
+    }
+
+    /**
+     *  \brief  Find batch of items
+     *
+     *  Primary slots of keys are prefetched \ref impl::BATCH keys ahead
+     *  of their resolution, so that memory latency overlaps.
+     *
+     *  \param  begin  Keys begin (forward iterator)
+     *  \param  end    Keys end
+     *  \param  out    Item indices output (-1 for missing items)
+     */
+    template <class Key_iter, class Out_iter>
+    void find_batch(Key_iter begin, Key_iter end, Out_iter out) const {
+        Key_iter ahead = begin;
+        for (size_t n = 0; n < impl::BATCH && ahead != end; ++n, ++ahead)
+            prefetch(*ahead);
+
+        for (; begin != end; ++begin, ++out) {
+            if (ahead != end) prefetch(*ahead++);
+
+            *out = find_index(*begin);
+        }
+    }
+
+    /**
+     *  \brief  Insert batch of items
+     *
+     *  See \ref find_batch for notes on prefetching.
+     *
+     *  \param  begin  Items begin (forward iterator)
+     *  \param  end    Items end
+     *
+     *  \return Number of inserted items
+     */
+    template <class Item_iter>
+    size_t insert_batch(Item_iter begin, Item_iter end) {
+        size_t cnt = 0;
+
+        Item_iter ahead = begin;
+        for (size_t n = 0; n < impl::BATCH && ahead != end; ++n, ++ahead)
+            prefetch(m_key_fn(*ahead));
+
+        for (; begin != end; ++begin) {
+            if (ahead != end) prefetch(m_key_fn(*ahead++));
+
+            if (0 <= insert(*begin)) ++cnt;
+        }
+
+        return cnt;
+    }
+
+    /**
+     *  \brief  Add batch of values to item members
+     *
+     *  Adds \c delta values to \c member of items given by the keys
+     *  (items are inserted as by \ref operator[] if they don't exist).
+     *  See \ref find_batch for notes on prefetching.
+     *  Throws an exception on table overfill.
+     *
+     *  \param  begin   Keys begin (forward iterator)
+     *  \param  end     Keys end
+     *  \param  delta   Values (one per key)
+     *  \param  member  Item member pointer
+     */
+    template <class Key_iter, class Delta_iter, class Member_ptr>
+    void add_batch(
+        Key_iter   begin,
+        Key_iter   end,
+        Delta_iter delta,
+        Member_ptr member)
+    {
+        Key_iter ahead = begin;
+        for (size_t n = 0; n < impl::BATCH && ahead != end; ++n, ++ahead)
+            prefetch(*ahead);
+
+        for (; begin != end; ++begin, ++delta) {
+            if (ahead != end) prefetch(*ahead++);
+
+            (*this)[*begin].*member += *delta;
+        }
     }
 
 };  // end of template class linear
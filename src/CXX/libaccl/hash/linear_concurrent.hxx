@@ -0,0 +1,587 @@
+#ifndef libaccl__hash__linear_concurrent_hxx
+#define libaccl__hash__linear_concurrent_hxx
+
+/**
+ *  \file
+ *  \brief  Concurrent linear hashtable
+ *
+ *  \date   2016/01/07
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/hash/linear.hxx"
+#include "libaccl/hash/chain.hxx"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <utility>
+#include <initializer_list>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+namespace hash {
+
+/**
+ *  \brief  Hashtable with linear collision resolution (concurrent)
+ *
+ *  Concurrent variant of \ref linear; the slot resolution (multiple hash
+ *  functions followed by the collision string) is the same.
+ *
+ *  Items are kept in a separate array of item records (allocated
+ *  from its beginning), slots only refer to them.
+ *  Slot is an atomic word holding the slot state, a key tag (a few hash
+ *  bits) and the item record index; state transitions are CAS operations:
+ *  * EMPTY -> USED (item published)
+ *  * USED  -> AVAIL (item erased)
+ *
+ *  An inserter writes the new item to a fresh item record first and then
+ *  publishes it (with its key) by a single CAS, so slots are never seen
+ *  half-written.
+ *  Item indices (as returned by \ref find and \ref insert) are the item
+ *  record indices.
+ *
+ *  \ref find is wait-free: it never waits for anything and it visits
+ *  every slot at most once.
+ *  \ref insert and \ref operator[] are lock-free: a failed CAS means
+ *  that another thread has just published an item; inserters of the same
+ *  key get the item published first.
+ *
+ *  Note that AVAIL slots are never re-used (that would allow readers
+ *  to see an item being overwritten); erased items are NOT destroyed
+ *  and their records count in the table capacity, just like records
+ *  of an item which lost the publication race to the same key or whose
+ *  writing threw an exception.
+ *  \ref compact reclaims them (when the table is not used concurrently).
+ *
+ *  Items must not be modified by more threads after insertion
+ *  unless atomically; see \ref fetch_add.
+ *
+ *  \tparam  Item_t   Item type (must be comparable with \c ==)
+ *  \tparam  Hash_fn  Hash functor, accepts \c Key_t and \c size_t (table size)
+ *  \tparam  Key_t    Key type (the item type by default)
+ *  \tparam  Key_fn   Key accessor (item identity by default)
+ */
+template <
+    typename Item_t,
+    class    Hash_fn,
+    typename Key_t   = Item_t,
+    class    Key_fn  = impl::identity_key<Item_t> >
+class linear_concurrent {
+    private:
+
+    /** Slot state (low bits of the slot word) */
+    enum state_t {
+        EMPTY      = 0,  /**< Empty slot (unused yet)          */
+        USED       = 2,  /**< Slot in use                      */
+        AVAIL      = 3,  /**< Available slot (previously used) */
+        STATE_MASK = 3   /**< State bits mask                  */
+    };  // end of enum state_t
+
+    /** Key tag modulus (tag is stored above the state bits) */
+    static const size_t TAG_MOD = ((size_t)1 << 30) - 1;
+
+    /** Item record index shift (index is stored above the tag) */
+    static const unsigned INDEX_SHIFT = 32;
+
+    /** Tag bits mask (of the slot word) */
+    static const uint64_t TAG_MASK = 0xffffffffULL & ~(uint64_t)STATE_MASK;
+
+    /** Table slot (state, key tag and item record index) */
+    typedef std::atomic<uint64_t> slot;
+
+    const impl::hash_fns<Hash_fn> m_hash_fn;   /**< Hash functors       */
+    const size_t                  m_size;      /**< Table size          */
+    const size_t                  m_capacity;  /**< Table capacity      */
+    std::unique_ptr<slot[]>       m_tab;       /**< Hash table          */
+    std::unique_ptr<Item_t[]>     m_items;     /**< Item records        */
+    std::atomic<size_t>           m_item_top;  /**< Records allocated   */
+    std::atomic<size_t>           m_item_cnt;  /**< Current item count  */
+    const Key_fn                  m_key_fn;    /**< Key accessor        */
+
+    /** Key tag (shifted above the state bits) */
+    uint64_t tag(const Key_t & key) const {
+        return (uint64_t)(m_hash_fn.last(key, TAG_MOD) << 2);
+    }
+
+    /** Slot word */
+    static uint64_t word(size_t item, uint64_t tag, state_t state) {
+        return ((uint64_t)item << INDEX_SHIFT) | tag | state;
+    }
+
+    /** Item record index (of slot word) */
+    static size_t item_ix(uint64_t w) { return (size_t)(w >> INDEX_SHIFT); }
+
+    /**
+     *  \brief  Walk key probe path
+     *
+     *  Calls \c fn(index) for slots on the key probe path (hash functions
+     *  indices followed by the collision string) until it returns \c true.
+     *
+     *  \param  key  Item key
+     *  \param  fn   Slot check
+     */
+    template <class Fn>
+    void probe(const Key_t & key, Fn fn) const {
+        size_t index = 0;
+
+        // (Multiple) hashing
+        if (m_hash_fn.probe(key, m_size, index, fn)) return;
+
+        // Collision string
+        for (size_t i = 1; i < m_size; ++i) {
+            if (!(++index < m_size)) index = 0;
+
+            if (fn(index)) return;
+        }
+    }
+
+    /**
+     *  \brief  Find or insert item
+     *
+     *  The new item is written (to a fresh item record) when the first
+     *  empty slot on the key probe path is met.
+     *  If the slot is taken meanwhile, the item is published to the next
+     *  empty one, unless the slot got the key.
+     *
+     *  \param  key       Item key
+     *  \param  make      Item writer (called with new item reference)
+     *  \param  inserted  Set to \c true iff new item was inserted
+     *
+     *  \return Item index or -1 in case of table overfill
+     */
+    template <class Make_fn>
+    ssize_t acquire(const Key_t & key, Make_fn make, bool & inserted) {
+        const uint64_t t = tag(key);
+        ssize_t result = -1;
+        size_t  item   = m_capacity;  // unallocated
+        inserted = false;
+
+        probe(key, [this, &key, &make, &inserted, &result, &item, t](
+            size_t index)
+        {
+            slot & s = m_tab[index];
+            uint64_t st = s.load(std::memory_order_acquire);
+
+            for (;;) switch (st & STATE_MASK) {
+                case EMPTY:
+                    if (m_capacity == item) {
+                        item = m_item_top.fetch_add(1,
+                            std::memory_order_relaxed);
+
+                        if (!(item < m_capacity)) {  // overfill
+                            item = m_capacity;
+                            return true;
+                        }
+
+                        make(m_items[item]);  // the record is lost on throw
+                    }
+
+                    if (s.compare_exchange_weak(st, word(item, t, USED),
+                        std::memory_order_acq_rel,
+                        std::memory_order_acquire))
+                    {
+                        m_item_cnt.fetch_add(1, std::memory_order_relaxed);
+
+                        inserted = true;
+                        result   = item;
+                        return true;
+                    }
+
+                    break;  // lost the race, check the slot again
+
+                case USED:
+                    if ((st & TAG_MASK) == t &&
+                        m_key_fn(m_items[item_ix(st)]) == key)
+                    {
+                        result = item_ix(st);  // already exists
+                        return true;
+                    }
+
+                    return false;
+
+                default:  // AVAIL
+                    return false;
+            }
+        });
+
+        return result;
+    }
+
+    /** New item for \ref operator[] (constructed from key) */
+    static void new_item(Item_t & item, const Key_t & key, std::true_type) {
+        item = Item_t(key);
+    }
+
+    /** New item for \ref operator[] (value-initialised) */
+    static void new_item(Item_t & item, const Key_t & , std::false_type) {
+        item = Item_t();
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  See \ref linear constructor.
+     *
+     *  \tparam Key_fn_args  Key functor constructor argument types
+     *  \param  size         Table maximal size
+     *  \param  hash_fn      Hash functions
+     *  \param  capacity     Table capacity (85 % of \c size by default)
+     *  \param  key_fn_args  Key functor constructor arguments
+     */
+    template <typename... Key_fn_args>
+    linear_concurrent(
+        size_t                                 size,
+        const std::initializer_list<Hash_fn> & hash_fn,
+        size_t                                 capacity = 0,
+        Key_fn_args...                         key_fn_args)
+    :
+        m_hash_fn  ( hash_fn                  ),
+        m_size     ( size                     ),
+        m_capacity ( capacity ? : 0.85 * size ),
+        m_tab      ( new slot[size]           ),
+        m_items    ( new Item_t[m_capacity]   ),
+        m_item_top ( 0                        ),
+        m_item_cnt ( 0                        ),
+        m_key_fn   ( key_fn_args...           )
+    {
+        // Check capacity sanity
+        if (m_capacity > m_size || 0 == m_hash_fn.size() ||
+            m_capacity > ((uint64_t)1 << (64 - INDEX_SHIFT)) - 1)
+        {
+            throw std::logic_error(
+                "libaccl::hash::linear_concurrent: "
+                "invalid capacity");
+        }
+
+        for (size_t i = 0; i < m_size; ++i)
+            m_tab[i].store(EMPTY, std::memory_order_relaxed);
+    }
+
+    /** Table size getter */
+    size_t size() const { return m_size; }
+
+    /** Table capacity getter */
+    size_t capacity() const { return m_capacity; }
+
+    /** Item count getter */
+    size_t item_cnt() const {
+        return m_item_cnt.load(std::memory_order_relaxed);
+    }
+
+    /**
+     *  \brief  Number of item records not holding items
+     *
+     *  Records of erased items and items which weren't published
+     *  (see \ref compact).
+     */
+    size_t avail_cnt() const {
+        size_t top = m_item_top.load(std::memory_order_relaxed);
+        if (top > m_capacity) top = m_capacity;
+
+        return top - item_cnt();
+    }
+
+    /**
+     *  \brief  Item getter
+     *
+     *  \param  index  Item index (as returned by \ref find or \ref insert)
+     *
+     *  \return Item
+     */
+    const Item_t & at(size_t index) const { return m_items[index]; }
+
+    /**
+     *  \brief  Item getter
+     *
+     *  \param  index  Item index (as returned by \ref find or \ref insert)
+     *
+     *  \return Item
+     */
+    Item_t & at(size_t index) { return m_items[index]; }
+
+    /**
+     *  \brief  Insert item (lock-free)
+     *
+     *  \param  item  Item
+     *
+     *  \return Item index or -1 in case of table overfill or duplicity
+     */
+    ssize_t insert(const Item_t & item) {
+        bool inserted;
+        ssize_t index = acquire(m_key_fn(item),
+            [&item](Item_t & new_item) { new_item = item; }, inserted);
+
+        return inserted ? index : -1;
+    }
+
+    /**
+     *  \brief  Find item (wait-free)
+     *
+     *  \param  key  Item key
+     *
+     *  \return Item index or -1 if no such item exists
+     */
+    ssize_t find(const Key_t & key) const {
+        const uint64_t t = tag(key);
+        ssize_t result = -1;
+
+        probe(key, [this, &key, &result, t](size_t index) {
+            const uint64_t st = m_tab[index].load(std::memory_order_acquire);
+
+            switch (st & STATE_MASK) {
+                case EMPTY:
+                    return true;  // had been here if present
+
+                case USED:
+                    if ((st & TAG_MASK) == t &&
+                        m_key_fn(m_items[item_ix(st)]) == key)
+                    {
+                        result = item_ix(st);  // gotcha!
+                        return true;
+                    }
+            }
+
+            return false;  // continue
+        });
+
+        return result;
+    }
+
+    /**
+     *  \brief  Item exists
+     *
+     *  \param  key  Item key
+     *
+     *  \return \c true iff the item exists in the table
+     */
+    bool exists(const Key_t & key) const { return -1 != find(key); }
+
+    /**
+     *  \brief  Get item (lock-free)
+     *
+     *  Returns reference to existing item or newly inserted if it doesn't
+     *  exist, yet (see \ref linear::operator[]).
+     *  Throws an exception on table overfill.
+     *
+     *  \param  key  Item key
+     *
+     *  \return Item
+     */
+    Item_t & operator [] (const Key_t & key) {
+        bool inserted;
+        ssize_t index = acquire(key, [&key](Item_t & item) {
+            new_item(item, key, key_constructed<Item_t, Key_t>());
+        }, inserted);
+
+        if (0 > index)
+            throw std::runtime_error(
+                "libaccl::hash::linear_concurrent::[]: "
+                "table overfill");
+
+        return m_items[index];
+    }
+
+    /**
+     *  \brief  Erase item
+     *
+     *  \param  key  Item key
+     *
+     *  \return \c true iff the item was erased (by this call)
+     */
+    bool erase(const Key_t & key) {
+        const uint64_t t = tag(key);
+        bool erased = false;
+
+        probe(key, [this, &key, &erased, t](size_t index) {
+            slot & s = m_tab[index];
+            uint64_t st = s.load(std::memory_order_acquire);
+
+            switch (st & STATE_MASK) {
+                case EMPTY:
+                    return true;  // no such item
+
+                case USED:
+                    if ((st & TAG_MASK) == t &&
+                        m_key_fn(m_items[item_ix(st)]) == key)
+                    {
+                        // Fails if erased concurrently
+                        erased = s.compare_exchange_strong(st,
+                            (st & ~(uint64_t)STATE_MASK) | AVAIL,
+                            std::memory_order_acq_rel);
+
+                        return true;
+                    }
+            }
+
+            return false;  // continue
+        });
+
+        if (erased) m_item_cnt.fetch_sub(1, std::memory_order_relaxed);
+
+        return erased;
+    }
+
+    /**
+     *  \brief  Compact table (reclaim item records)
+     *
+     *  Items are moved to the beginning of the item records and the slots
+     *  are rebuilt, so that records of erased (and unpublished) items
+     *  and AVAIL slots are free again.
+     *  Item indices change.
+     *  Must NOT run concurrently with any other operation.
+     */
+    void compact() {
+        if (!avail_cnt()) return;
+
+        std::unique_ptr<Item_t[]> items(new Item_t[m_capacity]);
+
+        size_t cnt = 0;
+        for (size_t i = 0; i < m_size; ++i) {
+            const uint64_t st = m_tab[i].load(std::memory_order_relaxed);
+
+            if (USED == (st & STATE_MASK))
+                items[cnt++] = std::move(m_items[item_ix(st)]);
+
+            m_tab[i].store(EMPTY, std::memory_order_relaxed);
+        }
+
+        m_items.swap(items);
+        m_item_top.store(cnt, std::memory_order_relaxed);
+        m_item_cnt.store(cnt, std::memory_order_relaxed);
+
+        // Publish items (keys are unique, the 1st empty slot is it)
+        for (size_t i = 0; i < cnt; ++i) {
+            const Key_t & key = m_key_fn(m_items[i]);
+            const uint64_t t = tag(key);
+
+            probe(key, [this, i, t](size_t index) {
+                if (EMPTY != m_tab[index].load(std::memory_order_relaxed))
+                    return false;
+
+                m_tab[index].store(word(i, t, USED),
+                    std::memory_order_relaxed);
+
+                return true;
+            });
+        }
+    }
+
+    /**
+     *  \brief  Atomic fetch-and-add on value
+     *
+     *  \param  value  Value (integral)
+     *  \param  delta  Addend
+     *
+     *  \return Previous value
+     */
+    template <typename Value_t>
+    static Value_t fetch_add(Value_t & value, Value_t delta) {
+        static_assert(std::is_integral<Value_t>::value,
+            "integral value required");
+
+        return __atomic_fetch_add(&value, delta, __ATOMIC_RELAXED);
+    }
+
+    /**
+     *  \brief  Atomic fetch-and-add on item member (lock-free)
+     *
+     *  The item is inserted (see \ref operator[]) if it doesn't exist.
+     *
+     *  \param  key     Item key
+     *  \param  member  Item member pointer (integral member)
+     *  \param  delta   Addend
+     *
+     *  \return Previous value
+     */
+    template <typename Value_t>
+    Value_t fetch_add(const Key_t & key, Value_t Item_t::* member, Value_t delta) {
+        return fetch_add((*this)[key].*member, delta);
+    }
+
+    /**
+     *  \brief  Atomic load of value
+     *
+     *  \param  value  Value (integral)
+     *
+     *  \return Value
+     */
+    template <typename Value_t>
+    static Value_t load(const Value_t & value) {
+        return __atomic_load_n(&value, __ATOMIC_RELAXED);
+    }
+
+    /**
+     *  \brief  Call function for every item
+     *
+     *  Items inserted concurrently may or may not be visited.
+     *
+     *  \param  fn  Function, called with item index and item
+     */
+    template <class Fn>
+    void for_each(Fn fn) const { for_each(0, m_size, fn); }
+
+    /**
+     *  \brief  Call function for every item in slot range
+     *
+     *  Items inserted concurrently may or may not be visited.
+     *
+     *  \param  begin  Range begin (slot index)
+     *  \param  end    Range end (slot index, up to \ref size)
+     *  \param  fn     Function, called with item index and item
+     */
+    template <class Fn>
+    void for_each(size_t begin, size_t end, Fn fn) const {
+        if (end > m_size) end = m_size;
+
+        for (size_t i = begin; i < end; ++i) {
+            const uint64_t st = m_tab[i].load(std::memory_order_acquire);
+
+            if (USED == (st & STATE_MASK))
+                fn(item_ix(st), m_items[item_ix(st)]);
+        }
+    }
+
+};  // end of template class linear_concurrent
+
+}}  // end of namespace libaccl::hash
+
+#endif  // end of #ifndef libaccl__hash__linear_concurrent_hxx
@@ -0,0 +1,453 @@
+#ifndef libaccl__hash__linear_mapped_hxx
+#define libaccl__hash__linear_mapped_hxx
+
+/**
+ *  \file
+ *  \brief  Memory-mapped read-only linear hashtable
+ *
+ *  \date   2016/01/10
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/hash/linear.hxx"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <initializer_list>
+#include <type_traits>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+
+namespace libaccl {
+namespace hash {
+
+namespace impl {
+
+/**
+ *  \brief  Mapped table file header
+ *
+ *  The file layout is
+ *  - header,
+ *  - control bytes (table size),
+ *  - items (table size, unused slots are zeroed).
+ *
+ *  Sections are aligned to \ref MAPPED_ALIGN bytes (zero padding).
+ *  Numbers are stored in the native byte order (checked by the byte
+ *  order mark).
+ */
+struct mapped_header {
+    char     magic[8];      /**< File magic                    */
+    uint32_t byte_order;    /**< Byte order mark               */
+    uint32_t version;       /**< Format version                */
+    uint64_t item_size;     /**< Item size                     */
+    uint64_t item_align;    /**< Item alignment                */
+    uint64_t hash_fn_cnt;   /**< Number of hash functions      */
+    uint64_t size;          /**< Table size                    */
+    uint64_t capacity;      /**< Table capacity                */
+    uint64_t item_cnt;      /**< Item count                    */
+    uint64_t max_probe;     /**< Longest probe of an item      */
+    uint64_t ctrl_offset;   /**< Control bytes offset          */
+    uint64_t items_offset;  /**< Items offset                  */
+    uint64_t file_size;     /**< File size                     */
+};  // end of struct mapped_header
+
+/** Mapped table file magic */
+static const char MAPPED_MAGIC[8] = { 'L', 'A', 'C', 'C', 'L', 'H', 'T', 'L' };
+
+/** Mapped table byte order mark */
+static const uint32_t MAPPED_BYTE_ORDER = 0x01020304;
+
+/** Mapped table format version */
+static const uint32_t MAPPED_VERSION = 1;
+
+/** Mapped table sections alignment */
+static const uint64_t MAPPED_ALIGN = 64;
+
+/** Align offset (up) */
+inline uint64_t mapped_align(uint64_t offset) {
+    return (offset + MAPPED_ALIGN - 1) / MAPPED_ALIGN * MAPPED_ALIGN;
+}
+
+}  // end of namespace impl
+
+
+/**
+ *  \brief  Memory-mapped read-only linear hashtable
+ *
+ *  The class serves searches in \ref linear table saved to a flat file
+ *  (see \ref save and \ref impl::mapped_header).
+ *  The file is mapped read-only and shared, so the table is available
+ *  immediately (without any deserialisation) and its pages are shared
+ *  by all processes mapping it (via the page cache).
+ *
+ *  The items must be trivially copyable; they are saved as they are.
+ *  The view must use the same hash functions (and key accessor)
+ *  as the saved table, otherwise the items are not found.
+ *  The number of hash functions is checked; the functions themselves
+ *  can not be.
+ *
+ *  \tparam  Item_t   Item type (must be trivially copyable)
+ *  \tparam  Hash_fn  Hash functor (see \ref linear)
+ *  \tparam  Key_t    Key type (the item type by default)
+ *  \tparam  Key_fn   Key accessor (item identity by default)
+ */
+template <
+    typename Item_t,
+    class    Hash_fn,
+    typename Key_t   = Item_t,
+    class    Key_fn  = impl::identity_key<Item_t> >
+class linear_mapped {
+    static_assert(std::is_trivially_copyable<Item_t>::value,
+        "libaccl::hash::linear_mapped: item must be trivially copyable");
+
+    public:
+
+    /** Source table type */
+    typedef linear<Item_t, Hash_fn, Key_t, Key_fn> linear_t;
+
+    private:
+
+    /** Mapped table (see \ref impl::get_index) */
+    struct table {
+        const uint8_t * ctrl;       /**< Slot control bytes     */
+        const Item_t  * items;      /**< Slot items             */
+        size_t          slots;      /**< Number of slots        */
+        size_t          max_probe;  /**< Longest item probe     */
+
+        /** Table size */
+        size_t size() const { return slots; }
+
+        /** Item */
+        const Item_t * item(size_t index) const { return items + index; }
+
+    };  // end of struct table
+
+    impl::hash_fns<Hash_fn> m_hash_fn;   /**< Hash functors           */
+    void *                  m_addr;      /**< Mapping address         */
+    size_t                  m_len;       /**< Mapping length          */
+    table                   m_tab;       /**< Mapped table            */
+    size_t                  m_capacity;  /**< Table capacity          */
+    size_t                  m_item_cnt;  /**< Item count              */
+    const Key_fn            m_key_fn;    /**< Key accessor            */
+
+    /**
+     *  \brief  Check mapped file header
+     *
+     *  \param  hdr  Header
+     *
+     *  \return Error message or \c NULL if the header is valid
+     */
+    const char * check(const impl::mapped_header & hdr) const {
+        if (0 != ::memcmp(hdr.magic, impl::MAPPED_MAGIC, sizeof(hdr.magic)))
+            return "not a mapped table";
+
+        if (impl::MAPPED_BYTE_ORDER != hdr.byte_order)
+            return "byte order mismatch";
+
+        if (impl::MAPPED_VERSION != hdr.version)
+            return "unsupported format version";
+
+        if (sizeof(Item_t) != hdr.item_size || alignof(Item_t) != hdr.item_align)
+            return "item type mismatch";
+
+        if (m_hash_fn.size() != hdr.hash_fn_cnt)
+            return "hash functions mismatch";
+
+        // Sections are checked against the file size 1st, so that
+        // the offset arithmetics can't overflow
+        if (hdr.file_size != m_len
+        ||  hdr.size > m_len / sizeof(Item_t)
+        ||  hdr.ctrl_offset  < sizeof(hdr)
+        ||  hdr.ctrl_offset  > m_len
+        ||  hdr.size > m_len - hdr.ctrl_offset
+        ||  hdr.items_offset < hdr.ctrl_offset + hdr.size
+        ||  hdr.items_offset > m_len
+        ||  hdr.items_offset % alignof(Item_t)
+        ||  hdr.size * sizeof(Item_t) != m_len - hdr.items_offset)
+            return "corrupt layout";
+
+        if (0 == hdr.size || hdr.capacity > hdr.size
+        ||  hdr.item_cnt > hdr.capacity || hdr.max_probe > hdr.size)
+            return "corrupt header";
+
+        return NULL;
+    }
+
+    /** Map file */
+    void map(const std::string & file) {
+        const int fd = ::open(file.c_str(), O_RDONLY);
+        if (0 > fd)
+            throw std::runtime_error(
+                "libaccl::hash::linear_mapped: "
+                "failed to open " + file);
+
+        struct stat st;
+        if (0 != ::fstat(fd, &st)) {
+            ::close(fd);
+            throw std::runtime_error(
+                "libaccl::hash::linear_mapped: "
+                "failed to stat " + file);
+        }
+
+        m_len = st.st_size;
+        if (m_len < sizeof(impl::mapped_header)) {
+            ::close(fd);
+            throw std::runtime_error(
+                "libaccl::hash::linear_mapped: "
+                "truncated file " + file);
+        }
+
+        m_addr = ::mmap(NULL, m_len, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // the mapping stays
+
+        if (MAP_FAILED == m_addr) {
+            m_addr = NULL;
+            throw std::runtime_error(
+                "libaccl::hash::linear_mapped: "
+                "failed to map " + file);
+        }
+
+        const char * base = (const char *)m_addr;
+        const impl::mapped_header & hdr = *(const impl::mapped_header *)base;
+
+        const char * error = check(hdr);
+        if (NULL != error) {
+            unmap();
+            throw std::runtime_error(
+                std::string("libaccl::hash::linear_mapped: ") +
+                error + ": " + file);
+        }
+
+        m_tab.ctrl      = (const uint8_t *)(base + hdr.ctrl_offset);
+        m_tab.items     = (const Item_t  *)(base + hdr.items_offset);
+        m_tab.slots     = hdr.size;
+        m_tab.max_probe = hdr.max_probe;
+        m_capacity      = hdr.capacity;
+        m_item_cnt      = hdr.item_cnt;
+    }
+
+    /** Unmap file */
+    void unmap() {
+        if (NULL != m_addr) ::munmap(m_addr, m_len);
+
+        m_addr = NULL;
+        m_len  = 0;
+    }
+
+    public:
+
+    /**
+     *  \brief  Save table
+     *
+     *  Pending rehashing is finished on a copy of the table first.
+     *
+     *  \param  tab  Table
+     *  \param  out  Output stream (binary)
+     */
+    static void save(const linear_t & tab, std::ostream & out) {
+        if (tab.rehashing()) {
+            linear_t copy(tab);
+            copy.rehash();
+            save(copy, out);
+            return;
+        }
+
+        const size_t size = tab.size();
+
+        impl::mapped_header hdr;
+        ::memset(&hdr, 0, sizeof(hdr));
+        ::memcpy(hdr.magic, impl::MAPPED_MAGIC, sizeof(hdr.magic));
+        hdr.byte_order   = impl::MAPPED_BYTE_ORDER;
+        hdr.version      = impl::MAPPED_VERSION;
+        hdr.item_size    = sizeof(Item_t);
+        hdr.item_align   = alignof(Item_t);
+        hdr.hash_fn_cnt  = tab.m_hash_fn.size();
+        hdr.size         = size;
+        hdr.capacity     = tab.capacity();
+        hdr.item_cnt     = tab.item_cnt();
+        hdr.max_probe    = tab.max_probe();
+        hdr.ctrl_offset  = impl::mapped_align(sizeof(hdr));
+        hdr.items_offset = impl::mapped_align(hdr.ctrl_offset + size);
+        hdr.file_size    = hdr.items_offset + size * sizeof(Item_t);
+
+        const std::vector<char> zero(
+            std::max<size_t>(impl::MAPPED_ALIGN, sizeof(Item_t)), 0);
+
+        out.write((const char *)&hdr, sizeof(hdr));
+        out.write(zero.data(), hdr.ctrl_offset - sizeof(hdr));
+        out.write((const char *)tab.m_tab.ctrl.data(), size);
+        out.write(zero.data(), hdr.items_offset - hdr.ctrl_offset - size);
+
+        for (size_t i = 0; i < size; ++i)
+            out.write(impl::ctrl_used(tab.m_tab.ctrl[i])
+                ? (const char *)tab.m_tab.item(i) : zero.data(),
+                sizeof(Item_t));
+
+        if (!out)
+            throw std::runtime_error(
+                "libaccl::hash::linear_mapped::save: "
+                "write failed");
+    }
+
+    /**
+     *  \brief  Save table
+     *
+     *  \param  tab   Table
+     *  \param  file  File path
+     */
+    static void save(const linear_t & tab, const std::string & file) {
+        std::ofstream out(file.c_str(),
+            std::ios::binary | std::ios::out | std::ios::trunc);
+
+        if (!out)
+            throw std::runtime_error(
+                "libaccl::hash::linear_mapped::save: "
+                "failed to open " + file);
+
+        save(tab, out);
+
+        out.close();
+        if (!out)
+            throw std::runtime_error(
+                "libaccl::hash::linear_mapped::save: "
+                "failed to write " + file);
+    }
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  file         Saved table file path
+     *  \param  hash_fn      Hash functions (those of the saved table)
+     *  \param  key_fn_args  Key accessor constructor arguments
+     */
+    template <class... Key_fn_args>
+    linear_mapped(
+        const std::string                    & file,
+        const std::initializer_list<Hash_fn> & hash_fn,
+        Key_fn_args...                         key_fn_args)
+    :
+        m_hash_fn  ( hash_fn        ),
+        m_addr     ( NULL           ),
+        m_len      ( 0              ),
+        m_capacity ( 0              ),
+        m_item_cnt ( 0              ),
+        m_key_fn   ( key_fn_args... )
+    {
+        map(file);
+    }
+
+    /** Move constructor */
+    linear_mapped(linear_mapped && orig):
+        m_hash_fn  ( orig.m_hash_fn  ),
+        m_addr     ( orig.m_addr     ),
+        m_len      ( orig.m_len      ),
+        m_tab      ( orig.m_tab      ),
+        m_capacity ( orig.m_capacity ),
+        m_item_cnt ( orig.m_item_cnt ),
+        m_key_fn   ( orig.m_key_fn   )
+    {
+        orig.m_addr = NULL;
+        orig.m_len  = 0;
+    }
+
+    linear_mapped(const linear_mapped & ) = delete;
+    linear_mapped & operator = (const linear_mapped & ) = delete;
+
+    /** Destructor */
+    ~linear_mapped() { unmap(); }
+
+    /** Table size */
+    size_t size() const { return m_tab.size(); }
+
+    /** Table capacity */
+    size_t capacity() const { return m_capacity; }
+
+    /** Item count */
+    size_t item_cnt() const { return m_item_cnt; }
+
+    /** Longest probe of an item */
+    size_t max_probe() const { return m_tab.max_probe; }
+
+    /** Slot is in use */
+    bool used(size_t index) const {
+        return index < size() && impl::ctrl_used(m_tab.ctrl[index]);
+    }
+
+    /** Item getter */
+    const Item_t & at(size_t index) const { return *m_tab.item(index); }
+
+    /**
+     *  \brief  Find item
+     *
+     *  \param  key  Item key
+     *
+     *  \return Item index or -1 if not found
+     */
+    ssize_t find(const Key_t & key) const {
+        if (!size()) return -1;
+
+        ssize_t index;
+        impl::get_index(m_hash_fn, m_key_fn, m_tab, key,
+            impl::fingerprint(m_hash_fn, key), NULL, NULL, &index);
+
+        return index;
+    }
+
+    /**
+     *  \brief  Check item existence
+     *
+     *  \param  key  Item key
+     *
+     *  \return \c true iff item is in the table
+     */
+    bool exists(const Key_t & key) const { return 0 <= find(key); }
+
+};  // end of template class linear_mapped
+
+}}  // end of namespace libaccl::hash
+
+#endif  // end of #ifndef libaccl__hash__linear_mapped_hxx
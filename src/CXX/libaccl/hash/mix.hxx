@@ -0,0 +1,170 @@
+#ifndef libaccl__hash__mix_hxx
+#define libaccl__hash__mix_hxx
+
+/**
+ *  \file
+ *  \brief  Hash mixing functions and table size reduction
+ *
+ *  \date   2016/01/09
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <array>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+namespace hash {
+
+namespace impl {
+
+/** Mixing constants (wyhash) */
+static const uint64_t MIX_K0 = 0xa0761d6478bd642fULL;
+static const uint64_t MIX_K1 = 0xe7037ed1a0b428dbULL;
+static const uint64_t MIX_K2 = 0x8ebc6af09c88c6e3ULL;
+
+/** Multiply and fold (128-bit product high ^ low) */
+inline uint64_t mum(uint64_t a, uint64_t b) {
+    const unsigned __int128 r = (unsigned __int128)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+}  // end of namespace impl
+
+/** Size is power of 2 */
+inline bool is_pow2(size_t size) { return size && !(size & (size - 1)); }
+
+/**
+ *  \brief  Round size up to power of 2
+ *
+ *  Tables of power-of-2 size reduce hashes to indices by masking
+ *  (see \ref reduce); use well-mixed hash functions (\ref int_hash,
+ *  \ref point_hash) with them, since masking only keeps the low bits.
+ *
+ *  \param  size  Size
+ *
+ *  \return The least power of 2 not lesser than \c size
+ */
+inline size_t pow2(size_t size) {
+    size_t p = 1;
+    while (p < size) p <<= 1;
+    return p;
+}
+
+/**
+ *  \brief  Reduce hash to table index
+ *
+ *  Power-of-2 sizes are reduced by mask, others by modulo.
+ *
+ *  \param  h     Hash
+ *  \param  size  Table size
+ *
+ *  \return Table index
+ */
+inline size_t reduce(uint64_t h, size_t size) {
+    return is_pow2(size) ? (size_t)(h & (size - 1)) : (size_t)(h % size);
+}
+
+/**
+ *  \brief  Integer hash function
+ *
+ *  wyhash-style multiply-fold mixing; low bits are usable for masking.
+ *
+ *  \tparam  Int_t  Integral key type
+ */
+template <typename Int_t>
+class int_hash {
+    private:
+
+    uint64_t m_seed;  /**< Seed */
+
+    public:
+
+    /** Constructor */
+    int_hash(uint64_t seed = 0): m_seed(seed ^ impl::MIX_K0) {}
+
+    /** Full hash */
+    uint64_t hash(Int_t key) const {
+        return impl::mum((uint64_t)key ^ impl::MIX_K1, m_seed ^ impl::MIX_K2);
+    }
+
+    /** Table index */
+    size_t operator () (Int_t key, size_t size) const {
+        return reduce(hash(key), size);
+    }
+
+};  // end of template class int_hash
+
+/**
+ *  \brief  Point coordinates hash function
+ *
+ *  Hashes \c std::vector or \c std::array of integral coordinates
+ *  (as used by the accumulator backends); wyhash-style multiply-fold
+ *  mixing of each coordinate, low bits are usable for masking.
+ *
+ *  \tparam  Point_t  Point type
+ */
+template <class Point_t>
+class point_hash {
+    private:
+
+    uint64_t m_seed;  /**< Seed */
+
+    public:
+
+    /** Constructor */
+    point_hash(uint64_t seed = 0): m_seed(seed ^ impl::MIX_K0) {}
+
+    /** Full hash */
+    uint64_t hash(const Point_t & point) const {
+        uint64_t h = m_seed;
+        for (size_t d = 0; d < point.size(); ++d)
+            h = impl::mum((uint64_t)point[d] ^ impl::MIX_K1, h ^ impl::MIX_K2);
+
+        return h;
+    }
+
+    /** Table index */
+    size_t operator () (const Point_t & point, size_t size) const {
+        return reduce(hash(point), size);
+    }
+
+};  // end of template class point_hash
+
+}}  // end of namespace libaccl::hash
+
+#endif  // end of #ifndef libaccl__hash__mix_hxx
@@ -0,0 +1,306 @@
+#ifndef libaccl__hash__stats_hxx
+#define libaccl__hash__stats_hxx
+
+/**
+ *  \file
+ *  \brief  Hash table statistics
+ *
+ *  \date   2016/01/17
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+namespace hash {
+namespace stats {
+
+/**
+ *  \brief  Table snapshot
+ *
+ *  Describes the current layout of a table (see \ref linear::snapshot).
+ *  Probe length of an item is the number of slots checked when it's
+ *  looked up; items with probe length up to the number of hash functions
+ *  were resolved by a hash function, the rest lie in collision strings.
+ */
+struct snapshot {
+    std::vector<size_t> probe_hist;   /**< Items by probe length           */
+    std::vector<size_t> resolved;     /**< Items resolved by hash function */
+    size_t              collided;     /**< Items in collision strings      */
+    size_t              used;         /**< Used slots                      */
+    size_t              avail;        /**< Available slots (tombstones)    */
+    size_t              empty;        /**< Empty slots                     */
+    size_t              longest_run;  /**< Longest run of non-empty slots  */
+    size_t              max_probe;    /**< Longest probe (recorded)        */
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  hashes  Number of hash functions
+     */
+    snapshot(size_t hashes = 0):
+        probe_hist  ( 1, 0      ),
+        resolved    ( hashes, 0 ),
+        collided    ( 0         ),
+        used        ( 0         ),
+        avail       ( 0         ),
+        empty       ( 0         ),
+        longest_run ( 0         ),
+        max_probe   ( 0         )
+    {}
+
+    /**
+     *  \brief  Count item
+     *
+     *  \param  pos  Item probe length
+     */
+    void item(size_t pos) {
+        if (!(pos < probe_hist.size())) probe_hist.resize(pos + 1, 0);
+        ++probe_hist[pos];
+
+        if (pos <= resolved.size()) ++resolved[pos - 1];
+        else ++collided;
+    }
+
+    /** Mean probe length of items */
+    double mean_probe() const {
+        size_t sum = 0;
+        for (size_t pos = 1; pos < probe_hist.size(); ++pos)
+            sum += pos * probe_hist[pos];
+
+        return used ? (double)sum / used : 0;
+    }
+
+    /**
+     *  \brief  Export values
+     *
+     *  Calls \c fn(name, value) for each value; histogram bins are named
+     *  \c probe_hist.<length> (non-zero ones only), hash function counts
+     *  \c resolved.<index>.
+     *
+     *  \param  fn  Exporter
+     */
+    template <class Fn>
+    void for_each(Fn fn) const {
+        for (size_t pos = 1; pos < probe_hist.size(); ++pos)
+            if (probe_hist[pos])
+                fn("probe_hist." + std::to_string(pos), probe_hist[pos]);
+
+        for (size_t i = 0; i < resolved.size(); ++i)
+            fn("resolved." + std::to_string(i), resolved[i]);
+
+        fn(std::string("collided"),    collided);
+        fn(std::string("used"),        used);
+        fn(std::string("avail"),       avail);
+        fn(std::string("empty"),       empty);
+        fn(std::string("longest_run"), longest_run);
+        fn(std::string("max_probe"),   max_probe);
+    }
+
+};  // end of struct snapshot
+
+
+/**
+ *  \brief  No statistics
+ *
+ *  The default statistics policy of \ref linear; the hooks are empty,
+ *  so they are optimised out entirely.
+ */
+class none {
+    public:
+
+    /** Statistics are collected */
+    static const bool enabled = false;
+
+    void hashes(size_t ) {}         /**< Number of hash functions */
+    void insert(size_t ) {}         /**< Item inserted            */
+    void hit(size_t ) {}            /**< Item found               */
+    void miss(size_t ) {}           /**< Item not found           */
+    void overfill() {}              /**< Insertion overfill       */
+    void erase() {}                 /**< Item erased              */
+    void rehash() {}                /**< Item rehashed            */
+
+};  // end of class none
+
+
+/**
+ *  \brief  Operation counters
+ *
+ *  Statistics policy of \ref linear counting table operations.
+ *  Insertions and successful lookups record probe length of the item
+ *  (see \ref snapshot), so it's known how often each hash function
+ *  resolved a key and how often the collision string was used.
+ *  Note that the probe length of a hit is computed by re-hashing the key,
+ *  which makes lookups somewhat slower.
+ *  Misses record probe position where the search ended (bounded by
+ *  the longest probe of an item, see \ref linear::max_probe).
+ *
+ *  The counters are updated by lookups, too (a \c mutable table member);
+ *  they are not synchronised (just as the table isn't).
+ */
+class counters {
+    private:
+
+    std::vector<uint64_t> m_resolved;     /**< Ops resolved by hash function  */
+    uint64_t              m_collided;     /**< Ops in collision strings       */
+    uint64_t              m_probes;       /**< Total probe length             */
+    uint64_t              m_inserts;      /**< Insertions                     */
+    uint64_t              m_hits;         /**< Successful lookups             */
+    uint64_t              m_misses;       /**< Unsuccessful lookups           */
+    uint64_t              m_miss_probes;  /**< Total miss probe length        */
+    uint64_t              m_longest_miss; /**< Longest miss probe length      */
+    uint64_t              m_overfills;    /**< Insertions failed on overfill  */
+    uint64_t              m_erasures;     /**< Erasures                       */
+    uint64_t              m_rehashes;     /**< Items moved by rehashing       */
+
+    /** Record probe length */
+    void probe(size_t pos) {
+        m_probes += pos;
+
+        if (pos <= m_resolved.size()) ++m_resolved[pos - 1];
+        else ++m_collided;
+    }
+
+    public:
+
+    /** Statistics are collected */
+    static const bool enabled = true;
+
+    /** Constructor */
+    counters() { reset(); }
+
+    /** Set number of hash functions (the table does that) */
+    void hashes(size_t n) { m_resolved.assign(n, 0); }
+
+    /** Item inserted (with probe length \c pos) */
+    void insert(size_t pos) { ++m_inserts; probe(pos); }
+
+    /** Item found (with probe length \c pos) */
+    void hit(size_t pos) { ++m_hits; probe(pos); }
+
+    /** Item not found (search ended at probe position \c pos) */
+    void miss(size_t pos) {
+        ++m_misses;
+        m_miss_probes += pos;
+        m_longest_miss = std::max(m_longest_miss, (uint64_t)pos);
+    }
+
+    /** Insertion failed (table is full) */
+    void overfill() { ++m_overfills; }
+
+    /** Item erased */
+    void erase() { ++m_erasures; }
+
+    /** Item moved to a new table */
+    void rehash() { ++m_rehashes; }
+
+    /** Reset counters */
+    void reset() {
+        std::fill(m_resolved.begin(), m_resolved.end(), 0);
+        m_collided     = 0;
+        m_probes       = 0;
+        m_inserts      = 0;
+        m_hits         = 0;
+        m_misses       = 0;
+        m_miss_probes  = 0;
+        m_longest_miss = 0;
+        m_overfills    = 0;
+        m_erasures     = 0;
+        m_rehashes     = 0;
+    }
+
+    /** Insertions and hits resolved by hash function \c i */
+    uint64_t resolved(size_t i) const { return m_resolved.at(i); }
+
+    /** Insertions and hits resolved in collision strings */
+    uint64_t collided() const { return m_collided; }
+
+    /** Mean probe length of insertions and hits */
+    double mean_probe() const {
+        const uint64_t ops = m_inserts + m_hits;
+        return ops ? (double)m_probes / ops : 0;
+    }
+
+    /** Mean probe length of misses */
+    double mean_miss_probe() const {
+        return m_misses ? (double)m_miss_probes / m_misses : 0;
+    }
+
+    /** Longest probe length of a miss */
+    uint64_t longest_miss() const { return m_longest_miss; }
+
+    uint64_t inserts()   const { return m_inserts;   }  /**< Insertions  */
+    uint64_t hits()      const { return m_hits;      }  /**< Hits        */
+    uint64_t misses()    const { return m_misses;    }  /**< Misses      */
+    uint64_t overfills() const { return m_overfills; }  /**< Overfills   */
+    uint64_t erasures()  const { return m_erasures;  }  /**< Erasures    */
+    uint64_t rehashes()  const { return m_rehashes;  }  /**< Rehashed    */
+
+    /**
+     *  \brief  Export counters
+     *
+     *  Calls \c fn(name, value) for each counter (so that the counters
+     *  may be exported to a monitoring system); hash function counts
+     *  are named \c resolved.<index>.
+     *
+     *  \param  fn  Exporter
+     */
+    template <class Fn>
+    void for_each(Fn fn) const {
+        for (size_t i = 0; i < m_resolved.size(); ++i)
+            fn("resolved." + std::to_string(i), m_resolved[i]);
+
+        fn(std::string("collided"),     m_collided);
+        fn(std::string("probes"),       m_probes);
+        fn(std::string("inserts"),      m_inserts);
+        fn(std::string("hits"),         m_hits);
+        fn(std::string("misses"),       m_misses);
+        fn(std::string("miss_probes"),  m_miss_probes);
+        fn(std::string("longest_miss"), m_longest_miss);
+        fn(std::string("overfills"),    m_overfills);
+        fn(std::string("erasures"),     m_erasures);
+        fn(std::string("rehashes"),     m_rehashes);
+    }
+
+};  // end of class counters
+
+}}}  // end of namespace libaccl::hash::stats
+
+#endif  // end of #ifndef libaccl__hash__stats_hxx
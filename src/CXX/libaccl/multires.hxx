@@ -0,0 +1,431 @@
+#ifndef libaccl__multires_hxx
+#define libaccl__multires_hxx
+
+/**
+ *  \file
+ *  \brief  Coarse-to-fine multi-resolution accumulator
+ *
+ *  Parameter space sub-sampling: samples are voted to a coarse grid first,
+ *  finer grids only get votes in cells covered by promising coarse cells.
+ *
+ *  \date   2016/01/13
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "libaccl/accumulator.hxx"
+#include "libaccl/hash/linear.hxx"
+#include "libaccl/hash/mix.hxx"
+#include "libaccl/pattern/hypersphere.hxx"
+#include "libaccl/pattern/kernel.hxx"
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+
+/**
+ *  \brief  Multi-resolution accumulator
+ *
+ *  Hierarchy of (sparse) accumulators of decreasing cell size;
+ *  a level cell covers \c factor^N cells of the next (finer) level,
+ *  the finest level has the full resolution.
+ *
+ *  The finest level votes with hypersphere of the specified layers;
+ *  coarser levels use the exact image of the finest kernel, i.e. all
+ *  the coarse cell offsets its points may fall to (for any sample position
+ *  within a coarse cell), so that a coarse cell count is never lower than
+ *  counts of its finest level cells.
+ *  The coarse kernels are smaller by about factor^(N-1), so refinement
+ *  pays off in higher dimensions.
+ *  All votes have unit weight.
+ *
+ *  Samples are voted to the coarsest level first; cells with less than
+ *  \c threshold votes are then dropped (see \ref accumulator::prune).
+ *  A finer level only gets votes in cells whose parent cell (on the previous
+ *  level) was kept, so that the finest level votes are limited
+ *  to promising regions of the space.
+ *  Votes of the finest level cells with votes are the same as in a full
+ *  resolution accumulator.
+ *
+ *  \tparam  Base_t   Base numeric type (integral, signed)
+ *  \tparam  Count_t  Vote count type
+ *  \tparam  N        Space dimension (0 means runtime)
+ */
+template <typename Base_t, typename Count_t = unsigned, size_t N = 0>
+class multires {
+    public:
+
+    typedef accumulator<Base_t, Count_t, N>   accumulator_t;  /**< Level   */
+    typedef typename accumulator_t::kernel_t  kernel_t;       /**< Kernel  */
+    typedef typename accumulator_t::point_t   point_t;        /**< Point   */
+    typedef typename accumulator_t::peaks_t   peaks_t;        /**< Peaks   */
+
+    private:
+
+    typedef hash::point_hash<point_t>           cell_hash_t;  /**< Cell hash */
+    typedef hash::linear<point_t, cell_hash_t> cell_set_t;   /**< Cell set  */
+
+    /**
+     *  \brief  Kernel image at coarser level
+     *
+     *  Per dimension, offset \c o of a sample in coarse cell (of edge
+     *  \c scale) falls to coarse cell offset <tt>floor(o / scale)</tt>
+     *  or (unless \c o is a multiple of \c scale) the next one,
+     *  depending on the sample position within the cell.
+     *  The image is union of all the combinations for all kernel points.
+     */
+    class image: public pattern::points<Base_t, unsigned, N> {
+        public:
+
+        /**
+         *  \brief  Constructor
+         *
+         *  \param  kernel  Full resolution kernel
+         *  \param  scale   Coarse cell edge
+         */
+        image(const kernel_t & kernel, Base_t scale):
+            pattern::points<Base_t, unsigned, N>(kernel.dimension())
+        {
+            const size_t dim = kernel.dimension();
+            point_t cell = pattern::impl::point_type<Base_t, N>::zero(dim);
+
+            for (size_t i = 0; i < kernel.size(); ++i) {
+                const Base_t * o = kernel.offset(i);
+
+                for (size_t m = 0; m < ((size_t)1 << dim); ++m) {
+                    bool exists = true;
+                    for (size_t d = 0; d < dim && exists; ++d) {
+                        cell[d] = floor_div(o[d], scale);
+
+                        if (m & ((size_t)1 << d)) {
+                            exists = o[d] != cell[d] * scale;
+                            ++cell[d];
+                        }
+                    }
+
+                    if (exists) this->set(cell);
+                }
+            }
+
+            this->commit();
+        }
+
+    };  // end of class image
+
+    /** Resolution level */
+    struct resolution {
+        Base_t        scale;  /**< Cell edge (in the finest level cells) */
+        int64_t       outer;  /**< Kernel max. squared offset length      */
+        int64_t       inner;  /**< Kernel min. squared offset length      */
+        size_t        votes;  /**< Number of votes                        */
+        accumulator_t acc;    /**< Accumulator                            */
+
+        /** Constructor */
+        template <typename... Backend_args>
+        resolution(
+            Base_t           s,
+            const kernel_t & kernel,
+            Backend_args...  backend_args)
+        :
+            scale ( s                       ),
+            outer ( 0                       ),
+            inner ( -1                      ),
+            votes ( 0                       ),
+            acc   ( kernel, backend_args... )
+        {
+            for (size_t i = 0; i < kernel.size(); ++i) {
+                int64_t len = 0;
+                for (size_t d = 0; d < kernel.dimension(); ++d)
+                    len += (int64_t)kernel.offset(i)[d] * kernel.offset(i)[d];
+
+                if (len > outer) outer = len;
+                if (len < inner || inner < 0) inner = len;
+            }
+        }
+
+    };  // end of struct resolution
+
+    const size_t            m_dimension;  /**< Space dimension        */
+    const Count_t           m_threshold;  /**< Refinement threshold   */
+    std::vector<resolution> m_levels;     /**< Levels (coarsest 1st)  */
+    bool                    m_voted;      /**< Samples were voted     */
+
+    /** Division rounding towards minus infinity */
+    static Base_t floor_div(Base_t x, Base_t scale) {
+        return (x - (x < 0 ? scale - 1 : 0)) / scale;
+    }
+
+    /**
+     *  \brief  Kernel image may reach cell
+     *
+     *  Conservative test: the sample distance range of the (parent) cell
+     *  box must intersect the kernel offset length range.
+     *
+     *  \param  res     Resolution level
+     *  \param  sample  Sample coordinates (at the level)
+     *  \param  cell    Parent cell
+     *  \param  ratio   Parent cell edge (in the level cells)
+     *  \param  dim     Space dimension
+     */
+    static bool reaches(
+        const resolution & res,
+        const Base_t *     sample,
+        const point_t &    cell,
+        Base_t             ratio,
+        size_t             dim)
+    {
+        int64_t near = 0, far = 0;
+        for (size_t d = 0; d < dim; ++d) {
+            const int64_t lo = (int64_t)cell[d] * ratio - sample[d];
+            const int64_t hi = lo + ratio - 1;
+
+            const int64_t n = 0 < lo ? lo : hi < 0 ? -hi : 0;
+            const int64_t f = std::max(lo < 0 ? -lo : lo, hi < 0 ? -hi : hi);
+
+            near += n * n;
+            far  += f * f;
+        }
+
+        return near <= res.outer && res.inner <= far;
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \tparam Backend_args  Levels' backend constructor argument types
+     *  \param  dimension     Space dimension
+     *  \param  layers        Hypersphere layers (full resolution)
+     *  \param  levels        Number of levels
+     *  \param  factor        Cell edge ratio of neighbouring levels
+     *  \param  threshold     Minimal vote count of a cell to be refined
+     *  \param  backend_args  Levels' backend constructor arguments
+     *                        (see \ref backend::sparse; use table growth,
+     *                        since levels' sizes are not known upfront)
+     */
+    template <typename... Backend_args>
+    multires(
+        size_t                      dimension,
+        const std::vector<Base_t> & layers,
+        size_t                      levels,
+        Base_t                      factor,
+        Count_t                     threshold,
+        Backend_args...             backend_args)
+    :
+        m_dimension ( dimension ),
+        m_threshold ( threshold ),
+        m_voted     ( false     )
+    {
+        if (0 == levels || factor < 2 || layers.empty())
+            throw std::logic_error(
+                "libaccl::multires: "
+                "invalid resolution levels");
+
+        Base_t scale = 1;
+        for (size_t i = 1; i < levels; ++i) scale *= factor;
+
+        const pattern::hypersphere<Base_t, N> sphere(dimension, layers);
+        const kernel_t kernel(sphere);
+
+        m_levels.reserve(levels);
+        for (; 1 < scale; scale /= factor)
+            m_levels.emplace_back(scale,
+                kernel_t(image(kernel, scale)), backend_args...);
+
+        m_levels.emplace_back(1, kernel, backend_args...);
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return m_dimension; }
+
+    /** Refinement threshold */
+    Count_t threshold() const { return m_threshold; }
+
+    /** Number of levels */
+    size_t levels() const { return m_levels.size(); }
+
+    /**
+     *  \brief  Level accumulator
+     *
+     *  \param  i  Level (0 is the coarsest one)
+     */
+    const accumulator_t & level(size_t i) const { return m_levels[i].acc; }
+
+    /**
+     *  \brief  Level cell edge (in the finest level cells)
+     *
+     *  \param  i  Level (0 is the coarsest one)
+     */
+    Base_t scale(size_t i) const { return m_levels[i].scale; }
+
+    /**
+     *  \brief  Number of votes cast to level
+     *
+     *  \param  i  Level (0 is the coarsest one)
+     */
+    size_t votes(size_t i) const { return m_levels[i].votes; }
+
+    /** The finest level (full resolution) accumulator */
+    const accumulator_t & finest() const { return m_levels.back().acc; }
+
+    /**
+     *  \brief  Vote for batch of samples
+     *
+     *  The refinement needs complete votes of the coarser levels,
+     *  so all the samples must be voted by one call.
+     *
+     *  \param  samples  Sample coordinates (row-major, \ref dimension stride)
+     *  \param  count    Number of samples
+     */
+    void vote(const Base_t * samples, size_t count) {
+        if (m_voted)
+            throw std::logic_error(
+                "libaccl::multires::vote: "
+                "samples were already voted");
+
+        m_voted = true;
+
+        const size_t dim = m_dimension;
+        std::vector<Base_t> sample(dim);
+
+        // Coarsest level
+        resolution & top = m_levels.front();
+        std::vector<Base_t> coarse(count * dim);
+        for (size_t i = 0; i < coarse.size(); ++i)
+            coarse[i] = floor_div(samples[i], top.scale);
+
+        top.acc.vote(coarse.data(), count);
+        top.votes = count * top.acc.kernel().size();
+        std::vector<Base_t>().swap(coarse);
+
+        // Refinement
+        for (size_t l = 1; l < m_levels.size(); ++l) {
+            const resolution & parent = m_levels[l - 1];
+            resolution & res = m_levels[l];
+            const Base_t ratio = parent.scale / res.scale;
+
+            // Kept parent cells (small table, cache-friendly lookups)
+            m_levels[l - 1].acc.prune(m_threshold);
+
+            cell_set_t parents(hash::pow2(2 * parent.acc.size() + 16),
+                {cell_hash_t(0x9e3779b9), cell_hash_t(0x7f4a7c15)});
+
+            std::vector<point_t> kept_cells;
+            kept_cells.reserve(parent.acc.size());
+            parent.acc.for_each(
+            [&parents, &kept_cells](const point_t & cell, Count_t ) {
+                parents.insert(cell);
+                kept_cells.push_back(cell);
+            });
+
+            // Samples are pre-filtered if there are few kept cells
+            const bool prefilter =
+                kept_cells.size() * dim < res.acc.kernel().size();
+
+            // Kernel cells are ordered, so parent cells repeat in runs
+            point_t p    = pattern::impl::point_type<Base_t, N>::zero(dim);
+            point_t last = p;
+            bool    known = false, kept = false;
+
+            auto refined = [&parents, ratio, dim, &p, &last, &known, &kept](
+                const point_t & cell) -> bool
+            {
+                for (size_t d = 0; d < dim; ++d)
+                    p[d] = floor_div(cell[d], ratio);
+
+                if (!known || p != last) {
+                    last  = p;
+                    known = true;
+                    kept  = parents.exists(p);
+                }
+
+                return kept;
+            };
+
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t d = 0; d < dim; ++d)
+                    sample[d] = floor_div(samples[i * dim + d], res.scale);
+
+                if (prefilter && std::none_of(
+                    kept_cells.begin(), kept_cells.end(),
+                    [&res, &sample, ratio, dim](const point_t & cell) {
+                        return reaches(res, sample.data(), cell, ratio, dim);
+                    })) continue;
+
+                res.votes += res.acc.vote_if(sample.data(), refined);
+            }
+        }
+    }
+
+    /**
+     *  \brief  Cell vote count (the finest level)
+     *
+     *  \param  point  Cell coordinates
+     *
+     *  \return Number of votes for the cell
+     */
+    Count_t count(const point_t & point) const { return finest().count(point); }
+
+    /** Number of cells with votes (the finest level) */
+    size_t size() const { return finest().size(); }
+
+    /**
+     *  \brief  Find peaks (the finest level)
+     *
+     *  See \ref accumulator::peaks.
+     *
+     *  \param  threshold  Minimal vote count
+     *  \param  top        Max. number of peaks (0 means all)
+     *  \param  threads    Thread count (0 means hardware concurrency)
+     *
+     *  \return Peaks, ordered by vote count (descending)
+     */
+    peaks_t peaks(Count_t threshold, size_t top = 0, unsigned threads = 1)
+        const
+    {
+        return finest().peaks(threshold, top, threads);
+    }
+
+};  // end of template class multires
+
+}  // end of namespace libaccl
+
+#endif  // end of #ifndef libaccl__multires_hxx
@@ -0,0 +1,123 @@
+#ifndef libaccl__parallel_hxx
+#define libaccl__parallel_hxx
+
+/**
+ *  \file
+ *  \brief  Parallel execution helpers
+ *
+ *  Thin layer over std::thread used by parallel algorithms
+ *  of the library.
+ *
+ *  \date   2016/01/06
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <thread>
+#include <exception>
+#include <utility>
+#include <cstdlib>
+
+
+namespace libaccl {
+namespace parallel {
+
+/**
+ *  \brief  Resolve thread count
+ *
+ *  \param  threads  Required thread count (0 means hardware concurrency)
+ *
+ *  \return Thread count (at least 1)
+ */
+inline unsigned thread_cnt(unsigned threads) {
+    if (!threads) threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+/**
+ *  \brief  Chunk of range for a thread
+ *
+ *  Splits range [0, n) to \c cnt contiguous chunks of (nearly) equal size.
+ *
+ *  \param  n    Range size
+ *  \param  cnt  Chunk count
+ *  \param  i    Chunk index
+ *
+ *  \return Chunk boundaries
+ */
+inline std::pair<size_t, size_t> chunk(size_t n, size_t cnt, size_t i) {
+    const size_t q = n / cnt, r = n % cnt;
+    const size_t begin = i * q + (i < r ? i : r);
+    return std::make_pair(begin, begin + q + (i < r ? 1 : 0));
+}
+
+/**
+ *  \brief  Run function in threads
+ *
+ *  Runs \c fn(i) for \c i in [0, threads) in parallel (the last one
+ *  in the calling thread) and waits for all of them.
+ *  If any of the calls throws, the (1st) exception is re-thrown after
+ *  all threads have finished.
+ *
+ *  \param  threads  Thread count
+ *  \param  fn       Function
+ */
+template <class Fn>
+void run(unsigned threads, Fn fn) {
+    if (!threads) return;
+
+    std::vector<std::exception_ptr> x(threads);
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+
+    auto wrap = [&fn, &x](unsigned i) {
+        try { fn(i); }
+        catch (...) { x[i] = std::current_exception(); }
+    };
+
+    for (unsigned i = 0; i < threads - 1; ++i)
+        pool.emplace_back(wrap, i);
+
+    wrap(threads - 1);
+
+    for (size_t i = 0; i < pool.size(); ++i) pool[i].join();
+
+    for (size_t i = 0; i < x.size(); ++i)
+        if (x[i]) std::rethrow_exception(x[i]);
+}
+
+}}  // end of namespace libaccl::parallel
+
+#endif  // end of #ifndef libaccl__parallel_hxx
@@ -0,0 +1,286 @@
+#ifndef libaccl__pattern__cache_hxx
+#define libaccl__pattern__cache_hxx
+
+/**
+ *  \file
+ *  \brief  Pattern cache
+ *
+ *  \date   2016/01/12
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/pattern/hypersphere.hxx"
+#include "libaccl/parallel.hxx"
+
+#include <map>
+#include <list>
+#include <vector>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <utility>
+#include <exception>
+#include <cstdlib>
+
+
+namespace libaccl {
+namespace pattern {
+
+/**
+ *  \brief  Pattern cache
+ *
+ *  Thread-safe cache of immutable patterns keyed by space dimension
+ *  and layers' radii.
+ *  Patterns are shared (\c std::shared_ptr to const pattern); an evicted
+ *  pattern lives as long as someone holds it.
+ *  The least recently used patterns are evicted when memory used
+ *  by the cached patterns exceeds the budget.
+ *
+ *  A pattern is built (outside the cache lock) by the 1st requester;
+ *  concurrent requests of the same pattern wait for it to be done.
+ *
+ *  \tparam  Pattern_t  Pattern type (constructible from dimension
+ *                      and layers, e.g. \ref hypersphere)
+ */
+template <class Pattern_t = hypersphere<int> >
+class cache {
+    public:
+
+    typedef typename Pattern_t::point_t::value_type base_t;     /**< Base numeric type */
+    typedef std::shared_ptr<const Pattern_t>        pattern_t;  /**< Shared pattern    */
+    typedef std::vector<base_t>                     layers_t;   /**< Layers' radii     */
+
+    private:
+
+    typedef std::pair<size_t, layers_t> key_t;  /**< Key (dimension, layers) */
+
+    /** Cache entry */
+    struct entry {
+        typename std::list<key_t>::iterator lru;      /**< LRU list position  */
+        std::shared_future<pattern_t>       pattern;  /**< Pattern            */
+        size_t                              memory;   /**< Memory (if ready)  */
+        bool                                ready;    /**< Pattern is built   */
+    };  // end of struct entry
+
+    typedef std::map<key_t, entry> entries_t;  /**< Entries */
+
+    mutable std::mutex m_mutex;    /**< Mutex                        */
+    entries_t          m_entries;  /**< Entries                      */
+    std::list<key_t>   m_lru;      /**< Keys (most recently used 1st) */
+    size_t             m_budget;   /**< Memory budget (bytes)        */
+    size_t             m_memory;   /**< Memory used (bytes)          */
+    size_t             m_hits;     /**< Hit count                    */
+    size_t             m_misses;   /**< Miss count                   */
+
+    /** Evict least recently used (ready) patterns over budget (locked) */
+    void evict() {
+        auto key = m_lru.end();
+        while (m_memory > m_budget && key != m_lru.begin()) {
+            --key;
+
+            auto e = m_entries.find(*key);
+            if (!e->second.ready) continue;  // being built
+
+            m_memory -= e->second.memory;
+            m_entries.erase(e);
+            key = m_lru.erase(key);
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  budget  Memory budget (bytes)
+     */
+    cache(size_t budget):
+        m_budget ( budget ),
+        m_memory ( 0      ),
+        m_hits   ( 0      ),
+        m_misses ( 0      )
+    {}
+
+    /**
+     *  \brief  Get pattern
+     *
+     *  The pattern is built if it's not cached.
+     *
+     *  \param  dimension  Space dimension
+     *  \param  layers     Layers' radii
+     *
+     *  \return Pattern
+     */
+    pattern_t get(size_t dimension, const layers_t & layers) {
+        key_t key(dimension, layers);
+
+        std::promise<pattern_t> promise;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            auto e = m_entries.find(key);
+            if (m_entries.end() != e) {  // hit (maybe still being built)
+                m_lru.splice(m_lru.begin(), m_lru, e->second.lru);
+                ++m_hits;
+
+                std::shared_future<pattern_t> pattern = e->second.pattern;
+                lock.unlock();
+
+                return pattern.get();
+            }
+
+            ++m_misses;
+
+            m_lru.push_front(key);
+
+            entry & new_e   = m_entries[key];
+            new_e.lru       = m_lru.begin();
+            new_e.pattern   = promise.get_future().share();
+            new_e.memory    = 0;
+            new_e.ready     = false;
+        }
+
+        // Build the pattern (unlocked)
+        pattern_t pattern;
+        try {
+            pattern = std::make_shared<const Pattern_t>(dimension, layers);
+        }
+        catch (...) {
+            promise.set_exception(std::current_exception());
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto e = m_entries.find(key);
+            m_lru.erase(e->second.lru);
+            m_entries.erase(e);
+
+            throw;
+        }
+
+        promise.set_value(pattern);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        entry & e = m_entries.find(key)->second;
+        e.memory  = pattern->memory();
+        e.ready   = true;
+        m_memory += e.memory;
+
+        evict();
+
+        return pattern;
+    }
+
+    /**
+     *  \brief  Precompute patterns
+     *
+     *  Builds (in parallel) patterns expected to be needed,
+     *  e.g. ladder of radii of a parameter space sweep.
+     *  Note that the patterns may be evicted if they don't fit
+     *  the budget.
+     *
+     *  \param  dimension  Space dimension
+     *  \param  ladder     Layers' radii of the patterns
+     *  \param  threads    Thread count (0 means hardware concurrency)
+     */
+    void precompute(
+        size_t                        dimension,
+        const std::vector<layers_t> & ladder,
+        unsigned                      threads = 1)
+    {
+        threads = parallel::thread_cnt(threads);
+        if (threads > ladder.size()) threads = ladder.size();
+
+        parallel::run(threads, [this, dimension, &ladder, threads](unsigned t) {
+            const auto range = parallel::chunk(ladder.size(), threads, t);
+
+            for (size_t i = range.first; i < range.second; ++i)
+                get(dimension, ladder[i]);
+        });
+    }
+
+    /** Remove all patterns (but those being built) */
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const size_t budget = m_budget;
+        m_budget = 0;
+        evict();
+        m_budget = budget;
+    }
+
+    /** Number of cached patterns */
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    /** Memory used by cached patterns (bytes) */
+    size_t memory() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_memory;
+    }
+
+    /** Memory budget (bytes) */
+    size_t budget() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_budget;
+    }
+
+    /** Set memory budget (bytes) */
+    void budget(size_t budget) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_budget = budget;
+        evict();
+    }
+
+    /** Hit count */
+    size_t hits() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hits;
+    }
+
+    /** Miss count (number of patterns built) */
+    size_t misses() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_misses;
+    }
+
+};  // end of template class cache
+
+}}  // end of namespace libaccl::pattern
+
+#endif  // end of #ifndef libaccl__pattern__cache_hxx
@@ -97,7 +97,11 @@
  */
 
 #include "libaccl/pattern/points.hxx"
+#include "libaccl/parallel.hxx"
 
+#include <vector>
+#include <memory>
+#include <type_traits>
 #include <algorithm>
 #include <cassert>
 
@@ -113,72 +117,252 @@ namespace pattern {
  *  The hypersphere may be hollow and/or layered; one may specify thickness
  *  of each layer (circumference-to-centre).
  *
+ *  If the space dimension is specified as template parameter, points are
+ *  \c std::array -s and the slicing recursion is unrolled at compile time.
+ *  Otherwise (\c N == 0, the default), the dimension is set at runtime.
+ *
+ *  The point set and all working buffers are obtained from the \c Alloc
+ *  allocator; scratch buffers of the slicing recursion are allocated
+ *  once per construction (for all recursion levels).
+ *  Using \ref libaccl::arena::allocator, a pattern is built from a few
+ *  bulk allocations and released at once with the arena.
+ *
  *  \tparam  Base_t  Base numeric type (integral)
+ *  \tparam  N       Space dimension (0 means runtime)
+ *  \tparam  Alloc   Allocator (of \c Base_t)
  */
-template <typename Base_t>
-class hypersphere: public points<Base_t, unsigned> {
+template <
+    typename Base_t,
+    size_t   N     = 0,
+    class    Alloc = std::allocator<Base_t> >
+class hypersphere: public points<Base_t, unsigned, N, Alloc> {
+    private:
+
+    typedef points<Base_t, unsigned, N, Alloc> super_t;  /**< Superclass */
+
+    public:
+
+    typedef typename super_t::point_t point_t;  /**< Point */
+
     private:
 
-    typedef points<Base_t, unsigned> super_t;  /**< Superclass */
+    /** Slicing dimension (recursion level) for compile-time dimension */
+    template <size_t D>
+    using level_t = std::integral_constant<size_t, D>;
+
+    /** Vector using (rebound) allocator */
+    template <typename T>
+    using vector_t = std::vector<T,
+        typename std::allocator_traits<Alloc>::template rebind_alloc<T> >;
+
+    /** Next slicing dimension (runtime) */
+    static size_t next(size_t d) { return d + 1; }
+
+    /** Next slicing dimension (compile-time) */
+    template <size_t D>
+    static level_t<D + 1> next(level_t<D>) { return level_t<D + 1>(); }
 
     /**
-     *  \brief  Compute hypersphere 1st hyperoctant points
+     *  \brief  Scratch buffers
      *
-     *  \param  centre  Hypersphere centre
-     *  \param  layers  Hypersphere layers' radii
-     *  \param  d       Slicing dimension
+     *  Slice radii, midpoint criteria and slice centre for each slicing
+     *  dimension (recursion level) and working points, allocated at once.
      */
-    void octant(
-        const std::vector<Base_t> & centre,
-        const std::vector<Base_t> & layers,
-        size_t                      d = 0)
+    class scratch {
+        private:
+
+        size_t            m_layers;    /**< Number of layers         */
+        vector_t<Base_t>  m_radii;     /**< Slice radii (per level)  */
+        vector_t<Base_t>  m_criteria;  /**< Criteria (per level)     */
+        vector_t<size_t>  m_ids;       /**< Sphere indices (per level) */
+        vector_t<point_t> m_centre;    /**< Slice centres (per level) */
+
+        public:
+
+        const point_t    zero;  /**< Zero point              */
+        point_t          x;     /**< Working point           */
+        point_t          y;     /**< Working point           */
+        vector_t<size_t> nz;    /**< Non-zero coordinates    */
+
+        /** Constructor */
+        scratch(size_t dimension, size_t layers, const Alloc & alloc):
+            m_layers   ( layers                                      ),
+            m_radii    ( dimension * layers, 0, alloc                ),
+            m_criteria ( dimension * layers, 0, alloc                ),
+            m_ids      ( dimension * layers, 0, alloc                ),
+            m_centre   ( alloc                                       ),
+            zero       ( impl::point_type<Base_t, N>::zero(dimension) ),
+            x          ( zero                                        ),
+            y          ( zero                                        ),
+            nz         ( alloc                                       )
+        {
+            m_centre.resize(dimension, zero);
+            nz.reserve(dimension);
+        }
+
+        /** Slice radii of level \c d */
+        Base_t * radii(size_t d) { return m_radii.data() + d * m_layers; }
+
+        /** Midpoint criteria of level \c d */
+        Base_t * criteria(size_t d) {
+            return m_criteria.data() + d * m_layers;
+        }
+
+        /** Sphere indices of level \c d */
+        size_t * ids(size_t d) { return m_ids.data() + d * m_layers; }
+
+        /** Slice centre of level \c d */
+        point_t & centre(size_t d) { return m_centre[d]; }
+
+    };  // end of class scratch
+
+    /**
+     *  \brief  Compute 1D hypersphere layers (recursion fixed point)
+     *
+     *  Concentric spheres (\c ids set) are independent 1-point lines;
+     *  the point is passed with the sphere index instead of layer.
+     *
+     *  \tparam Fn         Point sink type
+     *  \param  centre     Hypersphere centre
+     *  \param  layers     Hypersphere layers' radii
+     *  \param  layer_cnt  Number of layers
+     *  \param  ids        Sphere indices (concentric spheres, see
+     *                     \ref concentric) or \c NULL (layers)
+     *  \param  d          Slicing dimension
+     *  \param  scr        Scratch buffers
+     *  \param  fn         Point sink, called with point and layer
+     */
+    template <class Fn>
+    static void line(
+        const point_t & centre,
+        const Base_t  * layers,
+        size_t          layer_cnt,
+        const size_t  * ids,
+        size_t          d,
+        scratch       & scr,
+        Fn            & fn)
     {
-        assert(d < centre.size());
-        assert(0 < layers.size());
+        point_t & point  = scr.centre(d);  // not used by slicing
+        unsigned  layer  = 0;
+        Base_t    radius = layers[layer];
 
-        // 1D, create layers
-        if (centre.size() - 1 == d) {
-            auto     point  = centre;
-            unsigned layer  = 0;
-            Base_t   radius = layers[layer];
-
-            point[d] += radius;
-            while (radius > layers[layers.size() - 1]) {
-                this->set(point, layer);
-                --point[d];
-                --radius;
-
-                while (layer < layers.size())
-                    if (radius <= layers[layer + 1]) layer++;
-                    else break;
+        point = centre;
+
+        // Concentric spheres' surface points
+        if (NULL != ids) {
+            for (size_t i = 0; i < layer_cnt; ++i) {
+                point[d] = centre[d] + layers[i];
+                fn(point, (unsigned)ids[i]);
             }
 
-            if (layer) --layer;
-            this->set(point, layer);  // stopper layer
+            return;
+        }
+
+        point[d] += radius;
+        while (radius > layers[layer_cnt - 1]) {
+            fn(point, layer);
+            --point[d];
+            --radius;
+
+            while (layer + 1 < layer_cnt)
+                if (radius <= layers[layer + 1]) layer++;
+                else break;
+        }
+
+        if (layer) --layer;
+        fn(point, layer);  // stopper layer
+    }
+
+    /**
+     *  \brief  Next slice radii of concentric spheres
+     *
+     *  Spheres done are removed (the rest keeps its order).
+     *
+     *  \param  radii     Slice radii
+     *  \param  criteria  Midpoint criteria
+     *  \param  ids       Sphere indices
+     *  \param  cnt       Number of spheres
+     *  \param  d_diff    Next slice offset
+     *
+     *  \return Number of spheres left
+     */
+    static size_t next_slice(
+        Base_t * radii,
+        Base_t * criteria,
+        size_t * ids,
+        size_t   cnt,
+        Base_t   d_diff)
+    {
+        size_t left = 0;
+        for (size_t i = 0; i < cnt; ++i) {
+            if (radii[i] - d_diff <= 0) continue;  // sphere done
+
+            // Update radius and criterion for the sphere
+            Base_t chi = d_diff;
+            if (criteria[i] > 0) chi -= --radii[i];
+            chi *= 4;
+            criteria[i] += chi + 1;
 
-            return;  // recursion fixed point
+            radii[left]    = radii[i];
+            criteria[left] = criteria[i];
+            ids[left]      = ids[i];
+            ++left;
         }
 
-        // Midpoint circle algorithm for slice radius computation
+        return left;
+    }
+
+    /**
+     *  \brief  Enumerate slices' radii
+     *
+     *  Midpoint circle algorithm for slice radius computation.
+     *  Layers' slice radii are interdependent (a layer done ends
+     *  the inner ones).
+     *  Concentric spheres (\c ids set) share the slices, but each of them
+     *  is sliced independently (exactly as if it was computed alone).
+     *
+     *  \tparam Sub        Slice sink type
+     *  \param  layers     Hypersphere layers' radii
+     *  \param  layer_cnt  Number of layers
+     *  \param  ids        Sphere indices (concentric spheres, see
+     *                     \ref concentric) or \c NULL (layers)
+     *  \param  radii      Slice radii buffer (\c layer_cnt long)
+     *  \param  criteria   Midpoint criteria buffer (\c layer_cnt long)
+     *  \param  slice_ids  Slice sphere indices buffer (if \c ids set)
+     *  \param  sub        Sink, called with slice offset, radii, their
+     *                     count and sphere indices for each slice
+     */
+    template <class Sub>
+    static void for_slices(
+        const Base_t  * layers,
+        size_t          layer_cnt,
+        const size_t  * ids,
+        Base_t        * radii,
+        Base_t        * criteria,
+        size_t        * slice_ids,
+        Sub           & sub)
+    {
         Base_t d_diff = 0;
-        std::vector<Base_t> radii;    radii.reserve(layers.size());
-        std::vector<Base_t> criteria; criteria.reserve(layers.size());
+        size_t cnt    = layer_cnt;
 
-        std::for_each(layers.begin(), layers.end(),
-        [&radii, &criteria](const Base_t & radius) {
-            radii.push_back(radius);
-            criteria.push_back(1 - radius);
-        });
+        for (size_t i = 0; i < layer_cnt; ++i) {
+            radii[i]    = layers[i];
+            criteria[i] = 1 - layers[i];
+        }
 
-        auto slice_centre = centre;
-        while (!radii.empty()) {
-            // 1st octant
-            slice_centre[d] = centre[d] + d_diff;
-            octant(slice_centre, radii, d + 1);
+        if (NULL != ids) std::copy(ids, ids + layer_cnt, slice_ids);
+
+        while (cnt) {
+            sub(d_diff, (const Base_t *)radii, cnt, (const size_t *)slice_ids);
 
             ++d_diff;  // next slice
 
-            for (size_t i = 0; i < radii.size(); ++i) {
+            if (NULL != ids) {
+                cnt = next_slice(radii, criteria, slice_ids, cnt, d_diff);
+                continue;
+            }
+
+            for (size_t i = 0; i < cnt; ++i) {
                 Base_t delta = radii[i] - d_diff;
 
                 // Octant done
@@ -188,82 +372,814 @@ class hypersphere: public points<Base_t, unsigned> {
                         ++i;
                     }
 
-                    // the rest is out-of-scope, too
-                    for (; i < radii.size(); radii.pop_back());
+                    cnt = i;  // the rest is out-of-scope, too
                     break;
                 }
 
                 // Update radius and criterion for the layer
                 Base_t chi = d_diff;
                 if (criteria[i] > 0) chi -= --radii[i];
-                chi <<= 2;
+                chi *= 4;
                 criteria[i] += chi + 1;
             }
         }
     }
 
     /**
-     *  \brief  Add 2nd-8th hyperoctants by symmetry
+     *  \brief  Compute hypersphere slices' 1st hyperoctant points
+     *
+     *  \tparam Level_t    Slicing dimension type
+     *  \tparam Fn         Point sink type
+     *  \param  centre     Hypersphere centre
+     *  \param  layers     Hypersphere layers' radii
+     *  \param  layer_cnt  Number of layers
+     *  \param  ids        Sphere indices (concentric spheres, see
+     *                     \ref concentric) or \c NULL (layers)
+     *  \param  d          Slicing dimension
+     *  \param  scr        Scratch buffers
+     *  \param  fn         Point sink
+     */
+    template <class Level_t, class Fn>
+    static void slices(
+        const point_t & centre,
+        const Base_t  * layers,
+        size_t          layer_cnt,
+        const size_t  * ids,
+        Level_t         d,
+        scratch       & scr,
+        Fn            & fn)
+    {
+        point_t & slice_centre = scr.centre(d);
+        slice_centre = centre;
+
+        auto sub = [&centre, &slice_centre, d, &scr, &fn](
+            Base_t d_diff, const Base_t * radii, size_t cnt,
+            const size_t * slice_ids)
+        {
+            // 1st octant
+            slice_centre[d] = centre[d] + d_diff;
+            octant(slice_centre, radii, cnt, slice_ids, next(d), scr, fn);
+        };
+
+        for_slices(layers, layer_cnt, ids, scr.radii(d), scr.criteria(d),
+            NULL != ids ? scr.ids(d) : NULL, sub);
+    }
+
+    /**
+     *  \brief  Compute hypersphere 1st hyperoctant points (runtime dimension)
+     *
+     *  \tparam Fn         Point sink type
+     *  \param  centre     Hypersphere centre
+     *  \param  layers     Hypersphere layers' radii
+     *  \param  layer_cnt  Number of layers
+     *  \param  ids        Sphere indices (concentric spheres, see
+     *                     \ref concentric) or \c NULL (layers)
+     *  \param  d          Slicing dimension
+     *  \param  scr        Scratch buffers
+     *  \param  fn         Point sink
+     */
+    template <class Fn>
+    static void octant(
+        const point_t & centre,
+        const Base_t  * layers,
+        size_t          layer_cnt,
+        const size_t  * ids,
+        size_t          d,
+        scratch       & scr,
+        Fn            & fn)
+    {
+        assert(d < centre.size());
+        assert(0 < layer_cnt);
+
+        // 1D, create layers
+        if (centre.size() - 1 == d)
+            line(centre, layers, layer_cnt, ids, d, scr, fn);  // fixed point
+        else
+            slices(centre, layers, layer_cnt, ids, d, scr, fn);
+    }
+
+    /**
+     *  \brief  Compute hypersphere 1st hyperoctant points (compile-time dim.)
+     *
+     *  \tparam D          Slicing dimension
+     *  \tparam Fn         Point sink type
+     *  \param  centre     Hypersphere centre
+     *  \param  layers     Hypersphere layers' radii
+     *  \param  layer_cnt  Number of layers
+     *  \param  ids        Sphere indices (concentric spheres, see
+     *                     \ref concentric) or \c NULL (layers)
+     *  \param  d          Slicing dimension
+     *  \param  scr        Scratch buffers
+     *  \param  fn         Point sink
+     */
+    template <size_t D, class Fn>
+    static void octant(
+        const point_t & centre,
+        const Base_t  * layers,
+        size_t          layer_cnt,
+        const size_t  * ids,
+        level_t<D>      d,
+        scratch       & scr,
+        Fn            & fn)
+    {
+        static_assert(D < N, "slicing dimension out of range");
+        assert(0 < layer_cnt);
+
+        octant(centre, layers, layer_cnt, ids, d, scr, fn,
+            std::integral_constant<bool, D + 1 == N>());
+    }
+
+    /** 1D, create layers (recursion fixed point, compile-time dimension) */
+    template <size_t D, class Fn>
+    static void octant(
+        const point_t & centre,
+        const Base_t  * layers,
+        size_t          layer_cnt,
+        const size_t  * ids,
+        level_t<D>      ,
+        scratch       & scr,
+        Fn            & fn,
+        std::true_type  )
+    {
+        line(centre, layers, layer_cnt, ids, D, scr, fn);
+    }
+
+    /** Slicing step (compile-time dimension) */
+    template <size_t D, class Fn>
+    static void octant(
+        const point_t & centre,
+        const Base_t  * layers,
+        size_t          layer_cnt,
+        const size_t  * ids,
+        level_t<D>      d,
+        scratch       & scr,
+        Fn            & fn,
+        std::false_type )
+    {
+        slices(centre, layers, layer_cnt, ids, d, scr, fn);
+    }
+
+    /**
+     *  \brief  Compute canonical 1st hyperoctant points
+     *
+     *  Each point computed by \ref octant is reduced to its canonical form
+     *  (coordinates sorted in ascending order).
+     *  The hypersphere consists of all images of the canonical points
+     *  by the hyperoctahedral symmetry (coordinate permutations and
+     *  reflections).
+     *  Note that if more 1st hyperoctant points map on the same canonical
+     *  point, the 1st computed one provides the payload (layer).
+     *
+     *  \param  layers  Hypersphere layers' radii
+     *  \param  scr     Scratch buffers
+     *  \param  canon   Canonical points (committed)
+     */
+    static void canonical(
+        const std::vector<Base_t> & layers,
+        scratch                   & scr,
+        typename super_t::set_t   & canon)
+    {
+        typedef typename std::conditional<N, level_t<0>, size_t>::type
+            level0_t;
+
+        point_t & c = scr.x;
+        auto fn = [&canon, &c](const point_t & x, unsigned layer) {
+            std::copy(x.begin(), x.end(), c.begin());
+            std::sort(c.begin(), c.end());
+            canon.insert(c, layer);
+        };
+
+        octant(scr.zero, layers.data(), layers.size(), NULL, level0_t(), scr, fn);
+        canon.commit();
+    }
+
+    /** Slicing below the 1st level (runtime dimension) */
+    template <class Fn>
+    static void sub_octant(
+        const point_t & centre,
+        const Base_t  * radii,
+        size_t          cnt,
+        size_t          ,
+        scratch       & scr,
+        Fn            & fn)
+    {
+        octant(centre, radii, cnt, NULL, (size_t)1, scr, fn);
+    }
+
+    /** Slicing below the 1st level (compile-time dimension) */
+    template <class Fn>
+    static void sub_octant(
+        const point_t & centre,
+        const Base_t  * radii,
+        size_t          cnt,
+        level_t<0>      ,
+        scratch       & scr,
+        Fn            & fn)
+    {
+        sub_octant(centre, radii, cnt, scr, fn,
+            std::integral_constant<bool, (1 < N)>());
+    }
+
+    /** Slicing below the 1st level (compile-time dimension) */
+    template <class Fn>
+    static void sub_octant(
+        const point_t & centre,
+        const Base_t  * radii,
+        size_t          cnt,
+        scratch       & scr,
+        Fn            & fn,
+        std::true_type  )
+    {
+        octant(centre, radii, cnt, NULL, level_t<1>(), scr, fn);
+    }
+
+    /** 1D sphere is not sliced */
+    template <class Fn>
+    static void sub_octant(
+        const point_t & ,
+        const Base_t  * ,
+        size_t          ,
+        scratch       & ,
+        Fn            & ,
+        std::false_type )
+    {}
+
+    /**
+     *  \brief  Compute canonical 1st hyperoctant points in parallel
+     *
+     *  Radii of the 1st level slices are computed first, then the slices
+     *  are distributed among threads (interleaved, the outer slices
+     *  are larger).
+     *  Canonical points of each slice are kept apart and merged in order
+     *  of the slices, so the result is the same as the one computed
+     *  by one thread (incl. payloads of points computed more times).
+     *
+     *  \param  layers   Hypersphere layers' radii
+     *  \param  threads  Thread count
+     *  \param  scr      Scratch buffers
+     *  \param  canon    Canonical points (committed)
+     */
+    static void canonical(
+        const std::vector<Base_t> & layers,
+        unsigned                    threads,
+        scratch                   & scr,
+        typename super_t::set_t   & canon)
+    {
+        typedef typename std::conditional<N, level_t<0>, size_t>::type
+            level0_t;
+
+        typedef typename super_t::set_t set_t;
+
+        const size_t dimension = scr.zero.size();
+        const Alloc  alloc     = canon.alloc();
+
+        if (threads < 2 || dimension < 2) {
+            canonical(layers, scr, canon);
+            return;
+        }
+
+        // 1st level slices' radii (slice offset is the slice index)
+        vector_t<Base_t> ladder(alloc);
+        vector_t<size_t> begin(alloc);
+        auto record = [&ladder, &begin](
+            Base_t , const Base_t * radii, size_t cnt, const size_t * )
+        {
+            begin.push_back(ladder.size());
+            ladder.insert(ladder.end(), radii, radii + cnt);
+        };
+
+        for_slices(layers.data(), layers.size(), NULL,
+            scr.radii(0), scr.criteria(0), NULL, record);
+
+        const size_t slice_cnt = begin.size();
+        begin.push_back(ladder.size());
+
+        if (threads > slice_cnt) threads = slice_cnt;
+
+        std::vector<set_t> part(slice_cnt, set_t(dimension, alloc));
+        parallel::run(threads,
+        [&layers, &ladder, &begin, &part, dimension, alloc, threads]
+        (unsigned t) {
+            scratch scr(dimension, layers.size(), alloc);
+
+            set_t   * sink = NULL;
+            point_t & c    = scr.x;
+            auto fn = [&sink, &c](const point_t & x, unsigned layer) {
+                std::copy(x.begin(), x.end(), c.begin());
+                std::sort(c.begin(), c.end());
+                sink->insert(c, layer);
+            };
+
+            point_t & centre = scr.centre(0);  // not used below 1st level
+            for (size_t i = t; i < part.size(); i += threads) {
+                sink = &part[i];
+
+                centre    = scr.zero;
+                centre[0] = (Base_t)i;
+                sub_octant(centre, ladder.data() + begin[i],
+                    begin[i + 1] - begin[i], level0_t(), scr, fn);
+            }
+        });
+
+        size_t size = 0;
+        for (size_t i = 0; i < part.size(); ++i) size += part[i].size();
+
+        canon.reserve(size);
+        for (size_t i = 0; i < part.size(); ++i)
+            for (size_t j = 0; j < part[i].size(); ++j)
+                canon.insert(part[i].point(j).begin(), part[i].payload(j));
+
+        canon.commit();
+    }
+
+    /** Canonical points of concentric spheres (sphere index 1st) */
+    typedef impl::flat_set<Base_t, unsigned, N ? N + 1 : 0, Alloc> shells_t;
+
+    /**
+     *  \brief  Compute canonical 1st hyperoctant points of concentric spheres
+     *
+     *  All the spheres are computed in one slicing recursion.
+     *  Canonical points are prefixed by the sphere index, so that
+     *  the committed set is ordered by sphere.
      *
      *  \param  dimension  Space dimension
+     *  \param  radii      Spheres' radii
+     *  \param  scr        Scratch buffers
+     *  \param  canon      Canonical points (committed)
      */
-    void symmetry(size_t dimension) {
-        // Diagonal symmetry
-        for (size_t d = 0; d < dimension; ++d) {
-            size_t b = (d + 1) % dimension;
-
-            const typename super_t::set_t points(*this);
-            std::for_each(points.begin(), points.end(),
-            [this, d, b](
-                const std::pair<typename super_t::point_t, unsigned> & x_layer)
-            {
-                if (x_layer.first[d] != x_layer.first[b]) {
-                    auto y(x_layer.first);
-                    auto tmp = y[d];
-                    y[d] = y[b];
-                    y[b] = tmp;
-
-                    this->set(y, x_layer.second);
-                }
-            });
+    static void canonical(
+        size_t                      dimension,
+        const std::vector<Base_t> & radii,
+        scratch                   & scr,
+        shells_t                  & canon)
+    {
+        typedef typename std::conditional<N, level_t<0>, size_t>::type
+            level0_t;
+
+        typename shells_t::point_t c =
+            impl::point_type<Base_t, N ? N + 1 : 0>::zero(dimension + 1);
+
+        auto fn = [&canon, &c](const point_t & x, unsigned sphere) {
+            c[0] = (Base_t)sphere;
+            std::copy(x.begin(), x.end(), c.begin() + 1);
+            std::sort(c.begin() + 1, c.end());
+            canon.insert(c, 0);
+        };
+
+        vector_t<size_t> ids(radii.size(), 0, canon.alloc());
+        for (size_t i = 0; i < ids.size(); ++i) ids[i] = i;
+
+        octant(scr.zero, radii.data(), radii.size(), ids.data(),
+            level0_t(), scr, fn);
+
+        canon.commit();
+    }
+
+    /**
+     *  \brief  Concentric spheres' canonical points ranges
+     *
+     *  \param  canon   Canonical points of concentric spheres
+     *  \param  spheres  Number of spheres
+     *
+     *  \return Range begin for each sphere (and the end)
+     */
+    static vector_t<size_t> ranges(const shells_t & canon, size_t spheres) {
+        vector_t<size_t> begin(spheres + 1, canon.size(), canon.alloc());
+
+        for (size_t i = canon.size(); i-- > 0; )
+            begin[(size_t)canon.point(i)[0]] = i;
+
+        for (size_t k = spheres; k-- > 0; )  // empty ranges
+            if (begin[k] > begin[k + 1]) begin[k] = begin[k + 1];
+
+        return begin;
+    }
+
+    /**
+     *  \brief  Emit images of canonical points
+     *
+     *  \tparam Set_t  Canonical points set type
+     *  \tparam Fn     Point sink type
+     *  \param  canon  Canonical points
+     *  \param  begin  Range begin
+     *  \param  end    Range end
+     *  \param  skip   Number of leading coordinates to skip (sphere index)
+     *  \param  scr    Scratch buffers
+     *  \param  fn     Point sink, called with point and layer
+     */
+    template <class Set_t, class Fn>
+    static void images(
+        const Set_t & canon,
+        size_t        begin,
+        size_t        end,
+        size_t        skip,
+        scratch     & scr,
+        Fn          & fn)
+    {
+        const size_t dimension = scr.zero.size();
+
+        for (size_t i = begin; i < end; ++i) {
+            const typename Set_t::coords c(
+                canon.point(i).begin() + skip, dimension);
+
+            images(c, canon.payload(i), scr, fn);
         }
+    }
 
-        // Axial symmetry
-        for (size_t d = 0; d < dimension; ++d) {
-            const typename super_t::set_t points(*this);
-            std::for_each(points.begin(), points.end(),
-            [this, d](
-                const std::pair<typename super_t::point_t, unsigned> & x_layer)
-            {
-                if (0 != x_layer.first[d]) {
-                    auto y(x_layer.first);
-                    y[d] = -y[d];
-
-                    this->set(y, x_layer.second);
-                }
-            });
+    /**
+     *  \brief  Store all images of canonical points
+     *
+     *  \tparam Set_t  Canonical points set type
+     *  \param  canon  Canonical points
+     *  \param  begin  Range begin
+     *  \param  end    Range end
+     *  \param  skip   Number of leading coordinates to skip (sphere index)
+     *  \param  scr    Scratch buffers
+     */
+    template <class Set_t>
+    void build(
+        const Set_t & canon,
+        size_t        begin,
+        size_t        end,
+        size_t        skip,
+        scratch     & scr)
+    {
+        const size_t dimension = scr.zero.size();
+
+        // Reserve exact final size
+        size_t size = 0;
+        for (size_t i = begin; i < end; ++i)
+            size += image_cnt(typename Set_t::coords(
+                canon.point(i).begin() + skip, dimension));
+
+        this->reserve(size);
+
+        // Emit all images of the canonical points
+        auto fn = [this](const point_t & x, unsigned layer) {
+            this->set(x, layer);
+        };
+
+        images(canon, begin, end, skip, scr, fn);
+
+        assert(this->size() == size);
+        this->commit();
+    }
+
+    /**
+     *  \brief  Store all images of canonical points in parallel
+     *
+     *  Canonical points are split among threads by their image counts;
+     *  each thread stores and sorts images of its points apart,
+     *  the sorted parts are merged.
+     *
+     *  \param  canon    Canonical points
+     *  \param  threads  Thread count
+     *  \param  scr      Scratch buffers
+     */
+    void build(
+        const typename super_t::set_t & canon,
+        unsigned                        threads,
+        scratch                       & scr)
+    {
+        typedef typename super_t::set_t set_t;
+
+        if (threads < 2 || canon.size() < 2) {
+            build(canon, 0, canon.size(), 0, scr);
+            return;
+        }
+
+        const size_t dimension = scr.zero.size();
+        const Alloc  alloc     = canon.alloc();
+
+        // Image counts (cumulative)
+        vector_t<size_t> cum(canon.size() + 1, 0, alloc);
+        for (size_t i = 0; i < canon.size(); ++i)
+            cum[i + 1] = cum[i] + image_cnt(canon.point(i));
+
+        const size_t total = cum.back();
+
+        std::vector<set_t> part(threads, set_t(dimension, alloc));
+        parallel::run(threads,
+        [&canon, &cum, &part, dimension, alloc, threads, total](unsigned t) {
+            const size_t begin = std::lower_bound(cum.begin(), cum.end(),
+                total * t / threads) - cum.begin();
+            const size_t end   = std::lower_bound(cum.begin(), cum.end(),
+                total * (t + 1) / threads) - cum.begin();
+
+            scratch scr(dimension, 0, alloc);
+            set_t & set = part[t];
+
+            set.reserve(cum[end] - cum[begin]);
+
+            auto fn = [&set](const point_t & x, unsigned layer) {
+                set.insert(x, layer);
+            };
+
+            images(canon, begin, end, 0, scr, fn);
+            set.commit();
+        });
+
+        this->merge(part.data(), part.size());
+        assert(this->size() == total);
+    }
+
+    /** Empty hypersphere (see \ref concentric) */
+    hypersphere(const Alloc & alloc, size_t dimension):
+        super_t(dimension, alloc)
+    {}
+
+    /**
+     *  \brief  Number of images of a canonical point
+     *
+     *  Number of distinct coordinate permutations (the multinomial
+     *  coefficient) times number of sign combinations of non-zero
+     *  coordinates.
+     *
+     *  \param  c  Canonical point (sorted coordinates)
+     *
+     *  \return Number of distinct images of \c c
+     */
+    template <class Point_t>
+    static size_t image_cnt(const Point_t & c) {
+        size_t cnt = 1, run = 0;
+
+        for (size_t i = 0; i < c.size(); ++i) {
+            run = 0 < i && c[i] == c[i - 1] ? run + 1 : 1;
+            cnt = cnt * (i + 1) / run;
+
+            if (0 != c[i]) cnt <<= 1;
         }
+
+        return cnt;
+    }
+
+    /**
+     *  \brief  Generate images of a canonical point
+     *
+     *  Distinct permutations are generated in lexicographical order,
+     *  sign combinations of non-zero coordinates in Gray code order
+     *  (i.e. each image differs from the previous one in one sign).
+     *  Every image is generated exactly once.
+     *
+     *  \tparam Point_t  Canonical point type
+     *  \tparam Fn       Point sink type
+     *  \param  c        Canonical point (sorted coordinates)
+     *  \param  layer    Point layer
+     *  \param  scr      Scratch buffers
+     *  \param  fn       Point sink, called with point and layer
+     */
+    template <class Point_t, class Fn>
+    static void images(
+        const Point_t & c,
+        unsigned        layer,
+        scratch       & scr,
+        Fn            & fn)
+    {
+        point_t          & x  = scr.x;
+        point_t          & y  = scr.y;
+        vector_t<size_t> & nz = scr.nz;
+
+        std::copy(c.begin(), c.end(), x.begin());
+
+        do {
+            nz.clear();
+            for (size_t i = 0; i < x.size(); ++i)
+                if (0 != x[i]) nz.push_back(i);
+
+            y = x;
+            fn(y, layer);
+
+            for (size_t m = 1; m < ((size_t)1 << nz.size()); ++m) {
+                size_t b = 0;
+                while (!(m >> b & 1)) ++b;  // Gray code: flip lowest bit
+
+                y[nz[b]] = -y[nz[b]];
+                fn(y, layer);
+            }
+        } while (std::next_permutation(x.begin(), x.end()));
     }
 
     public:
 
+    /**
+     *  \brief  Generate hypersphere points on the fly
+     *
+     *  The points are produced by the midpoint circle recursion and
+     *  symmetry without materialising the whole set; only the canonical
+     *  1st hyperoctant points (roughly 1 / (2^N * N!) of the set) are kept.
+     *  The set of points (and layers) is the same as the one stored
+     *  by the constructor; each point is passed to \c fn exactly once,
+     *  but NOT in any particular order.
+     *
+     *  \tparam Fn         Point visitor type
+     *  \param  dimension  Space dimension (must be \c N if \c N is set)
+     *  \param  layers     Hypersphere layers' radii
+     *  \param  fn         Visitor, called with \c point_t and layer
+     *  \param  alloc      Allocator
+     */
+    template <class Fn>
+    static void generate(
+        size_t                      dimension,
+        const std::vector<Base_t> & layers,
+        Fn                          fn,
+        const Alloc               & alloc = Alloc())
+    {
+        assert(0 < dimension);
+
+        scratch scr(dimension, layers.size(), alloc);
+
+        typename super_t::set_t canon(dimension, alloc);
+        canonical(layers, scr, canon);
+
+        images(canon, 0, canon.size(), 0, scr, fn);
+    }
+
+    /**
+     *  \brief  Generate hypersphere points on the fly (compile-time dim.)
+     *
+     *  \tparam Fn      Point visitor type
+     *  \param  layers  Hypersphere layers' radii
+     *  \param  fn      Visitor, called with \c point_t and layer
+     */
+    template <class Fn>
+    static void generate(const std::vector<Base_t> & layers, Fn fn) {
+        generate(N, layers, fn);
+    }
+
+    /**
+     *  \brief  Hypersphere point count
+     *
+     *  Computes the number of points without generating them.
+     *
+     *  \param  dimension  Space dimension (must be \c N if \c N is set)
+     *  \param  layers     Hypersphere layers' radii
+     *  \param  alloc      Allocator
+     *
+     *  \return Number of points
+     */
+    static size_t count(
+        size_t                      dimension,
+        const std::vector<Base_t> & layers,
+        const Alloc               & alloc = Alloc())
+    {
+        scratch scr(dimension, layers.size(), alloc);
+
+        typename super_t::set_t canon(dimension, alloc);
+        canonical(layers, scr, canon);
+
+        size_t cnt = 0;
+        for (size_t i = 0; i < canon.size(); ++i)
+            cnt += image_cnt(canon.point(i));
+
+        return cnt;
+    }
+
+    /**
+     *  \brief  Build concentric spheres in one pass
+     *
+     *  Builds (full, 1-layer) spheres of all the radii by one slicing
+     *  recursion (and one canonical points set) instead of computing
+     *  them one by one.
+     *  Each sphere is the same as \c hypersphere(dimension, {radius}).
+     *
+     *  \tparam Fn         Sphere sink type
+     *  \param  dimension  Space dimension (must be \c N if \c N is set)
+     *  \param  radii      Spheres' radii (any order)
+     *  \param  fn         Sink, called with radius index and sphere
+     *                     (rvalue, may be moved from)
+     *  \param  alloc      Allocator
+     */
+    template <class Fn>
+    static void concentric(
+        size_t                      dimension,
+        const std::vector<Base_t> & radii,
+        Fn                          fn,
+        const Alloc               & alloc = Alloc())
+    {
+        assert(0 < dimension);
+        if (radii.empty()) return;
+
+        scratch scr(dimension, radii.size(), alloc);
+
+        shells_t canon(N ? N + 1 : dimension + 1, alloc);
+        canonical(dimension, radii, scr, canon);
+
+        const vector_t<size_t> begin = ranges(canon, radii.size());
+        for (size_t k = 0; k < radii.size(); ++k) {
+            hypersphere sphere(alloc, dimension);
+            sphere.build(canon, begin[k], begin[k + 1], 1, scr);
+
+            fn(k, std::move(sphere));
+        }
+    }
+
+    /**
+     *  \brief  Generate concentric spheres' points on the fly
+     *
+     *  Like \ref generate, for all the radii at once (see \ref concentric).
+     *  Points of each sphere are passed in a row (spheres in order
+     *  of the radii); each point exactly once per sphere, but NOT
+     *  in any particular order.
+     *
+     *  \tparam Fn         Point visitor type
+     *  \param  dimension  Space dimension (must be \c N if \c N is set)
+     *  \param  radii      Spheres' radii (any order)
+     *  \param  fn         Visitor, called with radius index and \c point_t
+     *  \param  alloc      Allocator
+     */
+    template <class Fn>
+    static void generate_concentric(
+        size_t                      dimension,
+        const std::vector<Base_t> & radii,
+        Fn                          fn,
+        const Alloc               & alloc = Alloc())
+    {
+        assert(0 < dimension);
+        if (radii.empty()) return;
+
+        scratch scr(dimension, radii.size(), alloc);
+
+        shells_t canon(N ? N + 1 : dimension + 1, alloc);
+        canonical(dimension, radii, scr, canon);
+
+        const vector_t<size_t> begin = ranges(canon, radii.size());
+        for (size_t k = 0; k < radii.size(); ++k) {
+            auto sink = [&fn, k](const point_t & x, unsigned) { fn(k, x); };
+            images(canon, begin[k], begin[k + 1], 1, scr, sink);
+        }
+    }
+
     /**
      *  \brief  Constructor
      *
-     *  \param  dimension  Space dimension
+     *  \param  dimension  Space dimension (must be \c N if \c N is set)
+     *  \param  layers     Hypersphere layers' radii
+     *  \param  alloc      Allocator
+     */
+    hypersphere(
+        size_t                      dimension,
+        const std::vector<Base_t> & layers,
+        const Alloc               & alloc = Alloc())
+    :
+        super_t(dimension, alloc)
+    {
+        assert(0 < dimension);
+
+        scratch scr(dimension, layers.size(), alloc);
+
+        typename super_t::set_t canon(dimension, alloc);
+        canonical(layers, scr, canon);
+
+        build(canon, 0, canon.size(), 0, scr);
+    }
+
+    /**
+     *  \brief  Constructor (parallel)
+     *
+     *  The 1st level slices are computed by a thread pool, images
+     *  of canonical points are stored and sorted by the threads, too.
+     *  The result is the same as that of the sequential constructor.
+     *  Note that the allocator must be thread-safe (\c std::allocator is,
+     *  \ref libaccl::arena::allocator is NOT).
+     *
+     *  \param  dimension  Space dimension (must be \c N if \c N is set)
      *  \param  layers     Hypersphere layers' radii
+     *  \param  threads    Thread count (0 means hardware concurrency)
+     *  \param  alloc      Allocator
      */
     hypersphere(
         size_t                      dimension,
-        const std::vector<Base_t> & layers)
+        const std::vector<Base_t> & layers,
+        unsigned                    threads,
+        const Alloc               & alloc = Alloc())
+    :
+        super_t(dimension, alloc)
     {
         assert(0 < dimension);
 
-        const std::vector<Base_t> zero(dimension, 0);
-        octant(zero, layers);
-        symmetry(dimension);
+        threads = parallel::thread_cnt(threads);
+
+        scratch scr(dimension, layers.size(), alloc);
+
+        typename super_t::set_t canon(dimension, alloc);
+        canonical(layers, threads, scr, canon);
+
+        build(canon, threads, scr);
     }
 
+    /**
+     *  \brief  Constructor (compile-time dimension)
+     *
+     *  \param  layers  Hypersphere layers' radii
+     *  \param  alloc   Allocator
+     */
+    explicit hypersphere(
+        const std::vector<Base_t> & layers,
+        const Alloc               & alloc = Alloc())
+    :
+        hypersphere(N, layers, alloc)
+    {}
+
 };  // end of template class hypersphere
 
 }}  // end of namespace libaccl::pattern
@@ -0,0 +1,217 @@
+#ifndef libaccl__pattern__kernel_hxx
+#define libaccl__pattern__kernel_hxx
+
+/**
+ *  \file
+ *  \brief  Voting kernel
+ *
+ *  Pattern of points compiled for accumulator voting: flat array
+ *  of point offsets and parallel array of vote weights.
+ *
+ *  \date   2016/01/04
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libaccl/pattern/points.hxx"
+#include "libaccl/pattern/packed.hxx"
+
+#include <vector>
+#include <stdexcept>
+#include <cstdlib>
+
+
+namespace libaccl {
+namespace pattern {
+
+/**
+ *  \brief  Unit vote weight
+ *
+ *  Every pattern point casts one vote, whatever its payload.
+ *  Note that payload (e.g. hypersphere layer index) isn't a usable
+ *  weight as is; the outermost layer is 0 and zero weight points
+ *  are left out of the kernel.
+ */
+template <typename Weight_t>
+class unit_weight {
+    public:
+
+    template <typename Payload_t>
+    inline Weight_t operator () (const Payload_t & ) const {
+        return static_cast<Weight_t>(1);
+    }
+
+};  // end of template class unit_weight
+
+
+/**
+ *  \brief  Voting kernel
+ *
+ *  The kernel holds pattern point offsets in one contiguous buffer
+ *  (stride = dimension) and their vote weights in a parallel array,
+ *  so that voting is a sequential walk.
+ *  Points with zero weight are left out; kernel with no points
+ *  is refused (it would cast no votes).
+ *
+ *  \tparam  Base_t    Base numeric type (integral)
+ *  \tparam  Weight_t  Vote weight type
+ *  \tparam  N         Space dimension (0 means runtime)
+ */
+template <typename Base_t, typename Weight_t, size_t N = 0>
+class kernel {
+    public:
+
+    typedef typename impl::point_type<Base_t, N>::type point_t;  /**< Point */
+
+    private:
+
+    size_t                m_dimension;  /**< Space dimension */
+    std::vector<Base_t>   m_offsets;    /**< Point offsets   */
+    std::vector<Weight_t> m_weights;    /**< Vote weights    */
+    point_t               m_lo;         /**< Bounding box lower corner */
+    point_t               m_hi;         /**< Bounding box upper corner */
+
+    /** Add point (unless its weight is 0) */
+    template <typename Coord_t>
+    void add(const Coord_t * x, Weight_t w) {
+        if (Weight_t() == w) return;
+
+        for (size_t d = 0; d < m_dimension; ++d) {
+            if (m_weights.empty() || x[d] < m_lo[d]) m_lo[d] = x[d];
+            if (m_weights.empty() || x[d] > m_hi[d]) m_hi[d] = x[d];
+        }
+
+        m_offsets.insert(m_offsets.end(), x, x + m_dimension);
+        m_weights.push_back(w);
+    }
+
+    /** Refuse empty kernel */
+    void check() const {
+        if (m_weights.empty())
+            throw std::logic_error(
+                "libaccl::pattern::kernel: "
+                "empty kernel (all points have zero weight)");
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \tparam Payload_t  Pattern payload type
+     *  \tparam Alloc      Pattern allocator
+     *  \tparam Weight_fn  Weight functor (payload to vote weight)
+     *  \param  pattern    Pattern
+     *  \param  weight     Weight functor (unit weight by default)
+     */
+    template <typename Payload_t, class Alloc,
+        class Weight_fn = unit_weight<Weight_t> >
+    kernel(
+        const points<Base_t, Payload_t, N, Alloc> & pattern,
+        Weight_fn                                   weight = Weight_fn())
+    :
+        m_dimension ( pattern.dimension() ),
+        m_lo        ( impl::point_type<Base_t, N>::zero(m_dimension) ),
+        m_hi        ( m_lo )
+    {
+        m_offsets.reserve(pattern.size() * m_dimension);
+        m_weights.reserve(pattern.size());
+
+        const typename points<Base_t, Payload_t, N, Alloc>::set_t & set =
+            pattern;
+        for (size_t i = 0; i < set.size(); ++i)
+            add(set.point(i).begin(), weight(set.payload(i)));
+
+        check();
+    }
+
+    /**
+     *  \brief  Constructor (from packed pattern)
+     *
+     *  \tparam Offset_t   Packed coordinate type
+     *  \tparam Layer_t    Packed payload type
+     *  \tparam Weight_fn  Weight functor (layer to vote weight)
+     *  \param  pattern    Packed pattern
+     *  \param  weight     Weight functor (unit weight by default)
+     */
+    template <typename Offset_t, typename Layer_t,
+        class Weight_fn = unit_weight<Weight_t> >
+    kernel(
+        const packed<Base_t, Offset_t, Layer_t, N> & pattern,
+        Weight_fn                                    weight = Weight_fn())
+    :
+        m_dimension ( pattern.dimension() ),
+        m_lo        ( impl::point_type<Base_t, N>::zero(m_dimension) ),
+        m_hi        ( m_lo )
+    {
+        m_offsets.reserve(pattern.size() * m_dimension);
+        m_weights.reserve(pattern.size());
+
+        for (size_t i = 0; i < pattern.size(); ++i)
+            add(pattern.offset(i), weight(pattern.layer(i)));
+
+        check();
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return N ? N : m_dimension; }
+
+    /** Number of kernel points */
+    size_t size() const { return m_weights.size(); }
+
+    /** Point offset */
+    const Base_t * offset(size_t i) const {
+        return m_offsets.data() + i * dimension();
+    }
+
+    /** Point offsets (row-major) */
+    const Base_t * offsets() const { return m_offsets.data(); }
+
+    /** Vote weight */
+    const Weight_t & weight(size_t i) const { return m_weights[i]; }
+
+    /** Vote weights */
+    const Weight_t * weights() const { return m_weights.data(); }
+
+    /** Bounding box lower corner */
+    const point_t & lo() const { return m_lo; }
+
+    /** Bounding box upper corner */
+    const point_t & hi() const { return m_hi; }
+
+};  // end of template class kernel
+
+}}  // end of namespace libaccl::pattern
+
+#endif  // end of #ifndef libaccl__pattern__kernel_hxx
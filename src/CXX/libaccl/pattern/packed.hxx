@@ -0,0 +1,190 @@
+#ifndef libaccl__pattern__packed_hxx
+#define libaccl__pattern__packed_hxx
+
+/**
+ *  \file
+ *  \brief  Packed pattern representation
+ *
+ *  Narrow (e.g. 8-bit) point offsets and layer indices, for patterns
+ *  of small radius; a quarter of the full-width storage for \c int offsets.
+ *
+ *  \date   2016/01/15
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "libaccl/pattern/points.hxx"
+#include "libaccl/pattern/hypersphere.hxx"
+
+#include <vector>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+namespace pattern {
+
+/**
+ *  \brief  Packed pattern
+ *
+ *  Pattern points (offsets relative to the pattern centre) are stored
+ *  as \c Offset_t coordinates (row-major) and their payloads as \c Layer_t
+ *  (e.g. \ref hypersphere layer index), in sorted order of the source
+ *  pattern.
+ *  Packing fails if a coordinate or payload doesn't fit.
+ *
+ *  The packed pattern may be used instead of the full one where points
+ *  are only read sequentially (e.g. \ref kernel construction)
+ *  or kept for long (e.g. \ref cache of packed hyperspheres).
+ *
+ *  \tparam  Base_t    Base numeric type (integral) of the unpacked points
+ *  \tparam  Offset_t  Packed coordinate type (integral)
+ *  \tparam  Layer_t   Packed payload type (integral)
+ *  \tparam  N         Space dimension (0 means runtime)
+ */
+template <
+    typename Base_t,
+    typename Offset_t = int8_t,
+    typename Layer_t  = uint8_t,
+    size_t   N        = 0>
+class packed {
+    public:
+
+    typedef typename impl::point_type<Base_t, N>::type point_t;  /**< Point */
+
+    private:
+
+    size_t                m_dimension;  /**< Space dimension      */
+    std::vector<Offset_t> m_offsets;    /**< Offsets (row-major)  */
+    std::vector<Layer_t>  m_layers;     /**< Layers (payloads)    */
+
+    /** Value fits to packed type (survives round trip, keeps sign) */
+    template <typename T, typename U>
+    static bool fits(U value) {
+        return (U)(T)value == value && (value < U()) == ((T)value < T());
+    }
+
+    /** Pack pattern */
+    template <typename Payload_t, class Alloc>
+    void pack(const points<Base_t, Payload_t, N, Alloc> & pattern) {
+        const typename points<Base_t, Payload_t, N, Alloc>::set_t & set =
+            pattern;
+
+        m_offsets.reserve(set.size() * m_dimension);
+        m_layers.reserve(set.size());
+
+        for (size_t i = 0; i < set.size(); ++i) {
+            const auto x = set.point(i);
+            for (size_t d = 0; d < m_dimension; ++d) {
+                if (!fits<Offset_t>(x.begin()[d]))
+                    throw std::logic_error(
+                        "libaccl::pattern::packed: "
+                        "offset out of range");
+
+                m_offsets.push_back((Offset_t)x.begin()[d]);
+            }
+
+            if (!fits<Layer_t>(set.payload(i)))
+                throw std::logic_error(
+                    "libaccl::pattern::packed: "
+                    "payload out of range");
+
+            m_layers.push_back((Layer_t)set.payload(i));
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor (packs pattern)
+     *
+     *  \param  pattern  Pattern
+     */
+    template <typename Payload_t, class Alloc>
+    explicit packed(const points<Base_t, Payload_t, N, Alloc> & pattern):
+        m_dimension(pattern.dimension())
+    {
+        pack(pattern);
+    }
+
+    /**
+     *  \brief  Constructor (packed hypersphere)
+     *
+     *  See \ref hypersphere constructor.
+     *
+     *  \param  dimension  Space dimension
+     *  \param  layers     Hypersphere layers' radii
+     */
+    packed(size_t dimension, const std::vector<Base_t> & layers):
+        m_dimension(dimension)
+    {
+        pack(hypersphere<Base_t, N>(dimension, layers));
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return N ? N : m_dimension; }
+
+    /** Number of points */
+    size_t size() const { return m_layers.size(); }
+
+    /** Memory used by the pattern (bytes) */
+    size_t memory() const {
+        return m_offsets.capacity() * sizeof(Offset_t)
+             + m_layers.capacity()  * sizeof(Layer_t);
+    }
+
+    /** Point offset (packed coordinates) */
+    const Offset_t * offset(size_t i) const {
+        return m_offsets.data() + i * dimension();
+    }
+
+    /** Point layer (payload) */
+    Layer_t layer(size_t i) const { return m_layers[i]; }
+
+    /** Point (unpacked coordinates) */
+    point_t point(size_t i) const {
+        point_t x = impl::point_type<Base_t, N>::zero(dimension());
+        const Offset_t * offset = this->offset(i);
+        for (size_t d = 0; d < dimension(); ++d) x[d] = offset[d];
+
+        return x;
+    }
+
+};  // end of template class packed
+
+}}  // end of namespace libaccl::pattern
+
+#endif  // end of #ifndef libaccl__pattern__packed_hxx
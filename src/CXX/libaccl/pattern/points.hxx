@@ -44,7 +44,12 @@
  */
 
 #include <vector>
-#include <map>
+#include <array>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <numeric>
+#include <memory>
 #include <stdexcept>
 #include <cstdlib>
 
@@ -52,20 +57,517 @@
 namespace libaccl {
 namespace pattern {
 
+namespace impl {
+
+/**
+ *  \brief  Point coordinates type
+ *
+ *  Dynamically sized vector for runtime dimension (\c N == 0),
+ *  fixed-size array otherwise.
+ *
+ *  \tparam  Base_t  Base numeric type
+ *  \tparam  N       Space dimension (0 means runtime)
+ */
+template <typename Base_t, size_t N>
+struct point_type {
+    typedef std::array<Base_t, N> type;  /**< Point type */
+
+    /** Zero point (\c dimension must be \c N) */
+    static type zero(size_t dimension) {
+        if (N != dimension)
+            throw std::logic_error(
+                "libaccl::pattern::point_type::zero: "
+                "dimension mismatch");
+
+        type point; point.fill(0);
+        return point;
+    }
+
+    /** Point from coordinates */
+    static type make(const Base_t * begin, size_t) {
+        type point; std::copy(begin, begin + N, point.begin());
+        return point;
+    }
+
+};  // end of template struct point_type
+
+/** Point coordinates type (runtime dimension) */
+template <typename Base_t>
+struct point_type<Base_t, 0> {
+    typedef std::vector<Base_t> type;  /**< Point type */
+
+    /** Zero point */
+    static type zero(size_t dimension) { return type(dimension, 0); }
+
+    /** Point from coordinates */
+    static type make(const Base_t * begin, size_t size) {
+        return type(begin, begin + size);
+    }
+
+};  // end of template struct point_type
+
+
+/**
+ *  \brief  Flat set of points
+ *
+ *  Structure-of-arrays point storage.
+ *  Point coordinates are kept in one contiguous buffer (with stride equal
+ *  to the space dimension), point payloads are kept in a parallel array.
+ *
+ *  Points are appended in bulk by \ref insert and then sorted (in
+ *  lexicographical order of coordinates) and made unique by \ref commit.
+ *  Lookup is a binary search over the sorted set.
+ *  Note that if a point is inserted more than once, payload of the first
+ *  insertion is kept.
+ *
+ *  If the space dimension \c N is known at compile time, the stride
+ *  is a constant and points are \c std::array -s.
+ *
+ *  All the storage (including temporary buffers of \ref commit) is
+ *  obtained from the \c Alloc allocator (rebound as necessary).
+ *
+ *  \tparam  Base_t     Base numeric type (integral)
+ *  \tparam  Payload_t  Point payload type
+ *  \tparam  N          Space dimension (0 means runtime)
+ *  \tparam  Alloc      Allocator (of \c Base_t)
+ */
+template <
+    typename Base_t,
+    typename Payload_t,
+    size_t   N     = 0,
+    class    Alloc = std::allocator<Base_t> >
+class flat_set {
+    public:
+
+    typedef typename point_type<Base_t, N>::type point_t;  /**< Point     */
+    typedef Alloc                                alloc_t;  /**< Allocator */
+
+    /** Point coordinates (view of the coordinates buffer) */
+    class coords {
+        private:
+
+        const Base_t * m_begin;  /**< 1st coordinate */
+        size_t         m_size;   /**< Dimension      */
+
+        public:
+
+        /** Constructor */
+        coords(const Base_t * begin, size_t size):
+            m_begin(begin), m_size(size)
+        {}
+
+        /** Dimension */
+        size_t size() const { return m_size; }
+
+        /** Begin iterator */
+        const Base_t * begin() const { return m_begin; }
+
+        /** End iterator */
+        const Base_t * end() const { return m_begin + m_size; }
+
+        /** Coordinate getter */
+        const Base_t & operator [] (size_t i) const { return m_begin[i]; }
+
+        /** Conversion to point */
+        operator point_t () const {
+            return point_type<Base_t, N>::make(m_begin, m_size);
+        }
+
+    };  // end of class coords
+
+    typedef std::pair<coords, const Payload_t &> value_type;  /**< Point */
+
+    /** Const iterator */
+    class const_iterator {
+        friend class flat_set;
+
+        public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef flat_set::value_type      value_type;
+        typedef ptrdiff_t                 difference_type;
+        typedef const value_type *        pointer;
+        typedef value_type                reference;
+
+        private:
+
+        const flat_set * m_set;  /**< Set         */
+        size_t           m_ix;   /**< Point index */
+
+        /** Constructor */
+        const_iterator(const flat_set * set, size_t ix):
+            m_set(set), m_ix(ix)
+        {}
+
+        /** Member access proxy */
+        class arrow {
+            private:
+
+            const value_type m_value;  /**< Point */
+
+            public:
+
+            arrow(const value_type & value): m_value(value) {}
+
+            const value_type * operator -> () const { return &m_value; }
+
+        };  // end of class arrow
+
+        public:
+
+        /** Default constructor */
+        const_iterator(): m_set(NULL), m_ix(0) {}
+
+        /** Point index */
+        size_t index() const { return m_ix; }
+
+        /** Dereference */
+        value_type operator * () const { return m_set->at(m_ix); }
+
+        /** Member access */
+        arrow operator -> () const { return arrow(**this); }
+
+        /** Pre-increment */
+        const_iterator & operator ++ () { ++m_ix; return *this; }
+
+        /** Post-increment */
+        const_iterator operator ++ (int) {
+            const_iterator copy(*this); ++m_ix; return copy;
+        }
+
+        /** Comparison */
+        bool operator == (const const_iterator & rarg) const {
+            return m_ix == rarg.m_ix && m_set == rarg.m_set;
+        }
+
+        /** Comparison */
+        bool operator != (const const_iterator & rarg) const {
+            return !(*this == rarg);
+        }
+
+    };  // end of class const_iterator
+
+    private:
+
+    /** Vector using (rebound) allocator */
+    template <typename T>
+    using vector_t = std::vector<T,
+        typename std::allocator_traits<Alloc>::template rebind_alloc<T> >;
+
+    size_t              m_dimension;  /**< Space dimension         */
+    vector_t<Base_t>    m_coords;     /**< Coordinates (row-major) */
+    vector_t<Payload_t> m_payload;    /**< Payloads                */
+
+    /** Stride (constant if dimension is known at compile time) */
+    size_t stride() const { return N ? N : m_dimension; }
+
+    /** Point coordinates pointer */
+    const Base_t * row(size_t i) const {
+        return m_coords.data() + i * stride();
+    }
+
+    /** Lexicographical comparison of point coordinates */
+    bool less(const Base_t * larg, const Base_t * rarg) const {
+        return std::lexicographical_compare(
+            larg, larg + stride(),
+            rarg, rarg + stride());
+    }
+
+    /**
+     *  \brief  Stable sort of point indices
+     *
+     *  If coordinate ranges are small enough (typical for patterns),
+     *  LSD radix sort (one counting sort pass per dimension) is used.
+     *  Comparison-based stable sort is used otherwise.
+     *
+     *  \param  perm  Sorted point indices (\ref size long)
+     */
+    void sort_index(vector_t<size_t> & perm) const {
+        const size_t n = perm.size();
+
+        std::iota(perm.begin(), perm.end(), 0);
+        if (!n) return;
+
+        // Coordinate ranges
+        vector_t<Base_t> lo(row(0), row(0) + stride(), alloc());
+        vector_t<Base_t> hi(lo);
+        for (size_t i = 1; i < n; ++i) {
+            const Base_t * point = row(i);
+
+            for (size_t d = 0; d < stride(); ++d) {
+                if (point[d] < lo[d]) lo[d] = point[d];
+                if (point[d] > hi[d]) hi[d] = point[d];
+            }
+        }
+
+        size_t range = 0;
+        for (size_t d = 0; d < stride(); ++d)
+            range = std::max(range, (size_t)hi[d] - (size_t)lo[d] + 1);
+
+        if (range > 2 * n + 1024) {
+            std::stable_sort(perm.begin(), perm.end(),
+            [this](size_t larg, size_t rarg) {
+                return less(row(larg), row(rarg));
+            });
+
+            return;
+        }
+
+        // LSD radix sort
+        vector_t<size_t> tmp(n, 0, alloc());
+        vector_t<size_t> cnt(range + 1, 0, alloc());
+        for (size_t d = stride(); d-- > 0; ) {
+            std::fill(cnt.begin(), cnt.end(), 0);
+
+            for (size_t i = 0; i < n; ++i)
+                ++cnt[(size_t)row(i)[d] - (size_t)lo[d] + 1];
+
+            for (size_t c = 1; c < cnt.size(); ++c)
+                cnt[c] += cnt[c - 1];
+
+            for (size_t i = 0; i < n; ++i)
+                tmp[cnt[(size_t)row(perm[i])[d] - (size_t)lo[d]]++] = perm[i];
+
+            perm.swap(tmp);
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  dimension  Space dimension (taken from the 1st point if 0)
+     *  \param  alloc      Allocator
+     */
+    flat_set(size_t dimension = N, const Alloc & alloc = Alloc()):
+        m_dimension ( dimension ),
+        m_coords    ( alloc     ),
+        m_payload   ( alloc     )
+    {
+        if (N && N != dimension)
+            throw std::logic_error(
+                "libaccl::pattern::flat_set: "
+                "dimension mismatch");
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return stride(); }
+
+    /** Allocator */
+    Alloc alloc() const { return m_coords.get_allocator(); }
+
+    /** Set size */
+    size_t size() const { return m_payload.size(); }
+
+    /** Memory used by the set (bytes) */
+    size_t memory() const {
+        return sizeof(*this)
+            + m_coords.capacity()  * sizeof(Base_t)
+            + m_payload.capacity() * sizeof(Payload_t);
+    }
+
+    /** Reserve space for \c n points */
+    void reserve(size_t n) {
+        m_coords.reserve(n * stride());
+        m_payload.reserve(n);
+    }
+
+    /**
+     *  \brief  Append point
+     *
+     *  Note that the set must be committed after appending points
+     *  and before lookup.
+     *
+     *  \param  point    Point coordinates (\ref dimension long)
+     *  \param  payload  Point payload
+     */
+    void insert(const Base_t * point, const Payload_t & payload) {
+        m_coords.insert(m_coords.end(), point, point + stride());
+        m_payload.push_back(payload);
+    }
+
+    /**
+     *  \brief  Append point
+     *
+     *  \param  point    Point coordinates
+     *  \param  payload  Point payload
+     */
+    void insert(const point_t & point, const Payload_t & payload) {
+        if (!m_dimension) m_dimension = point.size();
+
+        if (point.size() != stride())
+            throw std::logic_error(
+                "libaccl::pattern::flat_set::insert: "
+                "point dimension mismatch");
+
+        insert(point.data(), payload);
+    }
+
+    /**
+     *  \brief  Commit appended points
+     *
+     *  Sorts the points and removes duplicities (1st inserted point wins).
+     */
+    void commit() {
+        const size_t n = size();
+
+        vector_t<size_t> perm(n, 0, alloc());
+        sort_index(perm);
+
+        vector_t<Base_t>    coords(alloc());  coords.reserve(m_coords.size());
+        vector_t<Payload_t> payload(alloc()); payload.reserve(n);
+
+        for (size_t i = 0; i < n; ++i) {
+            const Base_t * point = row(perm[i]);
+
+            // Duplicity (sorted right behind the 1st one)
+            if (!payload.empty() && std::equal(
+                point, point + stride(),
+                coords.end() - stride()))
+            {
+                continue;
+            }
+
+            coords.insert(coords.end(), point, point + stride());
+            payload.push_back(m_payload[perm[i]]);
+        }
+
+        m_coords.swap(coords);
+        m_payload.swap(payload);
+    }
+
+    /**
+     *  \brief  Merge committed sets
+     *
+     *  The set content is replaced by union of the (committed) sets;
+     *  the result is committed.
+     *  If a point is in more sets, payload from the 1st one is kept.
+     *
+     *  \param  sets  Sets
+     *  \param  cnt   Number of sets
+     */
+    void merge(const flat_set * sets, size_t cnt) {
+        size_t n = 0;
+        for (size_t s = 0; s < cnt; ++s) {
+            if (!m_dimension) m_dimension = sets[s].m_dimension;
+            n += sets[s].size();
+        }
+
+        vector_t<Base_t>    coords(alloc());  coords.reserve(n * stride());
+        vector_t<Payload_t> payload(alloc()); payload.reserve(n);
+        vector_t<size_t>    head(cnt, 0, alloc());
+
+        for (;;) {
+            size_t min = cnt;  // set with the least head point
+            for (size_t s = 0; s < cnt; ++s) {
+                if (!(head[s] < sets[s].size())) continue;
+
+                if (cnt == min || less(
+                    sets[s].row(head[s]), sets[min].row(head[min])))
+                {
+                    min = s;
+                }
+            }
+
+            if (cnt == min) break;  // all sets done
+
+            const Base_t * point = sets[min].row(head[min]);
+
+            // Duplicity (follows right after the 1st one)
+            if (payload.empty() || !std::equal(
+                point, point + stride(),
+                coords.end() - stride()))
+            {
+                coords.insert(coords.end(), point, point + stride());
+                payload.push_back(sets[min].m_payload[head[min]]);
+            }
+
+            ++head[min];
+        }
+
+        m_coords.swap(coords);
+        m_payload.swap(payload);
+    }
+
+    /** Point getter */
+    value_type at(size_t i) const {
+        return value_type(coords(row(i), stride()), m_payload[i]);
+    }
+
+    /** Point coordinates getter */
+    coords point(size_t i) const { return coords(row(i), stride()); }
+
+    /** Point payload getter */
+    const Payload_t & payload(size_t i) const { return m_payload[i]; }
+
+    /** Coordinates of all points (row-major, \ref dimension stride) */
+    const Base_t * coords_data() const { return m_coords.data(); }
+
+    /** Payloads of all points */
+    const Payload_t * payload_data() const { return m_payload.data(); }
+
+    /** Begin const iterator */
+    const_iterator begin() const { return const_iterator(this, 0); }
+
+    /** End const iterator */
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    /**
+     *  \brief  Find point (committed set only)
+     *
+     *  \param  point  Point coordinates
+     *
+     *  \return Point iterator or \ref end if no such point is in the set
+     */
+    const_iterator find(const point_t & point) const {
+        if (point.size() != stride()) return end();
+
+        // Binary search
+        size_t lo = 0, hi = size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (less(row(mid), point.data())) lo = mid + 1;
+            else hi = mid;
+        }
+
+        if (lo < size() && !less(point.data(), row(lo)))
+            return const_iterator(this, lo);
+
+        return end();
+    }
+
+};  // end of template class flat_set
+
+}  // end of namespace impl
+
+
 /**
  *  \brief  Pattern of points
  *
  *  Set of points.
+ *  The points are kept in flat, contiguous storage (see \ref impl::flat_set).
+ *  Point coordinates are \c std::vector -s for runtime space dimension
+ *  (\c N == 0) or \c std::array -s if \c N is specified.
+ *  The set storage is obtained from the \c Alloc allocator
+ *  (e.g. \ref libaccl::arena::allocator).
  *
  *  \tparam  Base_t     Base numeric type (integral)
  *  \tparam  Payload_t  Point payload type
+ *  \tparam  N          Space dimension (0 means runtime, the default)
+ *  \tparam  Alloc      Allocator (of \c Base_t)
  */
-template <typename Base_t, typename Payload_t>
+template <
+    typename Base_t,
+    typename Payload_t,
+    size_t   N     = 0,
+    class    Alloc = std::allocator<Base_t> >
 class points {
     public:
 
-    typedef std::vector<Base_t>          point_t;  /**< Point coordinates   */
-    typedef std::map<point_t, Payload_t> set_t;    /**< Implementation type */
+    typedef impl::flat_set<Base_t, Payload_t, N, Alloc> set_t;    /**< Implementation type */
+    typedef typename set_t::point_t                     point_t;  /**< Point coordinates   */
 
     private:
 
@@ -76,6 +578,9 @@ class points {
     /**
      *  \brief  Add point to set
      *
+     *  Note that the set must be committed after points are added
+     *  (see \ref commit).
+     *
      *  \param  point    Point coordinates (N-dimensional vector)
      *  \param  payload  Point payload
      */
@@ -83,14 +588,39 @@ class points {
         const point_t   & point,
         const Payload_t & payload = Payload_t())
     {
-        m_impl.emplace(point, payload);
+        m_impl.insert(point, payload);
     }
 
+    /** Reserve space for \c n points */
+    void reserve(size_t n) { m_impl.reserve(n); }
+
+    /** Commit added points (sort, remove duplicities) */
+    void commit() { m_impl.commit(); }
+
+    /** Set points to union of committed sets (see \ref impl::flat_set::merge) */
+    void merge(const set_t * sets, size_t cnt) { m_impl.merge(sets, cnt); }
+
     public:
 
+    /**
+     *  \brief  Constructor
+     *
+     *  \param  dimension  Space dimension (taken from the 1st point if 0)
+     *  \param  alloc      Allocator
+     */
+    points(size_t dimension = N, const Alloc & alloc = Alloc()):
+        m_impl(dimension, alloc)
+    {}
+
+    /** Space dimension */
+    size_t dimension() const { return m_impl.dimension(); }
+
     /** Set size */
     size_t size() const { return m_impl.size(); }
 
+    /** Memory used by the set (bytes) */
+    size_t memory() const { return m_impl.memory(); }
+
     /** Pattern access */
     operator const set_t & () const { return m_impl; }
 
@@ -123,7 +653,7 @@ class points {
                 "libaccl::points::get_payload: "
                 "no such point");
 
-        return x->second;
+        return m_impl.payload(x.index());
     }
 
 };  // end of template class points
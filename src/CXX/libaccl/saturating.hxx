@@ -0,0 +1,124 @@
+#ifndef libaccl__saturating_hxx
+#define libaccl__saturating_hxx
+
+/**
+ *  \file
+ *  \brief  Saturating counter
+ *
+ *  \date   2016/01/15
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <limits>
+#include <type_traits>
+#include <cstdlib>
+#include <cstdint>
+
+
+namespace libaccl {
+
+/**
+ *  \brief  Saturating counter
+ *
+ *  Unsigned integer which sticks at its maximum instead of wrapping
+ *  around on addition (and at 0 on subtraction).
+ *  Use it as accumulator vote count type to get narrow (8 or 16 bit)
+ *  cells: a saturated cell is still a (flat) peak.
+ *  Note that retraction of votes from a saturated cell is not exact.
+ *
+ *  The counter converts to and from \c T implicitly, so comparisons
+ *  and arithmetic other than \c += and \c -= are those of \c T.
+ *  The layout is that of \c T (vectorised backends rely on it).
+ *  Atomic operations (\ref backend::sparse_concurrent) are not supported.
+ *
+ *  \tparam  T  Unsigned integral type
+ */
+template <typename T>
+class saturating {
+    static_assert(std::is_unsigned<T>::value,
+        "libaccl::saturating: unsigned type required");
+
+    public:
+
+    typedef T value_type;  /**< Underlying type */
+
+    private:
+
+    T m_value;  /**< Value */
+
+    /** Maximal value */
+    static constexpr T max() { return std::numeric_limits<T>::max(); }
+
+    /** Clamp value */
+    template <typename U>
+    static T clamp(U value) {
+        if (value < U()) return T();
+        return (uintmax_t)value > (uintmax_t)max() ? max() : (T)value;
+    }
+
+    public:
+
+    /** Default constructor (zero) */
+    saturating(): m_value(0) {}
+
+    /** Constructor (value is clamped) */
+    template <typename U>
+    saturating(U value): m_value(clamp(value)) {}
+
+    /** Value */
+    operator T () const { return m_value; }
+
+    /** Saturating addition */
+    saturating & operator += (saturating rarg) {
+        const T sum = m_value + rarg.m_value;
+        m_value = sum < m_value ? max() : sum;
+        return *this;
+    }
+
+    /** Saturating subtraction */
+    saturating & operator -= (saturating rarg) {
+        m_value = rarg.m_value < m_value ? m_value - rarg.m_value : T();
+        return *this;
+    }
+
+    /** Counter is saturated */
+    bool saturated() const { return max() == m_value; }
+
+};  // end of template class saturating
+
+}  // end of namespace libaccl
+
+#endif  // end of #ifndef libaccl__saturating_hxx
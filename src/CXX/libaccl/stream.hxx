@@ -0,0 +1,337 @@
+#ifndef libaccl__stream_hxx
+#define libaccl__stream_hxx
+
+/**
+ *  \file
+ *  \brief  Sliding window accumulator (online clustering)
+ *
+ *  \date   2016/01/14
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "libaccl/accumulator.hxx"
+#include "libaccl/pattern/points.hxx"
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+
+
+namespace libaccl {
+
+/**
+ *  \brief  Sliding window accumulator
+ *
+ *  Samples arrive as a stream of timestamped points; the accumulator
+ *  holds votes of samples of the last \c window time units only.
+ *  Samples leaving the window have their votes retracted
+ *  (see \ref accumulator::retract; sparse backend cells without votes
+ *  are erased).
+ *
+ *  Peaks are maintained incrementally: the set of cells with at least
+ *  \c threshold votes ("hot" cells, ordered) and their peak flags;
+ *  peak cells are also kept in a set of their own, so that collecting
+ *  peaks costs O(peaks), not O(hot cells).
+ *  A vote or retraction only changes the sample kernel image cells,
+ *  so only hot cells in the image bounding box (widened by one
+ *  for neighbours) are re-checked.
+ *  The box is walked in the hot cells order; hot cells out of it
+ *  are skipped by seeking to the next in-box coordinates prefix.
+ *  Per-sample cost is bounded by the kernel size plus the number
+ *  of hot cells in the box (times 3^N neighbour lookups) plus
+ *  a seek per box row (all but the last coordinate).
+ *
+ *  \tparam  Base_t   Base numeric type (integral)
+ *  \tparam  Count_t  Vote count type
+ *  \tparam  N        Space dimension (0 means runtime)
+ *  \tparam  Time_t   Timestamp type
+ *  \tparam  Backend  Cells storage (must support retraction)
+ */
+template <
+    typename Base_t,
+    typename Count_t = unsigned,
+    size_t   N       = 0,
+    typename Time_t  = double,
+    class    Backend = backend::sparse<Base_t, Count_t, N> >
+class stream {
+    public:
+
+    /** Accumulator */
+    typedef libaccl::accumulator<Base_t, Count_t, N, Backend> accumulator_t;
+
+    typedef typename accumulator_t::kernel_t kernel_t;  /**< Kernel    */
+    typedef typename accumulator_t::point_t  point_t;   /**< Point     */
+    typedef typename accumulator_t::peak     peak;      /**< Peak      */
+    typedef typename accumulator_t::peaks_t  peaks_t;   /**< Peak list */
+
+    private:
+
+    typedef std::pair<Time_t, point_t> sample_t;     /**< Timestamped sample    */
+    typedef std::map<point_t, bool>    hot_t;        /**< Hot cells (peak flag) */
+    typedef std::set<point_t>          peak_cells_t; /**< Peak cells            */
+
+    const Time_t                m_window;      /**< Window length       */
+    const Count_t               m_threshold;   /**< Peak threshold      */
+    accumulator_t               m_acc;         /**< Accumulator         */
+    std::deque<sample_t>        m_samples;     /**< Samples in window   */
+    hot_t                       m_hot;         /**< Hot cells           */
+    peak_cells_t                m_peaks;       /**< Peak cells          */
+    const std::vector<Base_t> & m_neighbours;  /**< Neighbourhood       */
+    point_t                     m_cell;        /**< Scratch cell        */
+    point_t                     m_lo;          /**< Scratch box corner  */
+    point_t                     m_hi;          /**< Scratch box corner  */
+
+    /** Hot cell is a peak */
+    bool is_peak(const point_t & point) {
+        const size_t  dim   = m_acc.dimension();
+        const size_t  half  = m_neighbours.size() / dim / 2;
+        const Count_t count = m_acc.count(point);
+
+        for (size_t i = 0, k = 0; i < m_neighbours.size(); i += dim, ++k) {
+            for (size_t d = 0; d < dim; ++d)
+                m_cell[d] = point[d] + m_neighbours[i + d];
+
+            const Count_t n_count = m_acc.count(m_cell);
+            if (n_count > count || (n_count == count && k < half))
+                return false;
+        }
+
+        return true;
+    }
+
+    /** Set hot cell peak flag (and update peak cells) */
+    void set_peak(typename hot_t::iterator cell, bool peak) {
+        if (cell->second != peak) {
+            cell->second = peak;
+            if (peak) m_peaks.insert(cell->first);
+            else      m_peaks.erase(cell->first);
+        }
+    }
+
+    /**
+     *  \brief  Update hot cells and peaks after sample (un)voting
+     *
+     *  \param  sample  Sample
+     */
+    void update(const point_t & sample) {
+        const kernel_t & kernel = m_acc.kernel();
+        const size_t     dim    = m_acc.dimension();
+
+        // Hot cells of the kernel image
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            const Base_t * offset = kernel.offset(i);
+            for (size_t d = 0; d < dim; ++d)
+                m_cell[d] = sample[d] + offset[d];
+
+            if (m_acc.count(m_cell) < m_threshold) {
+                auto hot = m_hot.find(m_cell);
+                if (m_hot.end() != hot) {
+                    set_peak(hot, false);
+                    m_hot.erase(hot);
+                }
+            }
+            else
+                m_hot.insert(typename hot_t::value_type(m_cell, false));
+        }
+
+        // Re-check hot cells in the image box (and neighbours)
+        for (size_t d = 0; d < dim; ++d) {
+            m_lo[d] = sample[d] + kernel.lo()[d] - 1;
+            m_hi[d] = sample[d] + kernel.hi()[d] + 1;
+        }
+
+        auto hot = m_hot.lower_bound(m_lo);
+        while (hot != m_hot.end()) {
+            const point_t & cell = hot->first;
+
+            // 1st coordinate out of the box
+            size_t d = 0;
+            while (d < dim && !(cell[d] < m_lo[d] || m_hi[d] < cell[d])) ++d;
+
+            if (dim == d) {
+                set_peak(hot, is_peak(cell));
+                ++hot;
+                continue;
+            }
+
+            // Seek the next cell with the in-box prefix
+            m_cell = cell;
+            if (cell[d] < m_lo[d]) {
+                for (size_t e = d; e < dim; ++e) m_cell[e] = m_lo[e];
+            }
+            else {  // past the box, next prefix
+                while (d && !(m_cell[d - 1] < m_hi[d - 1])) --d;
+                if (!d) break;  // all done
+
+                ++m_cell[d - 1];
+                for (size_t e = d; e < dim; ++e) m_cell[e] = m_lo[e];
+            }
+
+            hot = m_hot.lower_bound(m_cell);
+        }
+    }
+
+    public:
+
+    /**
+     *  \brief  Constructor
+     *
+     *  \tparam Backend_args  Backend constructor argument types
+     *  \param  kernel        Voting kernel
+     *  \param  window        Window length
+     *  \param  threshold     Minimal vote count of a peak (positive)
+     *  \param  backend_args  Backend constructor arguments (after dimension)
+     */
+    template <typename... Backend_args>
+    stream(
+        const kernel_t &  kernel,
+        Time_t            window,
+        Count_t           threshold,
+        Backend_args...   backend_args)
+    :
+        m_window     ( window                  ),
+        m_threshold  ( threshold               ),
+        m_acc        ( kernel, backend_args... ),
+        m_neighbours ( impl::neighbourhood<Base_t>(kernel.dimension()) ),
+        m_cell       ( pattern::impl::point_type<Base_t, N>::zero(
+                           kernel.dimension()) ),
+        m_lo         ( m_cell                  ),
+        m_hi         ( m_cell                  )
+    {
+        if (Count_t() == threshold)
+            throw std::logic_error(
+                "libaccl::stream: "
+                "threshold must be positive");
+    }
+
+    /** Space dimension */
+    size_t dimension() const { return m_acc.dimension(); }
+
+    /** Window length */
+    Time_t window() const { return m_window; }
+
+    /** Peak threshold */
+    Count_t threshold() const { return m_threshold; }
+
+    /** Accumulator (votes of the samples in window) */
+    const accumulator_t & accumulator() const { return m_acc; }
+
+    /** Number of samples in window */
+    size_t samples() const { return m_samples.size(); }
+
+    /** Number of cells with at least \ref threshold votes */
+    size_t hot() const { return m_hot.size(); }
+
+    /** Number of peaks */
+    size_t peak_cnt() const { return m_peaks.size(); }
+
+    /**
+     *  \brief  Retract samples which left the window
+     *
+     *  Samples with timestamp \c time - \ref window or older are retracted.
+     *
+     *  \param  time  Current time
+     */
+    void expire(Time_t time) {
+        // Note that time - window could underflow (unsigned Time_t)
+        while (!m_samples.empty() &&
+            m_samples.front().first + m_window <= time)
+        {
+            const point_t & sample = m_samples.front().second;
+            m_acc.retract(sample);
+            update(sample);
+            m_samples.pop_front();
+        }
+    }
+
+    /**
+     *  \brief  Push sample
+     *
+     *  Expired samples are retracted first (see \ref expire).
+     *
+     *  \param  time    Sample timestamp (non-decreasing)
+     *  \param  sample  Sample coordinates
+     */
+    void push(Time_t time, const point_t & sample) {
+        if (!m_samples.empty() && time < m_samples.back().first)
+            throw std::logic_error(
+                "libaccl::stream::push: "
+                "timestamp out of order");
+
+        expire(time);
+
+        m_acc.vote(sample);
+        m_samples.emplace_back(time, sample);
+        update(sample);
+    }
+
+    /**
+     *  \brief  Current peaks
+     *
+     *  See \ref accumulator::peaks; the peaks are not searched for,
+     *  just collected from the peak cells.
+     *
+     *  \param  top  Max. number of peaks (0 means all)
+     *
+     *  \return Peaks, ordered by vote count (descending)
+     */
+    peaks_t peaks(size_t top = 0) const {
+        peaks_t peaks;
+        peaks.reserve(m_peaks.size());
+
+        for (auto cell = m_peaks.begin(); cell != m_peaks.end(); ++cell)
+            peaks.emplace_back(*cell, m_acc.count(*cell));
+
+        if (top && top < peaks.size()) {
+            std::nth_element(peaks.begin(), peaks.begin() + top, peaks.end());
+            peaks.erase(peaks.begin() + top, peaks.end());
+        }
+
+        std::sort(peaks.begin(), peaks.end());
+
+        return peaks;
+    }
+
+};  // end of template class stream
+
+}  // end of namespace libaccl
+
+#endif  // end of #ifndef libaccl__stream_hxx
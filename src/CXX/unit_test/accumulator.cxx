@@ -0,0 +1,709 @@
+/**
+ *  \file
+ *  \brief  Accumulator unit test
+ *
+ *  \date   2016/01/04
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#include <libaccl/accumulator.hxx>
+#include <libaccl/backend/dense.hxx>
+#include <libaccl/backend/sparse_concurrent.hxx>
+#include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/pattern/kernel.hxx>
+#include <libaccl/saturating.hxx>
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+
+/** Point assignment */
+static void assign(std::vector<int> & point, const std::vector<int> & x) {
+    point = x;
+}
+
+/** Point assignment */
+template <size_t N>
+static void assign(std::array<int, N> & point, const std::vector<int> & x) {
+    std::copy(x.begin(), x.end(), point.begin());
+}
+
+
+/**
+ *  \brief  Accumulator test
+ *
+ *  Samples are placed on circles around cluster centres; voting with
+ *  circle kernel of the same radius must produce peaks in the centres.
+ *
+ *  \tparam Accumulator  Accumulator type
+ *  \param  acc          Accumulator
+ *  \param  circle       Circle pattern
+ *  \param  centres      Cluster centres
+ */
+template <class Accumulator>
+static int accumulator_test(
+    Accumulator                              & acc,
+    const libaccl::pattern::hypersphere<int> & circle,
+    const std::vector<std::vector<int> >     & centres)
+{
+    typedef typename Accumulator::point_t point_t;
+
+    int error_cnt = 0;
+
+    // Generate samples (row-major batch)
+    std::vector<int> samples;
+    for (size_t i = 0; i < centres.size(); ++i)
+        for (auto x = circle.begin(); x != circle.end(); ++x)
+            for (size_t d = 0; d < centres[i].size(); ++d)
+                samples.push_back(centres[i][d] + x->first[d]);
+
+    acc.vote(samples.data(), samples.size() / acc.dimension());
+
+    std::cout << "Cells with votes: " << acc.size() << std::endl;
+
+    auto peaks = acc.peaks(circle.size() / 2);
+    for (size_t i = 0; i < peaks.size(); ++i) {
+        std::cout << "Peak [";
+        for (size_t d = 0; d < peaks[i].point.size(); ++d)
+            std::cout << peaks[i].point[d] << ' ';
+        std::cout << "] " << peaks[i].count << std::endl;
+    }
+
+    if (peaks.size() != centres.size()) {
+        std::cerr
+            << "Peak count mismatch: " << peaks.size()
+            << " != " << centres.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    for (size_t i = 0; i < centres.size(); ++i) {
+        point_t c; assign(c, centres[i]);
+
+        if (acc.count(c) != circle.size()) {
+            std::cerr
+                << "Centre " << i << " vote count mismatch: "
+                << acc.count(c) << " != " << circle.size() << std::endl;
+
+            ++error_cnt;
+        }
+
+        auto peak = std::find_if(peaks.begin(), peaks.end(),
+        [&c](const typename Accumulator::peak & p) {
+            return p.point == c;
+        });
+
+        if (peaks.end() == peak) {
+            std::cerr << "Centre " << i << " is not a peak" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    // Pruning
+    const unsigned threshold = circle.size() / 4;
+    size_t kept = 0;
+    acc.for_each([threshold, &kept](const point_t & , unsigned count) {
+        if (!(count < threshold)) ++kept;
+    });
+
+    acc.prune(threshold);
+
+    if (acc.size() != kept) {
+        std::cerr
+            << "Pruned cell count mismatch: " << acc.size()
+            << " != " << kept << std::endl;
+
+        ++error_cnt;
+    }
+
+    if (acc.peaks(circle.size() / 2).size() != peaks.size()) {
+        std::cerr << "Peaks changed by pruning" << std::endl;
+        ++error_cnt;
+    }
+
+    return error_cnt;
+}
+
+/** Sparse accumulator test */
+static int sparse_test(int radius) {
+    std::cerr << "Sparse accumulator test BEGIN" << std::endl;
+
+    int error_cnt = 0;
+
+    const std::vector<std::vector<int> > centres = {
+        { 0,  0}, {40, 25}, {-30, 50},
+    };
+
+    // Runtime dimension
+    {
+        libaccl::pattern::hypersphere<int> circle(2, {radius});
+        libaccl::pattern::kernel<int, unsigned> kernel(circle);
+
+        libaccl::accumulator<int> acc(kernel, 20011);
+        error_cnt += accumulator_test(acc, circle, centres);
+    }
+
+    // Compile-time dimension
+    {
+        libaccl::pattern::hypersphere<int>       circle(2, {radius});
+        libaccl::pattern::hypersphere<int, 2>    circle2({radius});
+        libaccl::pattern::kernel<int, unsigned, 2> kernel(circle2);
+
+        // Power-of-2 table size (hash masking)
+        libaccl::accumulator<int, unsigned, 2> acc(kernel,
+            libaccl::hash::pow2(20011));
+        error_cnt += accumulator_test(acc, circle, centres);
+    }
+
+    std::cerr << "Sparse accumulator test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Dense accumulator test (compares with sparse one)
+ *
+ *  \param  radius  Pattern radius
+ *  \param  filled  Use filled circle kernel (long kernel rows)
+ */
+static int dense_test(int radius, bool filled) {
+    std::cerr << "Dense accumulator test BEGIN" << std::endl;
+
+    typedef libaccl::backend::dense<int, unsigned, 2> dense_t;
+    typedef libaccl::accumulator<int, unsigned, 2, dense_t> accumulator_t;
+
+    int error_cnt = 0;
+
+    const std::vector<std::vector<int> > centres = {
+        { 0,  0}, {40, 25}, {-30, 50},
+    };
+
+    libaccl::pattern::hypersphere<int>         circle(2, {radius});
+    libaccl::pattern::hypersphere<int, 2>      circle2(
+        filled ? std::vector<int>{radius, 0} : std::vector<int>{radius});
+    libaccl::pattern::kernel<int, unsigned, 2> kernel(circle2);
+
+    // Note that the box cuts some votes off
+    accumulator_t acc(kernel,
+        accumulator_t::point_t{{-64, -64}},
+        accumulator_t::point_t{{ 64,  64}});
+
+    libaccl::accumulator<int, unsigned, 2> sparse(kernel, 40009);
+
+    std::vector<int> samples;
+    for (size_t i = 0; i < centres.size(); ++i)
+        for (auto x = circle.begin(); x != circle.end(); ++x)
+            for (size_t d = 0; d < 2; ++d)
+                samples.push_back(centres[i][d] + x->first[d]);
+
+    acc.vote(samples.data(), samples.size() / 2);
+    sparse.vote(samples.data(), samples.size() / 2);
+
+    size_t inside = 0;
+    sparse.for_each(
+    [&acc, &inside, &error_cnt](
+        const accumulator_t::point_t & point, unsigned count)
+    {
+        if (point[0] < -64 || 64 < point[0]) return;
+        if (point[1] < -64 || 64 < point[1]) return;
+
+        ++inside;
+        if (acc.count(point) != count) {
+            std::cerr
+                << "Cell [" << point[0] << ' ' << point[1]
+                << "] count mismatch: " << acc.count(point)
+                << " != " << count << std::endl;
+
+            ++error_cnt;
+        }
+    });
+
+    if (acc.size() != inside) {
+        std::cerr
+            << "Cell count mismatch: " << acc.size()
+            << " != " << inside << std::endl;
+
+        ++error_cnt;
+    }
+
+    auto peaks = acc.peaks(kernel.size() / 2);
+    if (!filled && peaks.size() != centres.size()) {
+        std::cerr
+            << "Peak count mismatch: " << peaks.size()
+            << " != " << centres.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    // Copies are bound to their own kernel (fast path)
+    accumulator_t copy(acc), orig(acc);
+    accumulator_t moved(std::move(orig));
+    if (!acc.backend().bound(acc.kernel()) ||
+        !copy.backend().bound(copy.kernel()) ||
+        !moved.backend().bound(moved.kernel()))
+    {
+        std::cerr << "Accumulator copy kernel not bound" << std::endl;
+        ++error_cnt;
+    }
+
+    copy.vote(samples.data(), samples.size() / 2);
+    moved.vote(samples.data(), samples.size() / 2);
+    sparse.for_each(
+    [&copy, &moved, &error_cnt](
+        const accumulator_t::point_t & point, unsigned count)
+    {
+        if (copy.count(point) != moved.count(point)) ++error_cnt;
+        if (copy.count(point) && copy.count(point) != 2 * count) ++error_cnt;
+    });
+
+    std::cerr << "Dense accumulator test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Accumulators have the same votes */
+template <class Accumulator1, class Accumulator2>
+static int compare(const Accumulator1 & acc1, const Accumulator2 & acc2) {
+    int error_cnt = 0;
+
+    if (acc1.size() != acc2.size()) {
+        std::cerr
+            << "Cell count mismatch: " << acc1.size()
+            << " != " << acc2.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    acc1.for_each(
+    [&acc2, &error_cnt](
+        const typename Accumulator1::point_t & point, unsigned count)
+    {
+        if (acc2.count(point) != count) ++error_cnt;
+    });
+
+    return error_cnt;
+}
+
+/** Parallel voting test (compares with single-threaded voting) */
+static int parallel_test(int radius, unsigned threads) {
+    std::cerr << "Parallel voting test BEGIN" << std::endl;
+
+    typedef libaccl::accumulator<int, unsigned, 2> sparse_t;
+    typedef libaccl::accumulator<int, unsigned, 2,
+        libaccl::backend::dense<int, unsigned, 2> > dense_t;
+    typedef libaccl::accumulator<int, unsigned, 2,
+        libaccl::backend::sparse_concurrent<int, unsigned, 2> > shared_t;
+
+    int error_cnt = 0;
+
+    libaccl::pattern::hypersphere<int, 2>      disc({radius, 0});
+    libaccl::pattern::kernel<int, unsigned, 2> kernel(disc);
+
+    // Pseudo-random samples
+    std::vector<int> samples;
+    unsigned seed = 12345;
+    for (size_t i = 0; i < 2000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        samples.push_back((int)(seed >> 16) % 100 - 50);
+    }
+
+    sparse_t sparse1(kernel, 40009), sparse2(kernel, 40009);
+    sparse1.vote(samples.data(), samples.size() / 2);
+    sparse2.vote(samples.data(), samples.size() / 2, threads);
+    error_cnt += compare(sparse1, sparse2);
+
+    sparse_t grown(kernel, 101, 0, 2.0);  // growing table
+    grown.vote(samples.data(), samples.size() / 2, threads);
+    error_cnt += compare(sparse1, grown);
+
+    const dense_t::point_t lo = {{-64, -64}}, hi = {{64, 64}};
+    dense_t dense1(kernel, lo, hi), dense2(kernel, lo, hi);
+    dense1.vote(samples.data(), samples.size() / 2);
+    dense2.vote(samples.data(), samples.size() / 2, threads);
+    error_cnt += compare(dense1, dense2);
+
+    shared_t shared(kernel, 40009);
+    shared.vote(samples.data(), samples.size() / 2, threads);
+    error_cnt += compare(sparse1, shared);
+
+    std::cerr << "Parallel voting test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Reference peaks (by neighbour lookups) */
+template <class Accumulator>
+static typename Accumulator::peaks_t reference_peaks(
+    const Accumulator & acc, unsigned threshold)
+{
+    typedef typename Accumulator::point_t point_t;
+
+    typename Accumulator::peaks_t peaks;
+    acc.for_each(
+    [&acc, threshold, &peaks](const point_t & point, unsigned count) {
+        if (count < threshold) return;
+
+        size_t cnt = 1;
+        for (size_t d = 0; d < point.size(); ++d) cnt *= 3;
+
+        for (size_t k = 0; k < cnt; ++k) {
+            point_t n = point;
+            for (size_t d = 0, o = k; d < point.size(); ++d, o /= 3)
+                n[d] += (int)(o % 3) - 1;
+
+            if (n == point) continue;
+
+            const unsigned n_count = acc.count(n);
+            if (n_count > count || (n_count == count && n < point)) return;
+        }
+
+        peaks.emplace_back(point, count);
+    });
+
+    std::sort(peaks.begin(), peaks.end());
+
+    return peaks;
+}
+
+/** Peaks are the same */
+template <class Peaks>
+static int compare_peaks(
+    const char * name, const Peaks & peaks, const Peaks & ref, size_t top)
+{
+    const size_t size = top && top < ref.size() ? top : ref.size();
+
+    if (peaks.size() != size) {
+        std::cerr
+            << name << ": peak count mismatch: " << peaks.size()
+            << " != " << size << std::endl;
+
+        return 1;
+    }
+
+    for (size_t i = 0; i < size; ++i)
+        if (peaks[i].point != ref[i].point || peaks[i].count != ref[i].count) {
+            std::cerr << name << ": peak " << i << " mismatch" << std::endl;
+            return 1;
+        }
+
+    return 0;
+}
+
+/** Peaks test (single-/multi-threaded, top-K, compares with reference) */
+template <class Accumulator>
+static int peaks_test(
+    const char * name, const Accumulator & acc, unsigned threads)
+{
+    int error_cnt = 0;
+
+    for (unsigned threshold = 1; threshold <= 4; threshold += 3) {
+        const auto ref = reference_peaks(acc, threshold);
+
+        std::cout
+            << name << ": " << ref.size() << " peaks over "
+            << threshold << " votes" << std::endl;
+
+        error_cnt += compare_peaks(name,
+            acc.peaks(threshold), ref, 0);
+        error_cnt += compare_peaks(name,
+            acc.peaks(threshold, 0, threads), ref, 0);
+        error_cnt += compare_peaks(name,
+            acc.peaks(threshold, 10), ref, 10);
+        error_cnt += compare_peaks(name,
+            acc.peaks(threshold, 10, threads), ref, 10);
+        error_cnt += compare_peaks(name,
+            acc.peaks(threshold, ref.size() + 1, threads), ref, 0);
+    }
+
+    return error_cnt;
+}
+
+/** Peak extraction test (all backends) */
+static int peaks_test(int radius, unsigned threads) {
+    std::cerr << "Peak extraction test BEGIN" << std::endl;
+
+    typedef libaccl::accumulator<int, unsigned, 2> sparse_t;
+    typedef libaccl::accumulator<int, unsigned> sparse_rt_t;
+    typedef libaccl::accumulator<int, unsigned, 2,
+        libaccl::backend::dense<int, unsigned, 2> > dense_t;
+    typedef libaccl::accumulator<int, unsigned, 2,
+        libaccl::backend::sparse_concurrent<int, unsigned, 2> > shared_t;
+    typedef libaccl::accumulator<int, unsigned, 3> sparse3_t;
+    typedef libaccl::accumulator<int, unsigned, 3,
+        libaccl::backend::sparse_concurrent<int, unsigned, 3> > shared3_t;
+
+    int error_cnt = 0;
+
+    libaccl::pattern::hypersphere<int, 2>      circle({radius});
+    libaccl::pattern::kernel<int, unsigned, 2> kernel(circle);
+
+    libaccl::pattern::hypersphere<int>         circle_rt(2, {radius});
+    libaccl::pattern::kernel<int, unsigned>    kernel_rt(circle_rt);
+
+    // Pseudo-random samples
+    std::vector<int> samples;
+    unsigned seed = 54321;
+    for (size_t i = 0; i < 600; ++i) {
+        seed = seed * 1103515245 + 12345;
+        samples.push_back((int)(seed >> 16) % 100 - 50);
+    }
+
+    sparse_t sparse(kernel, 40009);
+    sparse.vote(samples.data(), samples.size() / 2);
+    error_cnt += peaks_test("sparse", sparse, threads);
+
+    sparse_rt_t sparse_rt(kernel_rt, 40009);
+    sparse_rt.vote(samples.data(), samples.size() / 2);
+    error_cnt += peaks_test("sparse (runtime dimension)", sparse_rt, threads);
+
+    sparse_t grown(kernel, 101, 0, 2.0);  // growing table
+    grown.vote(samples.data(), samples.size() / 2);
+    error_cnt += peaks_test("sparse (grown)", grown, threads);
+
+    // Note that the box cuts some votes off
+    dense_t dense(kernel, dense_t::point_t{{-48, -40}}, dense_t::point_t{{48, 56}});
+    dense.vote(samples.data(), samples.size() / 2);
+    error_cnt += peaks_test("dense", dense, threads);
+
+    shared_t shared(kernel, 40009);
+    shared.vote(samples.data(), samples.size() / 2, threads);
+    error_cnt += peaks_test("shared", shared, threads);
+
+    // 3D (more coordinate prefixes of neighbours), denser samples
+    std::vector<int> samples3;
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples3.push_back(samples[i] / 5);
+
+    libaccl::pattern::hypersphere<int, 3>      sphere({2});
+    libaccl::pattern::kernel<int, unsigned, 3> kernel3(sphere);
+
+    libaccl::pattern::hypersphere<int>         sphere_rt(3, {2});
+    libaccl::pattern::kernel<int, unsigned>    kernel3_rt(sphere_rt);
+
+    sparse3_t sparse3(kernel3, 40009);
+    sparse3.vote(samples3.data(), samples3.size() / 3);
+    error_cnt += peaks_test("sparse (3D)", sparse3, threads);
+
+    sparse_rt_t sparse3_rt(kernel3_rt, 40009);
+    sparse3_rt.vote(samples3.data(), samples3.size() / 3);
+    error_cnt += peaks_test("sparse (3D, runtime dimension)", sparse3_rt, threads);
+
+    shared3_t shared3(kernel3, 40009);
+    shared3.vote(samples3.data(), samples3.size() / 3, threads);
+    error_cnt += peaks_test("shared (3D)", shared3, threads);
+
+    std::cerr << "Peak extraction test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Saturating counter arithmetic test */
+static int saturating_test() {
+    typedef libaccl::saturating<uint8_t> counter_t;
+
+    int error_cnt = 0;
+
+    counter_t c;
+    c += 200; c += 100;
+    if (255 != c || !c.saturated()) ++error_cnt;
+
+    c -= 55;
+    if (200 != c || c.saturated()) ++error_cnt;
+
+    c -= 250;
+    if (0 != c) ++error_cnt;
+
+    if (255 != counter_t(1000) || 0 != counter_t(-5)) ++error_cnt;
+
+    if (error_cnt) std::cerr << "Saturating arithmetic failed" << std::endl;
+
+    return error_cnt;
+}
+
+/**
+ *  \brief  Compact accumulator test
+ *
+ *  Narrow coordinates and saturating counters; the votes must be those
+ *  of the full-width accumulator, capped.
+ *
+ *  \tparam Count_t  Counter type
+ *  \param  radius   Pattern radius
+ *  \param  copies   Number of copies of each sample
+ *  \param  weight   Vote weight
+ */
+template <typename Count_t>
+static int compact_test(int radius, size_t copies, unsigned weight) {
+    typedef libaccl::pattern::kernel<int16_t, Count_t, 2> kernel_t;
+    typedef libaccl::accumulator<int16_t, Count_t, 2>     sparse_t;
+    typedef libaccl::accumulator<int16_t, Count_t, 2,
+        libaccl::backend::dense<int16_t, Count_t, 2> >    dense_t;
+    typedef libaccl::accumulator<int, unsigned, 2>        full_t;
+    typedef typename Count_t::value_type                  value_t;
+
+    int error_cnt = 0;
+
+    libaccl::pattern::hypersphere<int16_t, 2> disc({(int16_t)radius, 0});
+    libaccl::pattern::hypersphere<int, 2>     disc_full({radius, 0});
+    auto weight_fn = [weight](unsigned) { return weight; };
+    kernel_t kernel(disc, weight_fn);
+    libaccl::pattern::kernel<int, unsigned, 2> kernel_full(disc_full, weight_fn);
+
+    std::vector<int16_t> samples;
+    std::vector<int>     samples_full;
+    unsigned seed = 777;
+    for (size_t i = 0; i < 300; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const int x = (int)(seed >> 16) % 60 - 30;
+        const int y = (int)(seed >> 4)  % 60 - 30;
+
+        for (size_t j = 0; j < copies; ++j) {
+            samples.push_back(x); samples.push_back(y);
+            samples_full.push_back(x); samples_full.push_back(y);
+        }
+    }
+
+    sparse_t sparse(kernel, 16384);
+    sparse.vote(samples.data(), samples.size() / 2);
+
+    const typename dense_t::point_t lo = {{-64, -64}}, hi = {{64, 64}};
+    dense_t dense(kernel, lo, hi);
+    dense.vote(samples.data(), samples.size() / 2);
+
+    full_t full(kernel_full, 16384);
+    full.vote(samples_full.data(), samples_full.size() / 2);
+
+    const unsigned max = std::numeric_limits<value_t>::max();
+    size_t saturated = 0;
+    full.for_each(
+    [&sparse, &dense, max, &saturated, &error_cnt](
+        const full_t::point_t & point, unsigned count)
+    {
+        const typename sparse_t::point_t p = {{
+            (int16_t)point[0], (int16_t)point[1]}};
+
+        const unsigned capped = std::min(count, max);
+        if (max <= count) ++saturated;
+
+        if (sparse.count(p) != capped || dense.count(p) != capped)
+            ++error_cnt;
+    });
+
+    if (sparse.size() != full.size() || dense.size() != full.size())
+        ++error_cnt;
+
+    std::cout
+        << sizeof(value_t) * 8 << "-bit counters: " << full.size()
+        << " cells, " << saturated << " saturated" << std::endl;
+
+    if (error_cnt)
+        std::cerr << "Compact accumulator votes mismatch" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Unit test */
+static int main_impl(int argc, char * const argv[]) {
+    int exit_code = 64;  // pessimistic assumption
+
+    int radius = 10;  // pattern radius
+    if (argc > 1) radius = ::atoi(argv[1]);
+
+    do {  // pragmatic do ... while (0) loop allowing for breaks
+        exit_code = sparse_test(radius);
+        if (0 != exit_code) break;
+
+        exit_code = dense_test(radius, false);
+        if (0 != exit_code) break;
+
+        exit_code = dense_test(radius, true);
+        if (0 != exit_code) break;
+
+        exit_code = parallel_test(radius, 5);
+        if (0 != exit_code) break;
+
+        exit_code = peaks_test(radius, 5);
+        if (0 != exit_code) break;
+
+        exit_code = saturating_test();
+        if (0 != exit_code) break;
+
+        exit_code = compact_test<libaccl::saturating<uint16_t> >(radius, 3, 1000);
+        if (0 != exit_code) break;
+
+        exit_code = compact_test<libaccl::saturating<uint8_t> >(radius, 4, 3);
+        if (0 != exit_code) break;
+
+    } while (0);  // end of pragmatic loop
+
+    std::cerr
+        << "Exit code: " << exit_code
+        << std::endl;
+
+    return exit_code;
+}
+
+/** Unit test exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,240 @@
+/**
+ *  \file
+ *  \brief  CUDA accumulator backend unit test
+ *
+ *  \date   2016/01/19
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libaccl/accumulator.hxx>
+#include <libaccl/backend/dense.hxx>
+#include <libaccl/backend/cuda.hxx>
+#include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/pattern/kernel.hxx>
+
+#include <vector>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+
+
+/** Layer index as vote weight */
+static uint32_t layer_weight(uint32_t layer) { return layer + 1; }
+
+
+/** Cells and peaks are the same */
+template <class Accumulator, class Reference>
+static int compare(
+    const char * name, const Accumulator & acc, const Reference & ref)
+{
+    typedef typename Reference::point_t point_t;
+
+    int error_cnt = 0;
+
+    if (acc.size() != ref.size()) {
+        std::cerr
+            << name << ": cell count mismatch: " << acc.size()
+            << " != " << ref.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    ref.for_each([&](const point_t & point, uint32_t count) {
+        if (acc.count(point) != count) {
+            std::cerr << name << ": cell vote count mismatch" << std::endl;
+            ++error_cnt;
+        }
+    });
+
+    for (uint32_t threshold = 1; threshold <= 9; threshold += 4) {
+        const auto peaks     = acc.peaks(threshold);
+        const auto ref_peaks = ref.peaks(threshold);
+
+        std::cout
+            << name << ": " << peaks.size() << " peaks over "
+            << threshold << " votes" << std::endl;
+
+        bool match = peaks.size() == ref_peaks.size();
+        for (size_t i = 0; match && i < peaks.size(); ++i)
+            match = peaks[i].point == ref_peaks[i].point
+                &&  peaks[i].count == ref_peaks[i].count;
+
+        if (!match) {
+            std::cerr << name << ": peaks mismatch" << std::endl;
+            ++error_cnt;
+        }
+
+        if (acc.peaks(threshold, 5).size() != std::min<size_t>(5, peaks.size())) {
+            std::cerr << name << ": top peaks mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  CUDA backend test
+ *
+ *  Votes (incl. those crossing the box boundary) must be the same
+ *  as those of \ref libaccl::backend::dense.
+ *
+ *  \tparam N        Space dimension
+ *  \param  radius   Pattern radius
+ *  \param  extent   Box extent (per dimension)
+ *  \param  samples  Number of samples
+ *  \param  batch    Samples batch size
+ *  \param  threads  Voting threads
+ */
+template <size_t N>
+static int cuda_test(
+    int      radius,
+    int32_t  extent,
+    size_t   sample_cnt,
+    size_t   batch,
+    unsigned threads)
+{
+    typedef libaccl::accumulator<int32_t, uint32_t, N,
+        libaccl::backend::cuda<int32_t, uint32_t, N> > cuda_t;
+    typedef libaccl::accumulator<int32_t, uint32_t, N,
+        libaccl::backend::dense<int32_t, uint32_t, N> > dense_t;
+
+    std::cerr << "CUDA backend test (" << N << "D) BEGIN" << std::endl;
+
+    int error_cnt = 0;
+
+    libaccl::pattern::hypersphere<int32_t, N> sphere({radius / 2, radius});
+    libaccl::pattern::kernel<int32_t, uint32_t, N> kernel(sphere, layer_weight);
+    libaccl::pattern::kernel<int32_t, uint32_t, N> unit(sphere);
+
+    typename cuda_t::point_t lo, hi;
+    lo.fill(-extent);
+    hi.fill(extent);
+
+    // Pseudo-random samples (some of them out of the box)
+    std::vector<int32_t> samples;
+    unsigned seed = 12345;
+    for (size_t i = 0; i < sample_cnt * N; ++i) {
+        seed = seed * 1103515245 + 12345;
+        samples.push_back((int32_t)((seed >> 16) % (2 * extent + 21))
+            - extent - 10);
+    }
+
+    cuda_t  acc(kernel, lo, hi, batch);
+    dense_t ref(kernel, lo, hi);
+
+    acc.vote(samples.data(), sample_cnt, threads);
+    ref.vote(samples.data(), sample_cnt);
+    error_cnt += compare("voting", acc, ref);
+
+    // Filtered voting (single cell additions)
+    auto filter = [](const typename cuda_t::point_t & cell) {
+        return 0 == cell[0] % 7;
+    };
+
+    acc.vote_if(samples.data(), filter);
+    ref.vote_if(samples.data(), filter);
+    error_cnt += compare("filtered voting", acc, ref);
+
+    acc.prune(4);
+    ref.prune(4);
+    error_cnt += compare("pruning", acc, ref);
+
+    // Another kernel is uploaded on the fly
+    acc.backend().vote(samples.data(), unit);
+    ref.backend().vote(samples.data(), unit);
+    error_cnt += compare("kernel change", acc, ref);
+
+    std::cerr << "CUDA backend test (" << N << "D) END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Unit test */
+static int main_impl(int argc, char * const argv[]) {
+    int exit_code = 64;  // pessimistic assumption
+
+    int radius = 8;  // pattern radius
+    if (argc > 1) radius = ::atoi(argv[1]);
+
+    // No device, skip the test (automake SKIP status)
+    if (!libaccl::backend::impl::cuda::device_cnt()) {
+        std::cerr << "No CUDA device" << std::endl;
+        return 77;
+    }
+
+    do {  // pragmatic do ... while (0) loop allowing for breaks
+        exit_code = cuda_test<2>(radius, 50, 2000, 256, 1);
+        if (0 != exit_code) break;
+
+        exit_code = cuda_test<2>(radius, 30, 1000, 100, 3);
+        if (0 != exit_code) break;
+
+        exit_code = cuda_test<3>(radius, 10, 2000, 64, 2);
+        if (0 != exit_code) break;
+
+    } while (0);  // end of pragmatic loop
+
+    std::cerr
+        << "Exit code: " << exit_code
+        << std::endl;
+
+    return exit_code;
+}
+
+/** Unit test exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
@@ -40,7 +40,16 @@
 
 
 #include <libaccl/hash/linear.hxx>
+#include <libaccl/hash/linear_concurrent.hxx>
 
+#include <vector>
+#include <list>
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iterator>
 #include <algorithm>
 #include <iostream>
 #include <exception>
@@ -107,14 +116,32 @@ static size_t secondary_hash_fn(const std::string & key, size_t size) {
 }
 
 
-/** Hash table test */
-static int hashtab_test(size_t size) {
+/** Static hash function chain */
+typedef libaccl::hash::chain<
+        libaccl::hash::function<hash_fn_t, primary_hash_fn>,
+        libaccl::hash::function<hash_fn_t, secondary_hash_fn> >
+    hash_chain_t;
+
+/** Hash table (static hash function chain) */
+typedef libaccl::hash::linear<
+        hash_item_t,
+        hash_chain_t,
+        std::string,
+        key_fn>
+    chain_hashtab_t;
+
+
+/**
+ *  \brief  Hash table test
+ *
+ *  \param  tab  Hash table
+ */
+template <class Hashtab>
+static int hashtab_test(Hashtab & tab) {
     int error_cnt = 0;
 
     std::cerr << "Hash table test BEGIN" << std::endl;
 
-    hashtab_t tab(size, {primary_hash_fn, secondary_hash_fn});
-
     data_t data;
     data.emplace_back("Harry Potter and the Philosopher's Stone",  1);
     data.emplace_back("Harry Potter and the Chamber of Secrets",   2);
@@ -152,6 +179,1128 @@ static int hashtab_test(size_t size) {
 }
 
 
+/** Integer hash function */
+typedef size_t (*int_hash_fn_t)(int, size_t);
+
+/** Integer secondary hash function */
+static size_t int_hash_fn(int key, size_t size) {
+    return ((size_t)key * 40503U + 17) % size;
+}
+
+/** Growing hash table */
+typedef libaccl::hash::linear<int, int_hash_fn_t> growing_hashtab_t;
+
+
+/**
+ *  \brief  Hash table growth test
+ *
+ *  \param  size   Initial table size
+ *  \param  items  Number of items
+ */
+static int growing_hashtab_test(size_t size, int items) {
+    int error_cnt = 0;
+
+    std::cerr << "Hash table growth test BEGIN" << std::endl;
+
+    growing_hashtab_t tab(size, {int_hash_fn});
+    tab.set_growth(2.0);
+
+    for (int i = 0; i < items; ++i) {
+        if (0 > tab.insert(i)) {
+            std::cerr << "Failed to insert " << i << std::endl;
+            ++error_cnt;
+        }
+
+        if (tab[i / 2] != i / 2) {  // find in either table (no insertion)
+            std::cerr << "Item " << i / 2 << " mismatch" << std::endl;
+            ++error_cnt;
+        }
+
+        for (int j = i; j >= 0 && j > i - 8; --j)
+            if (!tab.exists(j)) {
+                std::cerr << "Item " << j << " lost" << std::endl;
+                ++error_cnt;
+            }
+    }
+
+    if ((size_t)items != tab.item_cnt()) {
+        std::cerr
+            << "Item count mismatch: " << tab.item_cnt()
+            << " != " << items << std::endl;
+
+        ++error_cnt;
+    }
+
+    size_t iter_cnt = 0;
+    for (auto i = tab.begin(); i != tab.end(); ++i) ++iter_cnt;
+
+    if (iter_cnt != tab.item_cnt()) {
+        std::cerr << "Iteration count mismatch: " << iter_cnt << std::endl;
+        ++error_cnt;
+    }
+
+    tab.rehash();
+
+    // Erasure & compaction
+    for (int i = 0; i < items; i += 3)
+        if (!tab.erase(i)) {
+            std::cerr << "Failed to erase " << i << std::endl;
+            ++error_cnt;
+        }
+
+    if (tab.erase(0)) {
+        std::cerr << "Erased item 0 twice" << std::endl;
+        ++error_cnt;
+    }
+
+    const size_t tombstones = tab.avail_cnt();
+    tab.compact(true);
+
+    for (int i = 0; i < items; ++i)
+        if (tab.exists(i) != (0 != i % 3)) {
+            std::cerr << "Item " << i << " erasure mismatch" << std::endl;
+            ++error_cnt;
+        }
+
+    for (int i = 0; i < items; i += 3) tab.insert(i);  // rehash steps
+    tab.rehash();
+
+    if (0 != tab.avail_cnt() || (size_t)items != tab.item_cnt()) {
+        std::cerr << "Compaction failed" << std::endl;
+        ++error_cnt;
+    }
+
+    for (int i = 0; i < items; ++i)
+        if (!tab.exists(i)) {
+            std::cerr << "Item " << i << " lost" << std::endl;
+            ++error_cnt;
+        }
+
+    std::cout
+        << "Grown table: " << size << " -> " << tab.size()
+        << " slots, " << tab.item_cnt() << " items, "
+        << tombstones << " tombstones compacted" << std::endl;
+
+    std::cerr << "Hash table growth test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Built-in integer hash functions chain */
+typedef libaccl::hash::chain<
+        libaccl::hash::int_hash<int>,
+        libaccl::hash::int_hash<int> >
+    int_hash_chain_t;
+
+/** Power-of-2 size hash table */
+typedef libaccl::hash::linear<int, int_hash_chain_t> pow2_hashtab_t;
+
+/** Hash table with operation counters */
+typedef libaccl::hash::linear<
+        int,
+        int_hash_chain_t,
+        int,
+        libaccl::hash::impl::identity_key<int>,
+        libaccl::hash::stats::counters>
+    stats_hashtab_t;
+
+
+/**
+ *  \brief  Power-of-2 size hash table test
+ *
+ *  Uses (masking) built-in hash functions, keys are multiples of
+ *  the table size (the worst case for plain masking).
+ *
+ *  \param  size   Initial table size (rounded up to power of 2)
+ *  \param  items  Number of items
+ */
+static int pow2_hashtab_test(size_t size, int items) {
+    int error_cnt = 0;
+
+    std::cerr << "Power-of-2 hash table test BEGIN" << std::endl;
+
+    pow2_hashtab_t tab(libaccl::hash::pow2(size), {
+        int_hash_chain_t(
+            libaccl::hash::int_hash<int>(1),
+            libaccl::hash::int_hash<int>(2))});
+    tab.set_growth(2.0);
+
+    const int stride = tab.size();
+    for (int i = 0; i < items; ++i)
+        if (0 > tab.insert(i * stride)) {
+            std::cerr << "Failed to insert " << i * stride << std::endl;
+            ++error_cnt;
+        }
+
+    tab.rehash();
+
+    for (int i = 0; i < items; ++i)
+        if (!tab.exists(i * stride)) {
+            std::cerr << "Item " << i * stride << " lost" << std::endl;
+            ++error_cnt;
+        }
+
+    if (!libaccl::hash::is_pow2(tab.size())) {
+        std::cerr << "Table size " << tab.size() << " not power of 2" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cout
+        << "Power-of-2 table: " << tab.size() << " slots, "
+        << tab.item_cnt() << " items" << std::endl;
+
+    // High load (bounded probe)
+    stats_hashtab_t full(libaccl::hash::pow2(size), {}, 0.95 * size);
+    for (int i = 0; (size_t)i < full.capacity(); ++i) full.insert(3 * i);
+
+    for (int i = 0; (size_t)i < full.capacity(); ++i)
+        if (!full.exists(3 * i) || full.exists(3 * i + 1)) {
+            std::cerr << "High load lookup failed for " << 3 * i << std::endl;
+            ++error_cnt;
+        }
+
+    const libaccl::hash::stats::counters & cnt = full.stats();
+
+    std::cout
+        << "High load table: " << full.item_cnt() << " / " << full.size()
+        << " items, longest probe " << full.max_probe()
+        << ", longest miss " << cnt.longest_miss()
+        << ", mean miss " << cnt.mean_miss_probe() << std::endl;
+
+    if (full.max_probe() > full.size() / 4) {
+        std::cerr
+            << "High load longest probe " << full.max_probe()
+            << " not bounded (table size " << full.size() << ")"
+            << std::endl;
+        ++error_cnt;
+    }
+
+    // Misses stop at the longest probe (not at the end of the run)
+    if (cnt.misses() != full.capacity() || 0 == cnt.longest_miss()
+    ||  cnt.longest_miss() > full.max_probe())
+    {
+        std::cerr
+            << "High load misses: " << cnt.misses() << ", longest "
+            << cnt.longest_miss() << " (longest probe " << full.max_probe()
+            << ")" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr << "Power-of-2 hash table test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Statistics test
+ *
+ *  \param  size   Table size (rounded up to power of 2)
+ *  \param  items  Number of items (must fit)
+ */
+static int stats_hashtab_test(size_t size, int items) {
+    int error_cnt = 0;
+
+    std::cerr << "Hash table statistics test BEGIN" << std::endl;
+
+    stats_hashtab_t tab(libaccl::hash::pow2(size), {
+        int_hash_chain_t(
+            libaccl::hash::int_hash<int>(1),
+            libaccl::hash::int_hash<int>(2))});
+
+    for (int i = 0; i < items; ++i) tab.insert(7 * i);
+    for (int i = 0; i < items; ++i) tab.exists(7 * i);      // hits
+    for (int i = 0; i < items; ++i) tab.exists(7 * i + 1);  // misses
+    for (int i = 0; i < items; i += 2) tab.erase(7 * i);
+
+    const libaccl::hash::stats::counters & cnt = tab.stats();
+
+    uint64_t resolved = cnt.collided();
+    for (size_t i = 0; i < 2; ++i) resolved += cnt.resolved(i);
+
+    // Erasure by key looks the item up (hit)
+    const uint64_t hits = items + (items + 1) / 2;
+    if (cnt.inserts() != (uint64_t)items || cnt.hits() != hits
+    ||  cnt.misses() != (uint64_t)items
+    ||  cnt.erasures() != (uint64_t)(items + 1) / 2
+    ||  resolved != cnt.inserts() + cnt.hits())
+    {
+        std::cerr
+            << "Counters mismatch: " << cnt.inserts() << " inserts, "
+            << cnt.hits() << " hits, " << cnt.misses() << " misses, "
+            << cnt.erasures() << " erasures, " << resolved
+            << " resolved" << std::endl;
+        ++error_cnt;
+    }
+
+    const libaccl::hash::stats::snapshot snap = tab.snapshot();
+
+    size_t hist = 0, longest = 0;
+    for (size_t pos = 1; pos < snap.probe_hist.size(); ++pos) {
+        hist += snap.probe_hist[pos];
+        if (snap.probe_hist[pos]) longest = pos;
+    }
+
+    if (snap.used != tab.item_cnt() || snap.avail != tab.avail_cnt()
+    ||  snap.used + snap.avail + snap.empty != tab.size()
+    ||  hist != snap.used || longest > tab.max_probe()
+    ||  snap.resolved[0] + snap.resolved[1] + snap.collided != snap.used
+    ||  snap.longest_run < 1 || snap.longest_run > tab.size())
+    {
+        std::cerr
+            << "Snapshot mismatch: " << snap.used << " used, "
+            << snap.avail << " available, " << snap.empty << " empty, "
+            << hist << " in histogram" << std::endl;
+        ++error_cnt;
+    }
+
+    // Overfill
+    stats_hashtab_t full(16, {}, 8);
+    for (int i = 0; i < 10; ++i) full.insert(i);
+
+    if (2 != full.stats().overfills()) {
+        std::cerr
+            << "Overfills: " << full.stats().overfills()
+            << " != 2" << std::endl;
+        ++error_cnt;
+    }
+
+    // Export
+    size_t exported = 0;
+    cnt.for_each([&exported](const std::string & , uint64_t ) {
+        ++exported;
+    });
+
+    if (exported != 12) {
+        std::cerr << "Exported " << exported << " != 12" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cout
+        << "Statistics: mean probe " << cnt.mean_probe()
+        << " (items " << snap.mean_probe()
+        << "), longest run " << snap.longest_run << std::endl;
+
+    std::cerr << "Hash table statistics test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Counter (concurrent hash table item) */
+struct counter {
+    int      key;    /**< Key   */
+    unsigned count;  /**< Count */
+
+    /** New items are constructed from key (see hash::key_constructed) */
+    typedef std::true_type key_constructed;
+
+    /** Default constructor */
+    counter(): key(0), count(0) {}
+
+    /** Constructor */
+    counter(int k): key(k), count(0) {}
+
+};  // end of struct counter
+
+/** Counter key accessor */
+class counter_key_fn {
+    public:
+
+    inline int operator () (const counter & item) const { return item.key; }
+
+};  // end of class counter_key_fn
+
+/** Counter hash function */
+typedef size_t (*counter_hash_fn_t)(int, size_t);
+
+/** Counter primary hash function */
+static size_t counter_hash_fn(int key, size_t size) {
+    return ((size_t)key * 2654435761U) % size;
+}
+
+/** Concurrent hash table */
+typedef libaccl::hash::linear_concurrent<
+        counter,
+        counter_hash_fn_t,
+        int,
+        counter_key_fn>
+    concurrent_hashtab_t;
+
+
+/**
+ *  \brief  Concurrent hash table test
+ *
+ *  Threads count occurrences of keys concurrently, then erase some.
+ *
+ *  \param  size     Table size
+ *  \param  threads  Thread count
+ */
+static int concurrent_hashtab_test(size_t size, unsigned threads) {
+    int error_cnt = 0;
+
+    std::cerr << "Concurrent hash table test BEGIN" << std::endl;
+
+    concurrent_hashtab_t tab(size, {counter_hash_fn});
+
+    const int    keys   = size / 2;
+    const size_t rounds = 10;
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back([&tab, keys, rounds, t]() {
+            for (size_t r = 0; r < rounds; ++r)
+                for (int k = 0; k < keys; ++k) {
+                    const int key = (k + t * 7) % keys;
+                    tab.fetch_add(key, &counter::count, 1U);
+
+                    tab.find((key * 3) % keys);  // concurrent reader
+                }
+        });
+
+    for (auto w = workers.begin(); w != workers.end(); ++w) w->join();
+
+    if ((size_t)keys != tab.item_cnt()) {
+        std::cerr
+            << "Item count mismatch: " << tab.item_cnt()
+            << " != " << keys << std::endl;
+
+        ++error_cnt;
+    }
+
+    for (int k = 0; k < keys; ++k) {
+        const ssize_t index = tab.find(k);
+        if (0 > index || threads * rounds != tab.at(index).count) {
+            std::cerr << "Key " << k << " count mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    if (-1 != tab.insert(counter(0))) {
+        std::cerr << "Duplicate insertion succeeded" << std::endl;
+        ++error_cnt;
+    }
+
+    // Concurrent erasure (every key exactly once)
+    workers.clear();
+    for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back([&tab, keys, threads, t]() {
+            for (int k = t; k < keys; k += threads)
+                if (0 == k % 2) tab.erase(k);
+        });
+
+    for (auto w = workers.begin(); w != workers.end(); ++w) w->join();
+
+    for (int k = 0; k < keys; ++k)
+        if (tab.exists(k) != (1 == k % 2)) {
+            std::cerr << "Key " << k << " erasure mismatch" << std::endl;
+            ++error_cnt;
+        }
+
+    std::cout
+        << "Concurrent table: " << tab.item_cnt() << " items after erasure"
+        << std::endl;
+
+    std::cerr << "Concurrent hash table test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Counter hash table */
+typedef libaccl::hash::linear<
+        counter,
+        counter_hash_fn_t,
+        int,
+        counter_key_fn>
+    counter_hashtab_t;
+
+
+/**
+ *  \brief  Batch operations test
+ *
+ *  \param  size  Table size
+ */
+static int batch_hashtab_test(size_t size) {
+    int error_cnt = 0;
+
+    std::cerr << "Batch operations test BEGIN" << std::endl;
+
+    counter_hashtab_t tab(size, {counter_hash_fn});
+
+    const int keys = size / 2;
+
+    std::vector<counter> items;
+    for (int k = 0; k < keys; k += 2) items.push_back(counter(k));
+
+    if (items.size() != tab.insert_batch(items.begin(), items.end())) {
+        std::cerr << "Batch insertion failed" << std::endl;
+        ++error_cnt;
+    }
+
+    // Every key gets its value (twice)
+    std::vector<int>      batch;
+    std::vector<unsigned> deltas;
+    for (int k = 0; k < keys; ++k) {
+        batch.push_back(k);
+        deltas.push_back(k);
+    }
+
+    tab.add_batch(batch.begin(), batch.end(), deltas.begin(), &counter::count);
+    tab.add_batch(batch.begin(), batch.end(), deltas.begin(), &counter::count);
+
+    batch.push_back(keys);  // missing key
+
+    std::vector<ssize_t> index;
+    tab.find_batch(batch.begin(), batch.end(), std::back_inserter(index));
+
+    if (index.size() != batch.size() || -1 != index.back()) {
+        std::cerr << "Batch search failed" << std::endl;
+        ++error_cnt;
+    }
+
+    for (int k = 0; k < keys; ++k)
+        if (index[k] != tab.find(k) || (unsigned)(2 * k) != tab[k].count) {
+            std::cerr << "Key " << k << " batch mismatch" << std::endl;
+            ++error_cnt;
+        }
+
+    std::cerr << "Batch operations test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Tagged item (constructible from key, but not opted in) */
+struct tagged {
+    int key;  /**< Key */
+    int tag;  /**< Tag */
+
+    /** Default constructor */
+    tagged(): key(0), tag(0) {}
+
+    /** Constructor */
+    tagged(int k): key(k), tag(-1) {}
+
+};  // end of struct tagged
+
+/** Tagged item key accessor */
+class tagged_key_fn {
+    public:
+
+    inline int operator () (const tagged & item) const { return item.key; }
+
+};  // end of class tagged_key_fn
+
+/** Tagged item hash table */
+typedef libaccl::hash::linear<
+        tagged,
+        counter_hash_fn_t,
+        int,
+        tagged_key_fn>
+    tagged_hashtab_t;
+
+
+/**
+ *  \brief  New item construction test
+ *
+ *  Items are value-initialised by \c operator[] unless constructed
+ *  from key is opted in (see \ref libaccl::hash::key_constructed).
+ */
+static int key_constructed_test() {
+    int error_cnt = 0;
+
+    std::cerr << "Key construction test BEGIN" << std::endl;
+
+    if (!libaccl::hash::key_constructed<counter, int>::value ||
+        libaccl::hash::key_constructed<tagged, int>::value ||
+        !libaccl::hash::key_constructed<int, int>::value)
+    {
+        std::cerr << "Key construction trait mismatch" << std::endl;
+        ++error_cnt;
+    }
+
+    tagged_hashtab_t tagged_tab(101, {counter_hash_fn});
+    tagged & t = tagged_tab[5];
+    if (0 != t.key || 0 != t.tag) {
+        std::cerr << "New item not value-initialised" << std::endl;
+        ++error_cnt;
+    }
+    t.key = 5;  // the caller sets the key
+
+    if (0 > tagged_tab.find(5) || 1 != tagged_tab.item_cnt()) {
+        std::cerr << "Value-initialised item not found" << std::endl;
+        ++error_cnt;
+    }
+
+    counter_hashtab_t counter_tab(101, {counter_hash_fn});
+    if (7 != counter_tab[7].key || 0 > counter_tab.find(7)) {
+        std::cerr << "New item not constructed from key" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr << "Key construction test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Move-only hash table item (counts live instances) */
+struct movable {
+    static int live;              /**< Live instances */
+
+    int                  key;     /**< Key            */
+    std::unique_ptr<int> value;   /**< Value          */
+
+    /** Constructor (no default constructor) */
+    movable(int k, int v): key(k), value(new int(v)) { ++live; }
+
+    /** Move constructor */
+    movable(movable && orig):
+        key(orig.key), value(std::move(orig.value))
+    {
+        ++live;
+    }
+
+    /** Destructor */
+    ~movable() { --live; }
+
+};  // end of struct movable
+
+int movable::live = 0;
+
+/** Move-only item key accessor */
+class movable_key_fn {
+    public:
+
+    inline int operator () (const movable & item) const { return item.key; }
+
+};  // end of class movable_key_fn
+
+/** Move-only item hash table */
+typedef libaccl::hash::linear<
+        movable,
+        counter_hash_fn_t,
+        int,
+        movable_key_fn>
+    movable_hashtab_t;
+
+
+/**
+ *  \brief  Move-only items test
+ *
+ *  \param  size   Initial table size
+ *  \param  items  Item count
+ */
+static int movable_hashtab_test(size_t size, int items) {
+    int error_cnt = 0;
+
+    std::cerr << "Move-only items test BEGIN" << std::endl;
+
+    {
+        movable_hashtab_t tab(size, {counter_hash_fn});
+        tab.set_growth(2.0);
+
+        for (int i = 0; i < items; ++i) {
+            ssize_t index = i % 2
+                ? tab.emplace(i, i, 2 * i)
+                : tab.insert(movable(i, 2 * i));
+
+            if (0 > index) {
+                std::cerr << "Failed to insert " << i << std::endl;
+                ++error_cnt;
+            }
+        }
+
+        movable dup(0, -1);
+        if (0 <= tab.insert(std::move(dup)) || 0 <= tab.emplace(1, 1, -1)) {
+            std::cerr << "Duplicate inserted" << std::endl;
+            ++error_cnt;
+        }
+
+        if (!dup.value) {
+            std::cerr << "Rejected item moved from" << std::endl;
+            ++error_cnt;
+        }
+
+        for (int i = 0; i < items; i += 3) tab.erase(i);
+
+        if (movable::live != (int)tab.item_cnt() + 1) {
+            std::cerr
+                << "Live items: " << movable::live
+                << ", expected " << tab.item_cnt() + 1 << std::endl;
+            ++error_cnt;
+        }
+
+        for (int i = 0; i < items; ++i) {
+            ssize_t index = tab.find(i);
+
+            if (i % 3 ? 0 > index || 2 * i != *tab.at(index).value
+                      : 0 <= index)
+            {
+                std::cerr << "Item " << i << " mismatch" << std::endl;
+                ++error_cnt;
+            }
+        }
+
+        std::cerr
+            << "Size: " << tab.size()
+            << ", items: " << tab.item_cnt() << std::endl;
+    }
+
+    if (0 != movable::live) {
+        std::cerr << "Items leaked: " << movable::live << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr << "Move-only items test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Colliding hash function (all keys share the probe path) */
+static size_t collide_hash_fn(int , size_t ) { return 0; }
+
+
+/**
+ *  \brief  Re-insertion after erasure test
+ *
+ *  Keys stored after a slot freed by erasure must not be inserted
+ *  again (to the available slot).
+ */
+static int tombstone_hashtab_test() {
+    int error_cnt = 0;
+
+    std::cerr << "Re-insertion after erasure test BEGIN" << std::endl;
+
+    growing_hashtab_t tab(16, {collide_hash_fn});
+    for (int i = 1; i <= 3; ++i) tab.insert(i);
+
+    tab.erase(1);
+
+    if (0 <= tab.insert(3) || 2 != tab.item_cnt()) {
+        std::cerr << "Duplicate inserted" << std::endl;
+        ++error_cnt;
+    }
+
+    tab.erase(3);
+
+    if (tab.exists(3)) {
+        std::cerr << "Erased item exists" << std::endl;
+        ++error_cnt;
+    }
+
+    movable_hashtab_t mtab(16, {collide_hash_fn});
+    for (int i = 1; i <= 3; ++i) mtab.emplace(i, i, i);
+
+    mtab.erase(1);
+
+    if (0 <= mtab.emplace(2, 2, -1) || 2 != mtab.item_cnt()) {
+        std::cerr << "Duplicate emplaced" << std::endl;
+        ++error_cnt;
+    }
+
+    if (0 > mtab.emplace(1, 1, 1) || 3 != mtab.item_cnt()) {
+        std::cerr << "Failed to re-insert erased item" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr << "Re-insertion after erasure test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Wrapping hash function (all keys start 3 slots before the table end) */
+static size_t wrap_hash_fn(int , size_t size) { return size - 3; }
+
+
+/**
+ *  \brief  Control bytes group probing test
+ *
+ *  Covers the group matching corner cases: different keys sharing
+ *  the 7-bit fingerprint, collision string wrapping past the table end
+ *  (with less than a group of control bytes left) and available slots
+ *  inside a matched group.
+ */
+static int ctrl_group_hashtab_test() {
+    int error_cnt = 0;
+
+    std::cerr << "Control bytes group probing test BEGIN" << std::endl;
+
+    // Keys sharing fingerprint (different primary hashes)
+    const libaccl::hash::impl::hash_fns<int_hash_fn_t> fns({int_hash_fn});
+    const uint8_t fp = libaccl::hash::impl::fingerprint(fns, 0);
+
+    std::vector<int> keys;
+    for (int k = 0; keys.size() < 24; ++k)
+        if (fp == libaccl::hash::impl::fingerprint(fns, k))
+            keys.push_back(k);
+
+    growing_hashtab_t fp_tab(32, {int_hash_fn}, 28);
+    for (size_t i = 0; i < keys.size(); i += 2) fp_tab.insert(keys[i]);
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const ssize_t index = fp_tab.find(keys[i]);
+
+        if (i % 2 ? 0 <= index : 0 > index || keys[i] != fp_tab.at(index)) {
+            std::cerr
+                << "Fingerprint collision: key " << keys[i]
+                << " mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    for (size_t i = 1; i < keys.size(); i += 2)
+        if (0 > fp_tab.insert(keys[i])) {
+            std::cerr
+                << "Fingerprint collision: key " << keys[i]
+                << " not inserted" << std::endl;
+            ++error_cnt;
+        }
+
+    if (fp_tab.item_cnt() != keys.size()) {
+        std::cerr
+            << "Fingerprint collision: " << fp_tab.item_cnt()
+            << " items, expected " << keys.size() << std::endl;
+        ++error_cnt;
+    }
+
+    // Collision string wrapping past the table end (size isn't
+    // a multiple of group size, so the string ends by a partial group)
+    growing_hashtab_t wrap_tab(21, {wrap_hash_fn}, 20);
+    for (int i = 0; i < 19; ++i) {
+        const ssize_t index = wrap_tab.insert(i);
+
+        if ((ssize_t)((18 + i) % 21) != index) {
+            std::cerr
+                << "Wrapped string: key " << i << " at " << index
+                << ", expected " << (18 + i) % 21 << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    wrap_tab.erase(1);   // slot 19 (before the table end)
+    wrap_tab.erase(17);  // slot 14 (in the first group)
+
+    for (int i = 0; i < 20; ++i)
+        if (wrap_tab.exists(i) != (i < 19 && 1 != i && 17 != i)) {
+            std::cerr << "Wrapped string: key " << i << " mismatch" << std::endl;
+            ++error_cnt;
+        }
+
+    if (0 <= wrap_tab.insert(18) || 19 != wrap_tab.insert(19)) {
+        std::cerr << "Wrapped string: insertion mismatch" << std::endl;
+        ++error_cnt;
+    }
+
+    // Available slots inside a matched group
+    growing_hashtab_t avail_tab(64, {collide_hash_fn});
+    for (int i = 0; i < 16; ++i) avail_tab.insert(i);
+    for (int i = 0; i < 16; i += 2) avail_tab.erase(i);
+
+    for (int i = 0; i < 16; ++i)
+        if (avail_tab.exists(i) != (i % 2)) {
+            std::cerr << "Available slots: key " << i << " mismatch" << std::endl;
+            ++error_cnt;
+        }
+
+    for (int i = 1; i < 16; i += 2)
+        if (0 <= avail_tab.insert(i)) {
+            std::cerr << "Available slots: key " << i << " duplicated" << std::endl;
+            ++error_cnt;
+        }
+
+    if (0 != avail_tab.insert(100) || 2 != avail_tab.insert(101)
+    ||  10 != avail_tab.item_cnt())
+    {
+        std::cerr << "Available slots: insertion mismatch" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr << "Control bytes group probing test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Item with failing or stalling copy (on demand) */
+struct fragile {
+    static bool              fail;     /**< Copy fails                */
+    static std::atomic<bool> stall;    /**< Next copy stalls          */
+    static std::atomic<bool> stalled;  /**< Copy is stalled           */
+    static std::atomic<bool> resume;   /**< Stalled copy may proceed  */
+
+    int key;  /**< Key */
+
+    /** Constructor */
+    fragile(int k = 0): key(k) {}
+
+    /** Copy constructor */
+    fragile(const fragile & orig): key(orig.key) {}
+
+    /** Copy assignment (throws if copying fails) */
+    fragile & operator = (const fragile & orig) {
+        if (fail) throw std::runtime_error("fragile: copy failed");
+
+        if (stall.exchange(false)) {
+            stalled = true;
+            while (!resume) std::this_thread::yield();
+        }
+
+        key = orig.key;
+        return *this;
+    }
+
+};  // end of struct fragile
+
+bool              fragile::fail    = false;
+std::atomic<bool> fragile::stall(false);
+std::atomic<bool> fragile::stalled(false);
+std::atomic<bool> fragile::resume(false);
+
+/** Fragile item key accessor */
+class fragile_key_fn {
+    public:
+
+    inline int operator () (const fragile & item) const { return item.key; }
+
+};  // end of class fragile_key_fn
+
+/** Concurrent hash table of fragile items */
+typedef libaccl::hash::linear_concurrent<
+        fragile,
+        counter_hash_fn_t,
+        int,
+        fragile_key_fn>
+    fragile_hashtab_t;
+
+
+/**
+ *  \brief  Failed concurrent insertion test
+ *
+ *  Item that failed to be written must not block re-insertion
+ *  of the key; its record is reclaimed by compaction.
+ */
+static int concurrent_exception_test() {
+    int error_cnt = 0;
+
+    std::cerr << "Failed concurrent insertion test BEGIN" << std::endl;
+
+    // Leaked if the re-insertion hangs (the thread is detached)
+    fragile_hashtab_t * tab = new fragile_hashtab_t(16, {collide_hash_fn});
+
+    fragile::fail = true;
+    try {
+        tab->insert(fragile(1));
+
+        std::cerr << "Copy failure not propagated" << std::endl;
+        ++error_cnt;
+    }
+    catch (const std::runtime_error & ) {}
+    fragile::fail = false;
+
+    if (tab->exists(1) || 0 != tab->item_cnt() || 1 != tab->avail_cnt()) {
+        std::cerr << "Failed item inserted" << std::endl;
+        ++error_cnt;
+    }
+
+    std::shared_ptr<std::atomic<ssize_t> > index(
+        new std::atomic<ssize_t>(-2));
+    std::thread reinsert([tab, index]() {
+        index->store(tab->insert(fragile(1)));
+    });
+
+    for (int i = 0; i < 500 && -2 == index->load(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (-2 == index->load()) {
+        reinsert.detach();
+
+        std::cerr << "Re-insertion of failed item hangs" << std::endl;
+        return ++error_cnt;
+    }
+
+    reinsert.join();
+
+    if (0 > index->load() || !tab->exists(1) || 1 != tab->item_cnt()) {
+        std::cerr << "Failed to re-insert failed item" << std::endl;
+        ++error_cnt;
+    }
+
+    tab->compact();
+
+    if (0 != tab->avail_cnt() || 1 != tab->item_cnt() || !tab->exists(1)) {
+        std::cerr << "Failed item record not reclaimed" << std::endl;
+        ++error_cnt;
+    }
+
+    delete tab;
+
+    std::cerr << "Failed concurrent insertion test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Stalled concurrent insertion test
+ *
+ *  Inserter must not wait for another inserter of the same key stalled
+ *  while writing the item (lock-freedom); the item published 1st wins.
+ */
+static int concurrent_stall_test() {
+    int error_cnt = 0;
+
+    std::cerr << "Stalled concurrent insertion test BEGIN" << std::endl;
+
+    fragile_hashtab_t tab(16, {collide_hash_fn});
+
+    std::atomic<ssize_t> first(-2), second(-2);
+
+    fragile::stall   = true;
+    fragile::stalled = false;
+    fragile::resume  = false;
+    std::thread stalled([&tab, &first]() {
+        first.store(tab.insert(fragile(1)));
+    });
+
+    while (!fragile::stalled) std::this_thread::yield();
+
+    std::thread other([&tab, &second]() {
+        second.store(tab.insert(fragile(1)));
+    });
+
+    for (int i = 0; i < 500 && -2 == second.load(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (-2 == second.load()) {
+        std::cerr << "Inserter waits for stalled one" << std::endl;
+        ++error_cnt;
+    }
+
+    fragile::resume = true;
+    stalled.join();
+    other.join();
+
+    if (0 > second.load() || -1 != first.load() || 1 != tab.item_cnt()) {
+        std::cerr
+            << "Unexpected insertion results: " << first.load() << ", "
+            << second.load() << " (" << tab.item_cnt() << " items)"
+            << std::endl;
+        ++error_cnt;
+    }
+
+    if (1 != tab.avail_cnt()) {
+        std::cerr << "Lost item record not accounted" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr << "Stalled concurrent insertion test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Concurrent table compaction test
+ *
+ *  Records of erased items count in the table capacity until compaction.
+ *
+ *  \param  size  Table size
+ */
+static int concurrent_compact_test(size_t size) {
+    int error_cnt = 0;
+
+    std::cerr << "Concurrent table compaction test BEGIN" << std::endl;
+
+    concurrent_hashtab_t tab(size, {counter_hash_fn});
+    const int keys = tab.capacity();
+
+    for (int k = 0; k < keys; ++k) tab[k].count = k;
+    for (int k = 0; k < keys; k += 2) tab.erase(k);
+
+    if ((size_t)(keys + 1) / 2 != tab.avail_cnt()
+    ||  0 <= tab.insert(counter(keys)))
+    {
+        std::cerr << "Erased item records not accounted" << std::endl;
+        ++error_cnt;
+    }
+
+    tab.compact();
+
+    if (0 != tab.avail_cnt() || (size_t)keys / 2 != tab.item_cnt()) {
+        std::cerr << "Erased item records not reclaimed" << std::endl;
+        ++error_cnt;
+    }
+
+    for (int k = 0; k < keys; ++k) {
+        const ssize_t index = tab.find(k);
+
+        if ((0 <= index) != (1 == k % 2)
+        ||  (0 <= index && (unsigned)k != tab.at(index).count))
+        {
+            std::cerr << "Key " << k << " compaction mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    for (int k = keys; k < keys + (keys + 1) / 2; ++k)
+        if (0 > tab.insert(counter(k))) {
+            std::cerr << "Failed to insert key " << k << std::endl;
+            ++error_cnt;
+            break;
+        }
+
+    std::cerr << "Concurrent table compaction test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Compaction test
+ *
+ *  Compaction must keep the table capacity (no load factor rounding).
+ *
+ *  \param  size      Table size
+ *  \param  capacity  Table capacity
+ */
+static int compact_hashtab_test(size_t size, size_t capacity) {
+    int error_cnt = 0;
+
+    std::cerr << "Compaction test BEGIN" << std::endl;
+
+    growing_hashtab_t tab(size, {int_hash_fn}, capacity);
+    for (int i = 0; i < (int)capacity; ++i) tab.insert(i);
+    for (int i = 0; i < (int)capacity; i += 2) tab.erase(i);
+
+    for (int round = 0; round < 3; ++round) {
+        tab.compact();
+
+        if (tab.size() != size || tab.capacity() != capacity) {
+            std::cerr
+                << "Compacted table size " << tab.size() << ", capacity "
+                << tab.capacity() << " != " << size << ", " << capacity
+                << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    for (int i = 0; i < (int)capacity; ++i)
+        if (tab.exists(i) == !(i % 2)) {
+            std::cerr << "Item " << i << " mismatch" << std::endl;
+            ++error_cnt;
+        }
+
+    std::cerr << "Compaction test END" << std::endl;
+
+    return error_cnt;
+}
+
+
 /** Unit test */
 static int main_impl(int argc, char * const argv[]) {
     int exit_code = 64;  // pessimistic assumption
@@ -160,7 +1309,51 @@ static int main_impl(int argc, char * const argv[]) {
     if (argc > 1) size = ::atoi(argv[1]);
 
     do {  // pragmatic do ... while (0) loop allowing for breaks
-        exit_code = hashtab_test(size);
+        hashtab_t tab(size, {primary_hash_fn, secondary_hash_fn});
+        exit_code = hashtab_test(tab);
+        if (0 != exit_code) break;
+
+        chain_hashtab_t chain_tab(size, {});
+        exit_code = hashtab_test(chain_tab);
+        if (0 != exit_code) break;
+
+        exit_code = growing_hashtab_test(7, 10000);
+        if (0 != exit_code) break;
+
+        exit_code = pow2_hashtab_test(1000, 5000);
+        if (0 != exit_code) break;
+
+        exit_code = stats_hashtab_test(1000, 800);
+        if (0 != exit_code) break;
+
+        exit_code = batch_hashtab_test(size);
+        if (0 != exit_code) break;
+
+        exit_code = movable_hashtab_test(7, 10000);
+        if (0 != exit_code) break;
+
+        exit_code = key_constructed_test();
+        if (0 != exit_code) break;
+
+        exit_code = tombstone_hashtab_test();
+        if (0 != exit_code) break;
+
+        exit_code = ctrl_group_hashtab_test();
+        if (0 != exit_code) break;
+
+        exit_code = compact_hashtab_test(282, 239);
+        if (0 != exit_code) break;
+
+        exit_code = concurrent_hashtab_test(size, 4);
+        if (0 != exit_code) break;
+
+        exit_code = concurrent_exception_test();
+        if (0 != exit_code) break;
+
+        exit_code = concurrent_stall_test();
+        if (0 != exit_code) break;
+
+        exit_code = concurrent_compact_test(size);
         if (0 != exit_code) break;
 
     } while (0);  // end of pragmatic loop
@@ -0,0 +1,326 @@
+/**
+ *  \file
+ *  \brief  Memory-mapped linear hashtable unit test
+ *
+ *  \date   2016/01/10
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libaccl/hash/linear_mapped.hxx>
+
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+
+/** Hash table item (trivially copyable) */
+struct cell {
+    int      key;    /**< Key   */
+    unsigned count;  /**< Count */
+
+    /** New items are constructed from key (see hash::key_constructed) */
+    typedef std::true_type key_constructed;
+
+    /** Default constructor */
+    cell(): key(0), count(0) {}
+
+    /** Constructor */
+    cell(int k): key(k), count(0) {}
+
+};  // end of struct cell
+
+/** Cell key accessor */
+class cell_key_fn {
+    public:
+
+    inline int operator () (const cell & item) const { return item.key; }
+
+};  // end of class cell_key_fn
+
+/** Hash functions chain */
+typedef libaccl::hash::chain<
+        libaccl::hash::int_hash<int>,
+        libaccl::hash::int_hash<int> >
+    hash_chain_t;
+
+/** Hash table */
+typedef libaccl::hash::linear<cell, hash_chain_t, int, cell_key_fn> hashtab_t;
+
+/** Mapped hash table */
+typedef libaccl::hash::linear_mapped<cell, hash_chain_t, int, cell_key_fn>
+    mapped_hashtab_t;
+
+/** Hash function (for a mismatching table) */
+typedef size_t (*int_hash_fn_t)(int, size_t);
+
+/** Mismatching mapped table (single hash function) */
+typedef libaccl::hash::linear_mapped<cell, int_hash_fn_t, int, cell_key_fn>
+    other_mapped_hashtab_t;
+
+/** Mismatching hash function */
+static size_t int_hash_fn(int key, size_t size) {
+    return (size_t)key % size;
+}
+
+
+/**
+ *  \brief  Compare mapped table with the original
+ *
+ *  \param  tab     Table
+ *  \param  mapped  Mapped table
+ *  \param  keys    Key range
+ */
+static int compare(
+    const hashtab_t        & tab,
+    const mapped_hashtab_t & mapped,
+    int                      keys)
+{
+    int error_cnt = 0;
+
+    if (tab.size()     != mapped.size()     ||
+        tab.capacity() != mapped.capacity() ||
+        tab.item_cnt() != mapped.item_cnt())
+    {
+        std::cerr
+            << "Mapped table size " << mapped.size()
+            << ", capacity " << mapped.capacity()
+            << ", items " << mapped.item_cnt()
+            << " mismatch" << std::endl;
+        ++error_cnt;
+    }
+
+    for (int k = -keys; k < keys; ++k) {
+        const ssize_t index = tab.find(k);
+
+        if (0 > index) {
+            if (mapped.exists(k)) {
+                std::cerr << "Key " << k << " unexpectedly found" << std::endl;
+                ++error_cnt;
+            }
+
+            continue;
+        }
+
+        const ssize_t mapped_ix = mapped.find(k);
+
+        if (0 > mapped_ix) {
+            std::cerr << "Key " << k << " not found" << std::endl;
+            ++error_cnt;
+        }
+        else if (mapped.at(mapped_ix).key   != k ||
+                 mapped.at(mapped_ix).count != tab.at(index).count)
+        {
+            std::cerr << "Key " << k << " item mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Mapped table test
+ *
+ *  \param  file   Table file
+ *  \param  size   Initial table size
+ *  \param  items  Item count
+ */
+static int mapped_hashtab_test(const std::string & file, size_t size, int items) {
+    int error_cnt = 0;
+
+    std::cerr << "Mapped hash table test BEGIN" << std::endl;
+
+    hashtab_t tab(size, {});
+    tab.set_growth(2.0);
+
+    for (int i = 0; i < items; ++i) tab[i].count = 3 * i;
+    for (int i = 0; i < items; i += 5) tab.erase(i);  // leave tombstones
+
+    // Save while rehashing
+    int keys = items;
+    for (; !tab.rehashing(); ++keys) tab[keys].count = 3 * keys;
+
+    std::cerr
+        << "Table size: " << tab.size()
+        << ", items: " << tab.item_cnt()
+        << ", rehashing: " << tab.rehashing() << std::endl;
+
+    mapped_hashtab_t::save(tab, file);
+
+    tab.rehash();  // the saved table was rehashed on a copy
+
+    {
+        mapped_hashtab_t mapped(file, {});
+        error_cnt += compare(tab, mapped, keys);
+    }
+
+    // Fixed size table (no growth)
+    hashtab_t fixed(size, {});
+    for (int i = 0; i < items; i += 2) fixed.insert(cell(i));
+
+    mapped_hashtab_t::save(fixed, file);
+
+    {
+        mapped_hashtab_t mapped(file, {});
+        error_cnt += compare(fixed, mapped, items);
+
+        mapped_hashtab_t moved(std::move(mapped));
+        error_cnt += compare(fixed, moved, items);
+    }
+
+    // Mismatching view must be refused
+    try {
+        other_mapped_hashtab_t other(file, {int_hash_fn});
+
+        std::cerr << "Mismatching table mapped" << std::endl;
+        ++error_cnt;
+    }
+    catch (const std::runtime_error & x) {
+        std::cerr << "Mismatch refused: " << x.what() << std::endl;
+    }
+
+    // Corrupt headers must be refused
+    std::string image;
+    {
+        std::ifstream in(file.c_str(), std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>());
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        libaccl::hash::impl::mapped_header hdr;
+        ::memcpy(&hdr, image.data(), sizeof(hdr));
+
+        switch (c) {
+            case 0:  // sections wrap around (sums overflow to valid values)
+                hdr.size       += (uint64_t)1 << 61;
+                hdr.ctrl_offset = (uint64_t)7 << 61;
+                break;
+
+            case 1:  // probe longer than the table
+                hdr.max_probe = hdr.size + 1;
+                break;
+
+            case 2:  // empty table
+                hdr.size = hdr.capacity = hdr.item_cnt = hdr.max_probe = 0;
+                break;
+        }
+
+        std::string corrupt(image);
+        ::memcpy(&corrupt[0], &hdr, sizeof(hdr));
+        std::ofstream(file.c_str(), std::ios::binary | std::ios::trunc)
+            << corrupt;
+
+        try {
+            mapped_hashtab_t bad(file, {});
+
+            std::cerr << "Corrupt header " << c << " mapped" << std::endl;
+            ++error_cnt;
+        }
+        catch (const std::runtime_error & x) {
+            std::cerr << "Corrupt header refused: " << x.what() << std::endl;
+        }
+    }
+
+    // Truncated file must be refused
+    std::ofstream(file.c_str(), std::ios::binary | std::ios::trunc) << "junk";
+
+    try {
+        mapped_hashtab_t junk(file, {});
+
+        std::cerr << "Junk file mapped" << std::endl;
+        ++error_cnt;
+    }
+    catch (const std::runtime_error & x) {
+        std::cerr << "Junk refused: " << x.what() << std::endl;
+    }
+
+    ::remove(file.c_str());
+
+    std::cerr << "Mapped hash table test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Unit test */
+static int main_impl(int argc, char * const argv[]) {
+    int exit_code = 64;  // pessimistic assumption
+
+    std::string file = "linear_mapped.tab";  // table file
+    if (argc > 1) file = argv[1];
+
+    do {  // pragmatic do ... while (0) loop allowing for breaks
+        exit_code = mapped_hashtab_test(file, 64, 10000);
+        if (0 != exit_code) break;
+
+    } while (0);  // end of pragmatic loop
+
+    std::cerr
+        << "Exit code: " << exit_code
+        << std::endl;
+
+    return exit_code;
+}
+
+/** Unit test exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,3 @@
+#!/bin/sh
+
+./linear_mapped
@@ -0,0 +1,365 @@
+/**
+ *  \file
+ *  \brief  Multi-resolution accumulator unit test
+ *
+ *  \date   2016/01/13
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libaccl/multires.hxx>
+#include <libaccl/accumulator.hxx>
+#include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/pattern/kernel.hxx>
+
+#include <vector>
+#include <array>
+#include <set>
+#include <algorithm>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+
+
+/** Point assignment */
+static void assign(std::vector<int> & point, const std::vector<int> & x) {
+    point = x;
+}
+
+/** Point assignment */
+template <size_t N>
+static void assign(std::array<int, N> & point, const std::vector<int> & x) {
+    std::copy(x.begin(), x.end(), point.begin());
+}
+
+
+/**
+ *  \brief  Multi-resolution accumulator test
+ *
+ *  Samples are placed on hyperspheres around cluster centres (plus noise);
+ *  the finest level must find the centres and its cells must have
+ *  the same votes as cells of the full resolution accumulator.
+ *
+ *  \tparam N       Space dimension (0 means runtime)
+ *  \param  dim     Space dimension
+ *  \param  radius  Hypersphere radius
+ *  \param  levels  Number of levels
+ *  \param  factor  Cell edge ratio of neighbouring levels
+ */
+template <size_t N>
+static int multires_test(size_t dim, int radius, size_t levels, int factor) {
+    std::cerr
+        << "Multi-resolution accumulator test (dimension " << dim
+        << ", radius " << radius << ", " << levels << " levels, factor "
+        << factor << ") BEGIN"
+        << std::endl;
+
+    typedef libaccl::multires<int, unsigned, N>    multires_t;
+    typedef libaccl::accumulator<int, unsigned, N> accumulator_t;
+    typedef typename multires_t::point_t           point_t;
+
+    int error_cnt = 0;
+
+    libaccl::pattern::hypersphere<int, N>      sphere(dim, {radius});
+    libaccl::pattern::kernel<int, unsigned, N> kernel(sphere);
+
+    // Cluster centres
+    std::vector<std::vector<int> > centres;
+    for (size_t i = 0; i < 3; ++i) {
+        std::vector<int> c(dim);
+        for (size_t d = 0; d < dim; ++d)
+            c[d] = (int)((i * 7 + d * 3) % 5) * radius - 2 * radius;
+
+        centres.push_back(c);
+    }
+
+    // Samples (cluster points + noise)
+    std::vector<int> samples;
+    for (size_t i = 0; i < centres.size(); ++i)
+        for (auto x = sphere.begin(); x != sphere.end(); ++x)
+            for (size_t d = 0; d < dim; ++d)
+                samples.push_back(centres[i][d] + x->first[d]);
+
+    unsigned seed = 4321;
+    for (size_t i = 0; i < sphere.size() / 2; ++i)
+        for (size_t d = 0; d < dim; ++d) {
+            seed = seed * 1103515245 + 12345;
+            samples.push_back((int)(seed >> 16) % (6 * radius) - 3 * radius);
+        }
+
+    const size_t count = samples.size() / dim;
+    const unsigned threshold = sphere.size() / 2;
+
+    multires_t acc(dim, {radius}, levels, factor, threshold, 1024, 0, 2.0);
+    acc.vote(samples.data(), count);
+
+    try {
+        acc.vote(samples.data(), count);
+
+        std::cerr << "Repeated voting not refused" << std::endl;
+        ++error_cnt;
+    }
+    catch (const std::logic_error & ) {}
+
+    accumulator_t full(kernel, 1024, 0, 2.0);
+    full.vote(samples.data(), count);
+
+    for (size_t l = 0; l < acc.levels(); ++l)
+        std::cout
+            << "Level " << l << " (scale " << acc.scale(l) << "): "
+            << acc.level(l).size() << " cells, "
+            << acc.votes(l) << " votes" << std::endl;
+
+    std::cout
+        << "Full resolution: " << full.size() << " cells, "
+        << count * kernel.size() << " votes" << std::endl;
+
+    if (!(acc.votes(levels - 1) < count * kernel.size())) {
+        std::cerr << "Finest level votes not reduced" << std::endl;
+        ++error_cnt;
+    }
+
+    // Finest level cells have the full resolution votes
+    size_t mismatch = 0;
+    acc.finest().for_each(
+    [&full, &mismatch](const point_t & point, unsigned count) {
+        if (full.count(point) != count) ++mismatch;
+    });
+
+    if (mismatch) {
+        std::cerr << mismatch << " cells vote count mismatch" << std::endl;
+        ++error_cnt;
+    }
+
+    // Full resolution cells in refined regions have the votes, too
+    if (1 < levels) {
+        const auto & parent = acc.level(levels - 2);
+        const int    ratio  = acc.scale(levels - 2);
+
+        size_t missing = 0;
+        full.for_each(
+        [&acc, &parent, ratio, &missing](const point_t & point, unsigned count) {
+            point_t p = point;
+            for (size_t d = 0; d < p.size(); ++d)
+                p[d] = (p[d] - (p[d] < 0 ? ratio - 1 : 0)) / ratio;
+
+            if (parent.count(p) && acc.count(point) != count) ++missing;
+        });
+
+        if (missing) {
+            std::cerr << missing << " refined cells miss votes" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    // Cluster centres are the top peaks
+    auto peaks = acc.peaks(threshold, centres.size());
+    auto ref   = full.peaks(threshold, centres.size());
+
+    for (size_t i = 0; i < centres.size(); ++i) {
+        point_t c; assign(c, centres[i]);
+
+        if (acc.count(c) < sphere.size()) {
+            std::cerr
+                << "Centre " << i << " vote count mismatch: "
+                << acc.count(c) << " < " << sphere.size() << std::endl;
+
+            ++error_cnt;
+        }
+
+        auto peak = std::find_if(peaks.begin(), peaks.end(),
+        [&c](const typename multires_t::peaks_t::value_type & p) {
+            return p.point == c;
+        });
+
+        if (peaks.end() == peak) {
+            std::cerr << "Centre " << i << " is not a peak" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    if (peaks.size() != ref.size()) {
+        std::cerr
+            << "Peak count mismatch: " << peaks.size()
+            << " != " << ref.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    std::cerr
+        << "Multi-resolution accumulator test (dimension " << dim
+        << ", radius " << radius << ", " << levels << " levels, factor "
+        << factor << ") END"
+        << std::endl;
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Coarse kernel coverage test
+ *
+ *  Every coarse cell a full resolution kernel point may fall to
+ *  (for any sample position within the coarse cell) must be
+ *  in the level kernel; otherwise, coarse counts are too low
+ *  and pruning may drop real clusters.
+ *
+ *  \tparam N       Space dimension (0 means runtime)
+ *  \param  dim     Space dimension
+ *  \param  radius  Hypersphere radius
+ *  \param  levels  Number of levels
+ *  \param  factor  Cell edge ratio of neighbouring levels
+ */
+template <size_t N>
+static int coverage_test(size_t dim, int radius, size_t levels, int factor) {
+    std::cerr
+        << "Coarse kernel coverage test (dimension " << dim
+        << ", radius " << radius << ", " << levels << " levels, factor "
+        << factor << ") BEGIN"
+        << std::endl;
+
+    typedef libaccl::multires<int, unsigned, N> multires_t;
+
+    int error_cnt = 0;
+
+    libaccl::pattern::hypersphere<int, N>      sphere(dim, {radius});
+    libaccl::pattern::kernel<int, unsigned, N> kernel(sphere);
+
+    multires_t acc(dim, {radius}, levels, factor, 1, 1024, 0, 2.0);
+
+    for (size_t l = 0; l + 1 < acc.levels(); ++l) {
+        const int    scale = acc.scale(l);
+        const auto & coarse = acc.level(l).kernel();
+
+        std::set<std::vector<int> > cells;
+        for (size_t i = 0; i < coarse.size(); ++i)
+            cells.emplace(coarse.offset(i), coarse.offset(i) + dim);
+
+        // All sample residues (modulo scale)
+        size_t residues = 1;
+        for (size_t d = 0; d < dim; ++d) residues *= scale;
+
+        size_t missing = 0;
+        std::vector<int> cell(dim);
+        for (size_t r = 0; r < residues; ++r)
+            for (size_t i = 0; i < kernel.size(); ++i) {
+                size_t rest = r;
+                for (size_t d = 0; d < dim; ++d, rest /= scale) {
+                    const int x = (int)(rest % scale) + kernel.offset(i)[d];
+                    cell[d] = (x - (x < 0 ? scale - 1 : 0)) / scale;
+                }
+
+                if (!cells.count(cell)) ++missing;
+            }
+
+        if (missing) {
+            std::cerr
+                << "Level " << l << " (scale " << scale << ") kernel misses "
+                << missing << " of " << residues * kernel.size()
+                << " displacements" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    std::cerr
+        << "Coarse kernel coverage test (dimension " << dim
+        << ", radius " << radius << ", " << levels << " levels, factor "
+        << factor << ") END"
+        << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Unit test */
+static int main_impl(int argc, char * const argv[]) {
+    int exit_code = 64;  // pessimistic assumption
+
+    int radius = 16;  // hypersphere radius
+    if (argc > 1) radius = ::atoi(argv[1]);
+
+    size_t levels = 3;  // number of levels
+    if (argc > 2) levels = ::atoi(argv[2]);
+
+    do {  // pragmatic do ... while (0) loop allowing for breaks
+        exit_code = multires_test<0>(2, radius, levels, 2);
+        if (0 != exit_code) break;
+
+        exit_code = multires_test<2>(2, radius, levels, 2);
+        if (0 != exit_code) break;
+
+        exit_code = multires_test<3>(3, radius / 2, levels - 1, 2);
+        if (0 != exit_code) break;
+
+        exit_code = multires_test<3>(3, 16, 2, 4);
+        if (0 != exit_code) break;
+
+        exit_code = coverage_test<3>(3, 16, 2, 4);
+        exit_code += coverage_test<3>(3, 12, 2, 4);
+        exit_code += coverage_test<0>(4, 8, 2, 2);
+        exit_code += coverage_test<4>(4, 6, 3, 2);
+        if (0 != exit_code) break;
+
+    } while (0);  // end of pragmatic loop
+
+    std::cerr
+        << "Exit code: " << exit_code
+        << std::endl;
+
+    return exit_code;
+}
+
+/** Unit test exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
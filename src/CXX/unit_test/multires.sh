@@ -0,0 +1,4 @@
+#!/bin/sh
+
+./multires && \
+./multires 24 4
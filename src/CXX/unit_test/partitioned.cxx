@@ -0,0 +1,433 @@
+/**
+ *  \file
+ *  \brief  Partitioned accumulator unit test
+ *
+ *  \date   2016/01/18
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <libaccl/accumulator.hxx>
+#include <libaccl/backend/partitioned.hxx>
+#include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/pattern/kernel.hxx>
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+
+/** Pseudo-random samples (2D, row-major) */
+static std::vector<int> samples(size_t count) {
+    std::vector<int> samples;
+    unsigned seed = 54321;
+    for (size_t i = 0; i < 2 * count; ++i) {
+        seed = seed * 1103515245 + 12345;
+        samples.push_back((int)(seed >> 16) % 100 - 50);
+    }
+
+    return samples;
+}
+
+
+/**
+ *  \brief  Exchange batches between all partitions
+ *
+ *  Batches are passed via string streams (like via pipes between
+ *  worker processes).
+ *
+ *  \param  parts  Partitions
+ *  \param  halo   Exchange halo (votes otherwise)
+ *
+ *  \return Number of cells exchanged
+ */
+template <class Accumulator>
+static size_t exchange(std::vector<Accumulator> & parts, bool halo) {
+    size_t cell_cnt = 0;
+
+    for (size_t src = 0; src < parts.size(); ++src)
+        for (size_t dst = 0; dst < parts.size(); ++dst) {
+            if (src == dst) continue;
+
+            std::stringstream pipe;
+            if (halo)
+                parts[src].backend().send_halo(dst, pipe);
+            else
+                parts[src].backend().send(dst, pipe);
+
+            cell_cnt += parts[dst].backend().receive(pipe);
+        }
+
+    return cell_cnt;
+}
+
+
+/**
+ *  \brief  Partitioned voting test
+ *
+ *  Samples are split to partitions; partition cells and union of
+ *  partition peaks must be the same as those of single accumulator.
+ *
+ *  \tparam Accumulator  Partitioned accumulator type
+ *  \tparam Reference    Reference accumulator type
+ *  \param  name         Test name
+ *  \param  kernel       Voting kernel
+ *  \param  part_cnt     Partition count
+ *  \param  block        Block bits
+ *  \param  threads      Voting threads (per partition)
+ */
+template <class Accumulator, class Reference>
+static int partitioned_test(
+    const char *                                  name,
+    const typename Accumulator::kernel_t        & kernel,
+    size_t                                        part_cnt,
+    unsigned                                      block,
+    unsigned                                      threads)
+{
+    typedef typename Accumulator::point_t point_t;
+
+    int error_cnt = 0;
+
+    const std::vector<int> sample = samples(300);
+    const size_t sample_cnt = sample.size() / 2;
+
+    Reference ref(kernel, 40009);
+    ref.vote(sample.data(), sample_cnt);
+
+    std::vector<Accumulator> parts;
+    for (size_t i = 0; i < part_cnt; ++i)
+        parts.emplace_back(kernel, i, part_cnt, 16384, 0, 2.0, block);
+
+    // Each partition votes for its chunk of samples
+    for (size_t i = 0; i < part_cnt; ++i) {
+        const size_t begin = sample_cnt * i / part_cnt;
+        const size_t end   = sample_cnt * (i + 1) / part_cnt;
+        parts[i].vote(sample.data() + 2 * begin, end - begin, threads);
+    }
+
+    const size_t shipped = exchange(parts, false);
+
+    size_t cell_cnt = 0;
+    for (size_t i = 0; i < part_cnt; ++i) {
+        cell_cnt += parts[i].size();
+
+        for (size_t j = 0; j < part_cnt; ++j)
+            if (j != i && parts[i].backend().pending(j)) {
+                std::cerr
+                    << name << ": votes for partition " << j
+                    << " left in partition " << i << std::endl;
+
+                ++error_cnt;
+            }
+    }
+
+    std::cout
+        << name << ": " << cell_cnt << " cells in " << part_cnt
+        << " partitions, " << shipped << " cells shipped" << std::endl;
+
+    if (cell_cnt != ref.size()) {
+        std::cerr
+            << name << ": cell count mismatch: " << cell_cnt
+            << " != " << ref.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    ref.for_each([&](const point_t & point, unsigned count) {
+        const Accumulator & owner =
+            parts[parts[0].backend().owner(point)];
+
+        if (owner.count(point) != count) {
+            std::cerr << name << ": cell vote count mismatch" << std::endl;
+            ++error_cnt;
+        }
+    });
+
+    // Peaks (with halo)
+    for (unsigned threshold = 1; threshold <= 4; threshold += 3) {
+        for (size_t i = 0; i < part_cnt; ++i)
+            parts[i].backend().halo(threshold);
+
+        const size_t halo = exchange(parts, true);
+
+        typename Accumulator::peaks_t peaks;
+        for (size_t i = 0; i < part_cnt; ++i) {
+            const auto part_peaks = parts[i].peaks(threshold, 0, threads);
+            peaks.insert(peaks.end(), part_peaks.begin(), part_peaks.end());
+        }
+
+        std::sort(peaks.begin(), peaks.end());
+
+        const auto ref_peaks = ref.peaks(threshold);
+
+        std::cout
+            << name << ": " << peaks.size() << " peaks over " << threshold
+            << " votes, " << halo << " halo cells" << std::endl;
+
+        bool match = peaks.size() == ref_peaks.size();
+        for (size_t i = 0; match && i < peaks.size(); ++i)
+            match = peaks[i].point == ref_peaks[i].point
+                &&  peaks[i].count == ref_peaks[i].count;
+
+        if (!match) {
+            std::cerr << name << ": peaks mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Checkpoint test
+ *
+ *  Partitions are saved and merged offline (to a single accumulator
+ *  and to a partition of another partitioning).
+ *
+ *  \param  part_cnt  Partition count
+ */
+static int checkpoint_test(size_t part_cnt) {
+    typedef libaccl::backend::partitioned<int, unsigned, 2> backend_t;
+    typedef libaccl::accumulator<int, unsigned, 2, backend_t> partitioned_t;
+    typedef libaccl::accumulator<int, unsigned, 2> sparse_t;
+
+    std::cerr << "Checkpoint test BEGIN" << std::endl;
+
+    int error_cnt = 0;
+
+    libaccl::pattern::hypersphere<int, 2>      circle({4});
+    libaccl::pattern::kernel<int, unsigned, 2> kernel(circle);
+
+    const std::vector<int> sample = samples(200);
+    const size_t sample_cnt = sample.size() / 2;
+
+    std::vector<partitioned_t> parts;
+    for (size_t i = 0; i < part_cnt; ++i) {
+        const size_t begin = sample_cnt * i / part_cnt;
+        const size_t end   = sample_cnt * (i + 1) / part_cnt;
+
+        parts.emplace_back(kernel, i, part_cnt, 4096, 0, 2.0);
+        parts[i].vote(sample.data() + 2 * begin, end - begin);
+    }
+
+    exchange(parts, false);
+
+    // Offline merge
+    sparse_t merged(kernel, 40009);
+    partitioned_t repart(kernel, 0, 2, 4096, 0, 2.0, 2);
+
+    for (size_t i = 0; i < part_cnt; ++i) {
+        std::stringstream file;
+        file << "partitioned-" << i << ".tab";
+
+        parts[i].backend().save(file.str());
+
+        {
+            const auto mapped = backend_t::map(file.str());
+
+            if (mapped.item_cnt() != parts[i].size()) {
+                std::cerr << "Saved partition size mismatch" << std::endl;
+                ++error_cnt;
+            }
+
+            merged.backend().load(mapped);
+            repart.backend().load(mapped);
+        }
+
+        ::remove(file.str().c_str());
+    }
+
+    size_t cell_cnt = 0;
+    for (size_t i = 0; i < part_cnt; ++i) {
+        cell_cnt += parts[i].size();
+
+        parts[i].for_each([&](const sparse_t::point_t & point, unsigned count) {
+            if (merged.count(point) != count) {
+                std::cerr << "Merged cell vote count mismatch" << std::endl;
+                ++error_cnt;
+            }
+        });
+    }
+
+    if (merged.size() != cell_cnt) {
+        std::cerr
+            << "Merged cell count mismatch: " << merged.size()
+            << " != " << cell_cnt << std::endl;
+
+        ++error_cnt;
+    }
+
+    if (repart.size() + repart.backend().pending(1) != cell_cnt) {
+        std::cerr << "Repartitioned cell count mismatch" << std::endl;
+        ++error_cnt;
+    }
+
+    // Malformed batches are refused
+    sparse_t::point_t cell{{0, 0}};
+    while (1 != parts[0].backend().owner(cell)) ++cell[0];
+    parts[0].backend().add(cell, 1);
+
+    std::stringstream pipe;
+    parts[0].backend().send(1, pipe);
+    std::string batch = pipe.str();
+
+    typedef libaccl::backend::impl::batch_header header_t;
+
+    const unsigned votes = parts[1].count(cell);  // not to be changed
+
+    const char * malformed[] = {
+        "truncated", "misdirected", "corrupt", "oversized" };
+    for (size_t i = 0; i < 4; ++i) {
+        std::string data = batch;
+        size_t dst = 1;
+
+        header_t hdr;
+        ::memcpy(&hdr, data.data(), sizeof(hdr));
+        switch (i) {
+            case 0: data.resize(data.size() / 2); break;
+            case 1: dst = 0; break;
+            case 2: data.push_back('\x7f'); ++hdr.payload_size; break;
+            case 3: hdr.payload_size = (uint64_t)1 << 60; break;
+        }
+        if (i >= 2)
+            data.replace(0, sizeof(hdr), (const char *)&hdr, sizeof(hdr));
+
+        try {
+            std::stringstream in(data);
+            parts[dst].backend().receive(in);
+
+            std::cerr << malformed[i] << " batch accepted" << std::endl;
+            ++error_cnt;
+        }
+        catch (const std::runtime_error & ) {}
+
+        if (parts[1].count(cell) != votes) {
+            std::cerr << malformed[i] << " batch partly merged" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    std::stringstream in(batch);  // the intact batch is merged
+    parts[1].backend().receive(in);
+    if (parts[1].count(cell) != votes + 1) {
+        std::cerr << "Batch not merged" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr << "Checkpoint test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Unit test */
+static int main_impl(int argc, char * const argv[]) {
+    int exit_code = 64;  // pessimistic assumption
+
+    int radius = 6;  // pattern radius
+    if (argc > 1) radius = ::atoi(argv[1]);
+
+    typedef libaccl::accumulator<int, unsigned, 2,
+        libaccl::backend::partitioned<int, unsigned, 2> > partitioned_t;
+    typedef libaccl::accumulator<int, unsigned,
+        0, libaccl::backend::partitioned<int, unsigned> > partitioned_rt_t;
+
+    libaccl::pattern::hypersphere<int, 2>      circle({radius});
+    libaccl::pattern::kernel<int, unsigned, 2> kernel(circle);
+
+    libaccl::pattern::hypersphere<int>         circle_rt(2, {radius});
+    libaccl::pattern::kernel<int, unsigned>    kernel_rt(circle_rt);
+
+    do {  // pragmatic do ... while (0) loop allowing for breaks
+        exit_code = partitioned_test<partitioned_t,
+            libaccl::accumulator<int, unsigned, 2> >(
+            "single partition", kernel, 1, 4, 1);
+        if (0 != exit_code) break;
+
+        exit_code = partitioned_test<partitioned_t,
+            libaccl::accumulator<int, unsigned, 2> >(
+            "4 partitions", kernel, 4, 3, 1);
+        if (0 != exit_code) break;
+
+        exit_code = partitioned_test<partitioned_t,
+            libaccl::accumulator<int, unsigned, 2> >(
+            "7 partitions, cell blocks, parallel", kernel, 7, 0, 3);
+        if (0 != exit_code) break;
+
+        exit_code = partitioned_test<partitioned_rt_t,
+            libaccl::accumulator<int, unsigned> >(
+            "3 partitions (runtime dimension)", kernel_rt, 3, 2, 2);
+        if (0 != exit_code) break;
+
+        exit_code = checkpoint_test(3);
+        if (0 != exit_code) break;
+
+    } while (0);  // end of pragmatic loop
+
+    std::cerr
+        << "Exit code: " << exit_code
+        << std::endl;
+
+    return exit_code;
+}
+
+/** Unit test exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
@@ -0,0 +1,201 @@
+/**
+ *  \file
+ *  \brief  Pattern cache unit test
+ *
+ *  \date   2016/01/12
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libaccl/pattern/cache.hxx>
+
+#include <vector>
+#include <thread>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+
+typedef libaccl::pattern::cache<> cache_t;  /**< Hypersphere cache */
+
+
+/**
+ *  \brief  Pattern cache test
+ *
+ *  \param  dimension  Space dimension
+ *  \param  radii      Number of radii
+ *  \param  threads    Thread count
+ */
+static int cache_test(size_t dimension, int radii, unsigned threads) {
+    std::cerr << "Pattern cache test BEGIN" << std::endl;
+
+    int error_cnt = 0;
+
+    cache_t cache((size_t)-1);  // unlimited
+
+    // Precompute radius ladder
+    std::vector<cache_t::layers_t> ladder;
+    for (int r = 1; r <= radii; ++r)
+        ladder.push_back(cache_t::layers_t(1, r));
+
+    cache.precompute(dimension, ladder, threads);
+
+    if ((size_t)radii != cache.size() || (size_t)radii != cache.misses()) {
+        std::cerr
+            << "Precomputed " << cache.size()
+            << " patterns, " << cache.misses() << " built" << std::endl;
+        ++error_cnt;
+    }
+
+    // Concurrent requests of the same patterns
+    std::vector<cache_t::pattern_t> got(threads * radii);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+        pool.emplace_back([&cache, &got, &ladder, dimension, radii, t]() {
+            for (int r = 0; r < radii; ++r)
+                got[t * radii + r] = cache.get(dimension, ladder[r]);
+        });
+
+    for (size_t t = 0; t < pool.size(); ++t) pool[t].join();
+
+    for (unsigned t = 0; t < threads; ++t)
+        for (int r = 0; r < radii; ++r) {
+            const cache_t::pattern_t & p = got[t * radii + r];
+
+            if (p != got[r]) {
+                std::cerr << "Radius " << r + 1 << " not shared" << std::endl;
+                ++error_cnt;
+            }
+
+            const libaccl::pattern::hypersphere<int> sphere(dimension, ladder[r]);
+            if (0 == t && sphere.size() != p->size()) {
+                std::cerr << "Radius " << r + 1 << " size mismatch" << std::endl;
+                ++error_cnt;
+            }
+        }
+
+    if ((size_t)radii != cache.misses()) {
+        std::cerr << "Cached patterns rebuilt" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr
+        << "Patterns: " << cache.size()
+        << ", memory: " << cache.memory()
+        << ", hits: " << cache.hits()
+        << ", misses: " << cache.misses() << std::endl;
+
+    // Budget of the 2 largest patterns: the older ones are evicted
+    const size_t budget =
+        got[radii - 1]->memory() + got[radii - 2]->memory();
+
+    cache.get(dimension, ladder[radii - 2]);  // most recently used
+    cache.get(dimension, ladder[radii - 1]);
+    cache.budget(budget);
+
+    if (2 != cache.size() || budget != cache.memory()) {
+        std::cerr
+            << "Eviction failed: " << cache.size()
+            << " patterns, memory " << cache.memory() << std::endl;
+        ++error_cnt;
+    }
+
+    // Evicted pattern lives on and is rebuilt on demand
+    const size_t misses = cache.misses();
+    const cache_t::pattern_t p = cache.get(dimension, ladder[0]);
+
+    if (p == got[0] || p->size() != got[0]->size()
+    ||  misses + 1 != cache.misses())
+    {
+        std::cerr << "Evicted pattern not rebuilt" << std::endl;
+        ++error_cnt;
+    }
+
+    cache.clear();
+    if (0 != cache.size() || 0 != cache.memory()) {
+        std::cerr << "Cache not cleared" << std::endl;
+        ++error_cnt;
+    }
+
+    std::cerr << "Pattern cache test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Unit test */
+static int main_impl(int argc, char * const argv[]) {
+    int exit_code = 64;  // pessimistic assumption
+
+    size_t dimension = 3;  // pattern dimension
+    if (argc > 1) dimension = ::atoi(argv[1]);
+
+    int radii = 12;  // number of radii
+    if (argc > 2) radii = ::atoi(argv[2]);
+
+    do {  // pragmatic do ... while (0) loop allowing for breaks
+        exit_code = cache_test(dimension, radii, 4);
+        if (0 != exit_code) break;
+
+    } while (0);  // end of pragmatic loop
+
+    std::cerr
+        << "Exit code: " << exit_code
+        << std::endl;
+
+    return exit_code;
+}
+
+/** Unit test exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
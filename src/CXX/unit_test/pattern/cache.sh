@@ -0,0 +1,4 @@
+#!/bin/sh
+
+./cache 3 12 && \
+./cache 2 30
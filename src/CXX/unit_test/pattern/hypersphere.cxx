@@ -40,6 +40,7 @@
 
 
 #include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/arena.hxx>
 
 #include <algorithm>
 #include <iostream>
@@ -115,6 +116,306 @@ static int hypersphere_test(
 }
 
 
+/** Hypersphere points generator test (compares with stored points) */
+static int hypersphere_generate_test(
+    size_t                   dimension,
+    const std::vector<int> & layers)
+{
+    std::cerr << "Hypersphere generator test BEGIN" << std::endl;
+
+    typedef libaccl::pattern::hypersphere<int> hypersphere_t;
+
+    int error_cnt = 0;
+
+    const hypersphere_t sphere(dimension, layers);
+
+    size_t cnt = 0;
+    hypersphere_t::generate(dimension, layers,
+    [&sphere, &cnt, &error_cnt](
+        const hypersphere_t::point_t & point, unsigned layer)
+    {
+        ++cnt;
+
+        if (!(point & sphere) || sphere.get_payload(point) != layer) {
+            std::cerr << "Generated point mismatch" << std::endl;
+            ++error_cnt;
+        }
+    });
+
+    if (cnt != sphere.size() || cnt != hypersphere_t::count(dimension, layers)) {
+        std::cerr
+            << "Generated point count mismatch: " << cnt
+            << " != " << sphere.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    std::cerr << "Hypersphere generator test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Compile-time dimension hypersphere test (compares with runtime dim.) */
+template <size_t N>
+static int hypersphere_static_test(const std::vector<int> & layers) {
+    std::cerr << "Hypersphere pattern " << N << "D test BEGIN" << std::endl;
+
+    int error_cnt = 0;
+
+    const libaccl::pattern::hypersphere<int>    dynamic(N, layers);
+    const libaccl::pattern::hypersphere<int, N> fixed(layers);
+
+    if (dynamic.size() != fixed.size()) {
+        std::cerr
+            << "Size mismatch: " << dynamic.size()
+            << " != " << fixed.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    auto x = dynamic.begin();
+    auto y = fixed.begin();
+    for (; x != dynamic.end() && y != fixed.end(); ++x, ++y) {
+        if (!std::equal(x->first.begin(), x->first.end(), y->first.begin())
+        ||  x->second != y->second)
+        {
+            std::cerr << "Point mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    std::cerr << "Hypersphere pattern " << N << "D test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Arena-allocated hypersphere test (compares with the default allocator) */
+static int hypersphere_arena_test(
+    size_t                   dimension,
+    const std::vector<int> & layers)
+{
+    std::cerr << "Hypersphere arena test BEGIN" << std::endl;
+
+    typedef libaccl::arena::allocator<int> alloc_t;
+    typedef libaccl::pattern::hypersphere<int, 0, alloc_t> hypersphere_t;
+
+    int error_cnt = 0;
+
+    const libaccl::pattern::hypersphere<int> sphere(dimension, layers);
+
+    libaccl::arena::monotonic arena(1024);
+    size_t kept = 0;  // block kept by the 1st rewind
+
+    for (int round = 0; round < 3; ++round) {
+        {  // the sphere must be gone before the arena is rewound
+            const hypersphere_t arena_sphere(
+                dimension, layers, alloc_t(arena));
+
+            if (arena_sphere.size() != sphere.size()) {
+                std::cerr
+                    << "Size mismatch: " << arena_sphere.size()
+                    << " != " << sphere.size() << std::endl;
+
+                ++error_cnt;
+            }
+
+            auto x = sphere.begin();
+            auto y = arena_sphere.begin();
+            for (; x != sphere.end() && y != arena_sphere.end(); ++x, ++y) {
+                if (!std::equal(
+                        x->first.begin(), x->first.end(), y->first.begin())
+                ||  x->second != y->second)
+                {
+                    std::cerr << "Point mismatch" << std::endl;
+                    ++error_cnt;
+                }
+            }
+
+            std::cerr
+                << "Arena: " << arena.blocks() << " blocks, "
+                << arena.size() << " bytes, "
+                << arena.used() << " used" << std::endl;
+
+            if (0 == arena.used()) {
+                std::cerr << "Arena not used" << std::endl;
+                ++error_cnt;
+            }
+
+            // The largest block kept by rewind fits the whole sphere
+            if (round && (1 != arena.blocks() || kept != arena.size())) {
+                std::cerr
+                    << "Arena grew to " << arena.blocks() << " blocks, "
+                    << arena.size() << " bytes after rewind" << std::endl;
+                ++error_cnt;
+            }
+        }
+
+        arena.rewind();  // keep the largest block for the next round
+
+        if (!round) kept = arena.size();
+    }
+
+    std::cerr << "Hypersphere arena test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/**
+ *  \brief  Layer assignment test
+ *
+ *  Points are assigned existing layers only; the centre of a filled
+ *  hypersphere (the last layer radius is 0) is in the innermost layer.
+ */
+static int hypersphere_layers_test(
+    size_t                   dimension,
+    const std::vector<int> & layers)
+{
+    std::cerr << "Hypersphere layers test BEGIN" << std::endl;
+
+    typedef libaccl::pattern::hypersphere<int> hypersphere_t;
+
+    int error_cnt = 0;
+
+    const hypersphere_t sphere(dimension, layers);
+    const unsigned inner = layers.size() > 1 ? layers.size() - 2 : 0;
+
+    for (auto x = sphere.begin(); x != sphere.end(); ++x)
+        if (x->second > inner) {
+            std::cerr << "Point in layer " << x->second << std::endl;
+            ++error_cnt;
+        }
+
+    const hypersphere_t::point_t centre(dimension, 0);
+    if (layers.size() > 1 && 0 == layers.back()) {
+        if (!(centre & sphere) || sphere.get_payload(centre) != inner) {
+            std::cerr << "Centre not in layer " << inner << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    std::cerr << "Hypersphere layers test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Concentric spheres test (compares with spheres computed one by one) */
+template <size_t N>
+static int hypersphere_concentric_test(
+    size_t                   dimension,
+    const std::vector<int> & layers)
+{
+    std::cerr << "Concentric hyperspheres test BEGIN" << std::endl;
+
+    typedef libaccl::pattern::hypersphere<int, N> hypersphere_t;
+
+    int error_cnt = 0;
+
+    // Radii from the outer layer down to 0 (and the outer one again)
+    std::vector<int> radii;
+    for (int r = layers[0]; r >= 0; --r) radii.push_back(r);
+    radii.push_back(layers[0]);
+
+    std::vector<hypersphere_t> spheres;
+    hypersphere_t::concentric(dimension, radii,
+    [&spheres, &error_cnt](size_t i, hypersphere_t && sphere) {
+        if (i != spheres.size()) {
+            std::cerr << "Sphere " << i << " out of order" << std::endl;
+            ++error_cnt;
+        }
+
+        spheres.push_back(std::move(sphere));
+    });
+
+    if (spheres.size() != radii.size()) {
+        std::cerr << "Got " << spheres.size() << " spheres" << std::endl;
+        ++error_cnt;
+    }
+
+    std::vector<size_t> cnt(radii.size());
+    hypersphere_t::generate_concentric(dimension, radii,
+    [&cnt, &spheres, &error_cnt](
+        size_t i, const typename hypersphere_t::point_t & point)
+    {
+        ++cnt[i];
+
+        if (!(point & spheres[i])) {
+            std::cerr << "Generated point mismatch" << std::endl;
+            ++error_cnt;
+        }
+    });
+
+    for (size_t i = 0; i < spheres.size(); ++i) {
+        const hypersphere_t sphere(dimension, std::vector<int>(1, radii[i]));
+
+        bool equal = sphere.size() == spheres[i].size()
+            && cnt[i] == sphere.size();
+
+        auto x = sphere.begin();
+        auto y = spheres[i].begin();
+        for (; equal && x != sphere.end(); ++x, ++y)
+            equal = std::equal(x->first.begin(), x->first.end(),
+                y->first.begin()) && x->second == y->second;
+
+        if (!equal) {
+            std::cerr
+                << "Radius " << radii[i] << " mismatch: "
+                << spheres[i].size() << " points, "
+                << sphere.size() << " expected" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    std::cerr << "Concentric hyperspheres test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Parallel construction test (compares with sequential construction) */
+template <size_t N>
+static int hypersphere_parallel_test(
+    size_t                   dimension,
+    const std::vector<int> & layers,
+    unsigned                 threads)
+{
+    std::cerr << "Parallel hypersphere test BEGIN" << std::endl;
+
+    typedef libaccl::pattern::hypersphere<int, N> hypersphere_t;
+
+    int error_cnt = 0;
+
+    const hypersphere_t sphere(dimension, layers);
+
+    for (unsigned t = 1; t <= threads; ++t) {
+        const hypersphere_t parallel(dimension, layers, t);
+
+        bool equal = sphere.size() == parallel.size();
+
+        auto x = sphere.begin();
+        auto y = parallel.begin();
+        for (; equal && x != sphere.end(); ++x, ++y)
+            equal = std::equal(x->first.begin(), x->first.end(),
+                y->first.begin()) && x->second == y->second;
+
+        if (!equal) {
+            std::cerr
+                << t << " threads mismatch: "
+                << parallel.size() << " points, "
+                << sphere.size() << " expected" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    std::cerr << "Parallel hypersphere test END" << std::endl;
+
+    return error_cnt;
+}
+
+
 /** Unit test */
 static int main_impl(int argc, char * const argv[]) {
     int exit_code = 64;  // pessimistic assumption
@@ -134,6 +435,38 @@ static int main_impl(int argc, char * const argv[]) {
         exit_code = hypersphere_test(dimension, layers);
         if (0 != exit_code) break;
 
+        exit_code = hypersphere_generate_test(dimension, layers);
+        if (0 != exit_code) break;
+
+        exit_code = hypersphere_layers_test(dimension, layers);
+        if (0 != exit_code) break;
+
+        exit_code = hypersphere_arena_test(dimension, layers);
+        if (0 != exit_code) break;
+
+        exit_code = hypersphere_concentric_test<0>(dimension, layers);
+        if (0 != exit_code) break;
+
+        exit_code = hypersphere_parallel_test<0>(dimension, layers, 5);
+        if (0 != exit_code) break;
+
+        switch (dimension) {
+            case 2: exit_code = hypersphere_static_test<2>(layers); break;
+            case 3: exit_code = hypersphere_static_test<3>(layers); break;
+            case 4: exit_code = hypersphere_static_test<4>(layers); break;
+        }
+        if (0 != exit_code) break;
+
+        switch (dimension) {
+            case 3:
+                exit_code = hypersphere_concentric_test<3>(dimension, layers);
+                if (0 != exit_code) break;
+
+                exit_code = hypersphere_parallel_test<3>(dimension, layers, 5);
+                break;
+        }
+        if (0 != exit_code) break;
+
     } while (0);  // end of pragmatic loop
 
     std::cerr
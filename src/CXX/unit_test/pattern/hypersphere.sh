@@ -1,3 +1,7 @@
 #!/bin/sh
 
-./hypersphere 2 15 0
+./hypersphere 2 15 0 && \
+./hypersphere 2 9 4 0 && \
+./hypersphere 3 7 3 && \
+./hypersphere 4 6 && \
+./hypersphere 1 5 3
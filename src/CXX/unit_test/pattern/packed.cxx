@@ -0,0 +1,288 @@
+/**
+ *  \file
+ *  \brief  Packed pattern unit test
+ *
+ *  \date   2016/01/15
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libaccl/pattern/packed.hxx>
+#include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/pattern/kernel.hxx>
+#include <libaccl/pattern/cache.hxx>
+
+#include <vector>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+
+
+/** Layer vote weight */
+static unsigned layer_weight(unsigned layer) { return layer + 1; }
+
+
+/**
+ *  \brief  Packed pattern test
+ *
+ *  Packed hyperspheres must have the same points and layers as the full
+ *  ones, kernels made of them must be the same, too.
+ *
+ *  \tparam N          Space dimension (0 means runtime)
+ *  \tparam Offset_t   Packed coordinate type
+ *  \param  dimension  Space dimension
+ *  \param  layers     Hypersphere layers
+ */
+template <size_t N, typename Offset_t>
+static int packed_test(size_t dimension, const std::vector<int> & layers) {
+    typedef libaccl::pattern::hypersphere<int, N>              sphere_t;
+    typedef libaccl::pattern::packed<int, Offset_t, uint8_t, N> packed_t;
+    typedef libaccl::pattern::kernel<int, unsigned, N>          kernel_t;
+
+    int error_cnt = 0;
+
+    const sphere_t sphere(dimension, layers);
+    const packed_t packed(sphere);
+    const packed_t packed2(dimension, layers);
+
+    std::cout
+        << "Hypersphere [" << layers.front() << ".." << layers.back()
+        << "] (dimension " << dimension << "): " << sphere.size()
+        << " points, " << sphere.memory() << " B, packed "
+        << packed.memory() << " B" << std::endl;
+
+    if (packed.size() != sphere.size() || packed2.size() != sphere.size()) {
+        std::cerr << "Packed size mismatch" << std::endl;
+        return 1;
+    }
+
+    size_t i = 0;
+    for (auto x = sphere.begin(); x != sphere.end(); ++x, ++i) {
+        const auto p = packed.point(i);
+        bool same = packed.layer(i) == x->second
+            && packed2.layer(i) == x->second;
+
+        for (size_t d = 0; d < dimension; ++d)
+            same = same && p[d] == x->first[d]
+                && packed2.offset(i)[d] == x->first[d];
+
+        if (!same) {
+            std::cerr << "Packed point " << i << " mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    if (!(packed.memory() < sphere.memory())) {
+        std::cerr << "Packed pattern is not smaller" << std::endl;
+        ++error_cnt;
+    }
+
+    // Kernels
+    const kernel_t kernel(sphere, layer_weight), pkernel(packed, layer_weight);
+    const kernel_t ukernel(sphere), upkernel(packed);
+
+    for (int k = 0; k < 2; ++k) {
+        const kernel_t & k1 = k ? ukernel : kernel;
+        const kernel_t & k2 = k ? upkernel : pkernel;
+
+        bool same = k1.size() == k2.size() && k1.lo() == k2.lo()
+            && k1.hi() == k2.hi();
+
+        for (size_t j = 0; same && j < k1.size(); ++j) {
+            same = k1.weight(j) == k2.weight(j);
+            for (size_t d = 0; d < dimension; ++d)
+                same = same && k1.offset(j)[d] == k2.offset(j)[d];
+        }
+
+        if (!same) {
+            std::cerr << "Packed kernel mismatch" << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    return error_cnt;
+}
+
+/** Out-of-range packing test */
+static int range_test() {
+    int error_cnt = 0;
+
+    try {
+        libaccl::pattern::packed<int> packed(2, {128});
+
+        std::cerr << "Out-of-range offset not refused" << std::endl;
+        ++error_cnt;
+    }
+    catch (const std::logic_error & ) {}
+
+    try {
+        std::vector<int> layers;
+        for (int r = 300; r >= 0; --r) layers.push_back(r);
+        libaccl::pattern::packed<int, int16_t> packed(1, layers);
+
+        std::cerr << "Out-of-range layer not refused" << std::endl;
+        ++error_cnt;
+    }
+    catch (const std::logic_error & ) {}
+
+    // The largest radius that fits
+    libaccl::pattern::packed<int> packed(2, {127});
+    if (0 == packed.size()) ++error_cnt;
+
+    return error_cnt;
+}
+
+/** Default kernel weight test */
+static int kernel_test() {
+    typedef libaccl::pattern::kernel<int, unsigned> kernel_t;
+
+    int error_cnt = 0;
+
+    // Every point votes by default (the outermost layer index is 0)
+    const std::vector<std::vector<int> > layers = {{10}, {10, 5}};
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const libaccl::pattern::hypersphere<int> sphere(2, layers[i]);
+        const libaccl::pattern::packed<int>      packed(2, layers[i]);
+        const kernel_t kernel(sphere), pkernel(packed);
+
+        if (kernel.size() != sphere.size() || pkernel.size() != sphere.size()) {
+            std::cerr
+                << "Default kernel has " << kernel.size() << " / "
+                << pkernel.size() << " of " << sphere.size() << " points"
+                << std::endl;
+            ++error_cnt;
+        }
+    }
+
+    // Kernel with no points is refused
+    try {
+        const libaccl::pattern::hypersphere<int> sphere(2, {10});
+        kernel_t kernel(sphere, [](unsigned layer) { return layer; });
+
+        std::cerr << "Empty kernel not refused" << std::endl;
+        ++error_cnt;
+    }
+    catch (const std::logic_error & ) {}
+
+    return error_cnt;
+}
+
+/** Cache of packed patterns test */
+static int cache_test() {
+    typedef libaccl::pattern::packed<int>      packed_t;
+    typedef libaccl::pattern::cache<packed_t>  cache_t;
+
+    int error_cnt = 0;
+
+    cache_t cache(1 << 20);
+    cache.precompute(3, {{4}, {8}, {12, 10}}, 2);
+
+    const auto sphere = cache.get(3, {8});
+    if (sphere->size() != libaccl::pattern::hypersphere<int>(3, {8}).size()) {
+        std::cerr << "Cached packed pattern mismatch" << std::endl;
+        ++error_cnt;
+    }
+
+    if (1 != cache.hits()) {
+        std::cerr << "Cache hit count mismatch: " << cache.hits() << std::endl;
+        ++error_cnt;
+    }
+
+    std::cout << "Packed cache: " << cache.memory() << " B" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Unit test */
+static int main_impl(int argc, char * const argv[]) {
+    int exit_code = 64;  // pessimistic assumption
+
+    int radius = 20;  // max. hypersphere radius
+    if (argc > 1) radius = ::atoi(argv[1]);
+
+    do {  // pragmatic do ... while (0) loop allowing for breaks
+        exit_code = 0;
+
+        for (int r = 1; r <= radius && !exit_code; r += 3) {
+            exit_code += packed_test<0, int8_t>(2, {r});
+            exit_code += packed_test<2, int8_t>(2, {r, r / 2});
+            exit_code += packed_test<3, int8_t>(3, {r, 0});
+            exit_code += packed_test<4, int16_t>(4, {r / 2 + 1});
+        }
+
+        if (0 != exit_code) break;
+
+        exit_code = range_test();
+        if (0 != exit_code) break;
+
+        exit_code = kernel_test();
+        if (0 != exit_code) break;
+
+        exit_code = cache_test();
+        if (0 != exit_code) break;
+
+    } while (0);  // end of pragmatic loop
+
+    std::cerr
+        << "Exit code: " << exit_code
+        << std::endl;
+
+    return exit_code;
+}
+
+/** Unit test exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
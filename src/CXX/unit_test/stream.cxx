@@ -0,0 +1,365 @@
+/**
+ *  \file
+ *  \brief  Sliding window accumulator unit test
+ *
+ *  \date   2016/01/14
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <libaccl/stream.hxx>
+#include <libaccl/accumulator.hxx>
+#include <libaccl/backend/dense.hxx>
+#include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/pattern/kernel.hxx>
+
+#include <vector>
+#include <deque>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+
+
+/** Peaks are the same */
+template <class Peaks>
+static int compare_peaks(const Peaks & peaks, const Peaks & ref) {
+    if (peaks.size() != ref.size()) {
+        std::cerr
+            << "Peak count mismatch: " << peaks.size()
+            << " != " << ref.size() << std::endl;
+
+        return 1;
+    }
+
+    for (size_t i = 0; i < peaks.size(); ++i)
+        if (peaks[i].point != ref[i].point || peaks[i].count != ref[i].count) {
+            std::cerr << "Peak " << i << " mismatch" << std::endl;
+            return 1;
+        }
+
+    return 0;
+}
+
+/**
+ *  \brief  Sliding window accumulator test
+ *
+ *  Samples of 2 drifting clusters (circles) plus noise are streamed;
+ *  incrementally maintained peaks are compared with batch peak search
+ *  and the window votes with a batch-voted accumulator.
+ *
+ *  \tparam Stream     Stream accumulator type
+ *  \param  acc        Stream accumulator
+ *  \param  batch      Batch accumulator (empty, the same configuration)
+ *  \param  circle     Circle pattern
+ *  \param  count      Number of samples
+ */
+template <class Stream, class Accumulator>
+static int stream_test(
+    Stream                                      & acc,
+    Accumulator                                 & batch,
+    const libaccl::pattern::hypersphere<int, 2> & circle,
+    size_t                                        count)
+{
+    typedef typename Stream::point_t point_t;
+
+    int error_cnt = 0;
+
+    std::deque<std::pair<double, point_t> > window;
+    std::vector<point_t> points;
+    for (auto x = circle.begin(); x != circle.end(); ++x)
+        points.push_back(x->first);
+
+    unsigned seed = 2468;
+    size_t max_peaks = 0;
+    for (size_t i = 0; i < count; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const double time = i * 0.5;
+
+        point_t sample;
+        if ((seed >> 16) % 4) {  // cluster sample
+            const int drift = (int)(i / 200);
+            const point_t & x = points[(seed >> 8) % points.size()];
+            sample[0] = x[0] + ((seed >> 20) % 2 ? 20 + drift : -20);
+            sample[1] = x[1] + drift / 2;
+        }
+        else {  // noise
+            sample[0] = (int)((seed >> 16) % 80) - 40;
+            sample[1] = (int)((seed >> 8)  % 80) - 40;
+        }
+
+        acc.push(time, sample);
+
+        window.emplace_back(time, sample);
+        while (!(time - acc.window() < window.front().first))
+            window.pop_front();
+
+        if (acc.samples() != window.size()) {
+            std::cerr
+                << "Window size mismatch: " << acc.samples()
+                << " != " << window.size() << std::endl;
+
+            ++error_cnt;
+        }
+
+        max_peaks = std::max(max_peaks, acc.peak_cnt());
+
+        error_cnt += compare_peaks(acc.peaks(),
+            acc.accumulator().peaks(acc.threshold()));
+
+        if (error_cnt) break;
+    }
+
+    // Window votes
+    for (size_t i = 0; i < window.size(); ++i) batch.vote(window[i].second);
+
+    if (batch.size() != acc.accumulator().size()) {
+        std::cerr
+            << "Cell count mismatch: " << acc.accumulator().size()
+            << " != " << batch.size() << std::endl;
+
+        ++error_cnt;
+    }
+
+    batch.for_each([&acc, &error_cnt](const point_t & point, unsigned count) {
+        if (acc.accumulator().count(point) != count) ++error_cnt;
+    });
+
+    error_cnt += compare_peaks(acc.peaks(), batch.peaks(acc.threshold()));
+    error_cnt += compare_peaks(acc.peaks(2), batch.peaks(acc.threshold(), 2));
+
+    std::cout
+        << "Window: " << acc.samples() << " samples, "
+        << acc.accumulator().size() << " cells, "
+        << acc.hot() << " hot cells, " << acc.peak_cnt()
+        << " peaks (max. " << max_peaks << ")" << std::endl;
+
+    // Expire all
+    acc.expire(count + acc.window());
+
+    if (acc.samples() || acc.accumulator().size() || acc.hot() ||
+        acc.peak_cnt())
+    {
+        std::cerr << "Votes left after expiry" << std::endl;
+        ++error_cnt;
+    }
+
+    // Out of order sample
+    try {
+        acc.push(count * 2, point_t());
+        acc.push(count, point_t());
+
+        std::cerr << "Out of order sample not refused" << std::endl;
+        ++error_cnt;
+    }
+    catch (const std::logic_error & ) {}
+
+    return error_cnt;
+}
+
+/** Sparse backend test */
+static int sparse_test(int radius, double window, size_t count) {
+    std::cerr << "Sparse stream test BEGIN" << std::endl;
+
+    typedef libaccl::stream<int, unsigned, 2> stream_t;
+    typedef libaccl::accumulator<int, unsigned, 2> accumulator_t;
+
+    libaccl::pattern::hypersphere<int, 2>      circle({radius});
+    libaccl::pattern::kernel<int, unsigned, 2> kernel(circle);
+
+    int error_cnt = 0;
+
+    // Fixed size table (compacted by retraction)
+    {
+        stream_t acc(kernel, window, circle.size() / 4, 16384);
+        accumulator_t batch(kernel, 16384);
+        error_cnt += stream_test(acc, batch, circle, count);
+    }
+
+    // Fixed size table compaction is spread over retractions
+    {
+        accumulator_t acc(kernel, 4096), ref(kernel, 4096);
+        std::deque<accumulator_t::point_t> lag;
+        size_t compacting = 0;
+
+        unsigned seed = 1357;
+        for (size_t i = 0; i < count; ++i) {
+            seed = seed * 1103515245 + 12345;
+
+            accumulator_t::point_t sample;
+            sample[0] = (int)((seed >> 16) % 80) - 40;
+            sample[1] = (int)((seed >> 8)  % 80) - 40;
+
+            acc.vote(sample);
+            lag.push_back(sample);
+            if (lag.size() > 8) {
+                acc.retract(lag.front());
+                lag.pop_front();
+            }
+
+            if (acc.backend().table().rehashing()) ++compacting;
+        }
+
+        for (size_t i = 0; i < lag.size(); ++i) ref.vote(lag[i]);
+
+        if (!compacting) {
+            std::cerr << "Compaction is not incremental" << std::endl;
+            ++error_cnt;
+        }
+
+        if (acc.size() != ref.size()) {
+            std::cerr
+                << "Cell count mismatch after compaction: " << acc.size()
+                << " != " << ref.size() << std::endl;
+
+            ++error_cnt;
+        }
+
+        ref.for_each(
+        [&acc, &error_cnt](const accumulator_t::point_t & point, unsigned c) {
+            if (acc.count(point) != c) ++error_cnt;
+        });
+
+        std::cout
+            << "Compaction: " << compacting << " retractions of "
+            << count << " samples in progress" << std::endl;
+    }
+
+    // Growing table
+    {
+        stream_t acc(kernel, window, circle.size() / 4, 64, 0, 2.0);
+        accumulator_t batch(kernel, 64, 0, 2.0);
+        error_cnt += stream_test(acc, batch, circle, count);
+    }
+
+    // Unsigned timestamps (the window starts at 0)
+    {
+        libaccl::stream<int, unsigned, 2, unsigned> acc(
+            kernel, 100, circle.size() / 4, 16384);
+
+        for (unsigned time = 0; time < 300; ++time) {
+            acc.push(time, accumulator_t::point_t{{(int)time % 10, 0}});
+
+            const size_t samples = time < 100 ? time + 1 : 100;
+            if (acc.samples() != samples) {
+                std::cerr
+                    << "Window size mismatch at " << time << ": "
+                    << acc.samples() << " != " << samples << std::endl;
+
+                ++error_cnt;
+                break;
+            }
+        }
+    }
+
+    std::cerr << "Sparse stream test END" << std::endl;
+
+    return error_cnt;
+}
+
+/** Dense backend test */
+static int dense_test(int radius, double window, size_t count) {
+    std::cerr << "Dense stream test BEGIN" << std::endl;
+
+    typedef libaccl::backend::dense<int, unsigned, 2> dense_t;
+    typedef libaccl::stream<int, unsigned, 2, double, dense_t> stream_t;
+    typedef libaccl::accumulator<int, unsigned, 2, dense_t> accumulator_t;
+
+    libaccl::pattern::hypersphere<int, 2>      circle({radius});
+    libaccl::pattern::kernel<int, unsigned, 2> kernel(circle);
+
+    // Note that the box cuts some votes off
+    const accumulator_t::point_t lo = {{-48, -48}}, hi = {{48, 48}};
+
+    stream_t acc(kernel, window, circle.size() / 4, lo, hi);
+    accumulator_t batch(kernel, lo, hi);
+    int error_cnt = stream_test(acc, batch, circle, count);
+
+    std::cerr << "Dense stream test END" << std::endl;
+
+    return error_cnt;
+}
+
+
+/** Unit test */
+static int main_impl(int argc, char * const argv[]) {
+    int exit_code = 64;  // pessimistic assumption
+
+    int radius = 8;  // pattern radius
+    if (argc > 1) radius = ::atoi(argv[1]);
+
+    double window = 100;  // window length
+    if (argc > 2) window = ::atof(argv[2]);
+
+    size_t count = 2000;  // number of samples
+    if (argc > 3) count = ::atoi(argv[3]);
+
+    do {  // pragmatic do ... while (0) loop allowing for breaks
+        exit_code = sparse_test(radius, window, count);
+        if (0 != exit_code) break;
+
+        exit_code = dense_test(radius, window, count);
+        if (0 != exit_code) break;
+
+    } while (0);  // end of pragmatic loop
+
+    std::cerr
+        << "Exit code: " << exit_code
+        << std::endl;
+
+    return exit_code;
+}
+
+/** Unit test exception-safe wrapper */
+int main(int argc, char * const argv[]) {
+    int exit_code = 128;
+
+    try {
+        exit_code = main_impl(argc, argv);
+    }
+    catch (const std::exception & x) {
+        std::cerr
+            << "Standard exception caught: "
+            << x.what()
+            << std::endl;
+    }
+    catch (...) {
+        std::cerr
+            << "Unhandled non-standard exception caught"
+            << std::endl;
+    }
+
+    return exit_code;
+}
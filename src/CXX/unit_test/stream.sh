@@ -0,0 +1,4 @@
+#!/bin/sh
+
+./stream && \
+./stream 5 30 3000
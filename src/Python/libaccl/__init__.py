@@ -0,0 +1,75 @@
+"""
+libaccl: cluster detection by pattern voting in an accumulator
+
+Bulk data are passed without conversion: samples are taken via the buffer
+protocol (e.g. C-contiguous NumPy arrays of the pattern dtype, no copy)
+and pattern points and peaks are NumPy arrays viewing library-owned memory
+(read-only; memoryviews if NumPy isn't available).
+Voting and peak search release the GIL, so they may run on multiple
+Python threads (calls on one accumulator are serialised).
+
+Example:
+
+    import numpy, libaccl
+
+    circle = libaccl.Hypersphere(2, [10])
+    acc = libaccl.Accumulator(circle, 1 << 16)
+    acc.vote(numpy.array(samples, dtype=numpy.int32), threads=4)
+    points, counts = acc.peaks(len(circle) // 2)
+"""
+
+from libaccl import _libaccl
+
+try:
+    import numpy
+except ImportError:  # pragma: no cover
+    numpy = None
+
+
+__all__ = ["Hypersphere", "Accumulator"]
+
+
+def _array(buf):
+    """Zero-copy array of library-owned buffer"""
+    return numpy.asarray(buf) if numpy is not None else memoryview(buf)
+
+
+class Hypersphere(_libaccl.Hypersphere):
+    """
+    Hypersphere(dimension, layers, dtype="int32", threads=1)
+
+    Hypersphere pattern (see libaccl::pattern::hypersphere); layers are
+    the layers' radii, dtype is "int32" or "int64", threads > 1 (or 0 for
+    all cores) builds the pattern in parallel.
+    """
+
+    @property
+    def points(self):
+        """Point coordinates, shape (len(self), dimension)"""
+        return _array(self._points)
+
+    @property
+    def layers(self):
+        """Point layer indices, shape (len(self),)"""
+        return _array(self._layers)
+
+
+class Accumulator(_libaccl.Accumulator):
+    """
+    Accumulator(pattern, size, capacity=0, growth=0.0)
+
+    Sparse accumulator (see libaccl::accumulator) voting with the pattern
+    (unit weights); size is the hash table size, capacity and growth
+    are as of libaccl::hash::linear.
+    The samples dtype must match the pattern one.
+    """
+
+    def peaks(self, threshold, top=0, threads=1):
+        """
+        Peaks with at least threshold votes (top ones only if top > 0)
+
+        Returns (points, counts) arrays of shapes (k, dimension) and (k,),
+        ordered by count (descending).
+        """
+        points, counts = self._peaks(threshold, top, threads)
+        return _array(points), _array(counts)
@@ -0,0 +1,806 @@
+/**
+ *  \file
+ *  \brief  Python binding
+ *
+ *  CPython extension module \c libaccl._libaccl; the public interface
+ *  is the \c libaccl Python package.
+ *
+ *  Bulk data are never converted element by element:
+ *  sample arrays are accepted via the buffer protocol (C-contiguous,
+ *  no copy) and pattern points and accumulator peaks are returned
+ *  as read-only buffer objects (\c Array) viewing library-owned memory
+ *  (\c numpy.asarray makes arrays of them without copying).
+ *  Voting and peak search release the GIL.
+ *
+ *  Patterns and accumulators are instantiated for \c int32 and \c int64
+ *  coordinates (runtime dimension, sparse accumulator backend).
+ *
+ *  \date   2016/01/18
+ *  \author Vaclav Krpec  <vencik@razdva.cz>
+ *
+ *
+ *  LEGAL NOTICE
+ *
+ *  Copyright (c) 2015, Vaclav Krpec
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of
+ *     its contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ *  OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <libaccl/pattern/hypersphere.hxx>
+#include <libaccl/pattern/kernel.hxx>
+#include <libaccl/accumulator.hxx>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <exception>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+
+
+namespace {
+
+/** Vote count type */
+typedef unsigned count_t;
+
+
+/** Buffer format of element type */
+template <typename T> struct format;
+
+template <> struct format<int>           { static const char * value() { return "i"; } };
+template <> struct format<long>          { static const char * value() { return "l"; } };
+template <> struct format<long long>     { static const char * value() { return "q"; } };
+template <> struct format<unsigned>      { static const char * value() { return "I"; } };
+
+
+/**
+ *  \brief  Library-owned memory view
+ *
+ *  1D or 2D C-contiguous array; the owner keeps the memory alive.
+ */
+struct view {
+    std::shared_ptr<const void> owner;     /**< Memory owner      */
+    const void                * data;      /**< Data              */
+    const char                * format;    /**< Buffer format     */
+    size_t                      itemsize;  /**< Element size      */
+    size_t                      rows;      /**< Rows              */
+    size_t                      cols;      /**< Columns (0 = 1D)  */
+
+    /** Constructor */
+    template <typename T>
+    view(
+        const std::shared_ptr<const void> & own,
+        const T                           * begin,
+        size_t                              r,
+        size_t                              c = 0)
+    :
+        owner    ( own                  ),
+        data     ( begin                ),
+        format   ( ::format<T>::value() ),
+        itemsize ( sizeof(T)            ),
+        rows     ( r                    ),
+        cols     ( c                    )
+    {}
+
+};  // end of struct view
+
+
+/** Array object (exports \ref view by the buffer protocol) */
+struct array_object {
+    PyObject_HEAD
+    view       * data;      /**< View         */
+    Py_ssize_t   shape[2];  /**< Shape        */
+    Py_ssize_t   strides[2];  /**< Strides    */
+};  // end of struct array_object
+
+/** Array deallocation */
+static void array_dealloc(PyObject * self) {
+    delete ((array_object *)self)->data;
+    Py_TYPE(self)->tp_free(self);
+}
+
+/** Array buffer export */
+static int array_getbuffer(PyObject * self, Py_buffer * buf, int flags) {
+    array_object * arr = (array_object *)self;
+
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "libaccl.Array is read-only");
+        buf->obj = NULL;
+        return -1;
+    }
+
+    // Without shape (no PyBUF_ND), the buffer is exported flat
+    const bool nd = flags & PyBUF_ND;
+
+    buf->buf        = (void *)arr->data->data;
+    buf->obj        = self; Py_INCREF(self);
+    buf->itemsize   = arr->data->itemsize;
+    buf->ndim       = nd && arr->data->cols ? 2 : 1;
+    buf->len        = arr->shape[0] * (arr->data->cols ? arr->shape[1] : 1)
+                    * buf->itemsize;
+    buf->readonly   = 1;
+    buf->format     = (flags & PyBUF_FORMAT) ? (char *)arr->data->format : NULL;
+    buf->shape      = nd                      ? arr->shape   : NULL;
+    buf->strides    = (flags & PyBUF_STRIDES) ? arr->strides : NULL;
+    buf->suboffsets = NULL;
+    buf->internal   = NULL;
+
+    return 0;
+}
+
+/** Array length (rows) */
+static Py_ssize_t array_len(PyObject * self) {
+    return ((array_object *)self)->shape[0];
+}
+
+/** Array shape */
+static PyObject * array_shape(PyObject * self, void * ) {
+    array_object * arr = (array_object *)self;
+
+    return arr->data->cols
+        ? Py_BuildValue("(nn)", arr->shape[0], arr->shape[1])
+        : Py_BuildValue("(n)",  arr->shape[0]);
+}
+
+static PyBufferProcs array_buffer = {
+    array_getbuffer,  // bf_getbuffer
+    NULL,             // bf_releasebuffer
+};
+
+static PySequenceMethods array_sequence = {
+    array_len,  // sq_length
+};
+
+static PyGetSetDef array_getset[] = {
+    {(char *)"shape", array_shape, NULL, (char *)"Array shape", NULL},
+    {NULL}
+};
+
+static PyTypeObject array_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "libaccl._libaccl.Array",  // tp_name
+    sizeof(array_object),      // tp_basicsize
+};
+
+/** Create array object (steals the view) */
+static PyObject * array_new(view * v) {
+    std::unique_ptr<view> data(v);
+
+    array_object * arr = PyObject_New(array_object, &array_type);
+    if (!arr) return NULL;
+
+    arr->data       = data.release();
+    arr->shape[0]   = arr->data->rows;
+    arr->shape[1]   = arr->data->cols;
+    arr->strides[0] = arr->data->itemsize * (arr->data->cols ? : 1);
+    arr->strides[1] = arr->data->itemsize;
+
+    return (PyObject *)arr;
+}
+
+
+/** Accumulator (type-erased) */
+class accumulator_base {
+    public:
+
+    /** Space dimension */
+    virtual size_t dimension() const = 0;
+
+    /** Number of cells with votes */
+    virtual size_t size() const = 0;
+
+    /** Vote element size */
+    virtual size_t itemsize() const = 0;
+
+    /** Vote (see \ref libaccl::accumulator::vote) */
+    virtual void vote(const void * samples, size_t count, unsigned threads) = 0;
+
+    /** Peaks coordinates and counts (see \ref libaccl::accumulator::peaks) */
+    virtual std::pair<view *, view *> peaks(
+        count_t threshold, size_t top, unsigned threads) const = 0;
+
+    /** Destructor */
+    virtual ~accumulator_base() {}
+
+};  // end of class accumulator_base
+
+/** Pattern (type-erased) */
+class pattern_base {
+    public:
+
+    /** Space dimension */
+    virtual size_t dimension() const = 0;
+
+    /** Number of points */
+    virtual size_t size() const = 0;
+
+    /** Point coordinates view */
+    virtual view * points() const = 0;
+
+    /** Point layers view */
+    virtual view * layers() const = 0;
+
+    /** Accumulator with the pattern as kernel (unit vote weights) */
+    virtual accumulator_base * accumulator(
+        size_t size, size_t capacity, double growth) const = 0;
+
+    /** Destructor */
+    virtual ~pattern_base() {}
+
+};  // end of class pattern_base
+
+
+/** Accumulator implementation */
+template <typename Base_t>
+class accumulator_impl: public accumulator_base {
+    private:
+
+    typedef libaccl::accumulator<Base_t, count_t> acc_t;  /**< Accumulator */
+
+    acc_t m_acc;  /**< Accumulator */
+
+    public:
+
+    /** Constructor */
+    accumulator_impl(
+        const typename acc_t::kernel_t & kernel,
+        size_t size, size_t capacity, double growth)
+    :
+        m_acc(kernel, size, capacity, growth)
+    {}
+
+    size_t dimension() const { return m_acc.dimension(); }
+
+    size_t size() const { return m_acc.size(); }
+
+    size_t itemsize() const { return sizeof(Base_t); }
+
+    void vote(const void * samples, size_t count, unsigned threads) {
+        m_acc.vote((const Base_t *)samples, count, threads);
+    }
+
+    std::pair<view *, view *> peaks(
+        count_t threshold, size_t top, unsigned threads) const
+    {
+        const auto peaks = m_acc.peaks(threshold, top, threads);
+        const size_t dim = dimension();
+
+        // Flat arrays (runtime dimension points aren't contiguous)
+        auto coords = std::make_shared<std::vector<Base_t> >();
+        auto counts = std::make_shared<std::vector<count_t> >();
+        coords->reserve(peaks.size() * dim);
+        counts->reserve(peaks.size());
+        for (size_t i = 0; i < peaks.size(); ++i) {
+            coords->insert(coords->end(),
+                peaks[i].point.begin(), peaks[i].point.end());
+            counts->push_back(peaks[i].count);
+        }
+
+        std::unique_ptr<view> cv(
+            new view(coords, coords->data(), peaks.size(), dim));
+
+        view * nv = new view(counts, counts->data(), peaks.size());
+
+        return std::make_pair(cv.release(), nv);
+    }
+
+};  // end of template class accumulator_impl
+
+/** Pattern implementation */
+template <typename Base_t>
+class pattern_impl: public pattern_base {
+    private:
+
+    typedef libaccl::pattern::hypersphere<Base_t> sphere_t;  /**< Pattern */
+
+    std::shared_ptr<const sphere_t> m_sphere;  /**< Pattern */
+
+    /** Pattern points */
+    const typename sphere_t::set_t & set() const { return *m_sphere; }
+
+    public:
+
+    /** Constructor */
+    pattern_impl(
+        size_t dimension, const std::vector<Base_t> & layers, unsigned threads)
+    :
+        m_sphere(threads == 1
+            ? new sphere_t(dimension, layers)
+            : new sphere_t(dimension, layers, threads))
+    {}
+
+    size_t dimension() const { return m_sphere->dimension(); }
+
+    size_t size() const { return m_sphere->size(); }
+
+    view * points() const {
+        return new view(m_sphere, set().coords_data(), size(), dimension());
+    }
+
+    view * layers() const {
+        return new view(m_sphere, set().payload_data(), size());
+    }
+
+    accumulator_base * accumulator(
+        size_t size, size_t capacity, double growth) const
+    {
+        const libaccl::pattern::kernel<Base_t, count_t> kernel(*m_sphere);
+
+        return new accumulator_impl<Base_t>(kernel, size, capacity, growth);
+    }
+
+};  // end of template class pattern_impl
+
+
+/** Set Python exception from C++ one (call in catch block) */
+static void set_error() {
+    try { throw; }
+    catch (const std::bad_alloc & ) {
+        PyErr_NoMemory();
+    }
+    catch (const std::logic_error & x) {
+        PyErr_SetString(PyExc_ValueError, x.what());
+    }
+    catch (const std::exception & x) {
+        PyErr_SetString(PyExc_RuntimeError, x.what());
+    }
+    catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "unknown C++ exception");
+    }
+}
+
+
+/** Hypersphere object */
+struct hypersphere_object {
+    PyObject_HEAD
+    pattern_base * impl;  /**< Pattern */
+};  // end of struct hypersphere_object
+
+/** Hypersphere deallocation */
+static void hypersphere_dealloc(PyObject * self) {
+    delete ((hypersphere_object *)self)->impl;
+    Py_TYPE(self)->tp_free(self);
+}
+
+/** Layer radii of sequence */
+template <typename Base_t>
+static bool radii(PyObject * seq, std::vector<Base_t> & layers) {
+    PyObject * fast = PySequence_Fast(seq, "layers must be a sequence");
+    if (!fast) return false;
+
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(fast);
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        const long long r = PyLong_AsLongLong(
+            PySequence_Fast_GET_ITEM(fast, i));
+
+        if (-1 == r && PyErr_Occurred()) { Py_DECREF(fast); return false; }
+
+        layers.push_back((Base_t)r);
+    }
+
+    Py_DECREF(fast);
+    return true;
+}
+
+/** Pattern of base type */
+template <typename Base_t>
+static pattern_base * make_pattern(
+    size_t dimension, PyObject * seq, unsigned threads)
+{
+    std::vector<Base_t> layers;
+    if (!radii(seq, layers)) return NULL;
+
+    pattern_base * impl = NULL;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        impl = new pattern_impl<Base_t>(dimension, layers, threads);
+    }
+    catch (...) {
+        Py_BLOCK_THREADS
+        set_error();
+        Py_UNBLOCK_THREADS
+    }
+    Py_END_ALLOW_THREADS
+
+    return impl;
+}
+
+/** Hypersphere constructor */
+static int hypersphere_init(PyObject * self, PyObject * args, PyObject * kwds) {
+    static const char * kwlist[] = {
+        "dimension", "layers", "dtype", "threads", NULL };
+
+    Py_ssize_t   dimension = 0;
+    PyObject   * layers    = NULL;
+    const char * dtype     = "int32";
+    unsigned     threads   = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "nO|sI", (char **)kwlist,
+        &dimension, &layers, &dtype, &threads)) return -1;
+
+    if (dimension < 1) {
+        PyErr_SetString(PyExc_ValueError, "dimension must be positive");
+        return -1;
+    }
+
+    hypersphere_object * hs = (hypersphere_object *)self;
+    delete hs->impl; hs->impl = NULL;
+
+    if      (0 == std::strcmp(dtype, "int32"))
+        hs->impl = make_pattern<int32_t>(dimension, layers, threads);
+    else if (0 == std::strcmp(dtype, "int64"))
+        hs->impl = make_pattern<int64_t>(dimension, layers, threads);
+    else {
+        PyErr_SetString(PyExc_ValueError, "dtype must be int32 or int64");
+        return -1;
+    }
+
+    return hs->impl ? 0 : -1;
+}
+
+/** Hypersphere must be initialised */
+static pattern_base * hypersphere_impl(PyObject * self) {
+    pattern_base * impl = ((hypersphere_object *)self)->impl;
+    if (!impl)
+        PyErr_SetString(PyExc_ValueError, "uninitialised Hypersphere");
+
+    return impl;
+}
+
+/** Hypersphere size */
+static Py_ssize_t hypersphere_len(PyObject * self) {
+    pattern_base * impl = hypersphere_impl(self);
+    return impl ? (Py_ssize_t)impl->size() : -1;
+}
+
+/** Hypersphere dimension */
+static PyObject * hypersphere_dimension(PyObject * self, void * ) {
+    pattern_base * impl = hypersphere_impl(self);
+    return impl ? PyLong_FromSize_t(impl->dimension()) : NULL;
+}
+
+/** Hypersphere points (view) */
+static PyObject * hypersphere_points(PyObject * self, void * ) {
+    pattern_base * impl = hypersphere_impl(self);
+    return impl ? array_new(impl->points()) : NULL;
+}
+
+/** Hypersphere point layers (view) */
+static PyObject * hypersphere_layers(PyObject * self, void * ) {
+    pattern_base * impl = hypersphere_impl(self);
+    return impl ? array_new(impl->layers()) : NULL;
+}
+
+static PySequenceMethods hypersphere_sequence = {
+    hypersphere_len,  // sq_length
+};
+
+static PyGetSetDef hypersphere_getset[] = {
+    {(char *)"dimension", hypersphere_dimension, NULL,
+        (char *)"Space dimension", NULL},
+    {(char *)"_points", hypersphere_points, NULL,
+        (char *)"Point coordinates (Array view)", NULL},
+    {(char *)"_layers", hypersphere_layers, NULL,
+        (char *)"Point layer indices (Array view)", NULL},
+    {NULL}
+};
+
+static PyTypeObject hypersphere_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "libaccl._libaccl.Hypersphere",  // tp_name
+    sizeof(hypersphere_object),      // tp_basicsize
+};
+
+
+/** Accumulator object */
+struct accumulator_object {
+    PyObject_HEAD
+    accumulator_base * impl;   /**< Accumulator                    */
+    std::mutex       * mutex;  /**< Serialises voting (GIL is off) */
+};  // end of struct accumulator_object
+
+/** Accumulator deallocation */
+static void accumulator_dealloc(PyObject * self) {
+    accumulator_object * acc = (accumulator_object *)self;
+    delete acc->impl;
+    delete acc->mutex;
+    Py_TYPE(self)->tp_free(self);
+}
+
+/** Accumulator constructor */
+static int accumulator_init(PyObject * self, PyObject * args, PyObject * kwds) {
+    static const char * kwlist[] = {
+        "pattern", "size", "capacity", "growth", NULL };
+
+    PyObject   * pattern  = NULL;
+    Py_ssize_t   size     = 0;
+    Py_ssize_t   capacity = 0;
+    double       growth   = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!n|nd", (char **)kwlist,
+        &hypersphere_type, &pattern, &size, &capacity, &growth)) return -1;
+
+    pattern_base * hs = hypersphere_impl(pattern);
+    if (!hs) return -1;
+
+    if (size < 1 || capacity < 0) {
+        PyErr_SetString(PyExc_ValueError, "invalid size or capacity");
+        return -1;
+    }
+
+    accumulator_object * acc = (accumulator_object *)self;
+    delete acc->impl; acc->impl = NULL;
+
+    try {
+        if (!acc->mutex) acc->mutex = new std::mutex;
+        acc->impl = hs->accumulator(size, capacity, growth);
+    }
+    catch (...) {
+        set_error();
+        return -1;
+    }
+
+    return 0;
+}
+
+/** Accumulator must be initialised */
+static accumulator_base * accumulator_impl_of(PyObject * self) {
+    accumulator_base * impl = ((accumulator_object *)self)->impl;
+    if (!impl)
+        PyErr_SetString(PyExc_ValueError, "uninitialised Accumulator");
+
+    return impl;
+}
+
+/** Buffer format is a signed integer one */
+static bool signed_int_format(const char * format) {
+    if (!format) return false;
+
+    if ('@' == *format || '=' == *format || '<' == *format) ++format;
+
+    return 1 == std::strlen(format) && std::strchr("bhilq", *format);
+}
+
+/** Vote for samples (buffer of shape (n, dimension) or flat) */
+static PyObject * accumulator_vote(
+    PyObject * self, PyObject * args, PyObject * kwds)
+{
+    static const char * kwlist[] = { "samples", "threads", NULL };
+
+    PyObject * samples = NULL;
+    unsigned   threads = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|I", (char **)kwlist,
+        &samples, &threads)) return NULL;
+
+    accumulator_base * impl = accumulator_impl_of(self);
+    if (!impl) return NULL;
+
+    Py_buffer buf;
+    if (PyObject_GetBuffer(samples, &buf,
+        PyBUF_C_CONTIGUOUS | PyBUF_FORMAT)) return NULL;
+
+    const size_t dim = impl->dimension();
+
+    const char * error = NULL;
+    if (!signed_int_format(buf.format) || (size_t)buf.itemsize != impl->itemsize())
+        error = "samples type doesn't match the accumulator dtype";
+    else if (buf.ndim > 2 || (2 == buf.ndim && (size_t)buf.shape[1] != dim))
+        error = "samples must be of shape (n, dimension)";
+    else if ((buf.len / buf.itemsize) % dim)
+        error = "samples size isn't multiple of dimension";
+
+    if (error) {
+        PyBuffer_Release(&buf);
+        PyErr_SetString(PyExc_ValueError, error);
+        return NULL;
+    }
+
+    std::mutex * mutex = ((accumulator_object *)self)->mutex;
+    const size_t count = buf.len / buf.itemsize / dim;
+
+    bool ok = true;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        std::lock_guard<std::mutex> lock(*mutex);
+        impl->vote(buf.buf, count, threads);
+    }
+    catch (...) {
+        Py_BLOCK_THREADS
+        set_error();
+        Py_UNBLOCK_THREADS
+        ok = false;
+    }
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&buf);
+
+    if (!ok) return NULL;
+
+    Py_RETURN_NONE;
+}
+
+/** Peaks: tuple of coordinates (k, dimension) and counts (k) views */
+static PyObject * accumulator_peaks(
+    PyObject * self, PyObject * args, PyObject * kwds)
+{
+    static const char * kwlist[] = { "threshold", "top", "threads", NULL };
+
+    unsigned   threshold = 0;
+    Py_ssize_t top       = 0;
+    unsigned   threads   = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "I|nI", (char **)kwlist,
+        &threshold, &top, &threads)) return NULL;
+
+    accumulator_base * impl = accumulator_impl_of(self);
+    if (!impl) return NULL;
+
+    std::mutex * mutex = ((accumulator_object *)self)->mutex;
+
+    std::pair<view *, view *> peaks(NULL, NULL);
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        std::lock_guard<std::mutex> lock(*mutex);
+        peaks = impl->peaks(threshold, top < 0 ? 0 : top, threads);
+    }
+    catch (...) {
+        Py_BLOCK_THREADS
+        set_error();
+        Py_UNBLOCK_THREADS
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!peaks.first) return NULL;
+
+    PyObject * coords = array_new(peaks.first);
+    PyObject * counts = array_new(peaks.second);
+    if (!coords || !counts) {
+        Py_XDECREF(coords);
+        Py_XDECREF(counts);
+        return NULL;
+    }
+
+    return Py_BuildValue("(NN)", coords, counts);
+}
+
+/** Number of cells with votes */
+static Py_ssize_t accumulator_len(PyObject * self) {
+    accumulator_base * impl = accumulator_impl_of(self);
+    if (!impl) return -1;
+
+    std::mutex * mutex = ((accumulator_object *)self)->mutex;
+
+    // Voting may hold the mutex for long, don't block the interpreter
+    size_t size = 0;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(*mutex);
+        size = impl->size();
+    }
+    Py_END_ALLOW_THREADS
+
+    return size;
+}
+
+/** Accumulator dimension */
+static PyObject * accumulator_dimension(PyObject * self, void * ) {
+    accumulator_base * impl = accumulator_impl_of(self);
+    return impl ? PyLong_FromSize_t(impl->dimension()) : NULL;
+}
+
+static PyMethodDef accumulator_methods[] = {
+    {"vote", (PyCFunction)(void (*)(void))accumulator_vote,
+        METH_VARARGS | METH_KEYWORDS,
+        "vote(samples, threads=1)\n\n"
+        "Vote for samples (buffer of shape (n, dimension), no copy);\n"
+        "the GIL is released meanwhile."},
+    {"_peaks", (PyCFunction)(void (*)(void))accumulator_peaks,
+        METH_VARARGS | METH_KEYWORDS,
+        "_peaks(threshold, top=0, threads=1) -> (points, counts)\n\n"
+        "Peaks as Array views (the GIL is released while searching)."},
+    {NULL}
+};
+
+static PySequenceMethods accumulator_sequence = {
+    accumulator_len,  // sq_length
+};
+
+static PyGetSetDef accumulator_getset[] = {
+    {(char *)"dimension", accumulator_dimension, NULL,
+        (char *)"Space dimension", NULL},
+    {NULL}
+};
+
+static PyTypeObject accumulator_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "libaccl._libaccl.Accumulator",  // tp_name
+    sizeof(accumulator_object),      // tp_basicsize
+};
+
+
+static PyModuleDef module = {
+    PyModuleDef_HEAD_INIT,
+    "libaccl._libaccl",                  // m_name
+    "libaccl native binding",            // m_doc
+    -1,                                  // m_size
+};
+
+}  // end of anonymous namespace
+
+
+/** Module initialisation */
+PyMODINIT_FUNC PyInit__libaccl(void) {
+    array_type.tp_flags     = Py_TPFLAGS_DEFAULT;
+    array_type.tp_doc       = "Read-only array view of library-owned memory";
+    array_type.tp_dealloc   = array_dealloc;
+    array_type.tp_as_buffer = &array_buffer;
+    array_type.tp_as_sequence = &array_sequence;
+    array_type.tp_getset    = array_getset;
+
+    hypersphere_type.tp_flags   = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+    hypersphere_type.tp_doc     =
+        "Hypersphere(dimension, layers, dtype='int32', threads=1)";
+    hypersphere_type.tp_new     = PyType_GenericNew;
+    hypersphere_type.tp_init    = hypersphere_init;
+    hypersphere_type.tp_dealloc = hypersphere_dealloc;
+    hypersphere_type.tp_as_sequence = &hypersphere_sequence;
+    hypersphere_type.tp_getset  = hypersphere_getset;
+
+    accumulator_type.tp_flags   = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+    accumulator_type.tp_doc     =
+        "Accumulator(pattern, size, capacity=0, growth=0.0)";
+    accumulator_type.tp_new     = PyType_GenericNew;
+    accumulator_type.tp_init    = accumulator_init;
+    accumulator_type.tp_dealloc = accumulator_dealloc;
+    accumulator_type.tp_methods = accumulator_methods;
+    accumulator_type.tp_as_sequence = &accumulator_sequence;
+    accumulator_type.tp_getset  = accumulator_getset;
+
+    if (PyType_Ready(&array_type)       < 0) return NULL;
+    if (PyType_Ready(&hypersphere_type) < 0) return NULL;
+    if (PyType_Ready(&accumulator_type) < 0) return NULL;
+
+    PyObject * mod = PyModule_Create(&module);
+    if (!mod) return NULL;
+
+    Py_INCREF(&array_type);
+    Py_INCREF(&hypersphere_type);
+    Py_INCREF(&accumulator_type);
+    PyModule_AddObject(mod, "Array",       (PyObject *)&array_type);
+    PyModule_AddObject(mod, "Hypersphere", (PyObject *)&hypersphere_type);
+    PyModule_AddObject(mod, "Accumulator", (PyObject *)&accumulator_type);
+
+    return mod;
+}
@@ -0,0 +1,27 @@
+"""
+libaccl Python binding build
+
+The binding is built on the header-only C++ library (see src/CXX).
+"""
+
+from setuptools import setup, Extension
+
+
+setup(
+    name="libaccl",
+    version="0.1.0",
+    description="Cluster detection by pattern voting in an accumulator",
+    author="Vaclav Krpec",
+    author_email="vencik@razdva.cz",
+    license="BSD-3-Clause",
+    packages=["libaccl"],
+    ext_modules=[
+        Extension(
+            "libaccl._libaccl",
+            sources=["libaccl/_libaccl.cxx"],
+            include_dirs=["../CXX"],
+            extra_compile_args=["-std=c++11", "-Wall"],
+            libraries=["pthread"],
+            language="c++"),
+    ],
+)
@@ -0,0 +1,104 @@
+"""
+Python binding test
+
+Samples are placed on circles around cluster centres; voting with
+the circle pattern must produce peaks in the centres.
+Uses the array module (NumPy isn't required).
+"""
+
+import sys
+import array
+import hashlib
+import threading
+
+import libaccl
+
+
+def samples(circle, centres, typecode):
+    """Samples around centres (flat buffer)"""
+    points = circle.points
+    buf = array.array(typecode)
+    for c in centres:
+        for p in points.tolist():
+            buf.extend(c[d] + p[d] for d in range(len(c)))
+
+    return buf
+
+
+def accumulator_test(dtype, typecode):
+    """Voting and peaks test"""
+    error_cnt = 0
+
+    centres = [(0, 0), (40, 25), (-30, 50)]
+
+    circle = libaccl.Hypersphere(2, [10], dtype=dtype)
+    points = circle.points
+    if points.shape != (len(circle), 2) or not memoryview(points).readonly:
+        print("Pattern view shape mismatch: %s" % (points.shape,),
+              file=sys.stderr)
+        error_cnt += 1
+
+    # Flat export of the Array (consumers that don't request shape)
+    raw = circle._points
+    try:
+        if hashlib.sha256(raw).digest() != \
+           hashlib.sha256(memoryview(raw).tobytes()).digest():
+            print("Flat pattern view mismatch", file=sys.stderr)
+            error_cnt += 1
+    except BufferError as x:
+        print("Flat pattern view refused: %s" % x, file=sys.stderr)
+        error_cnt += 1
+
+    # Parallel construction gives the same pattern
+    parallel = libaccl.Hypersphere(2, [10], dtype=dtype, threads=2)
+    if parallel.points.tolist() != points.tolist():
+        print("Parallel pattern mismatch", file=sys.stderr)
+        error_cnt += 1
+
+    acc = libaccl.Accumulator(circle, 1 << 14)
+    buf = samples(circle, centres, typecode)
+
+    # Concurrent voting (half of the samples by each thread)
+    half = len(buf) // 4 * 2
+    threads = [
+        threading.Thread(target=acc.vote, args=(buf[:half],)),
+        threading.Thread(target=acc.vote, args=(buf[half:], 2)),
+    ]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    peaks, counts = acc.peaks(len(circle) // 2)
+    peaks = [tuple(p) for p in peaks.tolist()]
+    counts = counts.tolist()
+
+    print("%s: %d cells, peaks %s" % (dtype, len(acc), peaks))
+
+    if sorted(peaks) != sorted(centres) or set(counts) != {len(circle)}:
+        print("Peaks mismatch: %s %s" % (peaks, counts), file=sys.stderr)
+        error_cnt += 1
+
+    # dtype mismatch
+    other = array.array("q" if "i" == typecode else "i", [0, 0])
+    try:
+        acc.vote(other)
+        print("Sample dtype mismatch accepted", file=sys.stderr)
+        error_cnt += 1
+    except ValueError:
+        pass
+
+    return error_cnt
+
+
+def main():
+    error_cnt = 0
+    error_cnt += accumulator_test("int32", "i")
+    error_cnt += accumulator_test("int64", "q")
+
+    print("Exit code: %d" % error_cnt, file=sys.stderr)
+    return error_cnt
+
+
+if __name__ == "__main__":
+    sys.exit(main())